@@ -25,6 +25,8 @@
 
 #define ARR_SIZE(a) (sizeof(a)/sizeof(a[0]))
 
+#define UC_MAX_CPUS 64 // SNPS added: vCPUs per engine ("cpus" config)
+
 #define READ_QWORD(x) ((uint64_t)x)
 #define READ_DWORD(x) (x & 0xffffffff)
 #define READ_WORD(x) (x & 0xffff)
@@ -62,20 +64,40 @@ typedef void (*uc_args_uc_t)(struct uc_struct*);
 typedef int (*uc_args_int_uc_t)(struct uc_struct*);
 typedef void (*uc_cpu_exec_exit_t)(CPUState*);
 
+// SNPS added: entry key of a translated block, see uc_tb_profile_save()
+typedef struct uc_tb_key {
+    uint64_t phys_pc;
+    uint64_t phys_page2;    // -1 if the block does not cross a page
+    uint64_t pc;
+    uint64_t cs_base;
+    uint32_t flags;
+    uint32_t cflags;
+} uc_tb_key_t;
+
 typedef void (*tb_flush_t)(CPUState*); // SNPS added
+typedef bool (*tb_warm_t)(CPUState*, const uc_tb_key_t*); // SNPS added
 typedef void (*tb_flush_page_t)(CPUState*, uint64_t,  uint64_t); // SNPS added
 
+typedef size_t (*insn_count_t)(CPUState*); // SNPS added
+typedef void (*restore_callout_pc_t)(CPUState*); // SNPS added
+
 typedef void (*dmi_invalidate_t)(CPUState*, uint64_t, uint64_t); // SNPS added
+typedef void (*dmi_invalidate_ranges_t)(CPUState*, const uc_dmi_range_t*, size_t); // SNPS added
 
 typedef void (*tlb_flush_t)(CPUState*); // SNPS added
 typedef void (*tlb_flush_page_t)(CPUState*, uint64_t); // SNPS added
 typedef void (*tlb_flush_mmuidx_t)(CPUState*, uint16_t); // SNPS added
 typedef void (*tlb_flush_page_mmuidx_t)(CPUState*, uint64_t, uint16_t); // SNPS added
+typedef void (*tlb_flush_asid_mmuidx_t)(CPUState*, uint32_t, uint16_t); // SNPS added
+typedef void (*tlb_stats_t)(CPUState*, uc_tlb_stats_t*); // SNPS added
 
 typedef void (*tlb_cluster_flush_t)(CPUState*); // SNPS added
 typedef void (*tlb_cluster_flush_page_t)(CPUState*, uint64_t); // SNPS added
 typedef void (*tlb_cluster_flush_mmuidx_t)(CPUState*, uint16_t); // SNPS added
 typedef void (*tlb_cluster_flush_page_mmuidx_t)(CPUState*, uint64_t, uint16_t); // SNPS added
+typedef void (*tlb_cluster_flush_asid_mmuidx_t)(CPUState*, uint32_t, uint16_t); // SNPS added
+typedef void (*tlb_cluster_sync_t)(CPUState*); // SNPS added
+typedef void (*tlb_batch_apply_t)(struct uc_struct*); // SNPS added
 
 typedef int  (*cpu_breakpoint_insert_t)(CPUState*, vaddr, int, CPUBreakpoint**); // SNPS added
 typedef int  (*cpu_breakpoint_remove_t)(CPUState*, vaddr, int); // SNPS added
@@ -118,6 +140,7 @@ struct hook {
     uint64_t begin, end; // only trigger if PC or memory access is in this address (depends on hook type)
     void *callback;      // a uc_cb_* type
     void *user_data;
+    bool to_delete;      // SNPS added: deleted, freed with the code that may still call it
 };
 
 // hook list offsets
@@ -146,21 +169,21 @@ enum uc_hook_idx {
     struct list_item *cur
 
 // for loop macro to loop over hook lists
-#define HOOK_FOREACH(uc, hh, idx) while (false) // SNPS changed
-//    for (                                                 \
-//        cur = (uc)->hook[idx##_IDX].head;                 \
-//        cur != NULL && ((hh) = (struct hook *)cur->data)  \
-//            /* stop excuting callbacks on stop request */ \
-//            && !uc->stop_request;                         \
-//        cur = cur->next)
+#define HOOK_FOREACH(uc, hh, idx)                         \
+    for (                                                 \
+        cur = (uc)->hook[idx##_IDX].head;                 \
+        cur != NULL && ((hh) = (struct hook *)cur->data)  \
+            /* stop excuting callbacks on stop request */ \
+            && !uc->stop_request;                         \
+        cur = cur->next)
 
 // if statement to check hook bounds
 #define HOOK_BOUND_CHECK(hh, addr)                  \
     ((((addr) >= (hh)->begin && (addr) <= (hh)->end) \
          || (hh)->begin > (hh)->end))
 
-#define HOOK_EXISTS(uc, idx) (0) // SNPS changed
-#define HOOK_EXISTS_BOUNDED(uc, idx, addr) (0) // SNPS changed
+#define HOOK_EXISTS(uc, idx) ((uc)->hook[idx##_IDX].head != NULL)
+#define HOOK_EXISTS_BOUNDED(uc, idx, addr) _hook_exists_bounded((uc)->hook[idx##_IDX].head, addr)
 
 static inline bool _hook_exists_bounded(struct list_item *cur, uint64_t addr)
 {
@@ -172,9 +195,119 @@ static inline bool _hook_exists_bounded(struct list_item *cur, uint64_t addr)
     return false;
 }
 
-//relloc increment, KEEP THIS A POWER OF 2!
+// SNPS added: the hooks of an instruction, a block or a page, resolved when
+// it is translated or enters the TLB (see uc_hook_list_get())
+typedef struct uc_hook_list {
+    struct uc_struct *uc;
+    int types;              // UC_HOOK_* of the hooks
+    int count;
+    struct hook *hooks[];
+} uc_hook_list_t;
+
+// SNPS added: the range of a hook added or deleted since the last
+// uc_hooks_refresh(), more changes refresh everything
+#define UC_HOOK_RANGES 16
+typedef struct uc_hook_range {
+    uint64_t begin;
+    uint64_t end;
+    int types;
+} uc_hook_range_t;
+
+// SNPS added: a range granted by uc_dmi_grant(), ptr backs start
+typedef struct uc_dmi_grant {
+    uint64_t start;
+    uint64_t end;
+    unsigned char *ptr;
+    int prot;
+} uc_dmi_grant_t;
+
+// SNPS added: hook types dispatched through uc_hook_list_t
+#define UC_HOOK_RESOLVED \
+    (UC_HOOK_CODE | UC_HOOK_BLOCK | UC_HOOK_MEM_READ | UC_HOOK_MEM_WRITE | \
+     UC_HOOK_MEM_READ_AFTER)
+
+// SNPS changed: initial size, doubled as needed
 #define MEM_BLOCK_INCR 32
 
+// SNPS added: TLB shootdowns received in batching mode ("tlbbatch" config),
+// applied at the next TB boundary of the engine. Page invalidations beyond
+// the capacity are widened to their MMU indexes.
+#define UC_TLB_BATCH_PAGES 64
+#define UC_TLB_BATCH_ASIDS 16
+
+typedef struct uc_tlb_queue {
+    uint16_t flush_idxmap;      // MMU indexes flushed entirely
+    int n_pages;
+    struct {
+        uint64_t addr;
+        uint16_t idxmap;
+    } pages[UC_TLB_BATCH_PAGES];
+    int n_asids;
+    struct {
+        uint32_t asid;
+        uint16_t idxmap;
+    } asids[UC_TLB_BATCH_ASIDS];
+} uc_tlb_queue_t;
+
+typedef struct uc_tlb_batch {
+    QemuMutex lock;             // queue may be filled from other threads
+    int pending;                // read without the lock at TB boundaries
+    uc_tlb_queue_t queue;
+} uc_tlb_batch_t;
+
+// SNPS added: buffered basic block trace, see
+// uc_setup_basic_block_trace_buffer(). The write cursor of each vCPU is kept
+// in CPUState (bb_trace_pos) where generated code reaches it.
+typedef struct uc_bb_trace_file uc_bb_trace_file_t;
+
+typedef struct uc_bb_trace {
+    uint64_t *buffer;
+    uint64_t *end;              // after the last entry that fits
+    int flags;                  // UC_BB_TRACE_*
+    int words;                  // uint64_t per entry
+    uc_trace_buffer_t fn;
+    void *opaque;
+    uint64_t icount_base;       // instructions retired by previous runs
+    uc_bb_trace_file_t *file;   // writer thread, or NULL
+} uc_bb_trace_t;
+
+// SNPS added: memory access trace, see uc_setup_mem_trace(). Generated code
+// reserves room for the accesses of a TB on entry, TBs end before they could
+// need more than the buffer holds with UC_MEM_TRACE_INSN_MAX accesses of the
+// next instruction.
+#define UC_MEM_TRACE_INSN_MAX (UC_MEM_TRACE_MIN_ENTRIES / 2)
+
+typedef struct uc_mem_trace {
+    uint64_t *buffer;
+    uint64_t *end;              // after the last entry that fits
+    size_t entries;             // that fit into the buffer
+    int flags;                  // UC_MEM_TRACE_*
+    int words;                  // uint64_t per entry
+    uc_trace_buffer_t fn;
+    void *opaque;
+} uc_mem_trace_t;
+
+// SNPS added: engines of the same model sharing one translation context
+// ("tbgroup" config). TBs are keyed by physical PC, so all members must see
+// the same code at the same physical addresses. The lock is held by the
+// thread translating or executing on behalf of any member and is recursive
+// so that callbacks may flush TBs through any engine of the group.
+typedef struct uc_tb_group {
+    char name[64];
+    char model[80];
+    bool exact_budget;
+    int refs;                   // engines in the group
+    bool tcg_initialized;       // TCG globals of tcg_ctx have been created
+    void *tcg_ctx;              // shared TCGContext, created by the first engine
+    void **l1_map;              // shared page descriptors
+    size_t l1_map_size;
+    QemuMutex lock;
+    QemuThread owner;
+    int depth;
+    QLIST_HEAD(, uc_struct) members;
+    QLIST_ENTRY(uc_tb_group) entry;
+} uc_tb_group;
+
 struct uc_struct {
     uc_arch arch;
     uc_mode mode;
@@ -196,16 +329,23 @@ struct uc_struct {
     uc_args_int_uc_t vm_start;
     uc_args_tcg_enable_t tcg_enabled;
     uc_args_uc_long_t tcg_exec_init;
+    uc_args_uc_t tcg_exec_attach; // SNPS added
     uc_args_uc_ram_size_t memory_map;
     uc_args_uc_ram_size_ptr_t memory_map_ptr;
     uc_args_uc_mmio_size_t memory_map_mmio; // SNPS added
     uc_mem_unmap_t memory_unmap;
+    uc_args_uc_t memory_begin; // SNPS added
+    uc_args_uc_t memory_commit; // SNPS added
     uc_readonly_mem_t readonly_mem;
     uc_mem_redirect_t mem_redirect;
 
     size_t tb_size; // SNPS added
     tb_flush_t tb_flush; // SNPS added
     tb_flush_page_t tb_flush_page; // SNPS added
+    tb_flush_page_t tb_flush_hooked; // SNPS added
+    tb_warm_t tb_warm; // SNPS added
+    insn_count_t insn_count; // SNPS added
+    restore_callout_pc_t restore_callout_pc; // SNPS added
 
     uc_cb_mmio_t uc_portio_func; // SNPS added
     void*        uc_portio_opaque; // SNPS added
@@ -213,22 +353,35 @@ struct uc_struct {
     uc_cb_dmiptr_t   get_dmi_ptr; // SNPS added
     uc_cb_pgprot_t   protect_dmi_ptr; // SNPS added
     dmi_invalidate_t inv_dmi_ptr; // SNPS added
+    dmi_invalidate_ranges_t inv_dmi_ranges_ptr; // SNPS added
     void*            dmi_opaque; // SNPS added
+    uc_dmi_grant_t   *dmi_grants; // SNPS added: by address, see uc_dmi_grant()
+    size_t           dmi_grant_count; // SNPS added
+    size_t           dmi_grant_alloc; // SNPS added
 
     tlb_flush_t             tlb_flush; // SNPS added
     tlb_flush_page_t        tlb_flush_page; // SNPS added
     tlb_flush_mmuidx_t      tlb_flush_mmuidx; // SNPS added
     tlb_flush_page_mmuidx_t tlb_flush_page_mmuidx; // SNPS added
+    tlb_flush_asid_mmuidx_t tlb_flush_asid_mmuidx; // SNPS added
+    tlb_stats_t             tlb_stats; // SNPS added
 
     tlb_cluster_flush_t             tlb_cluster_flush; // SNPS added
     tlb_cluster_flush_page_t        tlb_cluster_flush_page; // SNPS added
     tlb_cluster_flush_mmuidx_t      tlb_cluster_flush_mmuidx; // SNPS added
     tlb_cluster_flush_page_mmuidx_t tlb_cluster_flush_page_mmuidx; // SNPS added
+    tlb_cluster_flush_asid_mmuidx_t tlb_cluster_flush_asid_mmuidx; // SNPS added
+    tlb_cluster_sync_t              tlb_cluster_sync; // SNPS added: on DSB
+    tlb_batch_apply_t               tlb_batch_apply; // SNPS added
+    uc_tlb_batch_t                  *tlb_batch; // SNPS added: NULL unless "tlbbatch"
+    bool                            tlb_broadcast_pending; // SNPS added: since the last DSB
 
     uc_tlb_cluster_flush_t             uc_tlb_cluster_flush; // SNPS added
     uc_tlb_cluster_flush_page_t        uc_tlb_cluster_flush_page; // SNPS added
     uc_tlb_cluster_flush_mmuidx_t      uc_tlb_cluster_flush_mmuidx; // SNPS added
     uc_tlb_cluster_flush_page_mmuidx_t uc_tlb_cluster_flush_page_mmuidx; // SNPS added
+    uc_tlb_cluster_flush_asid_mmuidx_t uc_tlb_cluster_flush_asid_mmuidx; // SNPS added
+    uc_tlb_cluster_sync_t              uc_tlb_cluster_sync; // SNPS added
     void*                              uc_tlb_cluster_opaque; // SNPS added
 
     cpu_breakpoint_insert_t breakpoint_insert; // SNPS added
@@ -250,6 +403,10 @@ struct uc_struct {
 
     uc_trace_basic_block_t uc_trace_bb_func; // SNPS added
     void*                  uc_trace_bb_opaque; // SNPS added
+    uc_bb_trace_t *bb_trace; // SNPS added: buffered trace, or NULL
+    uc_mem_trace_t *mem_trace; // SNPS added: or NULL
+    uc_mem_trace_range_t *mem_trace_ranges; // SNPS added: sorted, disjoint
+    size_t mem_trace_nranges; // SNPS added: 0 to trace all TBs
 
     uc_get_config_t uc_config_func; // SNPS added
     void*           uc_config_opaque; // SNPS added
@@ -267,11 +424,15 @@ struct uc_struct {
     bool is_excl; // SNPS added
     bool is_running; // SNPS added
     bool is_memcb; // SNPS added
+    bool exact_budget; // SNPS added
 
     char model[80]; // SNPS added
 
     // TODO: remove current_cpu, as it's a flag for something else ("cpu running"?)
     CPUState *cpu, *current_cpu;
+    CPUState **cpus; // SNPS added: all vCPUs, cpu is the selected one
+    int num_cpus;    // SNPS added: number of vCPUs created so far
+    int smp_cpus;    // SNPS added: number of vCPUs to create ("cpus" config)
 
     uc_insn_hook_validate insn_hook_validate;
 
@@ -317,10 +478,13 @@ struct uc_struct {
 
     /* code generation context */
     void *tcg_ctx;  // for "TCGContext tcg_ctx" in qemu/translate-all.c
+    uc_tb_group *tb_group; // SNPS added: translation sharing group, or NULL
+    QLIST_ENTRY(uc_struct) tb_group_entry; // SNPS added
     bool parallel_cpus; // for "bool parallel_cpus" in qemu/translate-all.c
 
     /* memory.c */
     unsigned memory_region_transaction_depth;
+    unsigned memory_region_seq; // SNPS added: names of memory regions
     bool memory_region_update_pending;
     bool ioeventfd_update_pending;
     QTAILQ_HEAD(memory_listeners, MemoryListener) memory_listeners;
@@ -345,8 +509,12 @@ struct uc_struct {
     // linked lists containing hooks per type
     struct list hook[UC_HOOK_MAX];
 
-    // hook to count number of instructions for uc_emu_start()
-    uc_hook count_hook;
+    GHashTable *hook_lists; // SNPS added: interned uc_hook_list_t
+    struct list hooks_to_del; // SNPS added: deleted, freed by uc_hooks_refresh()
+    bool hooks_changed; // SNPS added: hook lists in use are out of date
+    uc_hook_range_t hook_ranges[UC_HOOK_RANGES]; // SNPS added
+    int hook_range_count; // SNPS added
+    bool hooks_refresh_all; // SNPS added: an unbounded hook or too many
 
     size_t emu_counter; // current counter of uc_emu_start()
     size_t emu_count; // save counter of uc_emu_start()
@@ -358,8 +526,8 @@ struct uc_struct {
     bool quit_request;  // request to quit the current TB, but continue to emulate - for uc_mem_protect()
     bool emulation_done;  // emulation is done by uc_emu_start()
     bool timed_out;     // emulation timed out, uc_emu_start() will result in EC_ERR_TIMEOUT
-    QemuThread timer;   // timer for emulation timeout
-    uint64_t timeout;   // timeout for uc_emu_start()
+    int64_t deadline;   // SNPS changed: end of uc_emu_start() timeout, 0 if not armed
+    QLIST_ENTRY(uc_struct) timer_entry; // SNPS added: link in the list of armed timeouts
 
     uint64_t invalid_addr;  // invalid address to be accessed
     int invalid_error;  // invalid memory code: 1 = READ, 2 = WRITE, 3 = CODE
@@ -373,6 +541,10 @@ struct uc_struct {
     MemoryRegion **mapped_blocks;
     uint32_t mapped_block_count;
     uint32_t mapped_block_cache_index;
+    MemoryRegion **mapped_sorted; // SNPS added: mapped_blocks by address
+    uint32_t mapped_block_alloc; // SNPS added
+    bool mapped_overlap; // SNPS added: uc_mem_map_ptr/io may overlap blocks
+    unsigned mem_map_batch; // SNPS added: uc_mem_map_begin() nesting
     void *qemu_thread_data; // to support cross compile to Windows (qemu-thread-win32.c)
     uint32_t target_page_size;
     uint32_t target_page_align;
@@ -384,6 +556,13 @@ struct uc_struct {
     int qemu_dcache_linesize;
 
     uc_mmio_region_t *mmios; // SNPS added
+
+    // SNPS added: warm-start profile ("tbprofile" config)
+    char *tb_profile_path;      // NULL if blocks are not recorded
+    uc_tb_key_t *tb_profile;    // blocks translated so far
+    size_t tb_profile_len;
+    size_t tb_profile_size;
+    bool tb_profile_loaded;     // profile applied by uc_emu_start()
 };
 
 // Metadata stub for the variable-size cpu context used with uc_context_*()
@@ -392,9 +571,82 @@ struct uc_context {
    char data[0];
 };
 
+// SNPS added: serialize translation and execution within a sharing group
+static inline void uc_tb_group_lock(struct uc_struct *uc)
+{
+    uc_tb_group *group = uc->tb_group;
+
+    if (!group)
+        return;
+
+    if (group->depth > 0 && qemu_thread_is_self(&group->owner)) {
+        group->depth++;
+        return;
+    }
+
+    qemu_mutex_lock(&group->lock);
+    qemu_thread_get_self(&group->owner);
+    group->depth = 1;
+}
+
+static inline void uc_tb_group_unlock(struct uc_struct *uc)
+{
+    uc_tb_group *group = uc->tb_group;
+
+    if (group && --group->depth == 0)
+        qemu_mutex_unlock(&group->lock);
+}
+
+// SNPS added: does the translation context outlive this engine? Only valid
+// in uc_close(), after the engine left its group.
+static inline bool uc_tcg_shared(struct uc_struct *uc)
+{
+    return uc->tb_group && uc->tb_group->refs > 0;
+}
+
+// SNPS added: record a translated block for the warm-start profile
+void uc_tb_profile_add(struct uc_struct *uc, const uc_tb_key_t *key);
+
+// SNPS added: deliver the entries of the basic block trace buffer of @cpu
+void uc_bb_trace_flush(struct uc_struct *uc, CPUState *cpu);
+
+// SNPS added: deliver the entries of the memory trace buffer of @cpu and make
+// room for @need bytes
+void uc_mem_trace_flush(struct uc_struct *uc, CPUState *cpu, size_t need);
+
+// SNPS added: are the memory accesses of the TB at @pc traced?
+bool uc_mem_trace_covers(struct uc_struct *uc, uint64_t pc);
+
+// SNPS added: the hooks of @types whose range overlaps [@begin, @end], NULL
+// if there are none. Lists stay valid until uc_hooks_refresh().
+uc_hook_list_t *uc_hook_list_get(struct uc_struct *uc, int types,
+                                 uint64_t begin, uint64_t end);
+
+// SNPS added: call the code or block hooks of @uc, returns true on
+// uc_emu_stop()
+bool uc_hook_call_code(struct uc_struct *uc, uc_hook_list_t *hooks,
+                       uint64_t address, uint32_t size);
+
+// SNPS added: call the memory hooks of a page that match an access of @type
+// (UC_MEM_READ, UC_MEM_WRITE or UC_MEM_READ_AFTER) and overlap its bytes
+void uc_hook_call_mem(uc_hook_list_t *hooks, int type, uint64_t address,
+                      int size, int64_t value);
+
+// SNPS added: drop the code and TLB entries made for the hooks before a
+// change, with the lists and deleted hooks they refer to
+void uc_hooks_refresh(struct uc_struct *uc);
+
+// SNPS added: the host page and UC_DMI_PROT_* of the physical page @page if
+// it was granted by uc_dmi_grant()
+bool uc_dmi_lookup(struct uc_struct *uc, uint64_t page, unsigned char **ptr,
+                   int *prot);
+
 // check if this address is mapped in (via uc_mem_map())
 MemoryRegion *memory_mapping(struct uc_struct* uc, uint64_t address);
 
+// SNPS added: forget a block of mapped_blocks, false if it is not there
+bool memory_mapping_remove(struct uc_struct *uc, MemoryRegion *mr);
+
 // Defined in util/cacheinfo.c. Made externally linked to
 // allow calling it directly.
 void init_cache_info(struct uc_struct *uc);
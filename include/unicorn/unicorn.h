@@ -390,6 +390,32 @@ typedef void (*uc_tlb_cluster_flush_page_t)(void* opaque, uint64_t addr);
 typedef void (*uc_tlb_cluster_flush_mmuidx_t)(void* opaque, uint16_t idxmap);
 typedef void (*uc_tlb_cluster_flush_page_mmuidx_t)(void* opaque, uint64_t addr,
                                                    uint16_t idxmap);
+typedef void (*uc_tlb_cluster_flush_asid_mmuidx_t)(void* opaque, uint32_t asid,
+                                                   uint16_t idxmap); // SNPS added
+typedef void (*uc_tlb_cluster_sync_t)(void* opaque); // SNPS added
+
+// SNPS added: softmmu TLB counters of a vCPU, summed over its MMU indexes
+typedef struct uc_tlb_stats {
+    uint64_t misses;      // accesses that missed the main TLB
+    uint64_t victim_hits; // misses served by the victim TLB, the others
+                          // required a page table walk
+    uint64_t flushes;     // flushes of the TLB of an MMU index
+    uint64_t resizes;     // size changes of the main TLB of an MMU index
+    uint64_t entries;     // current number of main TLB entries
+    uint64_t dmi_grants;  // fills of non-RAM pages served by uc_dmi_grant()
+    uint64_t dmi_callbacks; // fills that called the DMI callback
+    uint64_t walk_host;   // page table walk accesses to RAM or DMI memory
+    uint64_t walk_io;     // page table walk accesses through I/O callbacks
+    uint64_t walk_cache_hits;   // page table walks that started at the last
+                                // level, see uc_tlb_stats()
+    uint64_t walk_cache_misses; // walks that started at the first level
+    uint64_t page_flushes; // page invalidations of the TLB of an MMU index
+    uint64_t large_page_flushes; // large pages dropped by page invalidations,
+                                 // see uc_tlb_stats()
+    uint64_t forced_flushes; // page invalidations that flushed the TLB of
+                             // an MMU index, also counted in flushes
+    uint64_t asid_flushes; // ASID invalidations of the TLB of an MMU index
+} uc_tlb_stats_t;
 
 typedef void (*uc_breakpoint_hit_t)(void* opaque, uint64_t addr);
 typedef void (*uc_watchpoint_hit_t)(void* opaque, uint64_t addr, uint64_t size,
@@ -397,6 +423,31 @@ typedef void (*uc_watchpoint_hit_t)(void* opaque, uint64_t addr, uint64_t size,
 
 typedef void (*uc_trace_basic_block_t)(void* opaque, uint64_t addr);
 
+// SNPS added: fields of a buffered basic block trace entry after the PC
+#define UC_BB_TRACE_ICOUNT 1    // instructions retired before the block
+#define UC_BB_TRACE_TIME   2    // host time in nanoseconds
+
+typedef void (*uc_trace_buffer_t)(void* opaque, const uint64_t *entries,
+                                  size_t count);
+
+// SNPS added: fields of a memory trace entry after the address and info word
+#define UC_MEM_TRACE_PADDR 1    // physical address
+#define UC_MEM_TRACE_VALUE 2    // value loaded or stored, zero extended
+
+// SNPS added: info word of a memory trace entry
+#define UC_MEM_TRACE_SIZE(info)    ((info) & 0xff)          // in bytes
+#define UC_MEM_TRACE_WRITE         0x100
+#define UC_MEM_TRACE_MMU_IDX(info) (((info) >> 16) & 0xff)
+
+// SNPS added: minimum number of entries of a memory trace buffer
+#define UC_MEM_TRACE_MIN_ENTRIES 128
+
+// SNPS added: a range of virtual code addresses [start, end)
+typedef struct uc_mem_trace_range {
+    uint64_t start;
+    uint64_t end;
+} uc_mem_trace_range_t;
+
 typedef const char* (*uc_get_config_t)(void* opaque, const char* config);
 
 // Opaque storage for CPU context, used with uc_context_*()
@@ -629,6 +680,12 @@ uc_err uc_emu_stop(uc_engine *uc);
  @end: end address of the area where the callback is effect (inclusive)
    NOTE 1: the callback is called only if related address is in range [@begin, @end]
    NOTE 2: if @begin > @end, callback is called whenever this hook type is triggered
+   NOTE 3: code and block hooks are resolved when code is translated, memory
+   hooks when a page enters the TLB, so code and pages outside of all ranges
+   run at full speed. Adding or deleting such a hook discards translations and
+   TLB entries; during emulation this takes effect once the current block is
+   left. uc_emu_stop() from a code hook stops before the hooked instruction.
+   Memory hooks see an access once, if any of its bytes is in range.
  @...: variable arguments (depending on @type)
    NOTE: if @type = UC_HOOK_INSN, this is the instruction ID (ex: UC_X86_INS_OUT)
 
@@ -711,6 +768,28 @@ uc_err uc_mem_map_io(uc_engine *uc, uint64_t addr, size_t size, uc_cb_mmio_t cal
 UNICORN_EXPORT
 uc_err uc_mem_map_portio(uc_engine *uc, uc_cb_mmio_t callback, void *opaque);
 
+/*
+ SNPS added
+ Batch memory mappings. The uc_mem_map*() calls between uc_mem_map_begin() and
+ the matching uc_mem_map_commit() update the address space and flush the TLB
+ once, at the commit. Batches can be nested.
+
+ The regions mapped in a batch cannot be accessed before the commit, and
+ uc_mem_unmap(), uc_mem_protect(), uc_emu_start() and uc_emu_resume() return
+ UC_ERR_ARG while a batch is open.
+
+ @uc: handle returned by uc_open()
+
+ @return UC_ERR_OK on success, or UC_ERR_ARG from uc_mem_map_commit() if no
+   batch is open.
+*/
+UNICORN_EXPORT
+uc_err uc_mem_map_begin(uc_engine *uc);
+
+// SNPS added
+UNICORN_EXPORT
+uc_err uc_mem_map_commit(uc_engine *uc);
+
 /*
  Unmap a region of emulation memory.
  This API deletes a memory mapping from the emulation memory space.
@@ -834,12 +913,82 @@ size_t uc_context_size(uc_engine *uc);
 UNICORN_EXPORT // SNPS added
 size_t uc_instruction_count(uc_engine *uc);
 
+/*
+ Continue emulation from the current CPU state for another @count
+ instructions. Unlike uc_emu_start() the PC is not rewritten and no timeout
+ is armed, the stop address of the last uc_emu_start() stays in effect.
+ Meant for running many short quanta back to back.
+
+ @uc: handle returned by uc_open()
+ @count: the number of instructions to be emulated
+
+ @return UC_ERR_OK on success, or other value on failure (refer to uc_err enum
+   for detailed error).
+*/
+UNICORN_EXPORT // SNPS added
+uc_err uc_emu_resume(uc_engine *uc, size_t count);
+
+/*
+ An engine can hold several vCPUs (set with the "cpus" config, up to 64).
+ They share memory, MMIO regions and translated code. Register access,
+ interrupts, breakpoints and uc_emu_start()/uc_emu_resume() act on the
+ selected vCPU; callbacks run while the selected vCPU executes. TLB and DMI
+ invalidation act on all vCPUs. vCPU 0 is selected after uc_open().
+ The vCPUs of an engine run one at a time on the calling thread, and
+ uc_cpu_select() fails while the engine is running. Running the vCPUs of
+ an engine in parallel on separate host threads is not supported. Engines
+ without a "tbgroup" can run in parallel on separate threads, but each
+ translates its own code; the members of a "tbgroup" run one at a time.
+*/
+UNICORN_EXPORT // SNPS added
+int uc_cpu_count(uc_engine *uc);
+
+UNICORN_EXPORT // SNPS added
+int uc_cpu_index(uc_engine *uc);
+
+UNICORN_EXPORT // SNPS added
+uc_err uc_cpu_select(uc_engine *uc, int index);
+
+/*
+ Engines opened with the same "tbgroup" config share one translation cache:
+ code translated by one of them is reused by all, keyed by physical PC. All
+ members must use the same model and "exactbudget" setting (uc_open() fails
+ with UC_ERR_ARG otherwise); the first one determines "tbsize". They must see
+ the same code at the same physical addresses and should use the same @until.
+ Code translated while a member has code or block hooks, traces or
+ breakpoints is not shared with the others. uc_tb_flush()/uc_tb_flush_page() through any
+ member invalidate the code for all of them, and pages that code is
+ translated from are protected through the DMI callbacks of every member.
+ Members translate and execute one at a time; a member called from a
+ callback of another one (e.g. to flush TBs) must not start emulation.
+*/
 UNICORN_EXPORT // SNPS added
 uc_err uc_tb_flush(uc_engine *uc);
 
 UNICORN_EXPORT // SNPS added
 uc_err uc_tb_flush_page(uc_engine *uc, uint64_t start, uint64_t end);
 
+/*
+ Warm-start profiles. With the "tbprofile" config set to a file name, the
+ engine records the blocks it translates; the first uc_emu_start() translates
+ the blocks listed in the file (if it exists) before executing anything, and
+ uc_close() writes the blocks of this run back to it. Translation happens
+ synchronously on the calling thread, with the current vCPU state.
+
+ uc_tb_profile_save() writes the recorded blocks to @path. It fails with
+ UC_ERR_ARG if the engine was opened without "tbprofile".
+
+ uc_tb_profile_load() translates the blocks listed in @path that are not
+ cached yet and stores their number in @count (if not NULL). It fails with
+ UC_ERR_ARG if the file is not a profile of the same model. Blocks whose
+ pages are no longer backed by RAM or DMI are skipped.
+*/
+UNICORN_EXPORT // SNPS added
+uc_err uc_tb_profile_save(uc_engine *uc, const char *path);
+
+UNICORN_EXPORT // SNPS added
+uc_err uc_tb_profile_load(uc_engine *uc, const char *path, size_t *count);
+
 UNICORN_EXPORT // SNPS added
 uc_err uc_tlb_flush(uc_engine *uc);
 
@@ -852,6 +1001,33 @@ uc_err uc_tlb_flush_mmuidx(uc_engine *uc, uint16_t idxmap);
 UNICORN_EXPORT // SNPS added
 uc_err uc_tlb_flush_page_mmuidx(uc_engine *uc, uint64_t addr, uint16_t idxmap);
 
+/*
+ TLB entries are tagged with the address space (ASID, and VMID in the upper
+ 16 bits of @asid) they were filled for, so that a context switch keeps the
+ entries of other address spaces. uc_tlb_flush_asid_mmuidx() invalidates the
+ non-global entries of one address space only.
+*/
+UNICORN_EXPORT // SNPS added
+uc_err uc_tlb_flush_asid_mmuidx(uc_engine *uc, uint32_t asid, uint16_t idxmap);
+
+/*
+ Read the TLB counters of the current vCPU. The counters accumulate from
+ uc_open(); the main TLB of each MMU index is resized on flushes according to
+ its use (on hosts whose TCG backend supports it, x86 so far).
+
+ Like the walk caches of real MMUs, each vCPU remembers the last level tables
+ of its page table walks (ARM long descriptor and RISC-V Sv32/39/48 tables), so
+ changes to higher level descriptors take effect after a TLB invalidation
+ covering them, or uc_tlb_flush().
+
+ The TLB holds guest pages larger than its own pages by their small pages.
+ Invalidating a page within one of the first large pages of an MMU index
+ only drops the pages of that large page; beyond those, large pages share a
+ region whose invalidation flushes the TLB of the MMU index.
+*/
+UNICORN_EXPORT // SNPS added
+uc_err uc_tlb_stats(uc_engine *uc, uc_tlb_stats_t *stats);
+
 UNICORN_EXPORT // SNPS added
 uc_err uc_register_tlb_cluster(uc_engine *uc, void *opaque,
         uc_tlb_cluster_flush_t             tlb_cluster_flush_fn,
@@ -859,6 +1035,36 @@ uc_err uc_register_tlb_cluster(uc_engine *uc, void *opaque,
         uc_tlb_cluster_flush_mmuidx_t      tlb_cluster_flush_mmuidx_fn,
         uc_tlb_cluster_flush_page_mmuidx_t tlb_cluster_flush_page_mmuidx_fn);
 
+/*
+ Broadcast invalidations by ASID to the cluster, typically by calling
+ uc_tlb_flush_asid_mmuidx() on all its engines. Without it they fall back
+ to the flush of the MMU indexes.
+*/
+UNICORN_EXPORT // SNPS added
+uc_err uc_register_tlb_cluster_asid(uc_engine *uc,
+        uc_tlb_cluster_flush_asid_mmuidx_t tlb_cluster_flush_asid_mmuidx_fn);
+
+/*
+ Batched TLB shootdowns ("tlbbatch" config). The uc_tlb_flush*() calls of an
+ engine opened with "tlbbatch" set to "1" don't flush synchronously but queue
+ the invalidation, coalescing pages and widening them to whole MMU indexes
+ when too many are queued. The queue is applied at the next TB boundary of
+ the engine, at the next uc_emu_start() or by uc_tlb_sync(), whichever comes
+ first. Queueing is thread-safe; uc_tlb_sync() must be called from the
+ thread running the engine or while it is stopped.
+
+ A DSB executed after broadcast TLB maintenance calls the function
+ registered with uc_register_tlb_cluster_sync(), which typically calls
+ uc_tlb_sync() on all engines of the cluster, and then applies the queue of
+ the engine itself.
+*/
+UNICORN_EXPORT // SNPS added
+uc_err uc_tlb_sync(uc_engine *uc);
+
+UNICORN_EXPORT // SNPS added
+uc_err uc_register_tlb_cluster_sync(uc_engine *uc,
+        uc_tlb_cluster_sync_t tlb_cluster_sync_fn);
+
 UNICORN_EXPORT // SNPS added
 uc_err uc_breakpoint_insert(uc_engine *uc, uint64_t addr);
 
@@ -934,6 +1140,34 @@ uc_err uc_setup_dmi(uc_engine *uc, void *opaque, uc_cb_dmiptr_t dmifn,
 UNICORN_EXPORT // SNPS added
 uc_err uc_dmi_invalidate(uc_engine *uc, uint64_t start, uint64_t end);
 
+// SNPS added: a physical address range [start, end)
+typedef struct uc_dmi_range {
+    uint64_t start;
+    uint64_t end;
+} uc_dmi_range_t;
+
+/*
+ Invalidate the DMI pointers of several physical ranges at once, e.g. when
+ a device remaps its memory. The cost of both calls is proportional to the
+ number of pages invalidated, up to a limit beyond which every TLB entry in
+ use is checked once for all the ranges.
+*/
+UNICORN_EXPORT // SNPS added
+uc_err uc_dmi_invalidate_ranges(uc_engine *uc, const uc_dmi_range_t *ranges,
+                                size_t count);
+
+/*
+ Grant DMI for the physical range [start, end) up front: its pages are backed
+ by the host memory at ptr, with the UC_DMI_PROT_* permissions of prot. TLB
+ fills on non-RAM memory look the grants up first and call the DMI callback
+ of uc_setup_dmi() only outside them. A grant replaces the parts of earlier
+ grants it overlaps, uc_dmi_invalidate() and uc_dmi_invalidate_ranges()
+ revoke the grants in their ranges. start and end must be page aligned.
+*/
+UNICORN_EXPORT // SNPS added
+uc_err uc_dmi_grant(uc_engine *uc, uint64_t start, uint64_t end,
+                    unsigned char *ptr, int prot);
+
  // SNPS added
 typedef enum uc_hint {
     UC_HINT_NOP, /* unused! NOP currently generates no code! */
@@ -959,6 +1193,61 @@ UNICORN_EXPORT // SNPS added
 uc_err uc_setup_basic_block_trace(uc_engine *uc, void *opaque,
                                   uc_trace_basic_block_t fn);
 
+/*
+ Buffered basic block trace. Instead of calling a function for every block,
+ the generated code appends an entry to @buffer when it enters a block: the
+ PC, followed by the instruction count with UC_BB_TRACE_ICOUNT and by the
+ host time with UC_BB_TRACE_TIME, one uint64_t each. @buffer holds @size
+ uint64_t, at least one entry. The instruction count accumulates over all
+ runs since the trace was set up. @fn is called with the complete entries
+ when @buffer is full and when uc_emu_start() or uc_emu_resume() returns.
+ A NULL @fn turns the trace off.
+
+ uc_basic_block_trace_file() streams the same trace into the file @path,
+ which is written by a separate thread. Entries are delta encoded: after the
+ NUL terminated magic "UCBBT1" and the flags as ULEB128, every entry is the
+ zigzag encoded difference to the previous PC followed by the differences of
+ the other fields, all ULEB128. The file is complete when the trace is turned
+ off or the engine is closed. A NULL @path turns the trace off.
+
+ Either trace replaces the one of uc_setup_basic_block_trace(), and vice
+ versa. Engines sharing translations ("tbgroup") must use the same trace
+ setting.
+*/
+UNICORN_EXPORT // SNPS added
+uc_err uc_setup_basic_block_trace_buffer(uc_engine *uc, void *opaque,
+                                         uint64_t *buffer, size_t size,
+                                         int flags, uc_trace_buffer_t fn);
+
+UNICORN_EXPORT // SNPS added
+uc_err uc_basic_block_trace_file(uc_engine *uc, const char *path, int flags);
+
+/*
+ Memory access trace. The loads and stores translated inline append an entry
+ to @buffer: the virtual address and an info word (see UC_MEM_TRACE_SIZE()),
+ followed by the physical address with UC_MEM_TRACE_PADDR and by the value
+ with UC_MEM_TRACE_VALUE, one uint64_t each. @buffer holds @size uint64_t,
+ at least UC_MEM_TRACE_MIN_ENTRIES entries. @fn is called with the complete
+ entries when @buffer is full and when uc_emu_start() or uc_emu_resume()
+ returns. A NULL @fn turns the trace off. Accesses made by helpers, such as
+ page table walks or DC ZVA, are not traced.
+
+ Room for the accesses of a block is reserved when the block is entered, so
+ blocks are ended early if their accesses would not fit into @buffer.
+
+ uc_mem_trace_ranges() restricts the trace to the blocks starting in one of
+ @count ranges of code addresses, all blocks are traced if @count is 0. Like
+ the trace itself it is applied when blocks are translated and costs nothing
+ in blocks that are not traced.
+*/
+UNICORN_EXPORT // SNPS added
+uc_err uc_setup_mem_trace(uc_engine *uc, void *opaque, uint64_t *buffer,
+                          size_t size, int flags, uc_trace_buffer_t fn);
+
+UNICORN_EXPORT // SNPS added
+uc_err uc_mem_trace_ranges(uc_engine *uc, const uc_mem_trace_range_t *ranges,
+                           size_t count);
+
 UNICORN_EXPORT // SNPS added
 uc_err uc_reset_cpu(uc_engine *uc);
 
@@ -2715,6 +2715,9 @@
 #define tb_reset_jump tb_reset_jump_aarch64eb
 #define tb_set_jmp_target tb_set_jmp_target_aarch64eb
 #define tb_target_set_jmp_target tb_target_set_jmp_target_aarch64eb
+#define tb_warm tb_warm_aarch64eb
+#define tb_invalidate_virt_pc tb_invalidate_virt_pc_aarch64eb
+#define tb_invalidate_virt_range tb_invalidate_virt_range_aarch64eb
 #define tcg_accel_class_init tcg_accel_class_init_aarch64eb
 #define tcg_accel_type tcg_accel_type_aarch64eb
 #define tcg_add_param_i32 tcg_add_param_i32_aarch64eb
@@ -2746,6 +2749,7 @@
 #define tcg_emit_op tcg_emit_op_aarch64eb
 #define tcg_enabled tcg_enabled_aarch64eb
 #define tcg_exec_all tcg_exec_all_aarch64eb
+#define tcg_exec_attach tcg_exec_attach_aarch64eb
 #define tcg_exec_init tcg_exec_init_aarch64eb
 #define tcg_expand_vec_op tcg_expand_vec_op_aarch64eb
 #define tcg_find_helper tcg_find_helper_aarch64eb
@@ -3265,8 +3269,10 @@
 #define thumb2_logic_op thumb2_logic_op_aarch64eb
 #define ti925t_initfn ti925t_initfn_aarch64eb
 #define tlb_add_large_page tlb_add_large_page_aarch64eb
+#define tlb_destroy tlb_destroy_aarch64eb
 #define tlb_init tlb_init_aarch64eb
 #define tlb_flush tlb_flush_aarch64eb
+#define tlb_flush_asid_by_mmuidx tlb_flush_asid_by_mmuidx_aarch64eb
 #define tlb_flush_by_mmuidx tlb_flush_by_mmuidx_aarch64eb
 #define tlb_flush_entry tlb_flush_entry_aarch64eb
 #define tlb_flush_page tlb_flush_page_aarch64eb
@@ -3274,9 +3280,14 @@
 #define tlb_is_dirty_ram tlb_is_dirty_ram_aarch64eb
 #define tlb_reset_dirty tlb_reset_dirty_aarch64eb
 #define tlb_reset_dirty_range tlb_reset_dirty_range_aarch64eb
+#define tlb_set_asid_by_mmuidx tlb_set_asid_by_mmuidx_aarch64eb
 #define tlb_set_dirty tlb_set_dirty_aarch64eb
 #define tlb_set_page tlb_set_page_aarch64eb
 #define tlb_set_page_with_attrs tlb_set_page_with_attrs_aarch64eb
+#define tlb_stats tlb_stats_aarch64eb
+#define tlb_walk_host tlb_walk_host_aarch64eb
+#define tlb_walk_cache_lookup tlb_walk_cache_lookup_aarch64eb
+#define tlb_walk_cache_insert tlb_walk_cache_insert_aarch64eb
 #define tlb_vaddr_to_host tlb_vaddr_to_host_aarch64eb
 #define tlbi_aa64_asid_is_write tlbi_aa64_asid_is_write_aarch64eb
 #define tlbi_aa64_asid_write tlbi_aa64_asid_write_aarch64eb
@@ -3413,8 +3424,16 @@
 #define tlb_flush_page_all_cpus_synced tlb_flush_page_all_cpus_synced_aarch64eb
 #define tlb_flush_by_mmuidx_all_cpus_synced tlb_flush_by_mmuidx_all_cpus_synced_aarch64eb
 #define tlb_flush_page_by_mmuidx_all_cpus_synced tlb_flush_page_by_mmuidx_all_cpus_synced_aarch64eb
+#define tlb_flush_asid_by_mmuidx_all_cpus_synced tlb_flush_asid_by_mmuidx_all_cpus_synced_aarch64eb
 #define dmi_invalidate dmi_invalidate_aarch64eb
+#define dmi_invalidate_ranges dmi_invalidate_ranges_aarch64eb
 #define helper_trace_tb_entry helper_trace_tb_entry_aarch64eb
+#define helper_trace_bb_flush helper_trace_bb_flush_aarch64eb
+#define helper_trace_bb_time helper_trace_bb_time_aarch64eb
+#define helper_mem_trace_flush helper_mem_trace_flush_aarch64eb
+#define helper_uc_hook_code helper_uc_hook_code_aarch64eb
+#define cpu_insn_count cpu_insn_count_aarch64eb
+#define cpu_restore_callout_pc cpu_restore_callout_pc_aarch64eb
 #define ARM64_REGS_STORAGE_SIZE ARM64_REGS_STORAGE_SIZE_aarch64eb
 #define aa64_va_parameters aa64_va_parameters_aarch64eb
 #define aa64_va_parameters_both aa64_va_parameters_both_aarch64eb
@@ -3431,12 +3450,14 @@
 #define arm_v7m_mmu_idx_all arm_v7m_mmu_idx_all_aarch64eb
 #define arm_v7m_mmu_idx_for_secstate arm_v7m_mmu_idx_for_secstate_aarch64eb
 #define arm_v7m_mmu_idx_for_secstate_and_priv arm_v7m_mmu_idx_for_secstate_and_priv_aarch64eb
+#define arm_get_cpu_by_id arm_get_cpu_by_id_aarch64eb
 #define arm_hcr_el2_eff arm_hcr_el2_eff_aarch64eb
 #define arm_mmu_idx arm_mmu_idx_aarch64eb
 #define arm_mmu_idx_el arm_mmu_idx_el_aarch64eb
 #define arm_mmu_idx_to_el arm_mmu_idx_to_el_aarch64eb
 #define arm_register_pre_el_change_hook arm_register_pre_el_change_hook_aarch64eb
 #define arm_register_el_change_hook arm_register_el_change_hook_aarch64eb
+#define arm_rebuild_hflags arm_rebuild_hflags_aarch64eb
 #define arm_reset_cpu arm_reset_cpu_aarch64eb
 #define arm_sctlr arm_sctlr_aarch64eb
 #define arm_set_cpu_off arm_set_cpu_off_aarch64eb
@@ -3585,6 +3606,7 @@
 #define helper_gvec_usra_s helper_gvec_usra_s_aarch64eb
 #define helper_msr_i_daifclear helper_msr_i_daifclear_aarch64eb
 #define helper_msr_i_daifset helper_msr_i_daifset_aarch64eb
+#define helper_rebuild_hflags helper_rebuild_hflags_aarch64eb
 #define helper_msr_i_spsel helper_msr_i_spsel_aarch64eb
 #define helper_neon_addlp_s16 helper_neon_addlp_s16_aarch64eb
 #define helper_neon_addlp_s8 helper_neon_addlp_s8_aarch64eb
@@ -4539,5 +4561,6 @@
 #define write_fp_dreg write_fp_dreg_aarch64eb
 #define helper_sev helper_sev_aarch64eb
 #define helper_sevl helper_sevl_aarch64eb
+#define helper_tlb_sync helper_tlb_sync_aarch64eb
 #define helper_call_breakpoints helper_call_breakpoints_aarch64eb
 #endif
@@ -128,6 +128,7 @@ TranslationBlock *tb_htable_lookup(CPUState *cpu, target_ulong pc,
     TranslationBlock *tb, **tb_hash_head, **ptb1;
     uint32_t h;
     tb_page_addr_t phys_pc, phys_page1;
+    void *owner = tb_owner(cpu); // SNPS added
 
     /* find translated block using physical mappings */
     phys_pc = get_page_addr_code(env, pc);
@@ -146,6 +147,7 @@ TranslationBlock *tb_htable_lookup(CPUState *cpu, target_ulong pc,
             tb->page_addr[0] == phys_page1 &&
             tb->cs_base == cs_base &&
             tb->flags == flags &&
+            tb->owner == owner && // SNPS added
             (tb_cflags(tb) & (CF_HASH_MASK | CF_INVALID)) == cf_mask) {
             if (tb->page_addr[1] == -1) {
                 /* done, we have a match */
@@ -256,7 +258,8 @@ static inline TranslationBlock *tb_find(CPUState *cpu,
         /* Check if translation buffer has been flushed */
         if (cpu->tb_flushed) {
             cpu->tb_flushed = false;
-        } else if (!(tb_cflags(tb) & CF_INVALID)) {
+        } else if (!(tb_cflags(tb) & CF_INVALID) &&
+                   last_tb->owner == tb->owner) { // SNPS changed
             tb_add_jump(last_tb, tb_exit, tb);
         }
     }
@@ -485,6 +488,22 @@ static inline void cpu_loop_exec_tb(CPUState *cpu, TranslationBlock *tb,
             cpu_loop_exit(cpu);
         }
         break;
+#else // SNPS added
+        int64_t insns_left = cpu_neg(cpu)->insn_budget += tb->icount;
+        uc_bb_trace_t *trace = cpu->uc->bb_trace;
+        *last_tb = NULL;
+        if (trace && cpu->bb_trace_pos > trace->buffer) {
+            /* Drop the trace entry of the TB not entered */
+            cpu->bb_trace_pos -= trace->words;
+        }
+        if (insns_left > 0 && insns_left < tb->icount) {
+            /* Exact budget: the TB did not fit into the remaining budget
+             * and was not entered. Run the remaining instructions in a
+             * shorter TB, which is cached by its instruction count. */
+            cpu->cflags_next_tb = (tb_cflags(tb) & ~CF_COUNT_MASK) |
+                                  insns_left;
+        }
+        break;
 #endif
     }
     default:
@@ -556,10 +575,7 @@ int cpu_exec(struct uc_struct *uc, CPUState *cpu)
     env->invalid_error = UC_ERR_OK;
 
     atomic_set(&cpu->tcg_exit_req, 0); // SNPS added
-
-    // SNPS added
-    if (uc->emu_count == 1)
-        tb_flush(cpu);
+    smp_mb(); // SNPS added: order against the stop_request check below
 
     /* prepare setjmp context for exception handling */
     if (sigsetjmp(cpu->jmp_env, 0) != 0) {
@@ -578,12 +594,14 @@ int cpu_exec(struct uc_struct *uc, CPUState *cpu)
 #endif /* buggy compiler */
         // Unicorn: commented out
         //tb_lock_reset();
+        cpu->mem_hook_split = false; // SNPS added: left a split access
     }
 
     /* if an exception is pending, we execute it here */
     while (!cpu_handle_exception(uc, cpu, &ret)) {
-        // SNPS added
-        if (cpu->insn_count >= cpu->insn_limit) {
+        // SNPS added: a uc_emu_stop() from another thread (e.g. the timeout)
+        // that came before tcg_exit_req was cleared is only seen here
+        if (cpu_neg(cpu)->insn_budget <= 0 || atomic_read(&uc->stop_request)) {
             uc->stop_request = true;
             break;
         }
@@ -602,10 +620,24 @@ int cpu_exec(struct uc_struct *uc, CPUState *cpu)
                does not require tcg headers for cpu_common_reset.  */
             if (cflags == -1) {
                 cflags = curr_cflags(uc);
+                // SNPS added: single-step through one-instruction TBs; they
+                // are hashed by their count and cached next to normal TBs
+                if (uc->emu_count == 1)
+                    cflags |= 1;
             } else {
                 cpu->cflags_next_tb = -1;
             }
 
+            // SNPS added: deliver batched TLB shootdowns at TB boundaries
+            if (unlikely(uc->tlb_batch && atomic_read(&uc->tlb_batch->pending))) {
+                uc->tlb_batch_apply(uc);
+            }
+
+            // SNPS added: drop code and TLB entries made for changed hooks
+            if (unlikely(uc->hooks_changed)) {
+                uc_hooks_refresh(uc);
+            }
+
             tb = tb_find(cpu, last_tb, tb_exit, cflags);
             if (!tb) {   // invalid TB due to invalid code?
                 uc->invalid_error = UC_ERR_FETCH_UNMAPPED;
@@ -616,18 +648,12 @@ int cpu_exec(struct uc_struct *uc, CPUState *cpu)
             cpu_loop_exec_tb(cpu, tb, &last_tb, &tb_exit);
 
             // SNPS added
-            if (cpu->insn_count >= cpu->insn_limit)
+            if (cpu_neg(cpu)->insn_budget <= 0)
                 break;
         }
     }
 
     cc->cpu_exec_exit(cpu);
 
-    // Unicorn: flush JIT cache to because emulation might stop in
-    // the middle of translation, thus generate incomplete code.
-    // TODO: optimize this for better performance
-    if (uc->emu_count == 1) // SNPS added
-        tb_flush(cpu);
-
     return ret;
 }
@@ -62,19 +62,380 @@
 
 #define ALL_MMUIDX_BITS ((1 << NB_MMU_MODES) - 1)
 
+static inline size_t sizeof_tlb(CPUArchState *env, uintptr_t mmu_idx)
+{
+    return tlb_n_entries(env, mmu_idx) * sizeof(CPUTLBEntry);
+}
+
+static void tlb_window_reset(CPUTLBDesc *desc, int64_t ns,
+                             size_t max_entries)
+{
+    desc->window_begin_ns = ns;
+    desc->window_max_entries = max_entries;
+}
+
+// SNPS added: only the sets written since the last reset, most flushes
+// come before the victim tlb has filled up
+QEMU_BUILD_BUG_ON(CPU_VTLB_BITS > 6);
+
+static void tlb_victim_reset(CPUArchState *env, int mmu_idx)
+{
+    uint64_t used = env->tlb_d[mmu_idx].vtlb_used;
+
+    while (used) {
+        size_t vset = ctz64(used) * CPU_VTLB_WAYS;
+
+        used &= used - 1;
+        memset(&env->tlb_v_table[mmu_idx][vset], -1,
+               CPU_VTLB_WAYS * sizeof(CPUTLBEntry));
+        memset(&env->iotlb_v[mmu_idx][vset], 0,
+               CPU_VTLB_WAYS * sizeof(CPUIOTLBEntry));
+    }
+    env->tlb_d[mmu_idx].vtlb_used = 0;
+}
+
+// SNPS added: the reverse map node of a main (victim == false) or victim slot
+static inline CPUTLBRmap *tlb_rmap_node(CPUArchState *env, int mmu_idx,
+                                       bool victim, size_t index)
+{
+    return &env->tlb_rmap[mmu_idx][victim ? tlb_n_entries(env, mmu_idx) + index
+                                          : index];
+}
+
+static inline struct CPUTLBRmapHead *tlb_rmap_bucket(CPUArchState *env,
+                                                     hwaddr phys)
+{
+    return &env->tlb_rmap_hash[(phys >> TARGET_PAGE_BITS) &
+                               ((1 << CPU_TLB_RMAP_BITS) - 1)];
+}
+
+static inline void tlb_rmap_unlink(CPUTLBRmap *node)
+{
+    if (node->next.le_prev) {
+        QLIST_REMOVE(node, next);
+        node->next.le_prev = NULL;
+    }
+}
+
+// SNPS added: file a slot under the physical page it maps now. Flushes leave
+// the nodes linked, lookups skip the empty slots.
+static inline void tlb_rmap_set(CPUArchState *env, int mmu_idx, bool victim,
+                                size_t index, hwaddr phys)
+{
+    CPUTLBRmap *node = tlb_rmap_node(env, mmu_idx, victim, index);
+
+    tlb_rmap_unlink(node);
+    QLIST_INSERT_HEAD(tlb_rmap_bucket(env, phys), node, next);
+}
+
+// SNPS added: allocate the nodes of a mmu mode for its current size
+static void tlb_rmap_alloc(CPUArchState *env, int mmu_idx)
+{
+    size_t i, n = tlb_n_entries(env, mmu_idx) + CPU_VTLB_SIZE;
+
+    env->tlb_rmap[mmu_idx] = g_new0(CPUTLBRmap, n);
+    for (i = 0; i < n; i++) {
+        env->tlb_rmap[mmu_idx][i].mmu_idx = mmu_idx;
+    }
+}
+
+// SNPS added: must be called before the size of the mmu mode changes
+static void tlb_rmap_free(CPUArchState *env, int mmu_idx)
+{
+    size_t i, n = tlb_n_entries(env, mmu_idx) + CPU_VTLB_SIZE;
+
+    for (i = 0; i < n; i++) {
+        tlb_rmap_unlink(&env->tlb_rmap[mmu_idx][i]);
+    }
+    g_free(env->tlb_rmap[mmu_idx]);
+    env->tlb_rmap[mmu_idx] = NULL;
+}
+
 void tlb_init(CPUState *cpu)
 {
+    CPUArchState *env = cpu->env_ptr;
+    int64_t now = get_clock_realtime();
+    int i;
+
+    env->tlb_rmap_hash = g_new0(struct CPUTLBRmapHead,
+                                1 << CPU_TLB_RMAP_BITS); // SNPS added
+    for (i = 0; i < NB_MMU_MODES; i++) {
+        CPUTLBDesc *desc = &env->tlb_d[i];
+
+        memset(desc, 0, sizeof(*desc));
+        tlb_window_reset(desc, now, 0);
+#if TCG_TARGET_IMPLEMENTS_DYN_TLB // SNPS changed
+        {
+            size_t n_entries = 1 << CPU_TLB_DYN_DEFAULT_BITS;
+
+            env->tlb_mask[i] = (n_entries - 1) << CPU_TLB_ENTRY_BITS;
+            env->tlb_table[i] = g_new(CPUTLBEntry, n_entries);
+            env->iotlb[i] = g_new0(CPUIOTLBEntry, n_entries);
+        }
+#else
+        memset(env->iotlb[i], 0, sizeof(env->iotlb[0]));
+#endif
+        memset(env->tlb_table[i], -1, sizeof_tlb(env, i));
+        desc->vtlb_used = -1; // SNPS added: reset all sets
+        tlb_victim_reset(env, i);
+        tlb_rmap_alloc(env, i); // SNPS added
+        desc->large_page_addr = -1;
+        desc->large_page_mask = -1;
+    }
+}
+
+// SNPS added
+void tlb_destroy(CPUState *cpu)
+{
+    CPUArchState *env = cpu->env_ptr;
+    int i;
+
+    for (i = 0; i < NB_MMU_MODES; i++) {
+        tlb_rmap_free(env, i);
+#if TCG_TARGET_IMPLEMENTS_DYN_TLB
+        g_free(env->tlb_table[i]);
+        g_free(env->iotlb[i]);
+        env->tlb_table[i] = NULL;
+        env->iotlb[i] = NULL;
+#endif
+    }
+    g_free(env->tlb_rmap_hash);
+    env->tlb_rmap_hash = NULL;
+}
+
+/**
+ * tlb_mmu_resize_locked() - perform TLB resize bookkeeping; resize if necessary
+ * @env: CPU that owns the TLB
+ * @mmu_idx: MMU index of the TLB
+ *
+ * Called on full flushes.
+ *
+ * We have two main constraints when resizing a TLB: (1) we only resize it
+ * on a TLB flush (otherwise we'd have to take a perf hit by either rehashing
+ * the array or unnecessarily flushing it), which means we do not control how
+ * frequently the resizing can occur; (2) we don't have access to the guest's
+ * future scheduling decisions, and therefore have to decide the magnitude of
+ * the resize based on past observations.
+ *
+ * In general, a memory-hungry process can benefit greatly from an appropriately
+ * sized TLB, since a guest TLB miss is very expensive. This doesn't mean that
+ * we just have to make the TLB as large as possible; while an oversized TLB
+ * results in minimal TLB miss rates, it also takes longer to be flushed
+ * (flushes can be _very_ frequent), and the reduced locality can also hurt
+ * performance.
+ *
+ * To achieve near-optimal performance for all kinds of workloads, we:
+ *
+ * 1. Aggressively increase the size of the TLB when the use rate of the
+ * TLB being flushed is high, since it is likely that in the near future this
+ * memory-hungry process will execute again, and its memory hungriness will
+ * probably be similar.
+ *
+ * 2. Slowly reduce the size of the TLB as the use rate declines over a
+ * reasonably large time window. The rationale is that if in such a time window
+ * we have not observed a high TLB use rate, it is likely that we won't observe
+ * it in the near future. In that case, once a time window expires we downsize
+ * the TLB to match the maximum use rate observed in the window.
+ *
+ * 3. Try to keep the maximum use rate in a time window in the 30-70% range,
+ * since in that range performance is likely near-optimal. Recall that the TLB
+ * is direct mapped, so we want the use rate to be low (or at least not too
+ * high), since otherwise we are likely to have a significant amount of
+ * conflict misses.
+ */
+static void tlb_mmu_resize_locked(CPUArchState *env, int mmu_idx)
+{
+#if TCG_TARGET_IMPLEMENTS_DYN_TLB // SNPS added
+    CPUTLBDesc *desc = &env->tlb_d[mmu_idx];
+    size_t old_size = tlb_n_entries(env, mmu_idx);
+    size_t rate;
+    size_t new_size = old_size;
+    int64_t now = get_clock_realtime();
+    int64_t window_len_ms = 100;
+    int64_t window_len_ns = window_len_ms * 1000 * 1000;
+    bool window_expired = now > desc->window_begin_ns + window_len_ns;
+
+    if (desc->n_used_entries > desc->window_max_entries) {
+        desc->window_max_entries = desc->n_used_entries;
+    }
+    rate = desc->window_max_entries * 100 / old_size;
+
+    if (rate > 70) {
+        new_size = MIN(old_size << 1, 1 << CPU_TLB_DYN_MAX_BITS);
+    } else if (rate < 30 && window_expired) {
+        size_t ceil = pow2ceil(desc->window_max_entries);
+        size_t expected_rate = desc->window_max_entries * 100 / ceil;
+
+        /*
+         * Avoid undersizing when the max number of entries seen is just below
+         * a pow2. For instance, if max_entries == 1025, the expected use rate
+         * would be 1025/2048==50%. However, if max_entries == 1023, we'd get
+         * 1023/1024==99.9% use rate, so we'd likely end up doubling the size
+         * later. Thus, make sure that the expected use rate remains below 70%.
+         * (and since we double the size, that means the lowest rate we'd
+         * expect to get is 35%, which is still in the 30-70% range where
+         * we consider that the size is appropriate.)
+         */
+        if (expected_rate > 70) {
+            ceil *= 2;
+        }
+        new_size = MAX(ceil, 1 << CPU_TLB_DYN_MIN_BITS);
+    }
+
+    if (new_size == old_size) {
+        if (window_expired) {
+            tlb_window_reset(desc, now, desc->n_used_entries);
+        }
+        return;
+    }
+
+    tlb_rmap_free(env, mmu_idx); // SNPS added
+    g_free(env->tlb_table[mmu_idx]);
+    g_free(env->iotlb[mmu_idx]);
+
+    tlb_window_reset(desc, now, 0);
+    desc->resizes++;
+    /* desc->n_used_entries is cleared by the caller */
+    env->tlb_mask[mmu_idx] = (new_size - 1) << CPU_TLB_ENTRY_BITS;
+    env->tlb_table[mmu_idx] = g_try_malloc0(new_size * sizeof(CPUTLBEntry));
+    env->iotlb[mmu_idx] = g_try_malloc0(new_size * sizeof(CPUIOTLBEntry));
+    /*
+     * If the allocations fail, try smaller sizes. We just freed some
+     * memory, so going back to half of new_size has a good chance of working.
+     * Increased memory pressure elsewhere in the system might cause the
+     * allocations to fail though, so we progressively reduce the allocation
+     * size, aborting if we cannot even allocate the smallest TLB we support.
+     */
+    while (env->tlb_table[mmu_idx] == NULL || env->iotlb[mmu_idx] == NULL) {
+        if (new_size == (1 << CPU_TLB_DYN_MIN_BITS)) {
+            fprintf(stderr, "%s: %s\n", __func__, strerror(errno));
+            abort();
+        }
+        new_size = MAX(new_size >> 1, 1 << CPU_TLB_DYN_MIN_BITS);
+        env->tlb_mask[mmu_idx] = (new_size - 1) << CPU_TLB_ENTRY_BITS;
+
+        g_free(env->tlb_table[mmu_idx]);
+        g_free(env->iotlb[mmu_idx]);
+        env->tlb_table[mmu_idx] = g_try_malloc0(new_size * sizeof(CPUTLBEntry));
+        env->iotlb[mmu_idx] = g_try_malloc0(new_size * sizeof(CPUIOTLBEntry));
+    }
+    tlb_rmap_alloc(env, mmu_idx); // SNPS added
+#endif
 }
 
 static void tlb_flush_one_mmuidx_locked(CPUArchState *env, int mmu_idx)
 {
-    memset(env->tlb_table[mmu_idx], -1, sizeof(env->tlb_table[0]));
-    memset(env->tlb_v_table[mmu_idx], -1, sizeof(env->tlb_v_table[0]));
+    env->tlb_d[mmu_idx].flushes++; // SNPS added
+    tlb_mmu_resize_locked(env, mmu_idx); // SNPS added
+    memset(env->tlb_table[mmu_idx], -1, sizeof_tlb(env, mmu_idx));
+    tlb_victim_reset(env, mmu_idx); // SNPS changed
+    env->tlb_d[mmu_idx].n_used_entries = 0; // SNPS added
     env->tlb_d[mmu_idx].large_page_addr = -1;
     env->tlb_d[mmu_idx].large_page_mask = -1;
+    env->tlb_d[mmu_idx].n_large_pages = 0; // SNPS added
     env->tlb_d[mmu_idx].vindex = 0;
 }
 
+// SNPS added
+static inline bool tlb_entry_is_empty(const CPUTLBEntry *te)
+{
+    return te->addr_read == -1 && te->addr_write == -1 && te->addr_code == -1;
+}
+
+// SNPS added: the ways of the victim tlb set of a main tlb index
+static inline size_t tlb_vset(size_t index)
+{
+    return (index & ((1 << CPU_VTLB_BITS) - 1)) * CPU_VTLB_WAYS;
+}
+
+// SNPS added: the victim tlb slot an entry of the main tlb is evicted to
+static inline size_t tlb_victim_next(CPUArchState *env, int mmu_idx,
+                                     size_t index)
+{
+    CPUTLBDesc *desc = &env->tlb_d[mmu_idx];
+
+    desc->vtlb_used |= 1ull << (index & ((1 << CPU_VTLB_BITS) - 1));
+    return tlb_vset(index) + desc->vindex++ % CPU_VTLB_WAYS;
+}
+
+// SNPS added: whether an entry is visible in the address space @asid, the
+// global ones are shared by all address spaces of a virtual machine
+static inline bool tlb_asid_match(const CPUIOTLBEntry *io, uint32_t asid)
+{
+    return io->asid == asid ||
+           (!io->attrs.tlb_nonglobal && (io->asid >> 16) == (asid >> 16));
+}
+
+// SNPS added: the walk cache remembers the last level tables of page table
+// walks, so that a TLB miss only reads the last level descriptor. Entries
+// are keyed by the table base register, which includes the ASID and VMID,
+// and are dropped by the TLB flushes that architecturally invalidate walk
+// caches, i.e. all flushes of the TLBs they belong to.
+static inline CPUWalkCacheEntry *tlb_walk_cache_entry(CPUState *cpu,
+                                                      const CPUWalkCacheEntry *key)
+{
+    uint64_t h = key->prefix ^ (key->base >> 12) ^ key->regime;
+
+    return &cpu->walk_cache[(h ^ (h >> CPU_WALK_CACHE_BITS)) &
+                            (CPU_WALK_CACHE_SIZE - 1)];
+}
+
+// SNPS added: the entry for the walk described by the key fields of @key
+const CPUWalkCacheEntry *tlb_walk_cache_lookup(CPUState *cpu,
+                                               const CPUWalkCacheEntry *key)
+{
+    CPUWalkCacheEntry *e = tlb_walk_cache_entry(cpu, key);
+
+    if (e->idxmap && e->regime == key->regime && e->base == key->base &&
+        e->ctx == key->ctx && e->prefix == key->prefix &&
+        e->prefix_mask == key->prefix_mask && e->shift == key->shift) {
+        cpu->walk_cache_hits++;
+        return e;
+    }
+    cpu->walk_cache_misses++;
+    return NULL;
+}
+
+// SNPS added
+void tlb_walk_cache_insert(CPUState *cpu, const CPUWalkCacheEntry *entry)
+{
+    g_assert(entry->idxmap != 0);
+    *tlb_walk_cache_entry(cpu, entry) = *entry;
+    cpu->walk_cache_idxmap |= entry->idxmap;
+}
+
+// SNPS added: drop the entries of the TLBs in @idxmap whose input addresses
+// include @addr (any address if @any_addr) and, if @asid_only, of @asid
+static void tlb_walk_cache_flush_match(CPUState *cpu, uint16_t idxmap,
+                                       bool any_addr, uint64_t addr,
+                                       bool asid_only, uint32_t asid)
+{
+    uint16_t used = 0;
+    int i;
+
+    if (!(cpu->walk_cache_idxmap & idxmap)) {
+        return;
+    }
+    for (i = 0; i < CPU_WALK_CACHE_SIZE; i++) {
+        CPUWalkCacheEntry *e = &cpu->walk_cache[i];
+
+        if ((e->idxmap & idxmap) &&
+            (any_addr ||
+             ((addr >> e->shift) & e->prefix_mask) == e->prefix) &&
+            (!asid_only || e->asid == asid)) {
+            e->idxmap = 0;
+        }
+        used |= e->idxmap;
+    }
+    cpu->walk_cache_idxmap = used;
+}
+
+// SNPS added
+static void tlb_walk_cache_flush(CPUState *cpu, uint16_t idxmap)
+{
+    tlb_walk_cache_flush_match(cpu, idxmap, true, 0, false, 0);
+}
+
 static void tlb_flush_by_mmuidx_async_work(CPUState *cpu, run_on_cpu_data data)
 {
     CPUArchState *env = cpu->env_ptr;
@@ -88,6 +449,7 @@ static void tlb_flush_by_mmuidx_async_work(CPUState *cpu, run_on_cpu_data data)
             tlb_flush_one_mmuidx_locked(env, mmu_idx);
         }
     }
+    tlb_walk_cache_flush(cpu, mmu_idx_bitmask); // SNPS added
 
     cpu_tb_jmp_cache_clear(cpu);
 }
@@ -104,6 +466,87 @@ void tlb_flush(CPUState *cpu)
     tlb_flush_by_mmuidx(cpu, ALL_MMUIDX_BITS);
 }
 
+// SNPS added
+void tlb_set_asid_by_mmuidx(CPUState *cpu, uint32_t asid, uint16_t idxmap)
+{
+    CPUArchState *env = cpu->env_ptr;
+    bool changed = false;
+    int mmu_idx;
+
+    for (mmu_idx = 0; mmu_idx < NB_MMU_MODES; mmu_idx++) {
+        CPUTLBDesc *desc = &env->tlb_d[mmu_idx];
+        size_t i, n = tlb_n_entries(env, mmu_idx);
+
+        if (!(idxmap & (1 << mmu_idx)) || desc->asid == asid) {
+            continue;
+        }
+        tlb_debug("mmu_idx: %d asid: 0x%" PRIx32 "\n", mmu_idx, asid);
+        desc->asid = asid;
+        changed = true;
+
+        /* the fast path doesn't check tags, so move the entries of other
+           address spaces out of the main tlb */
+        for (i = 0; i < n; i++) {
+            CPUTLBEntry *te = &env->tlb_table[mmu_idx][i];
+            CPUIOTLBEntry *io = &env->iotlb[mmu_idx][i];
+            size_t vidx;
+
+            if (tlb_entry_is_empty(te) || tlb_asid_match(io, asid)) {
+                continue;
+            }
+            vidx = tlb_victim_next(env, mmu_idx, i);
+            env->tlb_v_table[mmu_idx][vidx] = *te;
+            env->iotlb_v[mmu_idx][vidx] = *io;
+            env->iotlb_v[mmu_idx][vidx].p2v = &env->tlb_v_table[mmu_idx][vidx];
+            tlb_rmap_set(env, mmu_idx, true, vidx, io->phys);
+            memset(te, -1, sizeof(*te));
+            desc->n_used_entries--;
+        }
+    }
+
+    if (changed) {
+        cpu_tb_jmp_cache_clear(cpu);
+    }
+}
+
+// SNPS added
+void tlb_flush_asid_by_mmuidx(CPUState *cpu, uint32_t asid, uint16_t idxmap)
+{
+    CPUArchState *env = cpu->env_ptr;
+    int mmu_idx;
+
+    tlb_debug("asid: 0x%" PRIx32 " mmu_idx: 0x%" PRIx16 "\n", asid, idxmap);
+
+    for (mmu_idx = 0; mmu_idx < NB_MMU_MODES; mmu_idx++) {
+        size_t i, n = tlb_n_entries(env, mmu_idx);
+
+        if (!(idxmap & (1 << mmu_idx))) {
+            continue;
+        }
+        env->tlb_d[mmu_idx].asid_flushes++;
+        for (i = 0; i < n; i++) {
+            CPUTLBEntry *te = &env->tlb_table[mmu_idx][i];
+            CPUIOTLBEntry *io = &env->iotlb[mmu_idx][i];
+
+            if (!tlb_entry_is_empty(te) &&
+                io->attrs.tlb_nonglobal && io->asid == asid) {
+                memset(te, -1, sizeof(*te));
+                env->tlb_d[mmu_idx].n_used_entries--;
+            }
+        }
+        for (i = 0; i < CPU_VTLB_SIZE; i++) {
+            CPUIOTLBEntry *io = &env->iotlb_v[mmu_idx][i];
+
+            if (io->attrs.tlb_nonglobal && io->asid == asid) {
+                memset(&env->tlb_v_table[mmu_idx][i], -1, sizeof(CPUTLBEntry));
+            }
+        }
+    }
+    tlb_walk_cache_flush_match(cpu, idxmap, true, 0, true, asid);
+
+    cpu_tb_jmp_cache_clear(cpu);
+}
+
 static inline bool tlb_hit_page_anyprot(CPUTLBEntry *tlb_entry,
                                         target_ulong page)
 {
@@ -134,27 +577,104 @@ static inline bool tlb_flush_entry_locked(CPUTLBEntry *tlb_entry,
 static inline void tlb_flush_vtlb_page_locked(CPUArchState *env, int mmu_idx,
                                               target_ulong page)
 {
+    size_t vset = tlb_vset(tlb_index(env, mmu_idx, page)); // SNPS changed
     int k;
     //assert_cpu_is_self(env_cpu(env));
-    for (k = 0; k < CPU_VTLB_SIZE; k++) {
-        tlb_flush_entry_locked(&env->tlb_v_table[mmu_idx][k], page);
+    for (k = 0; k < CPU_VTLB_WAYS; k++) {
+        tlb_flush_entry_locked(&env->tlb_v_table[mmu_idx][vset + k], page);
+    }
+}
+
+// SNPS added: whether @addr lies within the large page @lp
+static inline bool tlb_large_page_hit(const CPUTLBLargePage *lp,
+                                      target_ulong addr)
+{
+#ifdef TARGET_AARCH64
+    const uint64_t mask = 0x00fffffffffffffful; // ignore top byte
+    return ((addr ^ lp->addr) & lp->mask & mask) == 0;
+#else
+    return ((addr ^ lp->addr) & lp->mask) == 0;
+#endif
+}
+
+// SNPS added
+static inline bool tlb_entry_in_large_page(CPUTLBEntry *te,
+                                           const CPUTLBLargePage *lp)
+{
+    return (te->addr_read != -1 && tlb_large_page_hit(lp, te->addr_read)) ||
+           (tlb_addr_write(te) != -1 &&
+            tlb_large_page_hit(lp, tlb_addr_write(te))) ||
+           (te->addr_code != -1 && tlb_large_page_hit(lp, te->addr_code));
+}
+
+// SNPS added: flush the entries of the pages of a large page, page by page
+// if it has no more pages than the main tlb has entries, else by a scan of
+// the main and victim tlbs
+static void tlb_flush_large_page_locked(CPUArchState *env, int midx,
+                                        const CPUTLBLargePage *lp)
+{
+    target_ulong pages = (~lp->mask >> TARGET_PAGE_BITS) + 1;
+    size_t i, n = tlb_n_entries(env, midx);
+
+    if (pages <= n) {
+        for (i = 0; i < pages; i++) {
+            target_ulong page = lp->addr + ((target_ulong)i << TARGET_PAGE_BITS);
+
+            if (tlb_flush_entry_locked(tlb_entry(env, midx, page), page)) {
+                env->tlb_d[midx].n_used_entries--;
+            }
+            tlb_flush_vtlb_page_locked(env, midx, page);
+        }
+        return;
+    }
+    for (i = 0; i < n; i++) {
+        CPUTLBEntry *te = &env->tlb_table[midx][i];
+
+        if (tlb_entry_in_large_page(te, lp)) {
+            memset(te, -1, sizeof(*te));
+            env->tlb_d[midx].n_used_entries--;
+        }
+    }
+    for (i = 0; i < CPU_VTLB_SIZE; i++) {
+        CPUTLBEntry *te = &env->tlb_v_table[midx][i];
+
+        if (tlb_entry_in_large_page(te, lp)) {
+            memset(te, -1, sizeof(*te));
+        }
     }
 }
 
 static void tlb_flush_page_locked(CPUArchState *env, int midx,
                                   target_ulong page)
 {
+    CPUTLBDesc *desc = &env->tlb_d[midx]; // SNPS added
     target_ulong lp_addr = env->tlb_d[midx].large_page_addr;
     target_ulong lp_mask = env->tlb_d[midx].large_page_mask;
+    int i; // SNPS added
+
+    desc->page_flushes++; // SNPS added
 
     /* Check if we need to flush due to large pages.  */
     if ((page & lp_mask) == lp_addr) {
         tlb_debug("forcing full flush midx %d ("
                   TARGET_FMT_lx "/" TARGET_FMT_lx ")\n",
                   midx, lp_addr, lp_mask);
+        desc->forced_flushes++; // SNPS added
         tlb_flush_one_mmuidx_locked(env, midx);
     } else {
-        tlb_flush_entry_locked(tlb_entry(env, midx, page), page);
+        // SNPS added: drop the tracked large pages covering the page
+        for (i = 0; i < desc->n_large_pages; ) {
+            if (tlb_large_page_hit(&desc->large_pages[i], page)) {
+                desc->large_page_flushes++;
+                tlb_flush_large_page_locked(env, midx, &desc->large_pages[i]);
+                desc->large_pages[i] = desc->large_pages[--desc->n_large_pages];
+            } else {
+                i++;
+            }
+        }
+        if (tlb_flush_entry_locked(tlb_entry(env, midx, page), page)) {
+            env->tlb_d[midx].n_used_entries--; // SNPS added
+        }
         tlb_flush_vtlb_page_locked(env, midx, page);
     }
 }
@@ -171,6 +691,8 @@ static void tlb_flush_page_async_work(CPUState *cpu, run_on_cpu_data data)
     for (mmu_idx = 0; mmu_idx < NB_MMU_MODES; mmu_idx++) {
         tlb_flush_page_locked(env, mmu_idx, addr);
     }
+    tlb_walk_cache_flush_match(cpu, ALL_MMUIDX_BITS, false, addr,
+                               false, 0); // SNPS added
 
     tb_flush_jmp_cache(cpu, addr);
 }
@@ -197,6 +719,8 @@ static void tlb_flush_page_by_mmuidx_async_work(CPUState *cpu,
             tlb_flush_page_locked(env, mmu_idx, addr);
         }
     }
+    tlb_walk_cache_flush_match(cpu, mmu_idx_bitmap, false, addr,
+                               false, 0); // SNPS added
 
     tb_flush_jmp_cache(cpu, addr);
 }
@@ -250,6 +774,13 @@ void tlb_flush_page_by_mmuidx_all_cpus_synced(CPUState *cpu, target_ulong addr,
     uc->tlb_cluster_flush_page_mmuidx(cpu, addr, idxmap);
 }
 
+// SNPS added
+void tlb_flush_asid_by_mmuidx_all_cpus_synced(CPUState *cpu, uint32_t asid, uint16_t idxmap) {
+    uc_engine *uc = cpu->uc;
+    g_assert(uc->tlb_cluster_flush_asid_mmuidx != NULL);
+    uc->tlb_cluster_flush_asid_mmuidx(cpu, asid, idxmap);
+}
+
 /*
  * Dirty write flag handling
  *
@@ -307,9 +838,9 @@ void tlb_reset_dirty(CPUState *cpu, ram_addr_t start1, ram_addr_t length)
 
     env = cpu->env_ptr;
     for (mmu_idx = 0; mmu_idx < NB_MMU_MODES; mmu_idx++) {
-        unsigned int i;
+        size_t i, n = tlb_n_entries(env, mmu_idx); // SNPS changed
 
-        for (i = 0; i < CPU_TLB_SIZE; i++) {
+        for (i = 0; i < n; i++) {
             tlb_reset_dirty_range_locked(&env->tlb_table[mmu_idx][i], start1,
                                          length);
         }
@@ -343,20 +874,41 @@ void tlb_set_dirty(CPUState *cpu, target_ulong vaddr)
     }
 
     for (mmu_idx = 0; mmu_idx < NB_MMU_MODES; mmu_idx++) {
+        size_t vset = tlb_vset(tlb_index(env, mmu_idx, vaddr)); // SNPS changed
         int k;
-        for (k = 0; k < CPU_VTLB_SIZE; k++) {
-            tlb_set_dirty1_locked(&env->tlb_v_table[mmu_idx][k], vaddr);
+        for (k = 0; k < CPU_VTLB_WAYS; k++) {
+            tlb_set_dirty1_locked(&env->tlb_v_table[mmu_idx][vset + k], vaddr);
         }
     }
 }
 
 /* Our TLB does not support large pages, so remember the area covered by
-   large pages and trigger a full TLB flush if these are invalidated.  */
+   large pages and trigger a full TLB flush if these are invalidated.
+   SNPS changed: the first CPU_TLB_LARGE_PAGES large pages are remembered
+   one by one, their invalidation only flushes their own pages.  */
 static void tlb_add_large_page(CPUArchState *env, int mmu_idx,
                                target_ulong vaddr, target_ulong size)
 {
+    CPUTLBDesc *desc = &env->tlb_d[mmu_idx]; // SNPS added
     target_ulong lp_addr = env->tlb_d[mmu_idx].large_page_addr;
     target_ulong lp_mask = ~(size - 1);
+    int i; // SNPS added
+
+    // SNPS added
+    if ((vaddr & env->tlb_d[mmu_idx].large_page_mask) == lp_addr) {
+        return;
+    }
+    for (i = 0; i < desc->n_large_pages; i++) {
+        if (tlb_large_page_hit(&desc->large_pages[i], vaddr)) {
+            return;
+        }
+    }
+    if (desc->n_large_pages < CPU_TLB_LARGE_PAGES) {
+        desc->large_pages[desc->n_large_pages].addr = vaddr & lp_mask;
+        desc->large_pages[desc->n_large_pages].mask = lp_mask;
+        desc->n_large_pages++;
+        return;
+    }
 
     if (lp_addr == (target_ulong)-1) {
         /* No previous large page.  */
@@ -394,11 +946,11 @@ void tlb_set_page_with_attrs(CPUState *cpu, target_ulong vaddr,
     CPUTLBEntry *te;
     hwaddr iotlb, xlat, sz, paddr_page;
     target_ulong vaddr_page;
-    unsigned vidx = env->tlb_d[mmu_idx].vindex++ % CPU_VTLB_SIZE;
     int asidx = cpu_asidx_from_attrs(cpu, attrs);
     int wp_flags;
     int newprot = prot; // SNPS added
     unsigned char* dmiptr = NULL; // SNPS added
+    uc_hook_list_t *hooks; // SNPS added
 
     if (size <= TARGET_PAGE_SIZE) {
         sz = TARGET_PAGE_SIZE;
@@ -430,8 +982,16 @@ void tlb_set_page_with_attrs(CPUState *cpu, target_ulong vaddr,
         !memory_region_is_romd(section->mr)) {
         /* IO memory case */
         // SNPS added: DMI/b_transport handling
-        if (env->uc->get_dmi_ptr != NULL &&
-            env->uc->get_dmi_ptr(env->uc->dmi_opaque, paddr_page, &dmiptr, &newprot)) {
+        // SNPS changed: granted ranges first, the callback for the others
+        bool dmi = uc_dmi_lookup(env->uc, paddr_page, &dmiptr, &newprot);
+        if (dmi) {
+            env->tlb_d[mmu_idx].dmi_grants++;
+        } else if (env->uc->get_dmi_ptr != NULL) {
+            env->tlb_d[mmu_idx].dmi_callbacks++;
+            dmi = env->uc->get_dmi_ptr(env->uc->dmi_opaque, paddr_page,
+                                       &dmiptr, &newprot);
+        }
+        if (dmi) {
             addend = (uintptr_t)dmiptr;
             prot = prot & newprot; // don't take more than we're allowed to
         } else {
@@ -449,12 +1009,33 @@ void tlb_set_page_with_attrs(CPUState *cpu, target_ulong vaddr,
     wp_flags = cpu_watchpoint_address_matches(cpu, vaddr_page,
                                               TARGET_PAGE_SIZE);
 
+    // SNPS added: pages with memory hooks take the slow path like watchpoints
+    hooks = uc_hook_list_get(cpu->uc, UC_HOOK_MEM_READ | UC_HOOK_MEM_WRITE |
+                             UC_HOOK_MEM_READ_AFTER, vaddr_page,
+                             vaddr_page + TARGET_PAGE_SIZE - 1);
+    if (hooks) {
+        if (hooks->types & (UC_HOOK_MEM_READ | UC_HOOK_MEM_READ_AFTER)) {
+            wp_flags |= BP_MEM_READ;
+        }
+        if (hooks->types & UC_HOOK_MEM_WRITE) {
+            wp_flags |= BP_MEM_WRITE;
+        }
+    }
+
     index = tlb_index(env, mmu_idx, vaddr_page);
     te = tlb_entry(env, mmu_idx, vaddr_page);
 
-    /* do not discard the translation in te, evict it into a victim tlb */
-    env->tlb_v_table[mmu_idx][vidx] = *te;
-    env->iotlb_v[mmu_idx][vidx] = env->iotlb[mmu_idx][index];
+    // SNPS changed: only evict the old entry into the victim tlb if it's for
+    // a different page, otherwise just overwrite the stale data
+    if (tlb_entry_is_empty(te)) {
+        env->tlb_d[mmu_idx].n_used_entries++;
+    } else if (!tlb_hit_page_anyprot(te, vaddr_page)) {
+        unsigned vidx = tlb_victim_next(env, mmu_idx, index);
+        env->tlb_v_table[mmu_idx][vidx] = *te;
+        env->iotlb_v[mmu_idx][vidx] = env->iotlb[mmu_idx][index];
+        env->iotlb_v[mmu_idx][vidx].p2v = &env->tlb_v_table[mmu_idx][vidx];
+        tlb_rmap_set(env, mmu_idx, true, vidx, env->iotlb_v[mmu_idx][vidx].phys);
+    }
 
     /* refill the tlb */
     /*
@@ -475,6 +1056,9 @@ void tlb_set_page_with_attrs(CPUState *cpu, target_ulong vaddr,
     // SNPS added: link iotlb back to tlb to enable dmi
     env->iotlb[mmu_idx][index].phys = paddr_page;
     env->iotlb[mmu_idx][index].p2v = te;
+    env->iotlb[mmu_idx][index].asid = env->tlb_d[mmu_idx].asid;
+    env->iotlb[mmu_idx][index].hooks = hooks; // SNPS added
+    tlb_rmap_set(env, mmu_idx, false, index, paddr_page);
 
     te->addend = addend - vaddr_page;
     if (prot & PAGE_READ) {
@@ -568,14 +1152,17 @@ static inline target_ulong tlb_read_ofs(CPUTLBEntry *entry, size_t ofs)
 static bool victim_tlb_hit(CPUArchState *env, size_t mmu_idx, size_t index,
                            size_t elt_ofs, target_ulong page)
 {
-    size_t vidx;
-    for (vidx = 0; vidx < CPU_VTLB_SIZE; ++vidx) {
+    size_t vidx, vset = tlb_vset(index); // SNPS changed
+    env->tlb_d[mmu_idx].misses++; // SNPS added
+    for (vidx = vset; vidx < vset + CPU_VTLB_WAYS; ++vidx) {
         CPUTLBEntry *vtlb = &env->tlb_v_table[mmu_idx][vidx];
 
         /* elt_ofs might correspond to .addr_write, so use atomic_read */
         target_ulong cmp = tlb_read_ofs(vtlb, elt_ofs);
 
-        if (cmp == page) {
+        // SNPS changed: the victim tlb holds other address spaces, too
+        if (cmp == page && tlb_asid_match(&env->iotlb_v[mmu_idx][vidx],
+                                          env->tlb_d[mmu_idx].asid)) {
             /* Found entry in victim tlb, swap tlb and iotlb.  */
             CPUTLBEntry tmptlb, *tlb = &env->tlb_table[mmu_idx][index];
 
@@ -586,6 +1173,15 @@ static bool victim_tlb_hit(CPUArchState *env, size_t mmu_idx, size_t index,
             CPUIOTLBEntry tmpio, *io = &env->iotlb[mmu_idx][index];
             CPUIOTLBEntry *vio = &env->iotlb_v[mmu_idx][vidx];
             tmpio = *io; *io = *vio; *vio = tmpio;
+            // SNPS added: keep the links back to the swapped tlb entries
+            io->p2v = tlb;
+            vio->p2v = vtlb;
+            tlb_rmap_set(env, mmu_idx, false, index, io->phys);
+            tlb_rmap_set(env, mmu_idx, true, vidx, vio->phys);
+            if (tlb_entry_is_empty(vtlb)) {
+                env->tlb_d[mmu_idx].n_used_entries++;
+            }
+            env->tlb_d[mmu_idx].victim_hits++;
             return true;
         }
     }
@@ -708,7 +1304,11 @@ static uint64_t io_readx(CPUArchState *env, CPUIOTLBEntry *iotlbentry,
     cpu->mem_io_vaddr = addr;
     cpu->mem_io_access_type = access_type;
 
+    cpu->callout_pc = retaddr; // SNPS added
+    cpu->callout_lazy_pc = true; // SNPS added
     r = memory_region_dispatch_read(mr, mr_offset, &val, op, iotlbentry->attrs);
+    cpu->callout_lazy_pc = false; // SNPS added
+    cpu->callout_pc = 0; // SNPS added
     if (r != MEMTX_OK) {
         hwaddr physaddr = mr_offset +
             section->offset_within_address_space -
@@ -743,7 +1343,11 @@ static void io_writex(CPUArchState *env, CPUIOTLBEntry *iotlbentry,
     }
     cpu->mem_io_vaddr = addr;
     cpu->mem_io_pc = retaddr;
+    cpu->callout_pc = retaddr; // SNPS added
+    cpu->callout_lazy_pc = true; // SNPS added
     r = memory_region_dispatch_write(mr, mr_offset, val, op, iotlbentry->attrs);
+    cpu->callout_lazy_pc = false; // SNPS added
+    cpu->callout_pc = 0; // SNPS added
     if (r != MEMTX_OK) {
         hwaddr physaddr = mr_offset +
             section->offset_within_address_space -
@@ -956,6 +1560,66 @@ static void *atomic_mmu_lookup(CPUArchState *env, target_ulong addr,
 typedef uint64_t FullLoadHelper(CPUArchState *env, target_ulong addr,
                                 TCGMemOpIdx oi, uintptr_t retaddr);
 
+// SNPS added: code is about to be translated from this page. The other
+// members of a sharing group execute the same TBs, so they protect it too.
+static void protect_dmi_page(CPUArchState *env, unsigned char *dmi,
+                             uint64_t phys)
+{
+    struct uc_struct *uc = env->uc, *m;
+
+    if (!uc->tb_group) {
+        if (uc->protect_dmi_ptr != NULL) {
+            uc->protect_dmi_ptr(uc->dmi_opaque, dmi, phys);
+        }
+        return;
+    }
+
+    QLIST_FOREACH(m, &uc->tb_group->members, tb_group_entry) {
+        if (m->protect_dmi_ptr != NULL) {
+            m->protect_dmi_ptr(m->dmi_opaque, dmi, phys);
+        }
+    }
+}
+
+// SNPS added: memory hooks see the PC of the access like device callbacks
+static void mem_hook(CPUArchState *env, uc_hook_list_t *hooks, int type,
+                     target_ulong addr, int size, uint64_t value,
+                     uintptr_t retaddr)
+{
+    CPUState *cpu = env_cpu(env);
+
+    cpu->callout_pc = retaddr;
+    cpu->callout_lazy_pc = true;
+    uc_hook_call_mem(hooks, type, addr, size, value);
+    cpu->callout_lazy_pc = false;
+    cpu->callout_pc = 0;
+}
+
+// SNPS added: the memory hooks of the second page of an access that crosses
+// from a page without hooks, which is reported once for the whole access
+static uc_hook_list_t *mem_hook_page2(CPUArchState *env, target_ulong addr,
+                                      int size, uintptr_t mmu_idx,
+                                      MMUAccessType access_type, size_t tlb_off,
+                                      uintptr_t retaddr)
+{
+    target_ulong page2 = (addr + size - 1) & TARGET_PAGE_MASK;
+    uintptr_t index2;
+    CPUTLBEntry *entry2;
+
+    if (page2 == (addr & TARGET_PAGE_MASK) || env_cpu(env)->mem_hook_split) {
+        return NULL;
+    }
+    index2 = tlb_index(env, mmu_idx, page2);
+    entry2 = tlb_entry(env, mmu_idx, page2);
+    if (!tlb_hit_page(tlb_read_ofs(entry2, tlb_off), page2) &&
+        !victim_tlb_hit(env, mmu_idx, index2, tlb_off, page2)) {
+        tlb_fill(env_cpu(env), page2, addr + size - page2, access_type,
+                 mmu_idx, retaddr);
+        index2 = tlb_index(env, mmu_idx, page2);
+    }
+    return env->iotlb[mmu_idx][index2].hooks;
+}
+
 static inline uint64_t __attribute__((always_inline))
 load_helper(CPUArchState *env, target_ulong addr, TCGMemOpIdx oi,
             uintptr_t retaddr, MemOp op, bool code_read, bool is_softmmu_access,
@@ -976,6 +1640,8 @@ load_helper(CPUArchState *env, target_ulong addr, TCGMemOpIdx oi,
     int error_code;
     struct hook *hook;
     bool handled;
+    uc_hook_list_t *hooks = NULL; // SNPS added
+    bool split; // SNPS added
     HOOK_FOREACH_VAR_DECLARE;
 
 #if 0 // SNPS added
@@ -1105,26 +1771,31 @@ load_helper(CPUArchState *env, target_ulong addr, TCGMemOpIdx oi,
         entry->addr_code &= ~TLB_NOTPROTECTED;
         tlb_addr = entry->addr_code;
 
-        if (env->uc->protect_dmi_ptr != NULL) {
+        {
             CPUIOTLBEntry *iotlbentry = &env->iotlb[mmu_idx][index];
             uint64_t phys = iotlbentry->phys & TARGET_PAGE_MASK;
             uintptr_t host = (uintptr_t)addr + entry->addend;
             unsigned char* dmi = (unsigned char*)(host & TARGET_PAGE_MASK);
-            env->uc->protect_dmi_ptr(env->uc->dmi_opaque, dmi, phys);
+            protect_dmi_page(env, dmi, phys); // SNPS changed
         }
     }
 
     /* Handle anything that isn't just a straight memory access.  */
     if (unlikely(tlb_addr & ~TARGET_PAGE_MASK)) {
-        CPUIOTLBEntry *iotlbentry;
+        CPUIOTLBEntry *iotlbentry = &env->iotlb[mmu_idx][index]; // SNPS changed
+
+        // SNPS added: memory hooks of the page, once for the whole access
+        if (unlikely(iotlbentry->hooks != NULL) && !code_read &&
+            !env_cpu(env)->mem_hook_split) {
+            hooks = iotlbentry->hooks;
+            mem_hook(env, hooks, UC_MEM_READ, addr, size, 0, retaddr);
+        }
 
         /* For anything that is unaligned, recurse through full_load.  */
         if ((addr & (size - 1)) != 0) {
             goto do_unaligned_access;
         }
 
-        iotlbentry = &env->iotlb[mmu_idx][index];
-
         /* Handle watchpoints.  */
         if (unlikely(tlb_addr & TLB_WATCHPOINT)) {
             /* On watchpoint hit, this will longjmp out.  */
@@ -1132,15 +1803,16 @@ load_helper(CPUArchState *env, target_ulong addr, TCGMemOpIdx oi,
                                  iotlbentry->attrs, BP_MEM_READ, retaddr, 0); // SNPS changed
 
             /* The backing page may or may not require I/O.  */
-            //tlb_addr &= ~TLB_WATCHPOINT; // SNPS changed, never goto
+            tlb_addr &= ~TLB_WATCHPOINT; // SNPS changed: RAM pages directly
             if ((tlb_addr & ~TARGET_PAGE_MASK) == 0) {
                 goto do_aligned_access;
             }
         }
 
         /* Handle I/O access.  */
-        return io_readx(env, iotlbentry, mmu_idx, addr,
-                        retaddr, access_type, op);
+        res = io_readx(env, iotlbentry, mmu_idx, addr,
+                       retaddr, access_type, op); // SNPS changed
+        goto finished;
     }
 
     /* Handle slow unaligned access (it spans two pages or IO).  */
@@ -1153,8 +1825,19 @@ load_helper(CPUArchState *env, target_ulong addr, TCGMemOpIdx oi,
     do_unaligned_access:
         addr1 = addr & ~((target_ulong)size - 1);
         addr2 = addr1 + size;
+        // SNPS added: from a page without hooks into a hooked one
+        if (hooks == NULL && !code_read) {
+            hooks = mem_hook_page2(env, addr, size, mmu_idx, access_type,
+                                   tlb_off, retaddr);
+            if (hooks != NULL) {
+                mem_hook(env, hooks, UC_MEM_READ, addr, size, 0, retaddr);
+            }
+        }
+        split = env_cpu(env)->mem_hook_split; // SNPS added
+        env_cpu(env)->mem_hook_split = true; // SNPS added
         r1 = full_load(env, addr1, oi, retaddr);
         r2 = full_load(env, addr2, oi, retaddr);
+        env_cpu(env)->mem_hook_split = split; // SNPS added
         shift = (addr & (size - 1)) * 8;
 
         if (memop_big_endian(op)) {
@@ -1198,16 +1881,9 @@ load_helper(CPUArchState *env, target_ulong addr, TCGMemOpIdx oi,
 
 finished:
     // Unicorn: callback on successful read
-#if 0 // SNPS added
-    if (!code_read) {
-        HOOK_FOREACH(uc, hook, UC_HOOK_MEM_READ_AFTER) {
-            if (!HOOK_BOUND_CHECK(hook, addr)) {
-                continue;
-            }
-            ((uc_cb_hookmem_t)hook->callback)(env->uc, UC_MEM_READ_AFTER, addr, size, res, hook->user_data);
-        }
+    if (unlikely(hooks != NULL)) { // SNPS changed
+        mem_hook(env, hooks, UC_MEM_READ_AFTER, addr, size, res, retaddr);
     }
-#endif
 
     return res;
 }
@@ -1355,6 +2031,7 @@ store_helper(CPUArchState *env, target_ulong addr, uint64_t val,
     size_t size = memop_size(op);
     struct hook *hook;
     bool handled;
+    bool split; // SNPS added
     HOOK_FOREACH_VAR_DECLARE;
 
 #if 0 // SNPS added
@@ -1438,15 +2115,20 @@ store_helper(CPUArchState *env, target_ulong addr, uint64_t val,
 
     /* Handle anything that isn't just a straight memory access.  */
     if (unlikely(tlb_addr & ~TARGET_PAGE_MASK)) {
-        CPUIOTLBEntry *iotlbentry;
+        CPUIOTLBEntry *iotlbentry = &env->iotlb[mmu_idx][index]; // SNPS changed
+
+        // SNPS added: memory hooks of the page, once for the whole access
+        if (unlikely(iotlbentry->hooks != NULL) &&
+            !env_cpu(env)->mem_hook_split) {
+            mem_hook(env, iotlbentry->hooks, UC_MEM_WRITE, addr, size, val,
+                     retaddr);
+        }
 
         /* For anything that is unaligned, recurse through byte stores.  */
         if ((addr & (size - 1)) != 0) {
             goto do_unaligned_access;
         }
 
-        iotlbentry = &env->iotlb[mmu_idx][index];
-
         /* Handle watchpoints.  */
         if (unlikely(tlb_addr & TLB_WATCHPOINT)) {
             /* On watchpoint hit, this will longjmp out.  */
@@ -1454,7 +2136,7 @@ store_helper(CPUArchState *env, target_ulong addr, uint64_t val,
                                  iotlbentry->attrs, BP_MEM_WRITE, retaddr, val); // SNPS changed
 
             /* The backing page may or may not require I/O.  */
-            // tlb_addr &= ~TLB_WATCHPOINT; // SNPS changed, never goto
+            tlb_addr &= ~TLB_WATCHPOINT; // SNPS changed: RAM pages directly
             if ((tlb_addr & ~TARGET_PAGE_MASK) == 0) {
                 goto do_aligned_access;
             }
@@ -1511,11 +2193,21 @@ store_helper(CPUArchState *env, target_ulong addr, uint64_t val,
                                  BP_MEM_WRITE, retaddr, val); // SNPS changed
         }
 
+        // SNPS added: from a page without hooks into a hooked one
+        if (unlikely(env->iotlb[mmu_idx][index2].hooks != NULL) &&
+            env->iotlb[mmu_idx][index].hooks == NULL &&
+            !env_cpu(env)->mem_hook_split) {
+            mem_hook(env, env->iotlb[mmu_idx][index2].hooks, UC_MEM_WRITE,
+                     addr, size, val, retaddr);
+        }
+
         /*
          * XXX: not efficient, but simple.
          * This loop must go in the forward direction to avoid issues
          * with self-modifying code in Windows 64-bit.
          */
+        split = env_cpu(env)->mem_hook_split; // SNPS added
+        env_cpu(env)->mem_hook_split = true; // SNPS added
         for (i = 0; i < size; ++i) {
             uint8_t val8;
             if (memop_big_endian(op)) {
@@ -1527,6 +2219,7 @@ store_helper(CPUArchState *env, target_ulong addr, uint64_t val,
             }
             helper_ret_stb_mmu(env, addr + i, val8, oi, retaddr);
         }
+        env_cpu(env)->mem_hook_split = split; // SNPS added
         return;
     }
 
@@ -1750,29 +2443,220 @@ static target_ulong lookup_virt_addr(CPUIOTLBEntry* iotlbe) {
     return -1;
 }
 
-// SNPS added
-void dmi_invalidate(CPUState *cpu, uint64_t start, uint64_t end) {
+// SNPS added: invalidate the slot of a reverse map node if it maps a page
+// accepted by @match, only looking at the slots that are in use
+static void dmi_invalidate_node(CPUState *cpu, CPUTLBRmap *node,
+                                bool (*match)(hwaddr, const void *),
+                                const void *opaque)
+{
+    CPUArchState *env = cpu->env_ptr;
+    int mmu_idx = node->mmu_idx;
+    size_t n = tlb_n_entries(env, mmu_idx);
+    size_t index = node - env->tlb_rmap[mmu_idx];
+    bool victim = index >= n;
+    CPUTLBEntry *te = victim ? &env->tlb_v_table[mmu_idx][index - n]
+                             : &env->tlb_table[mmu_idx][index];
+    CPUIOTLBEntry *io = victim ? &env->iotlb_v[mmu_idx][index - n]
+                               : &env->iotlb[mmu_idx][index];
+    target_ulong vaddr;
+
+    if (tlb_entry_is_empty(te) || !match(io->phys, opaque)) {
+        return;
+    }
+
+    vaddr = lookup_virt_addr(io);
+    tlb_rmap_unlink(node);
+    memset(te, -1, sizeof(*te));
+    if (!victim) {
+        env->tlb_d[mmu_idx].n_used_entries--;
+    }
+    if (vaddr != -1) {
+        tb_flush_jmp_cache(cpu, vaddr);
+    }
+}
+
+static bool dmi_match_page(hwaddr phys, const void *opaque)
+{
+    return phys == *(const hwaddr *)opaque;
+}
+
+typedef struct DMIRanges {
+    const uc_dmi_range_t *ranges;
+    size_t count;
+} DMIRanges;
+
+// the ranges are sorted and disjoint
+static bool dmi_match_ranges(hwaddr phys, const void *opaque)
+{
+    const DMIRanges *r = opaque;
+    size_t lo = 0, hi = r->count;
+
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+
+        if (r->ranges[mid].end <= phys) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo < r->count && r->ranges[lo].start < phys + TARGET_PAGE_SIZE;
+}
+
+static int dmi_range_cmp(const void *a, const void *b)
+{
+    const uc_dmi_range_t *ra = a, *rb = b;
+
+    return ra->start < rb->start ? -1 : ra->start > rb->start;
+}
+
+// SNPS added: invalidate the tlb entries of the physical pages overlapping
+// any of the ranges [start, end). Small ranges only visit the hash buckets of
+// their pages, large ones are matched against every slot in use.
+void dmi_invalidate_ranges(CPUState *cpu, const uc_dmi_range_t *ranges,
+                           size_t count)
+{
     CPUArchState *env = cpu->env_ptr;
-    int mmu_idx, idx;
+    struct CPUTLBRmapHead *bucket;
+    CPUTLBRmap *node, *tmp;
+    uc_dmi_range_t *sorted;
+    DMIRanges r;
+    uint64_t pages = 0;
+    size_t i, j;
+
+    memset(cpu->walk_dmi, 0, sizeof(cpu->walk_dmi));
+    for (i = 0; i < count; i++) {
+        if (ranges[i].start == 0 && ranges[i].end == ~0ull) {
+            tlb_flush(cpu);
+            return;
+        }
+        if (ranges[i].end > ranges[i].start) {
+            pages += ((ranges[i].end - 1) >> TARGET_PAGE_BITS) -
+                     (ranges[i].start >> TARGET_PAGE_BITS) + 1;
+        }
+    }
 
-    if (start == 0 && end == ~0ull) {
-        tlb_flush(cpu);
+    if (pages <= (1 << CPU_TLB_RMAP_BITS)) {
+        for (i = 0; i < count; i++) {
+            hwaddr page = ranges[i].start & TARGET_PAGE_MASK;
+
+            if (ranges[i].end <= ranges[i].start) {
+                continue;
+            }
+            for (; page < ranges[i].end; page += TARGET_PAGE_SIZE) {
+                bucket = tlb_rmap_bucket(env, page);
+                QLIST_FOREACH_SAFE(node, bucket, next, tmp) {
+                    dmi_invalidate_node(cpu, node, dmi_match_page, &page);
+                }
+                if (page + TARGET_PAGE_SIZE < page) {
+                    break;
+                }
+            }
+        }
         return;
     }
 
-    for (mmu_idx = 0; mmu_idx < NB_MMU_MODES; mmu_idx++) {
-        for (idx = 0; idx < CPU_TLB_SIZE; idx++) {
-            CPUIOTLBEntry* entry = &env->iotlb[mmu_idx][idx];
-            target_ulong vaddr = lookup_virt_addr(entry);
-            if (entry->phys >= start && entry->phys < end && vaddr != -1)
-                tlb_flush_page(cpu, vaddr);
+    // merge the ranges for the binary search
+    sorted = g_new(uc_dmi_range_t, count);
+    for (i = j = 0; i < count; i++) {
+        if (ranges[i].end > ranges[i].start) {
+            sorted[j++] = ranges[i];
+        }
+    }
+    qsort(sorted, j, sizeof(*sorted), dmi_range_cmp);
+    r.ranges = sorted;
+    r.count = 0;
+    for (i = 0; i < j; i++) {
+        if (r.count && sorted[i].start <= sorted[r.count - 1].end) {
+            sorted[r.count - 1].end = MAX(sorted[r.count - 1].end,
+                                          sorted[i].end);
+        } else {
+            sorted[r.count++] = sorted[i];
         }
+    }
 
-        for (idx = 0; idx < CPU_VTLB_SIZE; idx++) {
-            CPUIOTLBEntry* entry = &env->iotlb_v[mmu_idx][idx];
-            target_ulong vaddr = lookup_virt_addr(entry);
-            if (entry->phys >= start && entry->phys < end && vaddr != -1)
-                tlb_flush_page(cpu, vaddr);
+    for (i = 0; i < (1 << CPU_TLB_RMAP_BITS); i++) {
+        QLIST_FOREACH_SAFE(node, &env->tlb_rmap_hash[i], next, tmp) {
+            dmi_invalidate_node(cpu, node, dmi_match_ranges, &r);
         }
     }
+    g_free(sorted);
+}
+
+// SNPS added
+void dmi_invalidate(CPUState *cpu, uint64_t start, uint64_t end) {
+    uc_dmi_range_t range = { start, end };
+
+    dmi_invalidate_ranges(cpu, &range, 1);
+}
+
+// SNPS added: host address of @addr for a page table walk, in RAM or in a
+// DMI page, or NULL if the access has to go through the memory API. DMI pages
+// are remembered until the next DMI invalidation.
+void *tlb_walk_host(CPUState *cpu, AddressSpace *as, hwaddr addr,
+                    bool is_write)
+{
+    struct uc_struct *uc = cpu->uc;
+    hwaddr page = addr & TARGET_PAGE_MASK;
+    CPUWalkDMI *e = &cpu->walk_dmi[(addr >> TARGET_PAGE_BITS) &
+                                   (CPU_WALK_DMI_SIZE - 1)];
+    hwaddr xlat, len = 1;
+    MemoryRegion *mr;
+    unsigned char *dmiptr;
+    int prot;
+
+    if (e->host && e->page == page && (!is_write || (e->prot & PAGE_WRITE))) {
+        cpu->walk_host++;
+        return e->host + (addr - page);
+    }
+
+    mr = address_space_translate(as, addr, &xlat, &len, is_write);
+    if (memory_region_is_ram(mr)) {
+        cpu->walk_host++;
+        return qemu_map_ram_ptr(uc, mr->ram_block, xlat);
+    }
+    if (memory_region_is_romd(mr)) {
+        return NULL;
+    }
+
+    if (uc_dmi_lookup(uc, page, &dmiptr, &prot) ||
+        (uc->get_dmi_ptr != NULL &&
+         uc->get_dmi_ptr(uc->dmi_opaque, page, &dmiptr, &prot))) {
+        if (!is_write || (prot & PAGE_WRITE)) {
+            e->page = page;
+            e->host = dmiptr;
+            e->prot = prot;
+            cpu->walk_host++;
+            return dmiptr + (addr - page);
+        }
+    }
+    cpu->walk_io++;
+    return NULL;
+}
+
+// SNPS added
+void tlb_stats(CPUState *cpu, uc_tlb_stats_t *stats)
+{
+    CPUArchState *env = cpu->env_ptr;
+    int mmu_idx;
+
+    memset(stats, 0, sizeof(*stats));
+    for (mmu_idx = 0; mmu_idx < NB_MMU_MODES; mmu_idx++) {
+        CPUTLBDesc *desc = &env->tlb_d[mmu_idx];
+        stats->misses += desc->misses;
+        stats->victim_hits += desc->victim_hits;
+        stats->flushes += desc->flushes;
+        stats->page_flushes += desc->page_flushes;
+        stats->large_page_flushes += desc->large_page_flushes;
+        stats->forced_flushes += desc->forced_flushes;
+        stats->asid_flushes += desc->asid_flushes;
+        stats->resizes += desc->resizes;
+        stats->dmi_grants += desc->dmi_grants;
+        stats->dmi_callbacks += desc->dmi_callbacks;
+        stats->entries += tlb_n_entries(env, mmu_idx);
+    }
+    stats->walk_host = cpu->walk_host;
+    stats->walk_io = cpu->walk_io;
+    stats->walk_cache_hits = cpu->walk_cache_hits;
+    stats->walk_cache_misses = cpu->walk_cache_misses;
 }
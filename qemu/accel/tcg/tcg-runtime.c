@@ -28,6 +28,7 @@
 #include "exec/helper-proto.h"
 #include "exec/cpu_ldst.h"
 #include "exec/exec-all.h"
+#include "qemu/timer.h" // SNPS added
 #include "exec/tb-lookup.h"
 
 /* 32-bit helpers */
@@ -177,9 +178,62 @@ void HELPER(trace_tb_entry)(CPUArchState *env, uint64_t pc)
     void* opaque = env->uc->uc_trace_bb_opaque;
 
     if (trace_func == NULL) {
+        // TB translated by another engine of a sharing group
+        if (env->uc->tb_group != NULL)
+            return;
         fprintf(stderr, "unicorn: missing trace function for tb@0x%lx\n", pc);
         abort();
     }
 
     (*trace_func)(opaque, pc);
 }
+
+// SNPS added: the trace buffer is full
+void HELPER(trace_bb_flush)(CPUArchState *env)
+{
+    uc_bb_trace_flush(env->uc, env_cpu(env));
+}
+
+// SNPS added
+uint64_t HELPER(trace_bb_time)(void)
+{
+    return get_clock();
+}
+
+// SNPS added: the memory trace buffer can't hold the accesses of the TB
+void HELPER(mem_trace_flush)(CPUArchState *env, uint64_t need)
+{
+    uc_mem_trace_flush(env->uc, env_cpu(env), need);
+}
+
+// SNPS added: call code or block hooks, see gen_uc_tracecode()
+void HELPER(uc_hook_code)(CPUArchState *env, void *hooks, uint64_t pc,
+                          uint32_t size)
+{
+    CPUState *cpu = env_cpu(env);
+    CPUClass *cc = CPU_GET_CLASS(cpu->uc, cpu);
+    bool stop;
+
+    cc->set_pc(cpu, pc);
+    cpu->callout_pc = GETPC();
+    /* A TB entered with less budget than its length must not run hooks
+       past the budget; stop before the instruction instead. */
+    if (cpu_neg(cpu)->insn_budget < 0 &&
+        cpu_insn_count(cpu) >= cpu->insn_limit) {
+        cpu->callout_pc = 0;
+        cpu_loop_exit_restore(cpu, GETPC());
+    }
+    stop = uc_hook_call_code(env->uc, hooks, pc, size);
+    if (stop) {
+        /* Leave before the instruction. A PC written by the hook
+           (quit_request) is kept, only the budget is given back. */
+        if (cpu->uc->quit_request) {
+            cpu_neg(cpu)->insn_budget = cpu->insn_limit - cpu_insn_count(cpu);
+            cpu->callout_pc = 0;
+            cpu_loop_exit(cpu);
+        }
+        cpu->callout_pc = 0;
+        cpu_loop_exit_restore(cpu, GETPC());
+    }
+    cpu->callout_pc = 0;
+}
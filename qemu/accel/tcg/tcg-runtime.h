@@ -323,3 +323,7 @@ DEF_HELPER_FLAGS_5(gvec_bitsel, TCG_CALL_NO_RWG, void, ptr, ptr, ptr, ptr, i32)
 
 // SNPS added
 DEF_HELPER_FLAGS_2(trace_tb_entry, TCG_CALL_NO_RWG, void, env, i64)
+DEF_HELPER_FLAGS_1(trace_bb_flush, TCG_CALL_NO_RWG, void, env)
+DEF_HELPER_FLAGS_0(trace_bb_time, TCG_CALL_NO_RWG_SE, i64)
+DEF_HELPER_FLAGS_2(mem_trace_flush, TCG_CALL_NO_RWG, void, env, i64)
+DEF_HELPER_4(uc_hook_code, void, env, ptr, i64, i32)
@@ -55,7 +55,9 @@
 #endif
 
 #include "exec/cputlb.h"
+#include "exec/cpu_ldst.h" // SNPS added
 #include "exec/tb-hash.h"
+#include "exec/tb-lookup.h" // SNPS added
 #include "translate-all.h"
 #include "qemu/timer.h"
 
@@ -141,6 +143,13 @@ typedef struct PageDesc {
 
 static TranslationBlock *tb_find_pc(struct uc_struct *uc, uintptr_t tc_ptr);
 
+// SNPS added: iterate over the engines whose vCPUs may execute TBs of the
+// translation context of @uc, i.e. all members of its sharing group
+#define TB_GROUP_FOREACH(uc, m)                                               \
+    for ((m) = (uc)->tb_group ? QLIST_FIRST(&(uc)->tb_group->members) : (uc); \
+         (m) != NULL;                                                         \
+         (m) = (uc)->tb_group ? QLIST_NEXT((m), tb_group_entry) : NULL)
+
 // Unicorn: for cleaning up memory later.
 void free_code_gen_buffer(struct uc_struct *uc);
 
@@ -355,6 +364,12 @@ found:
         cpu_neg(cpu)->icount_decr.u16.low += num_insns - i;
     }
 #endif
+    // SNPS added: the budget was counted down by the full TB length on
+    // entry, only account for the instructions that actually retired
+    if (reset_icount) {
+        cpu_neg(cpu)->insn_budget += num_insns - i;
+    }
+
     restore_state_to_opc(env, tb, data);
 
 #ifdef CONFIG_PROFILER
@@ -404,6 +419,75 @@ bool cpu_restore_state(CPUState *cpu, uintptr_t host_pc, bool will_exit)
     return r;
 }
 
+// SNPS added
+size_t cpu_insn_count(CPUState *cpu)
+{
+    TCGContext *tcg_ctx = cpu->uc->tcg_ctx;
+    uintptr_t searched_pc = cpu->callout_pc;
+    uintptr_t check_offset = searched_pc - (uintptr_t)tcg_ctx->code_gen_buffer;
+    size_t retired = cpu->insn_limit - cpu_neg(cpu)->insn_budget;
+    TranslationBlock *tb;
+    uintptr_t host_pc;
+    uint8_t *p;
+    int i, j;
+
+    /* Outside of host callbacks from generated code, the budget is exact */
+    if (!searched_pc || check_offset >= tcg_ctx->code_gen_buffer_size) {
+        return retired;
+    }
+
+    tb = tb_find_pc(cpu->uc, searched_pc);
+    if (!tb) {
+        return retired;
+    }
+
+    searched_pc -= GETPC_ADJ;
+    host_pc = (uintptr_t)tb->tc.ptr;
+    p = tb->tc.search;
+
+    /* Walk the insn_start data to find the instruction that issued the
+       callback; it and everything after it in this TB has not retired yet */
+    for (i = 0; i < tb->icount; ++i) {
+        for (j = 0; j < TARGET_INSN_START_WORDS; ++j) {
+            decode_sleb128(&p);
+        }
+        host_pc += decode_sleb128(&p);
+        if (host_pc > searched_pc) {
+            return retired - (tb->icount - i);
+        }
+    }
+
+    return retired;
+}
+
+// SNPS added
+void cpu_restore_callout_pc(CPUState *cpu)
+{
+    TCGContext *tcg_ctx = cpu->uc->tcg_ctx;
+    uintptr_t searched_pc = cpu->callout_pc;
+    uintptr_t check_offset = searched_pc - (uintptr_t)tcg_ctx->code_gen_buffer;
+    TranslationBlock *tb;
+#ifdef TARGET_ARM
+    CPUArchState *env = cpu->env_ptr;
+    uint32_t condexec_bits = env->condexec_bits;
+#endif
+
+    /* Hints store the PC of the next instruction themselves */
+    if (!cpu->callout_lazy_pc ||
+        check_offset >= tcg_ctx->code_gen_buffer_size) {
+        return;
+    }
+
+    tb = tb_find_pc(cpu->uc, searched_pc);
+    if (tb) {
+        cpu_restore_state_from_tb(cpu, tb, searched_pc, false);
+#ifdef TARGET_ARM
+        /* the TB continues, it resets the IT state itself at the end */
+        env->condexec_bits = condexec_bits;
+#endif
+    }
+}
+
 static void page_init(struct uc_struct *uc)
 {
     page_size_init(uc);
@@ -851,6 +935,22 @@ static inline void code_gen_alloc(struct uc_struct *uc, size_t tb_size)
 void tcg_exec_init(struct uc_struct *uc, unsigned long tb_size)
 {
     TCGContext *tcg_ctx;
+    uc_tb_group *group = uc->tb_group; // SNPS added
+
+    // SNPS added: later members of a sharing group reuse the translation
+    // context and page descriptors set up by the first one
+    if (group) {
+        uc_tb_group_lock(uc);
+        QLIST_INSERT_HEAD(&group->members, uc, tb_group_entry);
+        if (group->tcg_ctx) {
+            uc->tcg_ctx = group->tcg_ctx;
+            page_init(uc);
+            uc->l1_map = group->l1_map;
+            uc->l1_map_size = group->l1_map_size;
+            uc_tb_group_unlock(uc);
+            return;
+        }
+    }
 
     cpu_gen_init(uc);
     tcg_ctx = uc->tcg_ctx;
@@ -862,6 +962,24 @@ void tcg_exec_init(struct uc_struct *uc, unsigned long tb_size)
        initialize the prologue now.  */
     tcg_prologue_init(tcg_ctx);
 #endif
+
+    // SNPS added
+    if (group) {
+        page_find(uc, 0); // allocates the level 1 map
+        group->tcg_ctx = uc->tcg_ctx;
+        group->l1_map = uc->l1_map;
+        group->l1_map_size = uc->l1_map_size;
+        uc_tb_group_unlock(uc);
+    }
+}
+
+// SNPS added: make @uc the engine translating with its (maybe shared)
+// translation context. Called with the group lock held.
+void tcg_exec_attach(struct uc_struct *uc)
+{
+    TCGContext *tcg_ctx = uc->tcg_ctx;
+
+    tcg_ctx->uc = uc;
 }
 
 bool tcg_enabled(struct uc_struct *uc)
@@ -963,7 +1081,9 @@ static void page_flush_tb(struct uc_struct *uc)
 void tb_flush(CPUState *cpu)
 {
     struct uc_struct* uc = cpu->uc;
+    struct uc_struct* m;
     TCGContext *tcg_ctx = uc->tcg_ctx;
+    int i;
 
     if (DEBUG_TB_FLUSH_GATE) {
         printf("qemu: flush code_size=%td nb_tbs=%d avg_tb_size=%td\n",
@@ -977,11 +1097,17 @@ void tb_flush(CPUState *cpu)
         cpu_abort(cpu, "Internal error: code buffer overflow\n");
     }
 
-    cpu_tb_jmp_cache_clear(cpu);
-    atomic_mb_set(&cpu->tb_flushed, true);
+    // SNPS changed: all vCPUs of all engines sharing the context
+    TB_GROUP_FOREACH(uc, m) {
+        for (i = 0; i < m->num_cpus; i++) {
+            cpu_tb_jmp_cache_clear(m->cpus[i]);
+            atomic_mb_set(&m->cpus[i]->tb_flushed, true);
+        }
+    }
 
     tcg_ctx->tb_ctx.nb_tbs = 0;
     memset(tcg_ctx->tb_ctx.tb_phys_hash, 0, sizeof(tcg_ctx->tb_ctx.tb_phys_hash));
+    memset(tcg_ctx->tb_ctx.tb_virt_hash, 0, sizeof(tcg_ctx->tb_ctx.tb_virt_hash)); // SNPS added
     page_flush_tb(uc);
 
     tcg_ctx->code_gen_ptr = tcg_ctx->code_gen_buffer;
@@ -1141,10 +1267,12 @@ void tb_phys_invalidate(struct uc_struct *uc,
     TranslationBlock *tb, tb_page_addr_t page_addr)
 {
     TCGContext *tcg_ctx = uc->tcg_ctx;
-    CPUState *cpu = uc->cpu;
+    struct uc_struct *m;
+    TranslationBlock **ptb; // SNPS added
     PageDesc *p;
     uint32_t h;
     tb_page_addr_t phys_pc;
+    int i;
 
     atomic_set(&tb->cflags, tb->cflags | CF_INVALID);
 
@@ -1153,6 +1281,13 @@ void tb_phys_invalidate(struct uc_struct *uc,
     h = tb_hash_func(phys_pc, tb->pc, tb->flags, tb->cflags & CF_HASH_MASK);
     tb_hash_remove(&tcg_ctx->tb_ctx.tb_phys_hash[h], tb);
 
+    // SNPS added
+    ptb = &tcg_ctx->tb_ctx.tb_virt_hash[tb_virt_hash_func(tb->pc)];
+    while (*ptb != tb) {
+        ptb = &(*ptb)->virt_hash_next;
+    }
+    *ptb = tb->virt_hash_next;
+
     /* remove the TB from the page list */
     if (tb->page_addr[0] != page_addr) {
         p = page_find(uc, tb->page_addr[0] >> TARGET_PAGE_BITS);
@@ -1167,8 +1302,13 @@ void tb_phys_invalidate(struct uc_struct *uc,
 
     /* remove the TB from the hash list */
     h = tb_jmp_cache_hash_func(tb->pc);
-    if (atomic_read(&cpu->tb_jmp_cache[h]) == tb) {
-        atomic_set(&cpu->tb_jmp_cache[h], NULL);
+    TB_GROUP_FOREACH(uc, m) { // SNPS changed: all vCPUs share TBs
+        for (i = 0; i < m->num_cpus; i++) {
+            CPUState *cpu = m->cpus[i];
+            if (atomic_read(&cpu->tb_jmp_cache[h]) == tb) {
+                atomic_set(&cpu->tb_jmp_cache[h], NULL);
+            }
+        }
     }
 
     /* suppress this TB from the two jump lists */
@@ -1312,6 +1452,11 @@ static void tb_link_page(struct uc_struct *uc,
     tb->phys_hash_next = *ptb;
     *ptb = tb;
 
+    // SNPS added
+    ptb = &tcg_ctx->tb_ctx.tb_virt_hash[tb_virt_hash_func(tb->pc)];
+    tb->virt_hash_next = *ptb;
+    *ptb = tb;
+
 #ifdef CONFIG_USER_ONLY
     if (DEBUG_TB_CHECK_GATE) {
         tb_page_check();
@@ -1363,6 +1508,7 @@ TranslationBlock *tb_gen_code(CPUState *cpu,
     tb->cs_base = cs_base;
     tb->flags = flags;
     tb->cflags = cflags;
+    tb->owner = tb_owner(cpu); // SNPS added
     tcg_ctx->tb_cflags = cflags;
     assert(cflags & CF_PARALLEL); // SNPS added
  tb_overflow:
@@ -1379,17 +1525,6 @@ TranslationBlock *tb_gen_code(CPUState *cpu,
     gen_intermediate_code(cpu, tb, max_insns);
     tcg_ctx->cpu = NULL;
 
-    // Unicorn: FIXME: Needs to be amended to work with new TCG
-#if 0
-    // Unicorn: when tracing block, patch block size operand for callback
-    if (env->uc->size_arg != -1 && HOOK_EXISTS_BOUNDED(env->uc, UC_HOOK_BLOCK, tb->pc)) {
-        if (env->uc->block_full)    // block size is unknown
-            *(tcg_ctx->gen_opparam_buf + env->uc->size_arg) = 0;
-        else
-            *(tcg_ctx->gen_opparam_buf + env->uc->size_arg) = tb->size;
-    }
-#endif
-
     // UNICORN: Commented out
     //trace_translate_block(tb, tb->pc, tb->tc.ptr);
 
@@ -1521,9 +1656,60 @@ TranslationBlock *tb_gen_code(CPUState *cpu,
      * through the physical hash table and physical page list.
      */
     tb_link_page(cpu->uc, tb, phys_pc, phys_page2);
+
+    // SNPS added: record the block for the warm-start profile
+    if (env->uc->tb_profile_path && !(cflags & CF_NOCACHE)) {
+        uc_tb_key_t key = { phys_pc, phys_page2, pc, cs_base, flags, cflags };
+        uc_tb_profile_add(env->uc, &key);
+    }
+
     return tb;
 }
 
+// SNPS added: map a virtual page to a physical one for instruction fetches,
+// returns false if the page is not backed by RAM or DMI
+static bool tb_warm_map(CPUState *cpu, target_ulong vaddr, uint64_t paddr,
+                        int mmu_idx)
+{
+    CPUArchState *env = cpu->env_ptr;
+
+    tlb_set_page(cpu, vaddr, paddr & TARGET_PAGE_MASK, PAGE_READ | PAGE_EXEC,
+                 mmu_idx, TARGET_PAGE_SIZE);
+    return !(tlb_entry(env, mmu_idx, vaddr)->addr_code & TLB_MMIO);
+}
+
+// SNPS added: translate a block of a warm-start profile ahead of its first
+// execution. The virtual pages of the block are temporarily mapped to the
+// recorded physical ones, the caller flushes the TLB afterwards. Returns
+// true if the block was translated.
+bool tb_warm(CPUState *cpu, const uc_tb_key_t *key)
+{
+    CPUArchState *env = cpu->env_ptr;
+    int mmu_idx = cpu_mmu_index(env, true);
+    target_ulong pc = key->pc;
+    target_ulong page = pc & TARGET_PAGE_MASK;
+    uint32_t cflags = key->cflags & CF_HASH_MASK;
+
+    if (!(cflags & CF_PARALLEL) || pc != key->pc) {
+        return false;
+    }
+
+    if (!tb_warm_map(cpu, page, key->phys_pc, mmu_idx)) {
+        return false;
+    }
+    if (key->phys_page2 != (uint64_t)-1 &&
+        !tb_warm_map(cpu, page + TARGET_PAGE_SIZE, key->phys_page2, mmu_idx)) {
+        return false;
+    }
+
+    if (tb_htable_lookup(cpu, pc, key->cs_base, key->flags, cflags)) {
+        return false;
+    }
+
+    tb_gen_code(cpu, pc, key->cs_base, key->flags, cflags);
+    return true;
+}
+
 /*
  * Invalidate all TBs which intersect with the target physical address range
  * [start;end[. NOTE: start and end may refer to *different* physical pages.
@@ -1828,6 +2014,74 @@ void tb_invalidate_phys_addr(AddressSpace *as, hwaddr addr)
 }
 #endif /* !defined(CONFIG_USER_ONLY) */
 
+// SNPS added: can @tb carry the hooks and traces of @uc? Within a group,
+// those TBs are private to the engine or its vCPUs (see tb_owner()).
+static bool tb_owned_by(struct uc_struct *uc, TranslationBlock *tb)
+{
+    int i;
+
+    if (tb->owner == NULL || tb->owner == uc) {
+        return tb->owner != NULL || uc->tb_group == NULL;
+    }
+    for (i = 0; i < uc->num_cpus; i++) {
+        if (tb->owner == uc->cpus[i]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static inline bool tb_overlaps(TranslationBlock *tb, target_ulong start,
+                               target_ulong end)
+{
+    return tb->pc <= end && (tb->pc >= start || start - tb->pc < tb->size);
+}
+
+// SNPS added: invalidate the TBs overlapping the virtual range [@start, @end],
+// with @hooked only those that may carry the hooks of @uc. A TB is at most a
+// page long, so it starts on a page of the range or on the one before.
+void tb_invalidate_virt_range(struct uc_struct *uc, target_ulong start,
+                              target_ulong end, bool hooked)
+{
+    TCGContext *tcg_ctx = uc->tcg_ctx;
+    TBContext *tb_ctx = &tcg_ctx->tb_ctx;
+    target_ulong page = (start & TARGET_PAGE_MASK) - TARGET_PAGE_SIZE;
+    target_ulong last = end & TARGET_PAGE_MASK;
+    TranslationBlock *tb, *next;
+    int i;
+
+    if (((last - page) >> TARGET_PAGE_BITS) >= CODE_GEN_VIRT_HASH_SIZE) {
+        for (i = 0; i < tb_ctx->nb_tbs; i++) {
+            tb = tb_ctx->tbs[i];
+            if (!(tb->cflags & CF_INVALID) && tb_overlaps(tb, start, end) &&
+                (!hooked || tb_owned_by(uc, tb))) {
+                tb_phys_invalidate(uc, tb, -1);
+            }
+        }
+        return;
+    }
+
+    for (;; page += TARGET_PAGE_SIZE) {
+        for (tb = tb_ctx->tb_virt_hash[tb_virt_hash_func(page)]; tb;
+             tb = next) {
+            next = tb->virt_hash_next;
+            if (tb_overlaps(tb, start, end) &&
+                (!hooked || tb_owned_by(uc, tb))) {
+                tb_phys_invalidate(uc, tb, -1);
+            }
+        }
+        if (page == last) {
+            break;
+        }
+    }
+}
+
+// SNPS added: invalidate the TBs containing a virtual PC
+void tb_invalidate_virt_pc(struct uc_struct *uc, target_ulong pc)
+{
+    tb_invalidate_virt_range(uc, pc, pc, false);
+}
+
 /* Called with tb_lock held.  */
 void tb_check_watchpoint(CPUState *cpu)
 {
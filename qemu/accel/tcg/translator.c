@@ -35,6 +35,7 @@ void translator_loop(const TranslatorOps *ops, DisasContextBase *db,
 {
     int bp_insn = 0;
     TCGContext *tcg_ctx = cpu->uc->tcg_ctx;
+    TCGOp *block_size_op = NULL; // SNPS added
 
     /* Initialize DisasContext */
     db->tb = tb;
@@ -64,24 +65,15 @@ void translator_loop(const TranslatorOps *ops, DisasContextBase *db,
         goto tb_end;
     }
 
+    /* Start translating.  */
+    gen_tb_start(tcg_ctx, db->tb);
+
     /* Unicorn: trace this block on request
-     * Only hook this block if it is not broken from previous translation due to
-     * full translation cache
+     * SNPS changed: once the TB is entered, the size is patched in below
      */
-    if (!cpu->uc->block_full && HOOK_EXISTS_BOUNDED(cpu->uc, UC_HOOK_BLOCK, db->pc_first)) {
-    // Unicorn: FIXME: Needs to be adjusted to work with new TCG
-#if 0
-        // Save block address to see if we need to patch block size later
-        cpu->uc->block_addr = db->pc_first;
-        cpu->uc->size_arg = tcg_ctx->gen_op_buf[tcg_ctx->gen_op_buf[0].prev].args;
-        gen_uc_tracecode(tcg_ctx, 0xf8f8f8f8, UC_HOOK_BLOCK_IDX, cpu->uc, db->pc_first);
-#endif
-    } else {
-        cpu->uc->size_arg = -1;
-    }
+    gen_uc_tracecode(tcg_ctx, 0, UC_HOOK_BLOCK_IDX, cpu->uc, db->pc_first);
+    block_size_op = tcg_ctx->uc_size_op;
 
-    /* Start translating.  */
-    gen_tb_start(tcg_ctx, db->tb);
     ops->tb_start(db, cpu);
     tcg_debug_assert(db->is_jmp == DISAS_NEXT);  /* no early exit */
 
@@ -94,7 +86,9 @@ void translator_loop(const TranslatorOps *ops, DisasContextBase *db,
         if (/*!db->singlestep_enabled*/ 1 // SNPS changed
             && unlikely(!QTAILQ_EMPTY(&cpu->breakpoints))) {
             CPUBreakpoint *bp;
-            QTAILQ_FOREACH(bp, &cpu->breakpoints, entry) {
+            // SNPS changed: only the bucket of the PC
+            for (bp = cpu->bp_hash[cpu_bp_hash_func(db->pc_next)]; bp;
+                 bp = bp->hash_next) {
                 if (bp->pc == db->pc_next) {
                     if (ops->breakpoint_check(db, cpu, bp)) {
                         bp_insn = 1;
@@ -132,7 +126,11 @@ void translator_loop(const TranslatorOps *ops, DisasContextBase *db,
 
         /* Stop translation if the output buffer is full,
            or we have executed all of the allowed instructions.  */
-        if (tcg_op_buf_full(tcg_ctx) || db->num_insns >= db->max_insns) {
+        /* SNPS changed: or the next instruction might not fit into the
+           memory trace buffer */
+        if (tcg_op_buf_full(tcg_ctx) || db->num_insns >= db->max_insns ||
+            (tcg_ctx->mem_trace && tcg_ctx->mem_trace_count +
+             UC_MEM_TRACE_INSN_MAX > cpu->uc->mem_trace->entries)) {
             db->is_jmp = DISAS_TOO_MANY;
             db->uc->block_full = true;
             break;
@@ -148,6 +146,11 @@ tb_end:
     db->tb->size = db->pc_next - db->pc_first;
     db->tb->icount = db->num_insns;
 
+    // SNPS added
+    if (block_size_op) {
+        tcg_set_insn_param(block_size_op, 1, db->tb->size);
+    }
+
 #ifdef DEBUG_DISAS
     if (qemu_loglevel_mask(CPU_LOG_TB_IN_ASM)
         && qemu_log_in_addr_range(db->pc_first)) {
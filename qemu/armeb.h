@@ -2715,6 +2715,9 @@
 #define tb_reset_jump tb_reset_jump_armeb
 #define tb_set_jmp_target tb_set_jmp_target_armeb
 #define tb_target_set_jmp_target tb_target_set_jmp_target_armeb
+#define tb_warm tb_warm_armeb
+#define tb_invalidate_virt_pc tb_invalidate_virt_pc_armeb
+#define tb_invalidate_virt_range tb_invalidate_virt_range_armeb
 #define tcg_accel_class_init tcg_accel_class_init_armeb
 #define tcg_accel_type tcg_accel_type_armeb
 #define tcg_add_param_i32 tcg_add_param_i32_armeb
@@ -2746,6 +2749,7 @@
 #define tcg_emit_op tcg_emit_op_armeb
 #define tcg_enabled tcg_enabled_armeb
 #define tcg_exec_all tcg_exec_all_armeb
+#define tcg_exec_attach tcg_exec_attach_armeb
 #define tcg_exec_init tcg_exec_init_armeb
 #define tcg_expand_vec_op tcg_expand_vec_op_armeb
 #define tcg_find_helper tcg_find_helper_armeb
@@ -3265,8 +3269,10 @@
 #define thumb2_logic_op thumb2_logic_op_armeb
 #define ti925t_initfn ti925t_initfn_armeb
 #define tlb_add_large_page tlb_add_large_page_armeb
+#define tlb_destroy tlb_destroy_armeb
 #define tlb_init tlb_init_armeb
 #define tlb_flush tlb_flush_armeb
+#define tlb_flush_asid_by_mmuidx tlb_flush_asid_by_mmuidx_armeb
 #define tlb_flush_by_mmuidx tlb_flush_by_mmuidx_armeb
 #define tlb_flush_entry tlb_flush_entry_armeb
 #define tlb_flush_page tlb_flush_page_armeb
@@ -3274,9 +3280,14 @@
 #define tlb_is_dirty_ram tlb_is_dirty_ram_armeb
 #define tlb_reset_dirty tlb_reset_dirty_armeb
 #define tlb_reset_dirty_range tlb_reset_dirty_range_armeb
+#define tlb_set_asid_by_mmuidx tlb_set_asid_by_mmuidx_armeb
 #define tlb_set_dirty tlb_set_dirty_armeb
 #define tlb_set_page tlb_set_page_armeb
 #define tlb_set_page_with_attrs tlb_set_page_with_attrs_armeb
+#define tlb_stats tlb_stats_armeb
+#define tlb_walk_host tlb_walk_host_armeb
+#define tlb_walk_cache_lookup tlb_walk_cache_lookup_armeb
+#define tlb_walk_cache_insert tlb_walk_cache_insert_armeb
 #define tlb_vaddr_to_host tlb_vaddr_to_host_armeb
 #define tlbi_aa64_asid_is_write tlbi_aa64_asid_is_write_armeb
 #define tlbi_aa64_asid_write tlbi_aa64_asid_write_armeb
@@ -3413,22 +3424,35 @@
 #define tlb_flush_page_all_cpus_synced tlb_flush_page_all_cpus_synced_armeb
 #define tlb_flush_by_mmuidx_all_cpus_synced tlb_flush_by_mmuidx_all_cpus_synced_armeb
 #define tlb_flush_page_by_mmuidx_all_cpus_synced tlb_flush_page_by_mmuidx_all_cpus_synced_armeb
+#define tlb_flush_asid_by_mmuidx_all_cpus_synced tlb_flush_asid_by_mmuidx_all_cpus_synced_armeb
 #define dmi_invalidate dmi_invalidate_armeb
+#define dmi_invalidate_ranges dmi_invalidate_ranges_armeb
 #define helper_trace_tb_entry helper_trace_tb_entry_armeb
+#define helper_trace_bb_flush helper_trace_bb_flush_armeb
+#define helper_trace_bb_time helper_trace_bb_time_armeb
+#define helper_mem_trace_flush helper_mem_trace_flush_armeb
+#define helper_uc_hook_code helper_uc_hook_code_armeb
+#define cpu_insn_count cpu_insn_count_armeb
+#define cpu_restore_callout_pc cpu_restore_callout_pc_armeb
 #define aa64_va_parameters aa64_va_parameters_armeb
 #define aa64_va_parameters_both aa64_va_parameters_both_armeb
 #define aarch64_translator_ops aarch64_translator_ops_armeb
 #define arm_cpu_tlb_fill arm_cpu_tlb_fill_armeb
+#define arm_mmu_idx_asid arm_mmu_idx_asid_armeb
+#define arm_tlb_update_asid arm_tlb_update_asid_armeb
 #define arm_v7m_mmu_idx_all arm_v7m_mmu_idx_all_armeb
 #define arm_v7m_mmu_idx_for_secstate arm_v7m_mmu_idx_for_secstate_armeb
 #define arm_v7m_mmu_idx_for_secstate_and_priv arm_v7m_mmu_idx_for_secstate_and_priv_armeb
 #define ARM_REGS_STORAGE_SIZE ARM_REGS_STORAGE_SIZE_armeb
+#define arm_get_cpu_by_id arm_get_cpu_by_id_armeb
 #define arm_hcr_el2_eff arm_hcr_el2_eff_armeb
 #define arm_mmu_idx arm_mmu_idx_armeb
 #define arm_mmu_idx_el arm_mmu_idx_el_armeb
 #define arm_mmu_idx_to_el arm_mmu_idx_to_el_armeb
 #define arm_register_pre_el_change_hook arm_register_pre_el_change_hook_armeb
 #define arm_register_el_change_hook arm_register_el_change_hook_armeb
+#define arm_rebuild_hflags arm_rebuild_hflags_armeb
+#define helper_rebuild_hflags helper_rebuild_hflags_armeb
 #define arm_reset_cpu arm_reset_cpu_armeb
 #define arm_sctlr arm_sctlr_armeb
 #define arm_set_cpu_off arm_set_cpu_off_armeb
@@ -3539,5 +3563,6 @@
 #define vfp_expand_imm vfp_expand_imm_armeb
 #define helper_sev helper_sev_armeb
 #define helper_sevl helper_sevl_armeb
+#define helper_tlb_sync helper_tlb_sync_armeb
 #define helper_call_breakpoints helper_call_breakpoints_armeb
 #endif
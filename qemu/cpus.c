@@ -152,8 +152,8 @@ static bool tcg_exec_all(struct uc_struct* uc)
     CPUState *cpu = uc->cpu;
     CPUArchState *env = cpu->env_ptr;
 
-    cpu->insn_count = 0;
-    cpu->insn_limit = uc->emu_count;
+    cpu->insn_limit = MIN(uc->emu_count, INT64_MAX);
+    cpu_neg(cpu)->insn_budget = cpu->insn_limit;
 
     cpu->is_idle = false;
 
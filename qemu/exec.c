@@ -511,9 +511,9 @@ address_space_translate_for_iotlb(CPUState *cpu, int asidx, hwaddr addr,
 
 CPUState *qemu_get_cpu(struct uc_struct *uc, int index)
 {
-    CPUState *cpu = uc->cpu;
-    if (cpu->cpu_index == index) {
-        return cpu;
+    // SNPS changed
+    if (index >= 0 && index < uc->num_cpus) {
+        return uc->cpus[index];
     }
     return NULL;
 }
@@ -564,7 +564,7 @@ AddressSpace *cpu_get_address_space(CPUState *cpu, int asidx)
 #endif
 
 #ifndef CONFIG_USER_ONLY
-static int cpu_get_free_index(Error **errp)
+static int cpu_get_free_index(struct uc_struct *uc, Error **errp) // SNPS changed
 {
     // Unicorn: if'd out
 #if 0
@@ -579,7 +579,13 @@ static int cpu_get_free_index(Error **errp)
     bitmap_set(cpu_index_map, cpu, 1);
     return cpu;
 #endif
-    return 0;
+    // SNPS changed: the vCPUs of an engine are numbered in creation order
+    if (uc->num_cpus >= uc->smp_cpus) {
+        error_setg(errp, "Trying to use more CPUs than max of %d",
+                   uc->smp_cpus);
+        return -1;
+    }
+    return uc->num_cpus;
 }
 
 void cpu_exec_exit(CPUState *cpu)
@@ -597,7 +603,7 @@ void cpu_exec_exit(CPUState *cpu)
 }
 #else
 
-static int cpu_get_free_index(Error **errp)
+static int cpu_get_free_index(struct uc_struct *uc, Error **errp) // SNPS changed
 {
     // Unicorn: if'd out
 #if 0
@@ -629,23 +635,33 @@ void cpu_exec_init(CPUState *cpu, Error **errp, void *opaque)
     cpu->uc = uc;
     env->uc = uc;
 
-    cpu->cpu_index = cpu_get_free_index(&local_err);
+    cpu->cpu_index = cpu_get_free_index(uc, &local_err); // SNPS changed
     if (local_err) {
         error_propagate(errp, local_err);
         return;
     }
 
-    // TODO: assert uc does not already have a cpu?
+    // SNPS changed: the last vCPU created is selected until uc_open()
+    // selects the first one
+    uc->cpus[uc->num_cpus++] = cpu;
     uc->cpu = cpu;
 
     // Unicorn: Required to clean-slate TLB state
+    tlb_init(cpu); // SNPS changed: allocates the TLB
     tlb_flush(cpu);
 
     if (tcg_enabled(uc) && !cc->tcg_initialized) {
         cc->tcg_initialized = true;
-        cc->tcg_initialize(uc);
+        // SNPS changed: globals of a shared translation context exist once
+        uc_tb_group_lock(uc);
+        if (!uc->tb_group || !uc->tb_group->tcg_initialized) {
+            cc->tcg_initialize(uc);
+        }
+        if (uc->tb_group) {
+            uc->tb_group->tcg_initialized = true;
+        }
+        uc_tb_group_unlock(uc);
     }
-    tlb_init(cpu);
 
 #ifndef CONFIG_USER_ONLY
 
@@ -703,15 +719,9 @@ static void breakpoint_invalidate(CPUState *cpu, target_ulong pc)
 #else
 static void breakpoint_invalidate(CPUState *cpu, target_ulong pc)
 {
-    tb_flush(cpu); return; // SNPS added
-    MemTxAttrs attrs;
-    hwaddr phys = cpu_get_phys_page_attrs_debug(cpu, pc, &attrs);
-    int asidx = cpu_asidx_from_attrs(cpu, attrs);
-    if (phys != -1) {
-        /* Locks grabbed by tb_invalidate_phys_addr */
-        tb_invalidate_phys_addr(cpu->cpu_ases[asidx].as,
-                                phys | (pc & ~TARGET_PAGE_MASK));
-    }
+    // SNPS changed: the PC is virtual and may have been translated from any
+    // physical page (or DMI memory), so drop the TBs containing the PC
+    tb_invalidate_virt_pc(cpu->uc, pc);
 }
 #endif
 
@@ -747,6 +757,95 @@ int cpu_watchpoint_address_matches(CPUState *cpu, vaddr addr, vaddr len)
     return 0;
 }
 #else
+// SNPS added
+static inline CPUWatchpointRef **wp_bucket(CPUState *cpu, vaddr granule)
+{
+    return &cpu->wp_hash[(granule ^ (granule >> CPU_WP_HASH_BITS)) &
+                         (CPU_WP_HASH_SIZE - 1)];
+}
+
+// SNPS added
+static inline bool wp_is_large(vaddr addr, vaddr len)
+{
+    return ((addr + len - 1) >> CPU_WP_GRANULE_BITS) -
+           (addr >> CPU_WP_GRANULE_BITS) >= CPU_WP_MAX_GRANULES;
+}
+
+// SNPS added
+static void wp_ref_insert(CPUWatchpointRef **pref, CPUWatchpoint *wp)
+{
+    CPUWatchpointRef *ref = g_new(CPUWatchpointRef, 1);
+
+    /* keep all GDB-injected watchpoints in front */
+    while (!(wp->flags & BP_GDB) && *pref) {
+        pref = &(*pref)->next;
+    }
+    ref->wp = wp;
+    ref->next = *pref;
+    *pref = ref;
+}
+
+// SNPS added
+static void wp_ref_remove(CPUWatchpointRef **pref, CPUWatchpoint *wp)
+{
+    CPUWatchpointRef *ref;
+
+    while ((*pref)->wp != wp) {
+        pref = &(*pref)->next;
+    }
+    ref = *pref;
+    *pref = ref->next;
+    g_free(ref);
+}
+
+// SNPS added: reference a watchpoint from its lists, see CPU_WP_HASH_SIZE
+static void wp_link(CPUState *cpu, CPUWatchpoint *wp)
+{
+    vaddr g = wp->vaddr >> CPU_WP_GRANULE_BITS;
+    vaddr last = (wp->vaddr + wp->len - 1) >> CPU_WP_GRANULE_BITS;
+
+    if (wp_is_large(wp->vaddr, wp->len)) {
+        wp_ref_insert(&cpu->wp_large, wp);
+        return;
+    }
+    for (; g <= last; g++) {
+        wp_ref_insert(wp_bucket(cpu, g), wp);
+    }
+}
+
+// SNPS added
+static void wp_unlink(CPUState *cpu, CPUWatchpoint *wp)
+{
+    vaddr g = wp->vaddr >> CPU_WP_GRANULE_BITS;
+    vaddr last = (wp->vaddr + wp->len - 1) >> CPU_WP_GRANULE_BITS;
+
+    if (wp_is_large(wp->vaddr, wp->len)) {
+        wp_ref_remove(&cpu->wp_large, wp);
+        return;
+    }
+    for (; g <= last; g++) {
+        wp_ref_remove(wp_bucket(cpu, g), wp);
+    }
+}
+
+// SNPS added: drop the TLB entries of the pages a watchpoint covers
+static void wp_flush(CPUState *cpu, CPUWatchpoint *wp)
+{
+    vaddr page = wp->vaddr & TARGET_PAGE_MASK;
+    vaddr last = (wp->vaddr + wp->len - 1) & TARGET_PAGE_MASK;
+
+    if ((last - page) >> TARGET_PAGE_BITS >= CPU_WP_MAX_GRANULES) {
+        tlb_flush(cpu);
+        return;
+    }
+    for (;; page += TARGET_PAGE_SIZE) {
+        tlb_flush_page(cpu, page);
+        if (page == last) {
+            break;
+        }
+    }
+}
+
 /* Add a watchpoint.  */
 int cpu_watchpoint_insert(CPUState *cpu, vaddr addr, vaddr len,
         int flags, CPUWatchpoint **watchpoint)
@@ -762,6 +861,7 @@ int cpu_watchpoint_insert(CPUState *cpu, vaddr addr, vaddr len,
     wp->vaddr = addr;
     wp->len = len;
     wp->flags = flags;
+    wp->stamp = 0; // SNPS added
 
     /* keep all GDB-injected watchpoints in front */
     if (flags & BP_GDB) {
@@ -769,8 +869,9 @@ int cpu_watchpoint_insert(CPUState *cpu, vaddr addr, vaddr len,
     } else {
         QTAILQ_INSERT_TAIL(&cpu->watchpoints, wp, entry);
     }
+    wp_link(cpu, wp); // SNPS added
 
-    tlb_flush_page(cpu, addr);
+    wp_flush(cpu, wp); // SNPS changed
 
     if (watchpoint)
         *watchpoint = wp;
@@ -781,9 +882,14 @@ int cpu_watchpoint_insert(CPUState *cpu, vaddr addr, vaddr len,
 int cpu_watchpoint_remove(CPUState *cpu, vaddr addr, vaddr len,
         int flags)
 {
+    CPUWatchpointRef *ref;
     CPUWatchpoint *wp;
 
-    QTAILQ_FOREACH(wp, &cpu->watchpoints, entry) {
+    // SNPS changed: the list of the first granule
+    ref = wp_is_large(addr, len) ? cpu->wp_large
+                                 : *wp_bucket(cpu, addr >> CPU_WP_GRANULE_BITS);
+    for (; ref; ref = ref->next) {
+        wp = ref->wp;
         if (addr == wp->vaddr && len == wp->len
                 && flags == (wp->flags & ~BP_WATCHPOINT_HIT)) {
             cpu_watchpoint_remove_by_ref(cpu, wp);
@@ -797,8 +903,9 @@ int cpu_watchpoint_remove(CPUState *cpu, vaddr addr, vaddr len,
 void cpu_watchpoint_remove_by_ref(CPUState *cpu, CPUWatchpoint *watchpoint)
 {
     QTAILQ_REMOVE(&cpu->watchpoints, watchpoint, entry);
+    wp_unlink(cpu, watchpoint); // SNPS added
 
-    tlb_flush_page(cpu, watchpoint->vaddr);
+    wp_flush(cpu, watchpoint); // SNPS changed
 
     g_free(watchpoint);
 }
@@ -834,16 +941,66 @@ static inline bool watchpoint_address_matches(CPUWatchpoint *wp,
     return !(addr > wpend || wp->vaddr > addrend);
 }
 
+// SNPS added: lookup of the watchpoints overlapping [addr, addr + len), each
+// one once: the buckets of the granules of the range, then wp_large
+typedef struct WPLookup {
+    vaddr addr, len;
+    vaddr g, last;
+    bool large;
+    uint64_t stamp;
+    CPUWatchpointRef *ref;
+} WPLookup;
+
+static void wp_lookup_init(CPUState *cpu, WPLookup *l, vaddr addr, vaddr len)
+{
+    l->addr = addr;
+    l->len = len;
+    l->g = addr >> CPU_WP_GRANULE_BITS;
+    l->last = (addr + len - 1) >> CPU_WP_GRANULE_BITS;
+    l->large = false;
+    l->stamp = ++cpu->wp_stamp;
+    l->ref = NULL;
+}
+
+static CPUWatchpoint *wp_lookup_next(CPUState *cpu, WPLookup *l)
+{
+    CPUWatchpoint *wp;
+
+    for (;;) {
+        while (l->ref == NULL) {
+            if (l->g <= l->last) {
+                l->ref = *wp_bucket(cpu, l->g++);
+            } else if (!l->large) {
+                l->ref = cpu->wp_large;
+                l->large = true;
+            } else {
+                return NULL;
+            }
+        }
+        wp = l->ref->wp;
+        l->ref = l->ref->next;
+        if (wp->stamp != l->stamp &&
+            watchpoint_address_matches(wp, l->addr, l->len)) {
+            wp->stamp = l->stamp;
+            return wp;
+        }
+    }
+}
+
 /* Return flags for watchpoints that match addr + prot.  */
 int cpu_watchpoint_address_matches(CPUState *cpu, vaddr addr, vaddr len)
 {
+    WPLookup l; // SNPS added
     CPUWatchpoint *wp;
     int ret = 0;
 
-    QTAILQ_FOREACH(wp, &cpu->watchpoints, entry) {
-        if (watchpoint_address_matches(wp, addr, TARGET_PAGE_SIZE)) {
-            ret |= wp->flags;
-        }
+    if (QTAILQ_EMPTY(&cpu->watchpoints)) { // SNPS added
+        return 0;
+    }
+    // SNPS changed: only the watchpoints near the page
+    wp_lookup_init(cpu, &l, addr, len);
+    while ((wp = wp_lookup_next(cpu, &l))) {
+        ret |= wp->flags;
     }
     return ret;
 }
@@ -856,9 +1013,10 @@ void cpu_check_watchpoint(CPUState *cpu, vaddr addr, vaddr len,
     CPUClass *cc = CPU_GET_CLASS(cpu->uc, cpu);
     CPUWatchpoint *wp;
 
-    struct CPUWatchpointCallInfo *info, *next;
-    QTAILQ_HEAD(callwp_head, CPUWatchpointCallInfo) calls;
-    QTAILQ_INIT(&calls);
+    // SNPS added: callbacks run after the lookup, usually without allocation
+    struct CPUWatchpointCallInfo call_buf[8], *calls = call_buf;
+    int num_calls = 0, max_calls = ARRAY_SIZE(call_buf), i;
+    WPLookup l;
 
     assert(tcg_enabled(cpu->uc));
     if (cpu->watchpoint_hit) {
@@ -872,11 +1030,16 @@ void cpu_check_watchpoint(CPUState *cpu, vaddr addr, vaddr len,
         //qemu_mutex_unlock_iothread();
         return;
     }
+    if (QTAILQ_EMPTY(&cpu->watchpoints)) { // SNPS added: e.g. memory hooks
+        return;
+    }
 
     addr = cc->adjust_watchpoint_address(cpu, addr, len);
-    QTAILQ_FOREACH(wp, &cpu->watchpoints, entry) {
-        if (watchpoint_address_matches(wp, addr, len)
-            && (wp->flags & flags)) {
+    // SNPS changed: only the watchpoints that overlap the access
+    wp_lookup_init(cpu, &l, addr, len);
+    while ((wp = wp_lookup_next(cpu, &l))) {
+        wp->flags &= ~BP_WATCHPOINT_HIT; // SNPS changed
+        if (wp->flags & flags) {
             if (flags == BP_MEM_READ) {
                 wp->flags |= BP_WATCHPOINT_HIT_READ;
             } else {
@@ -886,11 +1049,17 @@ void cpu_check_watchpoint(CPUState *cpu, vaddr addr, vaddr len,
             wp->hitattrs = attrs;
             // SNPS added
             if (wp->flags & BP_CALL) {
-                struct CPUWatchpointCallInfo *info
-                    = g_malloc(sizeof(struct CPUWatchpointCallInfo));
-                info->addr = wp->vaddr;
-                info->len = wp->len;
-                QTAILQ_INSERT_TAIL(&calls, info, entry);
+                if (num_calls == max_calls) {
+                    max_calls *= 2;
+                    if (calls == call_buf) {
+                        calls = g_memdup(call_buf, sizeof(call_buf));
+                    }
+                    calls = g_renew(struct CPUWatchpointCallInfo, calls,
+                                    max_calls);
+                }
+                calls[num_calls].addr = wp->vaddr;
+                calls[num_calls].len = wp->len;
+                num_calls++;
 
                 wp->flags &= ~BP_WATCHPOINT_HIT;
                 continue;
@@ -902,6 +1071,9 @@ void cpu_check_watchpoint(CPUState *cpu, vaddr addr, vaddr len,
                     continue;
                 }
                 cpu->watchpoint_hit = wp;
+                if (calls != call_buf) { // SNPS added
+                    g_free(calls);
+                }
 
                 mmap_lock();
                 tb_check_watchpoint(cpu);
@@ -919,18 +1091,23 @@ void cpu_check_watchpoint(CPUState *cpu, vaddr addr, vaddr len,
                     cpu_loop_exit_noexc(cpu);
                 }
             }
-        } else {
-            wp->flags &= ~BP_WATCHPOINT_HIT;
         }
     }
 
     // SNPS added
-    QTAILQ_FOREACH_SAFE(info, &calls, entry, next) {
+    for (i = 0; i < num_calls; i++) {
         struct uc_struct* uc = cpu->uc;
         void* opaque = uc->uc_watchpoint_opaque;
         bool iswr = flags & BP_MEM_WRITE;
-        cpu->uc->uc_watchpoint_func(opaque, info->addr, info->len, data, iswr);
-        g_free(info);
+        cpu->callout_pc = ra;
+        cpu->callout_lazy_pc = true;
+        cpu->uc->uc_watchpoint_func(opaque, calls[i].addr, calls[i].len, data,
+                                    iswr);
+        cpu->callout_lazy_pc = false;
+        cpu->callout_pc = 0;
+    }
+    if (calls != call_buf) {
+        g_free(calls);
     }
 }
 
@@ -938,7 +1115,7 @@ void cpu_check_watchpoint(CPUState *cpu, vaddr addr, vaddr len,
 int cpu_breakpoint_insert(CPUState *cpu, vaddr pc, int flags,
         CPUBreakpoint **breakpoint)
 {
-    CPUBreakpoint *bp;
+    CPUBreakpoint *bp, **pbp;
 
     bp = g_malloc(sizeof(*bp));
 
@@ -946,11 +1123,17 @@ int cpu_breakpoint_insert(CPUState *cpu, vaddr pc, int flags,
     bp->flags = flags;
 
     /* keep all GDB-injected breakpoints in front */
+    pbp = &cpu->bp_hash[cpu_bp_hash_func(pc)]; // SNPS added
     if (flags & BP_GDB) {
         QTAILQ_INSERT_HEAD(&cpu->breakpoints, bp, entry);
     } else {
         QTAILQ_INSERT_TAIL(&cpu->breakpoints, bp, entry);
+        while (*pbp) { // SNPS added
+            pbp = &(*pbp)->hash_next;
+        }
     }
+    bp->hash_next = *pbp; // SNPS added
+    *pbp = bp; // SNPS added
 
     breakpoint_invalidate(cpu, pc);
 
@@ -965,7 +1148,8 @@ int cpu_breakpoint_remove(CPUState *cpu, vaddr pc, int flags)
 {
     CPUBreakpoint *bp;
 
-    QTAILQ_FOREACH(bp, &cpu->breakpoints, entry) {
+    // SNPS changed: only the bucket of the PC
+    for (bp = cpu->bp_hash[cpu_bp_hash_func(pc)]; bp; bp = bp->hash_next) {
         if (bp->pc == pc && bp->flags == flags) {
             cpu_breakpoint_remove_by_ref(cpu, bp);
             return 0;
@@ -977,7 +1161,14 @@ int cpu_breakpoint_remove(CPUState *cpu, vaddr pc, int flags)
 /* Remove a specific breakpoint by reference.  */
 void cpu_breakpoint_remove_by_ref(CPUState *cpu, CPUBreakpoint *breakpoint)
 {
+    CPUBreakpoint **pbp; // SNPS added
+
     QTAILQ_REMOVE(&cpu->breakpoints, breakpoint, entry);
+    pbp = &cpu->bp_hash[cpu_bp_hash_func(breakpoint->pc)]; // SNPS added
+    while (*pbp != breakpoint) {
+        pbp = &(*pbp)->hash_next;
+    }
+    *pbp = breakpoint->hash_next;
 
     breakpoint_invalidate(cpu, breakpoint->pc);
 
@@ -1252,10 +1443,20 @@ void flatview_add_to_dispatch(FlatView *fv, MemoryRegionSection *section)
 
 #endif
 
+// SNPS added
+static int ram_block_offset_cmp(const void *a, const void *b)
+{
+    ram_addr_t x = (*(RAMBlock * const *)a)->offset;
+    ram_addr_t y = (*(RAMBlock * const *)b)->offset;
+
+    return x < y ? -1 : x > y;
+}
+
 static ram_addr_t find_ram_offset(struct uc_struct *uc, ram_addr_t size)
 {
-    RAMBlock *block, *next_block;
+    RAMBlock *block, **blocks;
     ram_addr_t offset = RAM_ADDR_MAX, mingap = RAM_ADDR_MAX;
+    size_t i, n = 0;
 
     assert(size != 0); /* it would hand out same offset multiple times */
 
@@ -1263,21 +1464,31 @@ static ram_addr_t find_ram_offset(struct uc_struct *uc, ram_addr_t size)
         return 0;
     }
 
+    // SNPS changed: the gaps between the blocks in offset order, instead of
+    // a search for the next block of each block
     QLIST_FOREACH(block, &uc->ram_list.blocks, next) {
-        ram_addr_t end, next = RAM_ADDR_MAX;
+        n++;
+    }
+    blocks = g_new(RAMBlock *, n);
+    n = 0;
+    QLIST_FOREACH(block, &uc->ram_list.blocks, next) {
+        blocks[n++] = block;
+    }
+    qsort(blocks, n, sizeof(*blocks), ram_block_offset_cmp);
 
-        end = block->offset + block->max_length;
+    for (i = 0; i < n; i++) {
+        ram_addr_t end, next = RAM_ADDR_MAX;
 
-        QLIST_FOREACH(next_block, &uc->ram_list.blocks, next) {
-            if (next_block->offset >= end) {
-                next = MIN(next, next_block->offset);
-            }
+        end = blocks[i]->offset + blocks[i]->max_length;
+        if (i + 1 < n) {
+            next = blocks[i + 1]->offset;
         }
         if (next - end >= size && next - end < mingap) {
             offset = end;
             mingap = next - end;
         }
     }
+    g_free(blocks);
 
     if (offset == RAM_ADDR_MAX) {
         fprintf(stderr, "Failed to find gap of requested size: %" PRIu64 "\n",
@@ -2721,6 +2721,9 @@ symbols = (
     'tb_reset_jump',
     'tb_set_jmp_target',
     'tb_target_set_jmp_target',
+    'tb_warm',
+    'tb_invalidate_virt_pc',
+    'tb_invalidate_virt_range',
     'tcg_accel_class_init',
     'tcg_accel_type',
     'tcg_add_param_i32',
@@ -2752,6 +2755,7 @@ symbols = (
     'tcg_emit_op',
     'tcg_enabled',
     'tcg_exec_all',
+    'tcg_exec_attach',
     'tcg_exec_init',
     'tcg_expand_vec_op',
     'tcg_find_helper',
@@ -3271,8 +3275,10 @@ symbols = (
     'thumb2_logic_op',
     'ti925t_initfn',
     'tlb_add_large_page',
+    'tlb_destroy',
     'tlb_init',
     'tlb_flush',
+    'tlb_flush_asid_by_mmuidx',
     'tlb_flush_by_mmuidx',
     'tlb_flush_entry',
     'tlb_flush_page',
@@ -3280,9 +3286,14 @@ symbols = (
     'tlb_is_dirty_ram',
     'tlb_reset_dirty',
     'tlb_reset_dirty_range',
+    'tlb_set_asid_by_mmuidx',
     'tlb_set_dirty',
     'tlb_set_page',
     'tlb_set_page_with_attrs',
+    'tlb_stats',
+    'tlb_walk_host',
+    'tlb_walk_cache_lookup',
+    'tlb_walk_cache_insert',
     'tlb_vaddr_to_host',
     'tlbi_aa64_asid_is_write',
     'tlbi_aa64_asid_write',
@@ -3421,8 +3432,16 @@ symbols = (
     'tlb_flush_page_all_cpus_synced',
     'tlb_flush_by_mmuidx_all_cpus_synced',
     'tlb_flush_page_by_mmuidx_all_cpus_synced',
+    'tlb_flush_asid_by_mmuidx_all_cpus_synced',
     'dmi_invalidate',
-    'helper_trace_tb_entry'
+    'dmi_invalidate_ranges',
+    'helper_trace_tb_entry',
+    'helper_trace_bb_flush',
+    'helper_trace_bb_time',
+    'helper_mem_trace_flush',
+    'helper_uc_hook_code',
+    'cpu_insn_count',
+    'cpu_restore_callout_pc',
 )
 
 arm_symbols = (
@@ -3430,16 +3449,21 @@ arm_symbols = (
     'aa64_va_parameters_both',
     'aarch64_translator_ops',
     'arm_cpu_tlb_fill',
+    'arm_mmu_idx_asid',
+    'arm_tlb_update_asid',
     'arm_v7m_mmu_idx_all',
     'arm_v7m_mmu_idx_for_secstate',
     'arm_v7m_mmu_idx_for_secstate_and_priv',
     'ARM_REGS_STORAGE_SIZE',
+    'arm_get_cpu_by_id',
     'arm_hcr_el2_eff',
     'arm_mmu_idx',
     'arm_mmu_idx_el',
     'arm_mmu_idx_to_el',
     'arm_register_pre_el_change_hook',
     'arm_register_el_change_hook',
+    'arm_rebuild_hflags',
+    'helper_rebuild_hflags',
     'arm_reset_cpu',
     'arm_sctlr',
     'arm_set_cpu_off',
@@ -3552,6 +3576,7 @@ arm_symbols = (
     # SNPS added
     'helper_sev',
     'helper_sevl',
+    'helper_tlb_sync',
     'helper_call_breakpoints',
 )
 
@@ -3572,12 +3597,14 @@ aarch64_symbols = (
     'arm_v7m_mmu_idx_all',
     'arm_v7m_mmu_idx_for_secstate',
     'arm_v7m_mmu_idx_for_secstate_and_priv',
+    'arm_get_cpu_by_id',
     'arm_hcr_el2_eff',
     'arm_mmu_idx',
     'arm_mmu_idx_el',
     'arm_mmu_idx_to_el',
     'arm_register_pre_el_change_hook',
     'arm_register_el_change_hook',
+    'arm_rebuild_hflags',
     'arm_reset_cpu',
     'arm_sctlr',
     'arm_set_cpu_off',
@@ -3726,6 +3753,7 @@ aarch64_symbols = (
     'helper_gvec_usra_s',
     'helper_msr_i_daifclear',
     'helper_msr_i_daifset',
+    'helper_rebuild_hflags',
     'helper_msr_i_spsel',
     'helper_neon_addlp_s16',
     'helper_neon_addlp_s8',
@@ -4682,6 +4710,7 @@ aarch64_symbols = (
     # SNPS added
     'helper_sev',
     'helper_sevl',
+    'helper_tlb_sync',
     'helper_call_breakpoints',
 )
 
@@ -5686,6 +5715,7 @@ riscv_symbols = (
     'decode_insn32',
     'do_raise_exception_err',
     'gen_helper_tlb_flush',
+    'gen_helper_tlb_flush_asid',
     'helper_csrrc',
     'helper_csrrs',
     'helper_csrrw',
@@ -5731,6 +5761,7 @@ riscv_symbols = (
     'helper_fsub_s',
     'helper_mret',
     'helper_tlb_flush',
+    'helper_tlb_flush_asid',
     'helper_set_rounding_mode',
     'helper_sret',
     'pmp_hart_has_privs',
@@ -98,7 +98,7 @@ static int machvirt_init(struct uc_struct *uc, MachineState *machine)
         return -1;
     }
 
-    for (n = 0; n < smp_cpus; n++) {
+    for (n = 0; n < uc->smp_cpus; n++) { // SNPS changed
         Object *cpuobj = object_new(uc, machine->cpu_type);
 
         uc->cpu = CPU(cpuobj);
@@ -144,7 +144,7 @@ static void virt_class_init(struct uc_struct *uc, ObjectClass *oc, void *data)
     MachineClass *mc = MACHINE_CLASS(uc, oc);
 
     mc->init = machvirt_init;
-    mc->max_cpus = 1; // SNPS changed
+    mc->max_cpus = UC_MAX_CPUS; // SNPS changed
     mc->is_default = 1;
     mc->arch = uc->arch; // SNPS changed
     // Unicorn: Enable all CPU features
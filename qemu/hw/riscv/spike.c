@@ -33,11 +33,14 @@
 
 static int spike_v1_10_0_board_init(struct uc_struct *uc, MachineState *machine)
 {
-    uc->cpu = cpu_create(uc, machine->cpu_type);
+    int n;
 
-    if (uc->cpu == NULL) {
-        fprintf(stderr, "Unable to make CPU definition\n");
-        return -1;
+    // SNPS changed: one hart per vCPU
+    for (n = 0; n < uc->smp_cpus; n++) {
+        if (cpu_create(uc, machine->cpu_type) == NULL) {
+            fprintf(stderr, "Unable to make CPU definition\n");
+            return -1;
+        }
     }
 
     return 0;
@@ -46,7 +49,7 @@ static int spike_v1_10_0_board_init(struct uc_struct *uc, MachineState *machine)
 static void spike_v1_10_0_machine_init(struct uc_struct *uc, MachineClass *mc)
 {
     mc->init = spike_v1_10_0_board_init;
-    mc->max_cpus = 1;
+    mc->max_cpus = UC_MAX_CPUS; // SNPS changed
     mc->is_default = 1;
 
     // Unicorn: instead of using SPIKE_V1_10_0_CPU like qemu,
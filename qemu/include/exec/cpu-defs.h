@@ -80,8 +80,11 @@ typedef uint64_t target_ulong;
 #endif
 
 #if !defined(CONFIG_USER_ONLY) && defined(CONFIG_TCG)
-/* use a fully associative victim tlb of 8 entries */
-#define CPU_VTLB_SIZE 8
+// SNPS changed: use a 4-way set associative victim tlb of 64 sets, the set
+// of an entry is given by the low bits of its index in the main tlb
+#define CPU_VTLB_BITS 6
+#define CPU_VTLB_WAYS 4
+#define CPU_VTLB_SIZE (CPU_VTLB_WAYS << CPU_VTLB_BITS)
 
 #if HOST_LONG_BITS == 32 && TARGET_LONG_BITS == 32
 #define CPU_TLB_ENTRY_BITS 4
@@ -111,6 +114,24 @@ typedef uint64_t target_ulong;
  * 0x18 (the offset of the addend field in each TLB entry) plus the offset
  * of tlb_table inside env (which is non-trivial but not huge).
  */
+#if TCG_TARGET_IMPLEMENTS_DYN_TLB // SNPS added
+#define CPU_TLB_DYN_MIN_BITS 6
+#define CPU_TLB_DYN_DEFAULT_BITS 8
+
+# if HOST_LONG_BITS == 32
+/* Make sure we do not require a double-word shift for the TLB load */
+#  define CPU_TLB_DYN_MAX_BITS (32 - TARGET_PAGE_BITS)
+# else /* HOST_LONG_BITS == 64 */
+/*
+ * Assuming TARGET_PAGE_BITS==12, with 2**22 entries we can cover 2**(22+12) ==
+ * 2**34 == 16G of address space. This is roughly what one would expect a
+ * TLB reach to be on a modern host.
+ */
+#  define CPU_TLB_DYN_MAX_BITS                                  \
+    MIN(22, TARGET_VIRT_ADDR_SPACE_BITS - TARGET_PAGE_BITS)
+# endif
+
+#else /* !TCG_TARGET_IMPLEMENTS_DYN_TLB */
 #define CPU_TLB_BITS                                             \
     MIN(8,                                                       \
         TCG_TARGET_TLB_DISPLACEMENT_BITS - CPU_TLB_ENTRY_BITS -  \
@@ -120,6 +141,7 @@ typedef uint64_t target_ulong;
          NB_MMU_MODES <= 8 ? 3 : 4))
 
 #define CPU_TLB_SIZE (1 << CPU_TLB_BITS)
+#endif /* TCG_TARGET_IMPLEMENTS_DYN_TLB */
 
 typedef struct CPUTLBEntry {
     /* bit TARGET_LONG_BITS to TARGET_PAGE_BITS : virtual address
@@ -164,28 +186,93 @@ typedef struct CPUIOTLBEntry {
 
     hwaddr phys; // SNPS added
     CPUTLBEntry* p2v; // SNPS added
+    uint32_t asid; // SNPS added: address space tag, see tlb_set_asid_by_mmuidx()
+    struct uc_hook_list *hooks; // SNPS added: memory hooks on the page, or NULL
 } CPUIOTLBEntry;
 
+// SNPS added: reverse map from physical pages to TLB slots, one node per
+// main and victim slot of each MMU mode, hashed by the page of iotlb.phys
+#define CPU_TLB_RMAP_BITS 12
+
+typedef struct CPUTLBRmap {
+    QLIST_ENTRY(CPUTLBRmap) next;
+    int mmu_idx;
+} CPUTLBRmap;
+
+QLIST_HEAD(CPUTLBRmapHead, CPUTLBRmap);
+
+// SNPS added: large pages tracked one by one per MMU mode, the others are
+// merged into the region of CPUTLBDesc.large_page_addr
+#define CPU_TLB_LARGE_PAGES 16
+
+typedef struct CPUTLBLargePage {
+    target_ulong addr;
+    target_ulong mask;
+} CPUTLBLargePage;
+
 typedef struct CPUTLBDesc {
     /*
      * Describe a region covering all of the large pages allocated
-     * into the tlb.  When any page within this region is flushed,
+     * into the tlb that do not fit in large_pages (SNPS changed).
+     * When any page within this region is flushed,
      * we must flush the entire tlb.  The region is matched if
      * (addr & large_page_mask) == large_page_addr.
      */
     target_ulong large_page_addr;
     target_ulong large_page_mask;
+    /* SNPS added: flushing a page within one of these only flushes the
+     * pages of the large page.  */
+    CPUTLBLargePage large_pages[CPU_TLB_LARGE_PAGES];
+    int n_large_pages;
     /* The next index to use in the tlb victim table.  */
     size_t vindex;
+    /* SNPS added: the victim tlb sets written since the last flush.  */
+    uint64_t vtlb_used;
+    /* SNPS added: the maximum number of entries used in the current window,
+     * which drives the resizing of a dynamic tlb on flushes.  */
+    int64_t window_begin_ns;
+    size_t window_max_entries;
+    size_t n_used_entries;
+    /* SNPS added: miss counters, see uc_tlb_stats().  */
+    uint64_t misses;
+    uint64_t victim_hits;
+    uint64_t flushes;
+    uint64_t page_flushes;
+    uint64_t large_page_flushes;
+    uint64_t forced_flushes;
+    uint64_t asid_flushes;
+    uint64_t resizes;
+    uint64_t dmi_grants;
+    uint64_t dmi_callbacks;
+    /* SNPS added: the address space tag of the entries of the main tlb.  */
+    uint32_t asid;
 } CPUTLBDesc;
 
+/* SNPS changed: tlb_table comes first, the cpu contexts saved by
+ * uc_context_save() end there and must not include any tlb state.  */
+#if TCG_TARGET_IMPLEMENTS_DYN_TLB // SNPS added
 #define CPU_COMMON_TLB \
     /* The meaning of the MMU modes is defined in the target code. */   \
+    CPUTLBEntry *tlb_table[NB_MMU_MODES];                               \
+    /* tlb_mask[i] contains (n_entries - 1) << CPU_TLB_ENTRY_BITS */    \
+    uintptr_t tlb_mask[NB_MMU_MODES];                                   \
     CPUTLBDesc tlb_d[NB_MMU_MODES];                                     \
+    CPUTLBEntry tlb_v_table[NB_MMU_MODES][CPU_VTLB_SIZE];               \
+    CPUIOTLBEntry *iotlb[NB_MMU_MODES];                                 \
+    CPUIOTLBEntry iotlb_v[NB_MMU_MODES][CPU_VTLB_SIZE];                 \
+    CPUTLBRmap *tlb_rmap[NB_MMU_MODES]; /* SNPS added */                \
+    struct CPUTLBRmapHead *tlb_rmap_hash; /* SNPS added */
+#else
+#define CPU_COMMON_TLB \
+    /* The meaning of the MMU modes is defined in the target code. */   \
     CPUTLBEntry tlb_table[NB_MMU_MODES][CPU_TLB_SIZE];                  \
+    CPUTLBDesc tlb_d[NB_MMU_MODES];                                     \
     CPUTLBEntry tlb_v_table[NB_MMU_MODES][CPU_VTLB_SIZE];               \
     CPUIOTLBEntry iotlb[NB_MMU_MODES][CPU_TLB_SIZE];                    \
-    CPUIOTLBEntry iotlb_v[NB_MMU_MODES][CPU_VTLB_SIZE];
+    CPUIOTLBEntry iotlb_v[NB_MMU_MODES][CPU_VTLB_SIZE];                 \
+    CPUTLBRmap *tlb_rmap[NB_MMU_MODES]; /* SNPS added */                \
+    struct CPUTLBRmapHead *tlb_rmap_hash; /* SNPS added */
+#endif
 
 #else
 
@@ -208,6 +295,7 @@ typedef struct CPUTLBDesc {
  */
 typedef struct CPUNegativeOffsetState {
     IcountDecr icount_decr;
+    int64_t insn_budget; // SNPS added: counted down by the length of a TB on entry
 } CPUNegativeOffsetState;
 
 #endif
@@ -139,7 +139,22 @@ static inline target_ulong tlb_addr_write(const CPUTLBEntry *entry)
 static inline uintptr_t tlb_index(CPUArchState *env, uintptr_t mmu_idx,
                                   target_ulong addr)
 {
-    return (addr >> TARGET_PAGE_BITS) & (CPU_TLB_SIZE - 1);
+#if TCG_TARGET_IMPLEMENTS_DYN_TLB // SNPS changed
+    uintptr_t size_mask = env->tlb_mask[mmu_idx] >> CPU_TLB_ENTRY_BITS;
+#else
+    uintptr_t size_mask = CPU_TLB_SIZE - 1;
+#endif
+    return (addr >> TARGET_PAGE_BITS) & size_mask;
+}
+
+// SNPS added
+static inline size_t tlb_n_entries(CPUArchState *env, uintptr_t mmu_idx)
+{
+#if TCG_TARGET_IMPLEMENTS_DYN_TLB
+    return (env->tlb_mask[mmu_idx] >> CPU_TLB_ENTRY_BITS) + 1;
+#else
+    return CPU_TLB_SIZE;
+#endif
 }
 
 /* Find the TLB entry corresponding to the mmu_idx + address pair.  */
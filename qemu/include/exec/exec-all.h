@@ -60,6 +60,29 @@ void restore_state_to_opc(CPUArchState *env, struct TranslationBlock *tb,
  */
 bool cpu_restore_state(CPUState *cpu, uintptr_t searched_pc, bool will_exit);
 
+/**
+ * cpu_insn_count:
+ * @cpu: the vCPU to query
+ * @return: number of retired instructions
+ *
+ * SNPS added: neg.insn_budget is counted down by the length of a TB on
+ * entry, instructions retired are derived from its initial value.
+ * While a host callback is running from within translated code (see
+ * cpu->callout_pc), exclude the instructions of the current TB that
+ * have not retired yet.
+ */
+size_t cpu_insn_count(CPUState *cpu);
+
+/**
+ * cpu_restore_callout_pc:
+ * @cpu: the vCPU to synchronize
+ *
+ * SNPS added: loads, stores and system register accesses don't store the
+ * guest PC before calling into the host (see cpu->callout_lazy_pc). While
+ * such a host callback is running, recover it from the insn_start data.
+ */
+void cpu_restore_callout_pc(CPUState *cpu);
+
 void QEMU_NORETURN cpu_loop_exit_noexc(CPUState *cpu);
 
 void QEMU_NORETURN cpu_io_recompile(CPUState *cpu, uintptr_t retaddr);
@@ -116,6 +139,14 @@ void cpu_address_space_init(CPUState *cpu, int asidx,
  * @cpu: CPU whose TLB should be initialized
  */
 void tlb_init(CPUState *cpu);
+void tlb_destroy(CPUState *cpu); // SNPS added
+void tlb_stats(CPUState *cpu, struct uc_tlb_stats *stats); // SNPS added
+void *tlb_walk_host(CPUState *cpu, AddressSpace *as, hwaddr addr,
+                    bool is_write); // SNPS added
+const CPUWalkCacheEntry *tlb_walk_cache_lookup(CPUState *cpu,
+                                               const CPUWalkCacheEntry *key); // SNPS added
+void tlb_walk_cache_insert(CPUState *cpu,
+                           const CPUWalkCacheEntry *entry); // SNPS added
 /**
  * tlb_flush_page:
  * @cpu: CPU whose TLB should be flushed
@@ -142,6 +173,29 @@ void tlb_flush_all_cpus_synced(CPUState *cpu);
 void tlb_flush_page_all_cpus_synced(CPUState *cpu, target_ulong addr);
 void tlb_flush_by_mmuidx_all_cpus_synced(CPUState *cpu, uint16_t idxmap);
 void tlb_flush_page_by_mmuidx_all_cpus_synced(CPUState *cpu, target_ulong addr, uint16_t idxmap);
+void tlb_flush_asid_by_mmuidx_all_cpus_synced(CPUState *cpu, uint32_t asid, uint16_t idxmap);
+/**
+ * tlb_set_asid_by_mmuidx:
+ * @cpu: CPU whose TLB should be switched
+ * @asid: tag of the new address space
+ * @idxmap: bitmap of MMU indexes to switch
+ *
+ * Switch the specified MMU indexes to the address space @asid. The upper
+ * 16 bits of a tag identify a virtual machine, whose global mappings are
+ * shared by all its address spaces. Entries of other address spaces are
+ * kept in the victim TLB as far as it has room for them.
+ */
+void tlb_set_asid_by_mmuidx(CPUState *cpu, uint32_t asid, uint16_t idxmap);
+/**
+ * tlb_flush_asid_by_mmuidx:
+ * @cpu: CPU whose TLB should be flushed
+ * @asid: tag of the address space to flush
+ * @idxmap: bitmap of MMU indexes to flush
+ *
+ * Flush the non-global entries of the address space @asid from the TLB
+ * of the specified CPU, for the specified MMU indexes.
+ */
+void tlb_flush_asid_by_mmuidx(CPUState *cpu, uint32_t asid, uint16_t idxmap);
 /**
  * tlb_flush_page_by_mmuidx:
  * @cpu: CPU whose TLB should be flushed
@@ -292,6 +346,7 @@ struct TranslationBlock {
     struct tb_tc tc;
     /* next matching tb for physical address. */
     struct TranslationBlock *phys_hash_next;
+    struct TranslationBlock *virt_hash_next; // SNPS added: same virtual page bucket
     /* original tb when cflags has CF_NOCACHE */
     struct TranslationBlock *orig_tb;
     /* first and second physical page containing code. The lower bit
@@ -324,6 +379,8 @@ struct TranslationBlock {
      */
     uintptr_t jmp_list_next[2];
     uintptr_t jmp_list_first;
+
+    void *owner; // SNPS added: only found by this vCPU or engine, see tb_owner()
 };
 
 /* Hide the atomic_read to make code a little easier on the eyes */
@@ -340,8 +397,12 @@ static inline uint32_t curr_cflags(struct uc_struct *uc)
 
 void tb_free(struct uc_struct *uc, TranslationBlock *tb);
 void tb_flush(CPUState *cpu);
+bool tb_warm(CPUState *cpu, const struct uc_tb_key *key); // SNPS added
 void tb_phys_invalidate(struct uc_struct *uc,
     TranslationBlock *tb, tb_page_addr_t page_addr);
+void tb_invalidate_virt_pc(struct uc_struct *uc, target_ulong pc); // SNPS added
+void tb_invalidate_virt_range(struct uc_struct *uc, target_ulong start,
+                              target_ulong end, bool hooked); // SNPS added
 TranslationBlock *tb_htable_lookup(CPUState *cpu, target_ulong pc,
                                    target_ulong cs_base, uint32_t flags,
                                    uint32_t cf_mask);
@@ -445,5 +506,7 @@ void page_size_init(struct uc_struct *uc);
 
 // SNPS added
 void dmi_invalidate(CPUState *cpu, uint64_t start, uint64_t end);
+void dmi_invalidate_ranges(CPUState *cpu, const struct uc_dmi_range *ranges,
+                           size_t count); // SNPS added
 
 #endif
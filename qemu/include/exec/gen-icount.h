@@ -11,7 +11,8 @@ static inline void gen_tb_start(TCGContext *tcg_ctx, TranslationBlock *tb)
 {
     //TCGv_i32 count, imm;
     TCGv_i32 flag;
-    TCGv_i64 ninsn, limit, dummy; // SNPS added
+    TCGv_i64 budget, left, dummy; // SNPS added
+    uc_bb_trace_t *trace = tcg_ctx->uc->bb_trace; // SNPS added
 
     tcg_ctx->exitreq_label = gen_new_label(tcg_ctx);
     flag = tcg_temp_new_i32(tcg_ctx);
@@ -55,27 +56,109 @@ static inline void gen_tb_start(TCGContext *tcg_ctx, TranslationBlock *tb)
     tcg_temp_free_i32(tcg_ctx, count);
 #endif
 
-    // SNPS added: check if we depleted our instruction budget
+    // SNPS added: make room in the trace buffer, it is flushed when full
+    if (trace != NULL) {
+        TCGLabel *room = gen_new_label(tcg_ctx);
+        TCGv_ptr pos = tcg_temp_new_ptr(tcg_ctx);
+        TCGv_ptr end = tcg_temp_new_ptr(tcg_ctx);
+        tcg_gen_ld_ptr(tcg_ctx, pos, tcg_ctx->cpu_env,
+                       offsetof(CPUState, bb_trace_pos) - offsetof(ArchCPU, env));
+        tcg_gen_ld_ptr(tcg_ctx, end, tcg_ctx->cpu_env,
+                       offsetof(CPUState, bb_trace_end) - offsetof(ArchCPU, env));
+        tcg_gen_brcond_ptr(tcg_ctx, TCG_COND_LTU, pos, end, room);
+        gen_helper_trace_bb_flush(tcg_ctx, tcg_ctx->cpu_env);
+        gen_set_label(tcg_ctx, room);
+        tcg_temp_free_ptr(tcg_ctx, end);
+        tcg_temp_free_ptr(tcg_ctx, pos);
+    }
+
+    // SNPS added: reserve room for the memory accesses of the TB in the
+    // memory trace, their number is patched in by gen_tb_end()
+    tcg_ctx->mem_trace = tcg_ctx->uc->mem_trace != NULL &&
+                         uc_mem_trace_covers(tcg_ctx->uc, tb->pc);
+    tcg_ctx->mem_trace_count = 0;
+    if (tcg_ctx->mem_trace) {
+        TCGLabel *room = gen_new_label(tcg_ctx);
+        TCGv_ptr pos = tcg_temp_new_ptr(tcg_ctx);
+        TCGv_ptr end = tcg_temp_new_ptr(tcg_ctx);
+        TCGv_i64 left = tcg_temp_new_i64(tcg_ctx);
+        TCGv_i64 need = tcg_temp_new_i64(tcg_ctx);
+        tcg_gen_ld_ptr(tcg_ctx, pos, tcg_ctx->cpu_env,
+                       offsetof(CPUState, mem_trace_pos) - offsetof(ArchCPU, env));
+        tcg_gen_ld_ptr(tcg_ctx, end, tcg_ctx->cpu_env,
+                       offsetof(CPUState, mem_trace_end) - offsetof(ArchCPU, env));
+        tcg_gen_extu_ptr_i64(tcg_ctx, left, end);
+        tcg_gen_extu_ptr_i64(tcg_ctx, need, pos);
+        tcg_gen_sub_i64(tcg_ctx, left, left, need);
+        tcg_gen_movi_i64(tcg_ctx, need, 0xfefefefefefefefe);
+        tcg_ctx->mem_trace_op[0] = tcg_last_op(tcg_ctx);
+        tcg_gen_brcond_i64(tcg_ctx, TCG_COND_GEU, left, need, room);
+        tcg_gen_movi_i64(tcg_ctx, need, 0xfefefefefefefefe);
+        tcg_ctx->mem_trace_op[1] = tcg_last_op(tcg_ctx);
+        gen_helper_mem_trace_flush(tcg_ctx, tcg_ctx->cpu_env, need);
+        gen_set_label(tcg_ctx, room);
+        tcg_temp_free_i64(tcg_ctx, need);
+        tcg_temp_free_i64(tcg_ctx, left);
+        tcg_temp_free_ptr(tcg_ctx, end);
+        tcg_temp_free_ptr(tcg_ctx, pos);
+    }
+
+    // SNPS added: count the TB down from the instruction budget. It is
+    // stored before the check, the exit path gives it back (see
+    // cpu_loop_exec_tb), so that no value lives across the branch.
     tcg_ctx->icount_label = gen_new_label(tcg_ctx);
-    limit = tcg_temp_new_i64(tcg_ctx);
-    ninsn = tcg_temp_local_new_i64(tcg_ctx);
-    tcg_gen_ld_i64(tcg_ctx, ninsn, tcg_ctx->cpu_env,
-                   offsetof(CPUState, insn_count) - offsetof(ArchCPU, env));
-    tcg_gen_ld_i64(tcg_ctx, limit, tcg_ctx->cpu_env,
-                   offsetof(CPUState, insn_limit) - offsetof(ArchCPU, env));
-    tcg_gen_brcond_i64(tcg_ctx, TCG_COND_GE, ninsn, limit,
-                       tcg_ctx->icount_label);
-    tcg_temp_free_i64(tcg_ctx, limit);
-
-    // SNPS added: update cpu->insn_count
+    budget = tcg_temp_new_i64(tcg_ctx);
+    left = tcg_temp_new_i64(tcg_ctx);
     dummy = tcg_temp_new_i64(tcg_ctx);
+    tcg_gen_ld_i64(tcg_ctx, budget, tcg_ctx->cpu_env,
+                   offsetof(ArchCPU, neg.insn_budget) - offsetof(ArchCPU, env));
+
+    // SNPS added: append the trace entry. The budget is recorded as is and
+    // turned into an instruction count by uc_bb_trace_flush(), the entry is
+    // dropped again if the TB is not entered (see cpu_loop_exec_tb).
+    if (trace != NULL) {
+        TCGv_ptr pos = tcg_temp_new_ptr(tcg_ctx);
+        TCGv_i64 val = tcg_temp_new_i64(tcg_ctx);
+        int ofs = 0;
+        tcg_gen_ld_ptr(tcg_ctx, pos, tcg_ctx->cpu_env,
+                       offsetof(CPUState, bb_trace_pos) - offsetof(ArchCPU, env));
+        tcg_gen_movi_i64(tcg_ctx, val, (int64_t)tb->pc);
+        tcg_gen_st_i64(tcg_ctx, val, pos, ofs);
+        ofs += 8;
+        if (trace->flags & UC_BB_TRACE_ICOUNT) {
+            tcg_gen_st_i64(tcg_ctx, budget, pos, ofs);
+            ofs += 8;
+        }
+        if (trace->flags & UC_BB_TRACE_TIME) {
+            gen_helper_trace_bb_time(tcg_ctx, val);
+            tcg_gen_st_i64(tcg_ctx, val, pos, ofs);
+            ofs += 8;
+        }
+        tcg_gen_addi_ptr(tcg_ctx, pos, pos, ofs);
+        tcg_gen_st_ptr(tcg_ctx, pos, tcg_ctx->cpu_env,
+                       offsetof(CPUState, bb_trace_pos) - offsetof(ArchCPU, env));
+        tcg_temp_free_i64(tcg_ctx, val);
+        tcg_temp_free_ptr(tcg_ctx, pos);
+    }
+
     tcg_gen_movi_i64(tcg_ctx, dummy, 0xfefefefefefefefe);
     tcg_ctx->icount_op = tcg_last_op(tcg_ctx);
-    tcg_gen_add_i64(tcg_ctx, ninsn, ninsn, dummy);
+    tcg_gen_sub_i64(tcg_ctx, left, budget, dummy);
+    tcg_gen_st_i64(tcg_ctx, left, tcg_ctx->cpu_env,
+                   offsetof(ArchCPU, neg.insn_budget) - offsetof(ArchCPU, env));
+
+    if (tcg_ctx->uc->exact_budget) {
+        // SNPS added: only enter if the whole TB fits into the budget, the
+        // remainder is executed by a shorter TB (see cpu_loop_exec_tb)
+        tcg_gen_brcondi_i64(tcg_ctx, TCG_COND_LT, left, 0,
+                            tcg_ctx->icount_label);
+    } else {
+        tcg_gen_brcondi_i64(tcg_ctx, TCG_COND_LE, budget, 0,
+                            tcg_ctx->icount_label);
+    }
     tcg_temp_free_i64(tcg_ctx, dummy);
-    tcg_gen_st_i64(tcg_ctx, ninsn, tcg_ctx->cpu_env,
-                   offsetof(CPUState, insn_count) - offsetof(ArchCPU, env));
-    tcg_temp_free_i64(tcg_ctx, ninsn);
+    tcg_temp_free_i64(tcg_ctx, left);
+    tcg_temp_free_i64(tcg_ctx, budget);
 
     // SNPS added: trace new TB if requested
     if (tcg_ctx->uc->uc_trace_bb_func != NULL) {
@@ -97,6 +180,12 @@ static inline void gen_tb_end(TCGContext *tcg_ctx, TranslationBlock *tb, int num
 #endif
     // SNPS added
     tcg_set_insn_param(tcg_ctx->icount_op, 1, num_insns);
+    if (tcg_ctx->mem_trace) {
+        size_t need = tcg_ctx->mem_trace_count *
+                      tcg_ctx->uc->mem_trace->words * sizeof(uint64_t);
+        tcg_set_insn_param(tcg_ctx->mem_trace_op[0], 1, need);
+        tcg_set_insn_param(tcg_ctx->mem_trace_op[1], 1, need);
+    }
     gen_set_label(tcg_ctx, tcg_ctx->icount_label);
     tcg_gen_exit_tb(tcg_ctx, tb, TB_EXIT_ICOUNT_EXPIRED);
 
@@ -49,6 +49,10 @@ typedef struct MemTxAttrs {
     unsigned int target_tlb_bit0 : 1;
     unsigned int target_tlb_bit1 : 1;
     unsigned int target_tlb_bit2 : 1;
+    /* SNPS added: the mapping belongs to the address space (ASID) it was
+     * filled for, rather than to all of them, see tlb_set_asid_by_mmuidx()
+     */
+    unsigned int tlb_nonglobal : 1;
 } MemTxAttrs;
 
 /* Bus masters which don't specify any attributes will get this,
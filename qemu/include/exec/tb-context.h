@@ -24,6 +24,8 @@
 
 #define CODE_GEN_PHYS_HASH_BITS     15
 #define CODE_GEN_PHYS_HASH_SIZE     (1 << CODE_GEN_PHYS_HASH_BITS)
+#define CODE_GEN_VIRT_HASH_BITS     12 // SNPS added
+#define CODE_GEN_VIRT_HASH_SIZE     (1 << CODE_GEN_VIRT_HASH_BITS) // SNPS added
 
 typedef struct TranslationBlock TranslationBlock;
 typedef struct TBContext TBContext;
@@ -32,6 +34,8 @@ struct TBContext {
 
     TranslationBlock **tbs;
     TranslationBlock *tb_phys_hash[CODE_GEN_PHYS_HASH_SIZE];
+    // SNPS added: by virtual page of the PC, see tb_invalidate_virt_pc()
+    TranslationBlock *tb_virt_hash[CODE_GEN_VIRT_HASH_SIZE];
     size_t tbs_size;
     int nb_tbs;
 
@@ -58,6 +58,14 @@ static inline unsigned int tb_jmp_cache_hash_func(target_ulong pc)
            | (tmp & TB_JMP_ADDR_MASK));
 }
 
+// SNPS added
+static inline uint32_t tb_virt_hash_func(target_ulong pc)
+{
+    target_ulong page = pc >> TARGET_PAGE_BITS;
+    return (page ^ (page >> CODE_GEN_VIRT_HASH_BITS)) &
+           (CODE_GEN_VIRT_HASH_SIZE - 1);
+}
+
 static inline
 uint32_t tb_hash_func(tb_page_addr_t phys_pc, target_ulong pc, uint32_t flags,
                       uint32_t cf_mask)
@@ -16,6 +16,25 @@
 #include "exec/exec-all.h"
 #include "exec/tb-hash.h"
 
+/* SNPS added: TBs carry the breakpoints of the vCPU and the hooks and traces
+ * of the engine that translated them. Where other vCPUs or engines of a
+ * tbgroup could pick them up, such TBs are only found by their owner. */
+static inline void *tb_owner(CPUState *cpu)
+{
+    struct uc_struct *uc = cpu->uc;
+
+    if (unlikely(!QTAILQ_EMPTY(&cpu->breakpoints)) &&
+        (uc->num_cpus > 1 || uc->tb_group)) {
+        return cpu;
+    }
+    if (uc->tb_group &&
+        (uc->hook[UC_HOOK_CODE_IDX].head || uc->hook[UC_HOOK_BLOCK_IDX].head ||
+         uc->uc_trace_bb_func || uc->bb_trace || uc->mem_trace)) {
+        return uc;
+    }
+    return NULL;
+}
+
 /* Might cause an exception, so have a longjmp destination ready */
 static inline TranslationBlock *
 tb_lookup__cpu_state(CPUState *cpu, target_ulong *pc, target_ulong *cs_base,
@@ -32,6 +51,7 @@ tb_lookup__cpu_state(CPUState *cpu, target_ulong *pc, target_ulong *cs_base,
                tb->pc == *pc &&
                tb->cs_base == *cs_base &&
                tb->flags == *flags &&
+               tb->owner == tb_owner(cpu) && // SNPS added
                (tb_cflags(tb) & (CF_HASH_MASK | CF_INVALID)) == cf_mask)) {
         return tb;
     }
@@ -8,4 +8,15 @@ struct QemuThread {
     pthread_t thread;
 };
 
+struct QemuMutex {
+    pthread_mutex_t lock;
+};
+
+struct QemuCond {
+    pthread_cond_t cond;
+};
+
+#define QEMU_MUTEX_INITIALIZER { PTHREAD_MUTEX_INITIALIZER }
+#define QEMU_COND_INITIALIZER  { PTHREAD_COND_INITIALIZER }
+
 #endif
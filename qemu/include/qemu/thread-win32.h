@@ -9,6 +9,17 @@ struct QemuThread {
     unsigned tid;
 };
 
+struct QemuMutex {
+    SRWLOCK lock;
+};
+
+struct QemuCond {
+    CONDITION_VARIABLE var;
+};
+
+#define QEMU_MUTEX_INITIALIZER { SRWLOCK_INIT }
+#define QEMU_COND_INITIALIZER  { CONDITION_VARIABLE_INIT }
+
 /* Only valid for joinable threads.  */
 HANDLE qemu_thread_get_handle(QemuThread *thread);
 
@@ -4,6 +4,8 @@
 #include "unicorn/platform.h"
 
 typedef struct QemuThread QemuThread;
+typedef struct QemuMutex QemuMutex;
+typedef struct QemuCond QemuCond;
 
 #ifdef _WIN32
 #include "qemu/thread-win32.h"
@@ -22,4 +24,18 @@ int qemu_thread_create(struct uc_struct *uc, QemuThread *thread, const char *nam
 void *qemu_thread_join(QemuThread *thread);
 void qemu_thread_exit(struct uc_struct *uc, void *retval);
 
+// SNPS added: statically initialized with QEMU_MUTEX/COND_INITIALIZER
+void qemu_mutex_init(QemuMutex *mutex);
+void qemu_mutex_destroy(QemuMutex *mutex);
+void qemu_mutex_lock(QemuMutex *mutex);
+void qemu_mutex_unlock(QemuMutex *mutex);
+void qemu_cond_signal(QemuCond *cond);
+void qemu_cond_wait(QemuCond *cond, QemuMutex *mutex);
+// return false if @ns nanoseconds passed without a signal
+bool qemu_cond_timedwait(QemuCond *cond, QemuMutex *mutex, int64_t ns);
+
+// SNPS added
+void qemu_thread_get_self(QemuThread *thread);
+bool qemu_thread_is_self(QemuThread *thread);
+
 #endif
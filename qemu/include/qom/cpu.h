@@ -214,6 +214,7 @@ typedef struct CPUBreakpoint {
     vaddr pc;
     int flags; /* BP_* */
     QTAILQ_ENTRY(CPUBreakpoint) entry;
+    struct CPUBreakpoint *hash_next; // SNPS added: same bucket of bp_hash
 } CPUBreakpoint;
 
 struct CPUWatchpoint {
@@ -223,20 +224,71 @@ struct CPUWatchpoint {
     MemTxAttrs hitattrs;
     int flags; /* BP_* */
     QTAILQ_ENTRY(CPUWatchpoint) entry;
+    uint64_t stamp; // SNPS added: last lookup that visited it
 };
 
 struct CPUWatchpointCallInfo {
     vaddr addr;
     vaddr len;
-    QTAILQ_ENTRY(CPUWatchpointCallInfo) entry;
 };
 
+// SNPS added: watchpoints are referenced from the buckets of the granules
+// they cover, or from wp_large if they cover more than CPU_WP_MAX_GRANULES
+#define CPU_WP_GRANULE_BITS 12
+#define CPU_WP_MAX_GRANULES 16
+#define CPU_WP_HASH_BITS 8
+#define CPU_WP_HASH_SIZE (1 << CPU_WP_HASH_BITS)
+
+typedef struct CPUWatchpointRef {
+    CPUWatchpoint *wp;
+    struct CPUWatchpointRef *next;
+} CPUWatchpointRef;
+
+// SNPS added: DMI pages used by page table walks, see tlb_walk_host()
+#define CPU_WALK_DMI_SIZE 16
+
+typedef struct CPUWalkDMI {
+    hwaddr page;
+    unsigned char *host;
+    int prot;
+} CPUWalkDMI;
+
+// SNPS added: last level tables found by page table walks, see
+// tlb_walk_cache_lookup()
+#define CPU_WALK_CACHE_BITS 7
+#define CPU_WALK_CACHE_SIZE (1 << CPU_WALK_CACHE_BITS)
+
+typedef struct CPUWalkCacheEntry {
+    /* the key: translation regime, table base register, other state the
+       walk depends on and the input address bits translated by the table */
+    int regime;
+    uint64_t base;
+    uint64_t ctx;
+    uint64_t prefix;
+    uint64_t prefix_mask;
+    int shift;           /* of the prefix in the input address */
+    uint32_t asid;       /* invalidated by tlb_flush_asid_by_mmuidx() */
+    uint16_t idxmap;     /* TLBs whose flushes invalidate it, 0 if unused */
+    /* the value */
+    hwaddr table;
+    uint64_t attrs;      /* target specific */
+} CPUWalkCacheEntry;
+
 struct KVMState;
 struct kvm_run;
 
 #define TB_JMP_CACHE_BITS 12
 #define TB_JMP_CACHE_SIZE (1 << TB_JMP_CACHE_BITS)
 
+// SNPS added: breakpoints hashed by PC, in the order of the breakpoints list
+#define CPU_BP_HASH_BITS 10
+#define CPU_BP_HASH_SIZE (1 << CPU_BP_HASH_BITS)
+
+static inline unsigned int cpu_bp_hash_func(vaddr pc)
+{
+    return (pc ^ (pc >> CPU_BP_HASH_BITS)) >> 1 & (CPU_BP_HASH_SIZE - 1);
+}
+
 /* The union type allows passing of 64 bit target pointers on 32 bit
  * hosts in a single parameter
  */
@@ -355,8 +407,17 @@ struct CPUState {
 
     /* ice debug support */
     QTAILQ_HEAD(breakpoints_head, CPUBreakpoint) breakpoints;
+    CPUBreakpoint *bp_hash[CPU_BP_HASH_SIZE]; // SNPS added
+    CPUWalkDMI walk_dmi[CPU_WALK_DMI_SIZE]; // SNPS added
+    uint64_t walk_host, walk_io; // SNPS added: see uc_tlb_stats()
+    CPUWalkCacheEntry walk_cache[CPU_WALK_CACHE_SIZE]; // SNPS added
+    uint16_t walk_cache_idxmap; // SNPS added: of all entries in use
+    uint64_t walk_cache_hits, walk_cache_misses; // SNPS added
 
     QTAILQ_HEAD(watchpoints_head, CPUWatchpoint) watchpoints;
+    CPUWatchpointRef *wp_hash[CPU_WP_HASH_SIZE]; // SNPS added
+    CPUWatchpointRef *wp_large; // SNPS added
+    uint64_t wp_stamp; // SNPS added
     CPUWatchpoint *watchpoint_hit;
 
     void *opaque;
@@ -399,8 +460,21 @@ struct CPUState {
     volatile sig_atomic_t tcg_exit_req;
     struct uc_struct* uc;
 
-    size_t insn_count; // SNPS added
-    size_t insn_limit; // SNPS added
+    size_t insn_limit; // SNPS added: initial value of neg.insn_budget
+    uintptr_t callout_pc; // SNPS added: host pc of running host callback
+    bool callout_lazy_pc; // SNPS added: guest pc not stored before callout
+    bool mem_hook_split; // SNPS added: pieces of an access already hooked
+
+    // SNPS added: buffered basic block trace, filled by generated code
+    uint64_t *bb_trace_pos;
+    uint64_t *bb_trace_end;
+    uint64_t bb_trace_discard[3]; // entries of TBs of other group members
+
+    // SNPS added: memory access trace, filled by generated code
+    uint64_t *mem_trace_pos;
+    uint64_t *mem_trace_end;
+    uint64_t *mem_trace_discard; // entries of TBs of other group members
+    size_t mem_trace_discard_size;
 
     bool is_idle; // SNPS added
 };
@@ -865,7 +939,8 @@ static inline bool cpu_breakpoint_test(CPUState *cpu, vaddr pc, int mask)
     CPUBreakpoint *bp;
 
     if (unlikely(!QTAILQ_EMPTY(&cpu->breakpoints))) {
-        QTAILQ_FOREACH(bp, &cpu->breakpoints, entry) {
+        // SNPS changed: only the bucket of the PC
+        for (bp = cpu->bp_hash[cpu_bp_hash_func(pc)]; bp; bp = bp->hash_next) {
             if (bp->pc == pc && (bp->flags & mask)) {
                 return true;
             }
@@ -146,8 +146,8 @@ MemoryRegion *memory_map_io(struct uc_struct *uc, hwaddr begin, size_t size,
     memory_region_init_io(uc, mmio, NULL, &uc_mmio_ops, opq, "uc.mmio", size);
     memory_region_add_subregion_overlap(get_system_memory(uc), begin, mmio, 0);
 
-    if (uc->current_cpu)
-    tlb_flush(uc->current_cpu);
+    if (uc->current_cpu && !uc->mem_map_batch) // SNPS changed
+        tlb_flush(uc->current_cpu);
 
     return mmio;
 }
@@ -166,7 +166,7 @@ MemoryRegion *memory_map(struct uc_struct *uc, hwaddr begin, size_t size, uint32
 
     memory_region_add_subregion(get_system_memory(uc), begin, ram);
 
-    if (uc->current_cpu)
+    if (uc->current_cpu && !uc->mem_map_batch) // SNPS changed
         tlb_flush(uc->current_cpu);
 
     return ram;
@@ -185,7 +185,7 @@ MemoryRegion *memory_map_ptr(struct uc_struct *uc, hwaddr begin, size_t size, ui
 
     memory_region_add_subregion(get_system_memory(uc), begin, ram);
 
-    if (uc->current_cpu)
+    if (uc->current_cpu && !uc->mem_map_batch) // SNPS changed
         tlb_flush(uc->current_cpu);
 
     return ram;
@@ -217,14 +217,8 @@ void memory_unmap(struct uc_struct *uc, MemoryRegion *mr)
     }
     memory_region_del_subregion(get_system_memory(uc), mr);
 
-    for (size_t i = 0; i < uc->mapped_block_count; i++) {
-        if (uc->mapped_blocks[i] == mr) {
-            uc->mapped_block_count--;
-            //shift remainder of array down over deleted pointer
-            memmove(&uc->mapped_blocks[i], &uc->mapped_blocks[i + 1], sizeof(MemoryRegion*) * (uc->mapped_block_count - i));
-            unicorn_free_memory_region(mr);
-            break;
-        }
+    if (memory_mapping_remove(uc, mr)) { // SNPS changed
+        unicorn_free_memory_region(mr);
     }
 
     // SNPS added
@@ -1156,7 +1150,9 @@ void memory_region_init(struct uc_struct *uc, MemoryRegion *mr,
 
     if (name) {
         char *escaped_name = memory_region_escape_name(name);
-        char *name_array = g_strdup_printf("%s[*]", escaped_name);
+        // SNPS changed: a unique index instead of a search for a free one
+        char *name_array = g_strdup_printf("%s[%u]", escaped_name,
+                                           uc->memory_region_seq++);
 
         if (!owner) {
             owner = qdev_get_machine(uc);
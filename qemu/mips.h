@@ -2715,6 +2715,9 @@
 #define tb_reset_jump tb_reset_jump_mips
 #define tb_set_jmp_target tb_set_jmp_target_mips
 #define tb_target_set_jmp_target tb_target_set_jmp_target_mips
+#define tb_warm tb_warm_mips
+#define tb_invalidate_virt_pc tb_invalidate_virt_pc_mips
+#define tb_invalidate_virt_range tb_invalidate_virt_range_mips
 #define tcg_accel_class_init tcg_accel_class_init_mips
 #define tcg_accel_type tcg_accel_type_mips
 #define tcg_add_param_i32 tcg_add_param_i32_mips
@@ -2746,6 +2749,7 @@
 #define tcg_emit_op tcg_emit_op_mips
 #define tcg_enabled tcg_enabled_mips
 #define tcg_exec_all tcg_exec_all_mips
+#define tcg_exec_attach tcg_exec_attach_mips
 #define tcg_exec_init tcg_exec_init_mips
 #define tcg_expand_vec_op tcg_expand_vec_op_mips
 #define tcg_find_helper tcg_find_helper_mips
@@ -3265,8 +3269,10 @@
 #define thumb2_logic_op thumb2_logic_op_mips
 #define ti925t_initfn ti925t_initfn_mips
 #define tlb_add_large_page tlb_add_large_page_mips
+#define tlb_destroy tlb_destroy_mips
 #define tlb_init tlb_init_mips
 #define tlb_flush tlb_flush_mips
+#define tlb_flush_asid_by_mmuidx tlb_flush_asid_by_mmuidx_mips
 #define tlb_flush_by_mmuidx tlb_flush_by_mmuidx_mips
 #define tlb_flush_entry tlb_flush_entry_mips
 #define tlb_flush_page tlb_flush_page_mips
@@ -3274,9 +3280,14 @@
 #define tlb_is_dirty_ram tlb_is_dirty_ram_mips
 #define tlb_reset_dirty tlb_reset_dirty_mips
 #define tlb_reset_dirty_range tlb_reset_dirty_range_mips
+#define tlb_set_asid_by_mmuidx tlb_set_asid_by_mmuidx_mips
 #define tlb_set_dirty tlb_set_dirty_mips
 #define tlb_set_page tlb_set_page_mips
 #define tlb_set_page_with_attrs tlb_set_page_with_attrs_mips
+#define tlb_stats tlb_stats_mips
+#define tlb_walk_host tlb_walk_host_mips
+#define tlb_walk_cache_lookup tlb_walk_cache_lookup_mips
+#define tlb_walk_cache_insert tlb_walk_cache_insert_mips
 #define tlb_vaddr_to_host tlb_vaddr_to_host_mips
 #define tlbi_aa64_asid_is_write tlbi_aa64_asid_is_write_mips
 #define tlbi_aa64_asid_write tlbi_aa64_asid_write_mips
@@ -3413,8 +3424,16 @@
 #define tlb_flush_page_all_cpus_synced tlb_flush_page_all_cpus_synced_mips
 #define tlb_flush_by_mmuidx_all_cpus_synced tlb_flush_by_mmuidx_all_cpus_synced_mips
 #define tlb_flush_page_by_mmuidx_all_cpus_synced tlb_flush_page_by_mmuidx_all_cpus_synced_mips
+#define tlb_flush_asid_by_mmuidx_all_cpus_synced tlb_flush_asid_by_mmuidx_all_cpus_synced_mips
 #define dmi_invalidate dmi_invalidate_mips
+#define dmi_invalidate_ranges dmi_invalidate_ranges_mips
 #define helper_trace_tb_entry helper_trace_tb_entry_mips
+#define helper_trace_bb_flush helper_trace_bb_flush_mips
+#define helper_trace_bb_time helper_trace_bb_time_mips
+#define helper_mem_trace_flush helper_mem_trace_flush_mips
+#define helper_uc_hook_code helper_uc_hook_code_mips
+#define cpu_insn_count cpu_insn_count_mips
+#define cpu_restore_callout_pc cpu_restore_callout_pc_mips
 #define MIPS64_REGS_STORAGE_SIZE MIPS64_REGS_STORAGE_SIZE_mips
 #define MIPS_REGS_STORAGE_SIZE MIPS_REGS_STORAGE_SIZE_mips
 #define cpu_mips_get_count cpu_mips_get_count_mips
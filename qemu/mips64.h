@@ -2715,6 +2715,9 @@
 #define tb_reset_jump tb_reset_jump_mips64
 #define tb_set_jmp_target tb_set_jmp_target_mips64
 #define tb_target_set_jmp_target tb_target_set_jmp_target_mips64
+#define tb_warm tb_warm_mips64
+#define tb_invalidate_virt_pc tb_invalidate_virt_pc_mips64
+#define tb_invalidate_virt_range tb_invalidate_virt_range_mips64
 #define tcg_accel_class_init tcg_accel_class_init_mips64
 #define tcg_accel_type tcg_accel_type_mips64
 #define tcg_add_param_i32 tcg_add_param_i32_mips64
@@ -2746,6 +2749,7 @@
 #define tcg_emit_op tcg_emit_op_mips64
 #define tcg_enabled tcg_enabled_mips64
 #define tcg_exec_all tcg_exec_all_mips64
+#define tcg_exec_attach tcg_exec_attach_mips64
 #define tcg_exec_init tcg_exec_init_mips64
 #define tcg_expand_vec_op tcg_expand_vec_op_mips64
 #define tcg_find_helper tcg_find_helper_mips64
@@ -3265,8 +3269,10 @@
 #define thumb2_logic_op thumb2_logic_op_mips64
 #define ti925t_initfn ti925t_initfn_mips64
 #define tlb_add_large_page tlb_add_large_page_mips64
+#define tlb_destroy tlb_destroy_mips64
 #define tlb_init tlb_init_mips64
 #define tlb_flush tlb_flush_mips64
+#define tlb_flush_asid_by_mmuidx tlb_flush_asid_by_mmuidx_mips64
 #define tlb_flush_by_mmuidx tlb_flush_by_mmuidx_mips64
 #define tlb_flush_entry tlb_flush_entry_mips64
 #define tlb_flush_page tlb_flush_page_mips64
@@ -3274,9 +3280,14 @@
 #define tlb_is_dirty_ram tlb_is_dirty_ram_mips64
 #define tlb_reset_dirty tlb_reset_dirty_mips64
 #define tlb_reset_dirty_range tlb_reset_dirty_range_mips64
+#define tlb_set_asid_by_mmuidx tlb_set_asid_by_mmuidx_mips64
 #define tlb_set_dirty tlb_set_dirty_mips64
 #define tlb_set_page tlb_set_page_mips64
 #define tlb_set_page_with_attrs tlb_set_page_with_attrs_mips64
+#define tlb_stats tlb_stats_mips64
+#define tlb_walk_host tlb_walk_host_mips64
+#define tlb_walk_cache_lookup tlb_walk_cache_lookup_mips64
+#define tlb_walk_cache_insert tlb_walk_cache_insert_mips64
 #define tlb_vaddr_to_host tlb_vaddr_to_host_mips64
 #define tlbi_aa64_asid_is_write tlbi_aa64_asid_is_write_mips64
 #define tlbi_aa64_asid_write tlbi_aa64_asid_write_mips64
@@ -3413,8 +3424,16 @@
 #define tlb_flush_page_all_cpus_synced tlb_flush_page_all_cpus_synced_mips64
 #define tlb_flush_by_mmuidx_all_cpus_synced tlb_flush_by_mmuidx_all_cpus_synced_mips64
 #define tlb_flush_page_by_mmuidx_all_cpus_synced tlb_flush_page_by_mmuidx_all_cpus_synced_mips64
+#define tlb_flush_asid_by_mmuidx_all_cpus_synced tlb_flush_asid_by_mmuidx_all_cpus_synced_mips64
 #define dmi_invalidate dmi_invalidate_mips64
+#define dmi_invalidate_ranges dmi_invalidate_ranges_mips64
 #define helper_trace_tb_entry helper_trace_tb_entry_mips64
+#define helper_trace_bb_flush helper_trace_bb_flush_mips64
+#define helper_trace_bb_time helper_trace_bb_time_mips64
+#define helper_mem_trace_flush helper_mem_trace_flush_mips64
+#define helper_uc_hook_code helper_uc_hook_code_mips64
+#define cpu_insn_count cpu_insn_count_mips64
+#define cpu_restore_callout_pc cpu_restore_callout_pc_mips64
 #define MIPS64_REGS_STORAGE_SIZE MIPS64_REGS_STORAGE_SIZE_mips64
 #define MIPS_REGS_STORAGE_SIZE MIPS_REGS_STORAGE_SIZE_mips64
 #define cpu_mips_get_count cpu_mips_get_count_mips64
@@ -2715,6 +2715,9 @@
 #define tb_reset_jump tb_reset_jump_mipsel
 #define tb_set_jmp_target tb_set_jmp_target_mipsel
 #define tb_target_set_jmp_target tb_target_set_jmp_target_mipsel
+#define tb_warm tb_warm_mipsel
+#define tb_invalidate_virt_pc tb_invalidate_virt_pc_mipsel
+#define tb_invalidate_virt_range tb_invalidate_virt_range_mipsel
 #define tcg_accel_class_init tcg_accel_class_init_mipsel
 #define tcg_accel_type tcg_accel_type_mipsel
 #define tcg_add_param_i32 tcg_add_param_i32_mipsel
@@ -2746,6 +2749,7 @@
 #define tcg_emit_op tcg_emit_op_mipsel
 #define tcg_enabled tcg_enabled_mipsel
 #define tcg_exec_all tcg_exec_all_mipsel
+#define tcg_exec_attach tcg_exec_attach_mipsel
 #define tcg_exec_init tcg_exec_init_mipsel
 #define tcg_expand_vec_op tcg_expand_vec_op_mipsel
 #define tcg_find_helper tcg_find_helper_mipsel
@@ -3265,8 +3269,10 @@
 #define thumb2_logic_op thumb2_logic_op_mipsel
 #define ti925t_initfn ti925t_initfn_mipsel
 #define tlb_add_large_page tlb_add_large_page_mipsel
+#define tlb_destroy tlb_destroy_mipsel
 #define tlb_init tlb_init_mipsel
 #define tlb_flush tlb_flush_mipsel
+#define tlb_flush_asid_by_mmuidx tlb_flush_asid_by_mmuidx_mipsel
 #define tlb_flush_by_mmuidx tlb_flush_by_mmuidx_mipsel
 #define tlb_flush_entry tlb_flush_entry_mipsel
 #define tlb_flush_page tlb_flush_page_mipsel
@@ -3274,9 +3280,14 @@
 #define tlb_is_dirty_ram tlb_is_dirty_ram_mipsel
 #define tlb_reset_dirty tlb_reset_dirty_mipsel
 #define tlb_reset_dirty_range tlb_reset_dirty_range_mipsel
+#define tlb_set_asid_by_mmuidx tlb_set_asid_by_mmuidx_mipsel
 #define tlb_set_dirty tlb_set_dirty_mipsel
 #define tlb_set_page tlb_set_page_mipsel
 #define tlb_set_page_with_attrs tlb_set_page_with_attrs_mipsel
+#define tlb_stats tlb_stats_mipsel
+#define tlb_walk_host tlb_walk_host_mipsel
+#define tlb_walk_cache_lookup tlb_walk_cache_lookup_mipsel
+#define tlb_walk_cache_insert tlb_walk_cache_insert_mipsel
 #define tlb_vaddr_to_host tlb_vaddr_to_host_mipsel
 #define tlbi_aa64_asid_is_write tlbi_aa64_asid_is_write_mipsel
 #define tlbi_aa64_asid_write tlbi_aa64_asid_write_mipsel
@@ -3413,8 +3424,16 @@
 #define tlb_flush_page_all_cpus_synced tlb_flush_page_all_cpus_synced_mipsel
 #define tlb_flush_by_mmuidx_all_cpus_synced tlb_flush_by_mmuidx_all_cpus_synced_mipsel
 #define tlb_flush_page_by_mmuidx_all_cpus_synced tlb_flush_page_by_mmuidx_all_cpus_synced_mipsel
+#define tlb_flush_asid_by_mmuidx_all_cpus_synced tlb_flush_asid_by_mmuidx_all_cpus_synced_mipsel
 #define dmi_invalidate dmi_invalidate_mipsel
+#define dmi_invalidate_ranges dmi_invalidate_ranges_mipsel
 #define helper_trace_tb_entry helper_trace_tb_entry_mipsel
+#define helper_trace_bb_flush helper_trace_bb_flush_mipsel
+#define helper_trace_bb_time helper_trace_bb_time_mipsel
+#define helper_mem_trace_flush helper_mem_trace_flush_mipsel
+#define helper_uc_hook_code helper_uc_hook_code_mipsel
+#define cpu_insn_count cpu_insn_count_mipsel
+#define cpu_restore_callout_pc cpu_restore_callout_pc_mipsel
 #define MIPS64_REGS_STORAGE_SIZE MIPS64_REGS_STORAGE_SIZE_mipsel
 #define MIPS_REGS_STORAGE_SIZE MIPS_REGS_STORAGE_SIZE_mipsel
 #define cpu_mips_get_count cpu_mips_get_count_mipsel
@@ -27,11 +27,16 @@
 
 CPUState *cpu_by_arch_id(struct uc_struct *uc, int64_t id)
 {
-    CPUState *cpu = uc->cpu;
-    CPUClass *cc = CPU_GET_CLASS(uc, cpu);
+    int i;
 
-    if (cc->get_arch_id(cpu) == id) {
-        return cpu;
+    // SNPS changed
+    for (i = 0; i < uc->num_cpus; i++) {
+        CPUState *cpu = uc->cpus[i];
+        CPUClass *cc = CPU_GET_CLASS(uc, cpu);
+
+        if (cc->get_arch_id(cpu) == id) {
+            return cpu;
+        }
     }
     return NULL;
 }
@@ -2715,6 +2715,9 @@
 #define tb_reset_jump tb_reset_jump_riscv64
 #define tb_set_jmp_target tb_set_jmp_target_riscv64
 #define tb_target_set_jmp_target tb_target_set_jmp_target_riscv64
+#define tb_warm tb_warm_riscv64
+#define tb_invalidate_virt_pc tb_invalidate_virt_pc_riscv64
+#define tb_invalidate_virt_range tb_invalidate_virt_range_riscv64
 #define tcg_accel_class_init tcg_accel_class_init_riscv64
 #define tcg_accel_type tcg_accel_type_riscv64
 #define tcg_add_param_i32 tcg_add_param_i32_riscv64
@@ -2746,6 +2749,7 @@
 #define tcg_emit_op tcg_emit_op_riscv64
 #define tcg_enabled tcg_enabled_riscv64
 #define tcg_exec_all tcg_exec_all_riscv64
+#define tcg_exec_attach tcg_exec_attach_riscv64
 #define tcg_exec_init tcg_exec_init_riscv64
 #define tcg_expand_vec_op tcg_expand_vec_op_riscv64
 #define tcg_find_helper tcg_find_helper_riscv64
@@ -3265,8 +3269,10 @@
 #define thumb2_logic_op thumb2_logic_op_riscv64
 #define ti925t_initfn ti925t_initfn_riscv64
 #define tlb_add_large_page tlb_add_large_page_riscv64
+#define tlb_destroy tlb_destroy_riscv64
 #define tlb_init tlb_init_riscv64
 #define tlb_flush tlb_flush_riscv64
+#define tlb_flush_asid_by_mmuidx tlb_flush_asid_by_mmuidx_riscv64
 #define tlb_flush_by_mmuidx tlb_flush_by_mmuidx_riscv64
 #define tlb_flush_entry tlb_flush_entry_riscv64
 #define tlb_flush_page tlb_flush_page_riscv64
@@ -3274,9 +3280,14 @@
 #define tlb_is_dirty_ram tlb_is_dirty_ram_riscv64
 #define tlb_reset_dirty tlb_reset_dirty_riscv64
 #define tlb_reset_dirty_range tlb_reset_dirty_range_riscv64
+#define tlb_set_asid_by_mmuidx tlb_set_asid_by_mmuidx_riscv64
 #define tlb_set_dirty tlb_set_dirty_riscv64
 #define tlb_set_page tlb_set_page_riscv64
 #define tlb_set_page_with_attrs tlb_set_page_with_attrs_riscv64
+#define tlb_stats tlb_stats_riscv64
+#define tlb_walk_host tlb_walk_host_riscv64
+#define tlb_walk_cache_lookup tlb_walk_cache_lookup_riscv64
+#define tlb_walk_cache_insert tlb_walk_cache_insert_riscv64
 #define tlb_vaddr_to_host tlb_vaddr_to_host_riscv64
 #define tlbi_aa64_asid_is_write tlbi_aa64_asid_is_write_riscv64
 #define tlbi_aa64_asid_write tlbi_aa64_asid_write_riscv64
@@ -3413,8 +3424,16 @@
 #define tlb_flush_page_all_cpus_synced tlb_flush_page_all_cpus_synced_riscv64
 #define tlb_flush_by_mmuidx_all_cpus_synced tlb_flush_by_mmuidx_all_cpus_synced_riscv64
 #define tlb_flush_page_by_mmuidx_all_cpus_synced tlb_flush_page_by_mmuidx_all_cpus_synced_riscv64
+#define tlb_flush_asid_by_mmuidx_all_cpus_synced tlb_flush_asid_by_mmuidx_all_cpus_synced_riscv64
 #define dmi_invalidate dmi_invalidate_riscv64
+#define dmi_invalidate_ranges dmi_invalidate_ranges_riscv64
 #define helper_trace_tb_entry helper_trace_tb_entry_riscv64
+#define helper_trace_bb_flush helper_trace_bb_flush_riscv64
+#define helper_trace_bb_time helper_trace_bb_time_riscv64
+#define helper_mem_trace_flush helper_mem_trace_flush_riscv64
+#define helper_uc_hook_code helper_uc_hook_code_riscv64
+#define cpu_insn_count cpu_insn_count_riscv64
+#define cpu_restore_callout_pc cpu_restore_callout_pc_riscv64
 #define RISCV32_REGS_STORAGE_SIZE RISCV32_REGS_STORAGE_SIZE_riscv64
 #define RISCV64_REGS_STORAGE_SIZE RISCV64_REGS_STORAGE_SIZE_riscv64
 #define cpu_riscv_get_fflags cpu_riscv_get_fflags_riscv64
@@ -3425,6 +3444,7 @@
 #define decode_insn32 decode_insn32_riscv64
 #define do_raise_exception_err do_raise_exception_err_riscv64
 #define gen_helper_tlb_flush gen_helper_tlb_flush_riscv64
+#define gen_helper_tlb_flush_asid gen_helper_tlb_flush_asid_riscv64
 #define helper_csrrc helper_csrrc_riscv64
 #define helper_csrrs helper_csrrs_riscv64
 #define helper_csrrw helper_csrrw_riscv64
@@ -3470,6 +3490,7 @@
 #define helper_fsub_s helper_fsub_s_riscv64
 #define helper_mret helper_mret_riscv64
 #define helper_tlb_flush helper_tlb_flush_riscv64
+#define helper_tlb_flush_asid helper_tlb_flush_asid_riscv64
 #define helper_set_rounding_mode helper_set_rounding_mode_riscv64
 #define helper_sret helper_sret_riscv64
 #define pmp_hart_has_privs pmp_hart_has_privs_riscv64
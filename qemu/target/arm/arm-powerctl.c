@@ -28,16 +28,16 @@
         } \
     } while (0)
 
-// Unicorn: commented out
-#if 0
-CPUState *arm_get_cpu_by_id(uint64_t id)
+// SNPS changed: look up the vCPUs of the engine
+CPUState *arm_get_cpu_by_id(struct uc_struct *uc, uint64_t id)
 {
-    CPUState *cpu;
+    int i;
 
     DPRINTF("cpu %" PRId64 "\n", id);
 
-    CPU_FOREACH(cpu) {
-        ARMCPU *armcpu = ARM_CPU(cpu);
+    for (i = 0; i < uc->num_cpus; i++) {
+        CPUState *cpu = uc->cpus[i];
+        ARMCPU *armcpu = ARM_CPU(uc, cpu);
 
         if (armcpu->mp_affinity == id) {
             return cpu;
@@ -50,13 +50,12 @@ CPUState *arm_get_cpu_by_id(uint64_t id)
 
     return NULL;
 }
-#endif
 
 int arm_set_cpu_on(struct uc_struct *uc,
                    uint64_t cpuid, uint64_t entry, uint64_t context_id,
                    uint32_t target_el, bool target_aa64)
 {
-    CPUState *target_cpu_state = uc->cpu;
+    CPUState *target_cpu_state;
     ARMCPU *target_cpu;
 
     DPRINTF("cpu %" PRId64 " (EL %d, %s) @ 0x%" PRIx64 " with R0 = 0x%" PRIx64
@@ -75,8 +74,7 @@ int arm_set_cpu_on(struct uc_struct *uc,
     }
 
     /* Retrieve the cpu we are powering up */
-    // Unicorn: commented out
-    //target_cpu_state = arm_get_cpu_by_id(cpuid);
+    target_cpu_state = arm_get_cpu_by_id(uc, cpuid); // SNPS changed
     if (!target_cpu_state) {
         /* The cpu was not found */
         return QEMU_ARM_POWERCTL_INVALID_PARAM;
@@ -170,6 +168,8 @@ int arm_set_cpu_on(struct uc_struct *uc,
         }
     }
 
+    arm_rebuild_hflags(&target_cpu->env); // SNPS added
+
     /* We check if the started CPU is now at the correct level */
     assert(target_el == arm_current_el(&target_cpu->env));
 
@@ -188,14 +188,13 @@ int arm_set_cpu_on(struct uc_struct *uc,
 
 int arm_set_cpu_off(struct uc_struct *uc, uint64_t cpuid)
 {
-    CPUState *target_cpu_state = uc->cpu;
+    CPUState *target_cpu_state;
     ARMCPU *target_cpu;
 
     DPRINTF("cpu %" PRId64 "\n", cpuid);
 
     /* change to the cpu we are powering up */
-    // Unicorn: commented out
-    //target_cpu_state = arm_get_cpu_by_id(cpuid);
+    target_cpu_state = arm_get_cpu_by_id(uc, cpuid); // SNPS changed
     if (!target_cpu_state) {
         return QEMU_ARM_POWERCTL_INVALID_PARAM;
     }
@@ -218,14 +217,13 @@ int arm_set_cpu_off(struct uc_struct *uc, uint64_t cpuid)
 
 int arm_reset_cpu(struct uc_struct *uc, uint64_t cpuid)
 {
-    CPUState *target_cpu_state = uc->cpu;
+    CPUState *target_cpu_state;
     ARMCPU *target_cpu;
 
     DPRINTF("cpu %" PRId64 "\n", cpuid);
 
     /* change to the cpu we are resetting */
-    // Unicorn: commented out
-    //target_cpu_state = arm_get_cpu_by_id(cpuid);
+    target_cpu_state = arm_get_cpu_by_id(uc, cpuid); // SNPS changed
     if (!target_cpu_state) {
         return QEMU_ARM_POWERCTL_INVALID_PARAM;
     }
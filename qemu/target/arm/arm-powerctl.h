@@ -18,8 +18,6 @@
 #define QEMU_ARM_POWERCTL_ALREADY_ON QEMU_PSCI_RET_ALREADY_ON
 #define QEMU_ARM_POWERCTL_IS_OFF QEMU_PSCI_RET_DENIED
 
-// Unicorn: Commented out
-#if 0
 /*
  * arm_get_cpu_by_id:
  * @cpuid: the id of the CPU we want to retrieve the state
@@ -28,8 +26,7 @@
  *
  * Returns: a pointer to the CPUState structure of the requested CPU.
  */
-CPUState *arm_get_cpu_by_id(uint64_t cpuid);
-#endif
+CPUState *arm_get_cpu_by_id(struct uc_struct *uc, uint64_t cpuid); // SNPS changed
 
 /*
  * arm_set_cpu_on:
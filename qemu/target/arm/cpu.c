@@ -409,6 +409,8 @@ static void arm_cpu_reset(CPUState *s)
 
     if (arm_feature(env, ARM_FEATURE_EL3) && arm_feature(env, ARM_FEATURE_EL2))
         env->cp15.scr_el3 |= SCR_HCE; // hypervisor call available
+
+    arm_rebuild_hflags(env); // SNPS added
 }
 
 static inline bool arm_excp_unmasked(CPUState *cs, unsigned int excp_idx,
@@ -1077,7 +1079,7 @@ static int arm_cpu_realizefn(struct uc_struct *uc, DeviceState *dev, Error **err
 
     /* No core_count specified, default to smp_cpus. */
     if (cpu->core_count == -1) {
-        cpu->core_count = smp_cpus;
+        cpu->core_count = uc->smp_cpus; // SNPS changed
     }
 #endif
 
@@ -1641,7 +1643,7 @@ static uint64_t a15_l2ctlr_read(CPUARMState *env, const ARMCPRegInfo *ri)
     /* Linux wants the number of processors from here.
      * Might as well set the interrupt-controller bit too.
      */
-    return ((smp_cpus - 1) << 24) | (1 << 23);
+    return ((env->uc->smp_cpus - 1) << 24) | (1 << 23); // SNPS changed
 }
 #endif
 
@@ -249,6 +249,9 @@ typedef struct CPUARMState {
     uint32_t btype;  /* BTI branch type.  spsr[11:10].  */
     uint64_t daif; /* exception masks, in the bits they are in PSTATE */
 
+    /* SNPS added: cached TB flags, see arm_rebuild_hflags() */
+    uint32_t hflags;
+
     uint64_t elr_el[4]; /* AArch64 exception link regs  */
     uint64_t sp_el[4]; /* AArch64 banked stack pointers */
 
@@ -3164,6 +3167,18 @@ static inline bool arm_cpu_bswap_data(CPUARMState *env)
 void cpu_get_tb_cpu_state(CPUARMState *env, target_ulong *pc,
                           target_ulong *cs_base, uint32_t *flags);
 
+/**
+ * arm_rebuild_hflags: (SNPS added)
+ * Rebuild the cached TB flags of an A profile CPU, which must be done
+ * after any change of the state they are computed from: exception level
+ * and execution state, PSTATE or CPSR bits other than the flags, and
+ * system registers. The program counter, Thumb, IT and BTYPE
+ * state, PSTATE.SS, FPEXC.EN and the short vector length are added by
+ * cpu_get_tb_cpu_state() on each lookup. Builds with CONFIG_DEBUG_TCG check
+ * the cached flags against a recomputation.
+ */
+void arm_rebuild_hflags(CPUARMState *env);
+
 enum {
     QEMU_PSCI_CONDUIT_DISABLED = 0,
     QEMU_PSCI_CONDUIT_SMC = 1,
@@ -83,12 +83,14 @@ void HELPER(msr_i_daifset)(CPUARMState *env, uint32_t imm)
 {
     daif_check(env, 0x1e, imm, GETPC());
     env->daif |= (imm << 6) & PSTATE_DAIF;
+    arm_rebuild_hflags(env); // SNPS added: PSTATE.D gates single step
 }
 
 void HELPER(msr_i_daifclear)(CPUARMState *env, uint32_t imm)
 {
     daif_check(env, 0x1f, imm, GETPC());
     env->daif &= ~((imm << 6) & PSTATE_DAIF);
+    arm_rebuild_hflags(env); // SNPS added: PSTATE.D gates single step
 }
 
 /* Convert a softfloat float_relation_ (as returned by
@@ -1051,6 +1053,7 @@ void HELPER(exception_return)(CPUARMState *env, uint64_t new_pc)
      * el0_a64 is return_to_aa64, else el0_a64 is ignored.
      */
     aarch64_sve_change_el(env, cur_el, new_el, return_to_aa64);
+    arm_rebuild_hflags(env); // SNPS added
 
     // Unicorn: commented out
     //qemu_mutex_lock_iothread();
@@ -1075,6 +1078,7 @@ illegal_return:
     if (!arm_singlestep_active(env)) {
         env->pstate &= ~PSTATE_SS;
     }
+    arm_rebuild_hflags(env); // SNPS added
     qemu_log_mask(LOG_GUEST_ERROR, "Illegal exception return at EL%d: "
                   "resuming execution at 0x%" PRIx64 "\n", cur_el, env->pc);
 }
@@ -424,17 +424,39 @@ static void fcse_write(CPUARMState *env, const ARMCPRegInfo *ri, uint64_t value)
 static void contextidr_write(CPUARMState *env, const ARMCPRegInfo *ri,
                              uint64_t value)
 {
-    ARMCPU *cpu = env_archcpu(env);
-
-    if (raw_read(env, ri) != value && !arm_feature(env, ARM_FEATURE_PMSA)
-        && !extended_addresses_enabled(env)) {
+    raw_write(env, ri, value);
+    if (!arm_feature(env, ARM_FEATURE_PMSA)) {
         /* For VMSA (when not using the LPAE long descriptor page table
-         * format) this register includes the ASID, so do a TLB flush.
+         * format) this register includes the ASID, so switch the TLB to it.
          * For PMSA it is purely a process ID and no action is needed.
          */
-        tlb_flush(CPU(cpu));
+        arm_tlb_update_asid(env); // SNPS changed
     }
-    raw_write(env, ri, value);
+}
+
+/* SNPS added: the MMU indexes of the regime an AArch32 TLBIASID applies
+ * to, or 0 if it is not tagged */
+static int tlbiasid_tlbmask(CPUARMState *env)
+{
+    if (arm_feature(env, ARM_FEATURE_PMSA) || arm_current_el(env) == 3) {
+        return 0;
+    }
+    if (arm_is_secure_below_el3(env)) {
+        return ARMMMUIdxBit_SE10_1 |
+               ARMMMUIdxBit_SE10_1_PAN |
+               ARMMMUIdxBit_SE10_0;
+    }
+    return ARMMMUIdxBit_E10_1 |
+           ARMMMUIdxBit_E10_1_PAN |
+           ARMMMUIdxBit_E10_0;
+}
+
+/* SNPS added: the TLB tag of @asid in the address spaces of @mask */
+static uint32_t tlbiasid_tag(CPUARMState *env, int mask, uint32_t asid)
+{
+    ARMMMUIdx mmu_idx = ctz32(mask) | ARM_MMU_IDX_A;
+
+    return (arm_mmu_idx_asid(env, mmu_idx) & 0xffff0000) | asid;
 }
 
 /* IS variants of TLB operations must affect all cores */
@@ -451,7 +473,14 @@ static void tlbiasid_is_write(CPUARMState *env, const ARMCPRegInfo *ri,
 {
 	// SNPS changed
     CPUState *cs = env_cpu(env);
-    tlb_flush_all_cpus_synced(cs);
+    int mask = tlbiasid_tlbmask(env);
+
+    if (mask) {
+        tlb_flush_asid_by_mmuidx_all_cpus_synced(cs,
+            tlbiasid_tag(env, mask, value & 0xff), mask);
+    } else {
+        tlb_flush_all_cpus_synced(cs);
+    }
 }
 
 static void tlbimva_is_write(CPUARMState *env, const ARMCPRegInfo *ri,
@@ -514,13 +543,20 @@ static void tlbiasid_write(CPUARMState *env, const ARMCPRegInfo *ri,
 {
     /* Invalidate by ASID (TLBIASID) */
     ARMCPU *cpu = env_archcpu(env);
+    int mask = tlbiasid_tlbmask(env); // SNPS added
 
     if (tlb_force_broadcast(env)) {
         tlbiasid_is_write(env, NULL, value);
         return;
     }
 
-    tlb_flush(CPU(cpu));
+    // SNPS changed
+    if (mask) {
+        tlb_flush_asid_by_mmuidx(CPU(cpu),
+                                 tlbiasid_tag(env, mask, value & 0xff), mask);
+    } else {
+        tlb_flush(CPU(cpu));
+    }
 }
 
 static void tlbimvaa_write(CPUARMState *env, const ARMCPRegInfo *ri,
@@ -3682,6 +3718,7 @@ static void vmsa_ttbcr_write(CPUARMState *env, const ARMCPRegInfo *ri,
     /* Preserve the high half of TCR_EL1, set via TTBCR2.  */
     value = deposit64(tcr->raw_tcr, 0, 32, value);
     vmsa_ttbcr_raw_write(env, ri, value);
+    arm_tlb_update_asid(env); // SNPS added
 }
 
 static void vmsa_ttbcr_reset(CPUARMState *env, const ARMCPRegInfo *ri)
@@ -3705,18 +3742,18 @@ static void vmsa_tcr_el12_write(CPUARMState *env, const ARMCPRegInfo *ri,
     /* For AArch64 the A1 bit could result in a change of ASID, so TLB flush. */
     tlb_flush(CPU(cpu));
     tcr->raw_tcr = value;
+    arm_tlb_update_asid(env); // SNPS added
 }
 
 static void vmsa_ttbr_write(CPUARMState *env, const ARMCPRegInfo *ri,
                             uint64_t value)
 {
-    /* If the ASID changes (with a 64-bit write), we must flush the TLB.  */
-    if (cpreg_field_is_64bit(ri) &&
-        extract64(raw_read(env, ri) ^ value, 48, 16) != 0) {
-        ARMCPU *cpu = env_archcpu(env);
-        tlb_flush(CPU(cpu));
-    }
+    /* SNPS changed: if the ASID changes (with a 64-bit write), switch the
+     * TLB to it rather than flushing it.  */
     raw_write(env, ri, value);
+    if (cpreg_field_is_64bit(ri)) {
+        arm_tlb_update_asid(env);
+    }
 }
 
 static void vmsa_tcr_ttbr_el2_write(CPUARMState *env, const ARMCPRegInfo *ri,
@@ -3724,18 +3761,10 @@ static void vmsa_tcr_ttbr_el2_write(CPUARMState *env, const ARMCPRegInfo *ri,
 {
     /*
      * If we are running with E2&0 regime, then an ASID is active.
-     * Flush if that might be changing.  Note we're not checking
-     * TCR_EL2.A1 to know if this is really the TTBRx_EL2 that
-     * holds the active ASID, only checking the field that might.
+     * SNPS changed: switch the TLB to it if that might be changing.
      */
-    if (extract64(raw_read(env, ri) ^ value, 48, 16) &&
-        (arm_hcr_el2_eff(env) & HCR_E2H)) {
-        tlb_flush_by_mmuidx(env_cpu(env),
-                            ARMMMUIdxBit_E20_2 |
-                            ARMMMUIdxBit_E20_2_PAN |
-                            ARMMMUIdxBit_E20_0);
-    }
     raw_write(env, ri, value);
+    arm_tlb_update_asid(env);
 }
 
 static void vttbr_write(CPUARMState *env, const ARMCPRegInfo *ri,
@@ -3747,13 +3776,18 @@ static void vttbr_write(CPUARMState *env, const ARMCPRegInfo *ri,
     /*
      * A change in VMID to the stage2 page table (Stage2) invalidates
      * the combined stage 1&2 tlbs (EL10_1 and EL10_0).
+     * SNPS changed: they are tagged with the VMID, so only a change of the
+     * table of the same VMID requires a flush.
      */
     if (raw_read(env, ri) != value) {
-        tlb_flush_by_mmuidx(cs,
-                            ARMMMUIdxBit_E10_1 |
-                            ARMMMUIdxBit_E10_1_PAN |
-                            ARMMMUIdxBit_E10_0);
+        if (extract64(raw_read(env, ri) ^ value, 48, 16) == 0) {
+            tlb_flush_by_mmuidx(cs,
+                                ARMMMUIdxBit_E10_1 |
+                                ARMMMUIdxBit_E10_1_PAN |
+                                ARMMMUIdxBit_E10_0);
+        }
         raw_write(env, ri, value);
+        arm_tlb_update_asid(env);
     }
 }
 
@@ -4213,6 +4247,41 @@ static void tlbi_aa64_vmalle1is_write(CPUARMState *env, const ARMCPRegInfo *ri,
 #endif
 }
 
+// SNPS added: TLBI ASIDE1IS, invalidate the non-global entries of an ASID
+static void tlbi_aa64_aside1is_write(CPUARMState *env, const ARMCPRegInfo *ri,
+                                     uint64_t value)
+{
+    int mask = vae1_tlbmask(env);
+    int el = (mask & ARMMMUIdxBit_E20_0) ? 2 : 1;
+    uint32_t asid = extract64(value, 48, 16);
+
+    if (!extract64(env->cp15.tcr_el[el].raw_tcr, 36, 1)) {
+        asid &= 0xff; /* TCR.AS */
+    }
+    tlb_flush_asid_by_mmuidx_all_cpus_synced(env_cpu(env),
+                                             tlbiasid_tag(env, mask, asid),
+                                             mask);
+}
+
+// SNPS added
+static void tlbi_aa64_aside1_write(CPUARMState *env, const ARMCPRegInfo *ri,
+                                   uint64_t value)
+{
+    int mask = vae1_tlbmask(env);
+    int el = (mask & ARMMMUIdxBit_E20_0) ? 2 : 1;
+    uint32_t asid = extract64(value, 48, 16);
+
+    if (tlb_force_broadcast(env)) {
+        tlbi_aa64_aside1is_write(env, NULL, value);
+        return;
+    }
+
+    if (!extract64(env->cp15.tcr_el[el].raw_tcr, 36, 1)) {
+        asid &= 0xff; /* TCR.AS */
+    }
+    tlb_flush_asid_by_mmuidx(env_cpu(env), tlbiasid_tag(env, mask, asid), mask);
+}
+
 static void tlbi_aa64_vmalle1_write(CPUARMState *env, const ARMCPRegInfo *ri,
                                     uint64_t value)
 {
@@ -4487,6 +4556,14 @@ static void sctlr_write(CPUARMState *env, const ARMCPRegInfo *ri,
     /* ??? Lots of these bits are not implemented.  */
     /* This may enable/disable the MMU, so do a TLB flush.  */
     tlb_flush(CPU(cpu));
+
+    // SNPS added
+    if (ri->type & ARM_CP_SUPPRESS_TB_END) {
+        /* The translator does not rebuild the hflags after writes that do
+         * not end the TB, see the XScale SCTLR definition below.
+         */
+        arm_rebuild_hflags(env);
+    }
 }
 
 static CPAccessResult fpexc32_access(CPUARMState *env, const ARMCPRegInfo *ri,
@@ -4593,7 +4670,7 @@ static const ARMCPRegInfo v8_cp_reginfo[] = {
     { .name = "TLBI_ASIDE1IS", .state = ARM_CP_STATE_AA64,
       .opc0 = 1, .opc1 = 0, .crn = 8, .crm = 3, .opc2 = 2,
       .access = PL1_W, .accessfn = access_ttlb, .type = ARM_CP_NO_RAW,
-      .writefn = tlbi_aa64_vmalle1is_write },
+      .writefn = tlbi_aa64_aside1is_write }, // SNPS changed
     { .name = "TLBI_VAAE1IS", .state = ARM_CP_STATE_AA64,
       .opc0 = 1, .opc1 = 0, .crn = 8, .crm = 3, .opc2 = 3,
       .access = PL1_W, .accessfn = access_ttlb, .type = ARM_CP_NO_RAW,
@@ -4617,7 +4694,7 @@ static const ARMCPRegInfo v8_cp_reginfo[] = {
     { .name = "TLBI_ASIDE1", .state = ARM_CP_STATE_AA64,
       .opc0 = 1, .opc1 = 0, .crn = 8, .crm = 7, .opc2 = 2,
       .access = PL1_W, .accessfn = access_ttlb, .type = ARM_CP_NO_RAW,
-      .writefn = tlbi_aa64_vmalle1_write },
+      .writefn = tlbi_aa64_aside1_write }, // SNPS changed
     { .name = "TLBI_VAAE1", .state = ARM_CP_STATE_AA64,
       .opc0 = 1, .opc1 = 0, .crn = 8, .crm = 7, .opc2 = 3,
       .access = PL1_W, .accessfn = access_ttlb, .type = ARM_CP_NO_RAW,
@@ -5014,6 +5091,7 @@ static void do_hcr_write(CPUARMState *env, uint64_t value, uint64_t valid_mask)
         tlb_flush(CPU(cpu));
     }
     env->cp15.hcr_el2 = value;
+    arm_tlb_update_asid(env); // SNPS added: E2H and TGE select the regime
 
     /*
      * Updates to VI and VF require us to update the status of
@@ -9415,6 +9493,7 @@ void arm_cpu_do_interrupt(CPUState *cs)
     } else {
         arm_cpu_do_interrupt_aarch32_(cs);
     }
+    arm_rebuild_hflags(env); // SNPS added
 
     arm_call_el_change_hook(cpu);
 
@@ -9598,6 +9677,71 @@ bool arm_s1_regime_using_lpae_format(CPUARMState *env, ARMMMUIdx mmu_idx)
     return regime_using_lpae_format(env, mmu_idx);
 }
 
+// SNPS added
+uint32_t arm_mmu_idx_asid(CPUARMState *env, ARMMMUIdx mmu_idx)
+{
+    uint32_t asid, vmid = 0;
+    int el;
+
+    switch (mmu_idx) {
+    case ARMMMUIdx_E10_0:
+    case ARMMMUIdx_E10_1:
+    case ARMMMUIdx_E10_1_PAN:
+        if (arm_feature(env, ARM_FEATURE_EL2)) {
+            vmid = extract64(env->cp15.vttbr_el2, 48, 16);
+        }
+        break;
+    case ARMMMUIdx_E20_0:
+    case ARMMMUIdx_E20_2:
+    case ARMMMUIdx_E20_2_PAN:
+    case ARMMMUIdx_SE10_0:
+    case ARMMMUIdx_SE10_1:
+    case ARMMMUIdx_SE10_1_PAN:
+        break;
+    case ARMMMUIdx_SE3:
+        /* AArch32 EL3 is the secure PL1 of the EL3&0 regime */
+        if (!arm_el_is_aa64(env, 3)) {
+            break;
+        }
+        /* fall through */
+    default:
+        return 0;
+    }
+
+    el = regime_el(env, mmu_idx);
+    if (regime_using_lpae_format(env, mmu_idx)) {
+        uint64_t tcr = regime_tcr(env, mmu_idx)->raw_tcr;
+
+        asid = extract64(regime_ttbr(env, mmu_idx, (tcr & TTBCR_A1) ? 1 : 0),
+                         48, 16);
+        if (!arm_el_is_aa64(env, el) || !extract64(tcr, 36, 1)) {
+            asid &= 0xff; /* TCR.AS */
+        }
+    } else {
+        bool secure = regime_is_secure(env, mmu_idx) &&
+                      arm_feature(env, ARM_FEATURE_EL3) &&
+                      !arm_el_is_aa64(env, 3);
+
+        asid = A32_BANKED_REG_GET(env, contextidr, secure) & 0xff;
+    }
+    return vmid << 16 | asid;
+}
+
+// SNPS added
+void arm_tlb_update_asid(CPUARMState *env)
+{
+    CPUState *cs = env_cpu(env);
+    int i;
+
+    if (arm_feature(env, ARM_FEATURE_M)) {
+        return;
+    }
+    for (i = 0; i < NB_MMU_MODES; i++) {
+        tlb_set_asid_by_mmuidx(cs, arm_mmu_idx_asid(env, i | ARM_MMU_IDX_A),
+                               1 << i);
+    }
+}
+
 #ifndef CONFIG_USER_ONLY
 static inline bool regime_is_user(CPUARMState *env, ARMMMUIdx mmu_idx)
 {
@@ -9917,6 +10061,7 @@ static uint32_t arm_ldl_ptw(CPUState *cs, hwaddr addr, bool is_secure,
     MemTxResult result = MEMTX_OK;
     AddressSpace *as;
     uint32_t data;
+    void *host; // SNPS added
 
     attrs.secure = is_secure;
     as = arm_addressspace(cs, attrs);
@@ -9924,6 +10069,12 @@ static uint32_t arm_ldl_ptw(CPUState *cs, hwaddr addr, bool is_secure,
     if (fi->s1ptw) {
         return 0;
     }
+    // SNPS added: RAM and DMI pages without the memory API
+    host = tlb_walk_host(cs, as, addr, false);
+    if (host) {
+        return regime_translation_big_endian(env, mmu_idx) ? ldl_be_p(host)
+                                                           : ldl_le_p(host);
+    }
     if (regime_translation_big_endian(env, mmu_idx)) {
         data = address_space_ldl_be(as, addr, attrs, &result);
     } else {
@@ -9946,6 +10097,7 @@ static uint64_t arm_ldq_ptw(CPUState *cs, hwaddr addr, bool is_secure,
     MemTxResult result = MEMTX_OK;
     AddressSpace *as;
     uint64_t data;
+    void *host; // SNPS added
 
     attrs.secure = is_secure;
     as = arm_addressspace(cs, attrs);
@@ -9953,6 +10105,12 @@ static uint64_t arm_ldq_ptw(CPUState *cs, hwaddr addr, bool is_secure,
     if (fi->s1ptw) {
         return 0;
     }
+    // SNPS added: RAM and DMI pages without the memory API
+    host = tlb_walk_host(cs, as, addr, false);
+    if (host) {
+        return regime_translation_big_endian(env, mmu_idx) ? ldq_be_p(host)
+                                                           : ldq_le_p(host);
+    }
     if (regime_translation_big_endian(env, mmu_idx)) {
         data = address_space_ldq_be(as, addr, attrs, &result);
     } else {
@@ -10163,6 +10321,7 @@ static bool get_phys_addr_v6(CPUARMState *env, uint32_t address,
         xn = desc & (1 << 4);
         pxn = desc & 1;
         ns = extract32(desc, 19, 1);
+        attrs->tlb_nonglobal = extract32(desc, 17, 1); /* nG */ // SNPS added
     } else {
         if (arm_feature(env, ARM_FEATURE_PXN)) {
             pxn = (desc >> 2) & 1;
@@ -10176,6 +10335,7 @@ static bool get_phys_addr_v6(CPUARMState *env, uint32_t address,
             goto do_fault;
         }
         ap = ((desc >> 4) & 3) | ((desc >> 7) & 4);
+        attrs->tlb_nonglobal = extract32(desc, 11, 1); /* nG */ // SNPS added
         switch (desc & 3) {
         case 0: /* Page translation fault.  */
             fi->type = ARMFault_Translation;
@@ -10491,6 +10651,52 @@ static ARMVAParameters aa32_va_parameters(CPUARMState *env, uint32_t va,
     };
 }
 
+// SNPS added: the walk cache entries of the MMU indexes of a translation
+// regime are shared, as they walk the same tables, and are dropped by
+// flushes of any of them. Stage 2 and the stage 1 indexes without a TLB
+// belong to the EL1&0 regime.
+static void arm_walk_cache_regime(CPUARMState *env, ARMMMUIdx mmu_idx,
+                                  CPUWalkCacheEntry *walk)
+{
+    switch (mmu_idx) {
+    case ARMMMUIdx_E10_0:
+    case ARMMMUIdx_E10_1:
+    case ARMMMUIdx_E10_1_PAN:
+    case ARMMMUIdx_Stage1_E0:
+    case ARMMMUIdx_Stage1_E1:
+    case ARMMMUIdx_Stage1_E1_PAN:
+        walk->regime = ARMMMUIdx_E10_1;
+        walk->idxmap = ARMMMUIdxBit_E10_0 | ARMMMUIdxBit_E10_1 |
+                       ARMMMUIdxBit_E10_1_PAN;
+        break;
+    case ARMMMUIdx_Stage2:
+        walk->regime = ARMMMUIdx_Stage2;
+        walk->idxmap = ARMMMUIdxBit_E10_0 | ARMMMUIdxBit_E10_1 |
+                       ARMMMUIdxBit_E10_1_PAN;
+        walk->asid = 0;
+        return;
+    case ARMMMUIdx_E20_0:
+    case ARMMMUIdx_E20_2:
+    case ARMMMUIdx_E20_2_PAN:
+        walk->regime = ARMMMUIdx_E20_2;
+        walk->idxmap = ARMMMUIdxBit_E20_0 | ARMMMUIdxBit_E20_2 |
+                       ARMMMUIdxBit_E20_2_PAN;
+        break;
+    case ARMMMUIdx_SE10_0:
+    case ARMMMUIdx_SE10_1:
+    case ARMMMUIdx_SE10_1_PAN:
+        walk->regime = ARMMMUIdx_SE10_1;
+        walk->idxmap = ARMMMUIdxBit_SE10_0 | ARMMMUIdxBit_SE10_1 |
+                       ARMMMUIdxBit_SE10_1_PAN;
+        break;
+    default:
+        walk->regime = mmu_idx;
+        walk->idxmap = 1 << arm_to_core_mmu_idx(mmu_idx);
+        break;
+    }
+    walk->asid = arm_mmu_idx_asid(env, walk->regime);
+}
+
 /**
  * get_phys_addr_lpae: perform one stage of page table walk, LPAE format
  *
@@ -10540,6 +10746,8 @@ static bool get_phys_addr_lpae(CPUARMState *env, target_ulong address,
     uint64_t descaddrmask;
     bool aarch64 = arm_el_is_aa64(env, el);
     bool guarded = false;
+    CPUWalkCacheEntry walk; // SNPS added
+    const CPUWalkCacheEntry *cached;
 
     /* TODO: This code does not support shareability levels. */
     if (aarch64) {
@@ -10673,6 +10881,25 @@ static bool get_phys_addr_lpae(CPUARMState *env, target_ulong address,
      * bits at each step.
      */
     tableattrs = regime_is_secure(env, mmu_idx) ? 0 : (1 << 4);
+
+    // SNPS added: continue at the last level if its table is cached
+    if (level < 3) {
+        arm_walk_cache_regime(env, mmu_idx, &walk);
+        walk.shift = 2 * stride + 3;
+        walk.regime |= param.select << 8 | aarch64 << 9;
+        walk.base = ttbr;
+        walk.ctx = tcr->raw_tcr;
+        walk.prefix_mask = (1ULL << (inputsize - walk.shift)) - 1;
+        walk.prefix = (address >> walk.shift) & walk.prefix_mask;
+        cached = tlb_walk_cache_lookup(cs, &walk);
+        if (cached) {
+            level = 3;
+            descaddr = cached->table;
+            tableattrs = cached->attrs;
+            indexmask = indexmask_grainsize;
+        }
+    }
+
     for (;;) {
         uint64_t descriptor;
         bool nstable;
@@ -10702,6 +10929,11 @@ static bool get_phys_addr_lpae(CPUARMState *env, target_ulong address,
             tableattrs |= extract64(descriptor, 59, 5);
             level++;
             indexmask = indexmask_grainsize;
+            if (level == 3) { // SNPS added
+                walk.table = descaddr;
+                walk.attrs = tableattrs;
+                tlb_walk_cache_insert(cs, &walk);
+            }
             continue;
         }
         /*
@@ -10756,6 +10988,7 @@ static bool get_phys_addr_lpae(CPUARMState *env, target_ulong address,
         xn = extract32(attrs, 12, 1);
         pxn = extract32(attrs, 11, 1);
         *prot = get_S1prot(env, mmu_idx, aarch64, ap, ns, xn, pxn);
+        txattrs->tlb_nonglobal = extract32(attrs, 9, 1); /* nG */ // SNPS added
     }
 
     fault_type = ARMFault_Permission;
@@ -12217,8 +12450,9 @@ ARMMMUIdx arm_stage1_mmu_idx(CPUARMState *env)
 }
 #endif
 
-void cpu_get_tb_cpu_state(CPUARMState *env, target_ulong *pc,
-                          target_ulong *cs_base, uint32_t *pflags)
+// SNPS changed: was cpu_get_tb_cpu_state(), the flags that are cached in
+// env->hflags, see arm_rebuild_hflags()
+static uint32_t rebuild_hflags(CPUARMState *env)
 {
     int current_el = arm_current_el(env);
     ARMMMUIdx mmu_idx = arm_mmu_idx_el(env, current_el);
@@ -12229,7 +12463,6 @@ void cpu_get_tb_cpu_state(CPUARMState *env, target_ulong *pc,
         ARMCPU *cpu = env_archcpu(env);
         uint64_t sctlr;
 
-        *pc = env->pc;
         flags = FIELD_DP32(flags, TBFLAG_ANY, AARCH64_STATE, 1);
         ARMMMUIdx stage1 = stage_1_mmu_idx(mmu_idx);
 
@@ -12281,7 +12514,6 @@ void cpu_get_tb_cpu_state(CPUARMState *env, target_ulong *pc,
             if (sctlr & (current_el == 0 ? SCTLR_BT0 : SCTLR_BT1)) {
                 flags = FIELD_DP32(flags, TBFLAG_A64, BT, 1);
             }
-            flags = FIELD_DP32(flags, TBFLAG_A64, BTYPE, env->btype);
         }
 
         /* Compute the condition for using AccType_UNPRIV for LDTR et al. */
@@ -12310,15 +12542,9 @@ void cpu_get_tb_cpu_state(CPUARMState *env, target_ulong *pc,
             }
         }
     } else {
-        *pc = env->regs[15];
-        flags = FIELD_DP32(flags, TBFLAG_AM32, THUMB, env->thumb);
-        flags = FIELD_DP32(flags, TBFLAG_A32, VECLEN, env->vfp.vec_len);
-        flags = FIELD_DP32(flags, TBFLAG_A32, VECSTRIDE, env->vfp.vec_stride);
-        flags = FIELD_DP32(flags, TBFLAG_AM32, CONDEXEC, env->condexec_bits);
         flags = FIELD_DP32(flags, TBFLAG_A32, SCTLR_B, arm_sctlr_b(env));
         flags = FIELD_DP32(flags, TBFLAG_A32, NS, !access_secure_reg(env));
-        if (env->vfp.xregs[ARM_VFP_FPEXC] & (1 << 30)
-            || arm_el_is_aa64(env, 1) || arm_feature(env, ARM_FEATURE_M)) {
+        if (arm_el_is_aa64(env, 1) || arm_feature(env, ARM_FEATURE_M)) {
             flags = FIELD_DP32(flags, TBFLAG_A32, VFPEN, 1);
         }
 
@@ -12326,12 +12552,6 @@ void cpu_get_tb_cpu_state(CPUARMState *env, target_ulong *pc,
             (arm_hcr_el2_eff(env) & (HCR_E2H | HCR_TGE)) != (HCR_E2H | HCR_TGE)) {
             flags = FIELD_DP32(flags, TBFLAG_A32, HSTR_ACTIVE, 1);
         }
-
-        /* Note that XSCALE_CPAR shares bits with VECSTRIDE */
-        if (arm_feature(env, ARM_FEATURE_XSCALE)) {
-            flags = FIELD_DP32(flags, TBFLAG_A32,
-                               XSCALE_CPAR, env->cp15.c15_cpar);
-        }
     }
 
     flags = FIELD_DP32(flags, TBFLAG_ANY, MMUIDX, arm_to_core_mmu_idx(mmu_idx));
@@ -12346,15 +12566,6 @@ void cpu_get_tb_cpu_state(CPUARMState *env, target_ulong *pc,
      */
     if (arm_singlestep_active(env)) {
         flags = FIELD_DP32(flags, TBFLAG_ANY, SS_ACTIVE, 1);
-        if (is_a64(env)) {
-            if (env->pstate & PSTATE_SS) {
-                flags = FIELD_DP32(flags, TBFLAG_ANY, PSTATE_SS, 1);
-            }
-        } else {
-            if (env->uncached_cpsr & PSTATE_SS) {
-                flags = FIELD_DP32(flags, TBFLAG_ANY, PSTATE_SS, 1);
-            }
-        }
     }
     if (arm_cpu_data_is_big_endian(env)) {
         flags = FIELD_DP32(flags, TBFLAG_ANY, BE_DATA, 1);
@@ -12408,6 +12619,85 @@ void cpu_get_tb_cpu_state(CPUARMState *env, target_ulong *pc,
         flags = FIELD_DP32(flags, TBFLAG_ANY, DEBUG_TARGET_EL, target_el);
     }
 
+    return flags;
+}
+
+// SNPS added
+void arm_rebuild_hflags(CPUARMState *env)
+{
+    env->hflags = rebuild_hflags(env);
+}
+
+// SNPS added
+void HELPER(rebuild_hflags)(CPUARMState *env)
+{
+    arm_rebuild_hflags(env);
+}
+
+// SNPS added: a stale cached flag would silently run TBs translated for
+// another state, so debug builds recompute them on each lookup
+static inline void assert_hflags_rebuild_correctly(CPUARMState *env)
+{
+#ifdef CONFIG_DEBUG_TCG
+    uint32_t rebuilt = rebuild_hflags(env);
+
+    if (unlikely(env->hflags != rebuilt)) {
+        fprintf(stderr, "TCG hflags mismatch (current:0x%08x rebuilt:0x%08x)\n",
+                env->hflags, rebuilt);
+        abort();
+    }
+#endif
+}
+
+// SNPS changed: the flags are cached in env->hflags, except on M profile
+// cores, which do not rebuild them on all the changes of their state
+void cpu_get_tb_cpu_state(CPUARMState *env, target_ulong *pc,
+                          target_ulong *cs_base, uint32_t *pflags)
+{
+    uint32_t flags;
+
+    if (arm_feature(env, ARM_FEATURE_M)) {
+        flags = rebuild_hflags(env);
+    } else {
+        assert_hflags_rebuild_correctly(env);
+        flags = env->hflags;
+    }
+
+    if (is_a64(env)) {
+        *pc = env->pc;
+        if (cpu_isar_feature(aa64_bti, env_archcpu(env))) {
+            flags = FIELD_DP32(flags, TBFLAG_A64, BTYPE, env->btype);
+        }
+    } else {
+        *pc = env->regs[15];
+        flags = FIELD_DP32(flags, TBFLAG_AM32, THUMB, env->thumb);
+        flags = FIELD_DP32(flags, TBFLAG_AM32, CONDEXEC, env->condexec_bits);
+        flags = FIELD_DP32(flags, TBFLAG_A32, VECLEN, env->vfp.vec_len);
+        /* Note that XSCALE_CPAR shares bits with VECSTRIDE */
+        if (arm_feature(env, ARM_FEATURE_XSCALE)) {
+            flags = FIELD_DP32(flags, TBFLAG_A32,
+                               XSCALE_CPAR, env->cp15.c15_cpar);
+        } else {
+            flags = FIELD_DP32(flags, TBFLAG_A32,
+                               VECSTRIDE, env->vfp.vec_stride);
+        }
+        if (env->vfp.xregs[ARM_VFP_FPEXC] & (1 << 30)) {
+            flags = FIELD_DP32(flags, TBFLAG_A32, VFPEN, 1);
+        }
+    }
+
+    if (FIELD_EX32(flags, TBFLAG_ANY, SS_ACTIVE)) {
+        if (is_a64(env)) {
+            if (env->pstate & PSTATE_SS) {
+                flags = FIELD_DP32(flags, TBFLAG_ANY, PSTATE_SS, 1);
+            }
+        } else {
+            if (env->uncached_cpsr & PSTATE_SS) {
+                flags = FIELD_DP32(flags, TBFLAG_ANY, PSTATE_SS, 1);
+            }
+        }
+    }
+
     *pflags = flags;
     *cs_base = 0;
 }
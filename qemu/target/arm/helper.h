@@ -1,5 +1,3 @@
-DEF_HELPER_4(uc_tracecode, void, i32, i32, ptr, i64)
-
 DEF_HELPER_FLAGS_1(sxtb16, TCG_CALL_NO_RWG_SE, i32, i32)
 DEF_HELPER_FLAGS_1(uxtb16, TCG_CALL_NO_RWG_SE, i32, i32)
 
@@ -55,6 +53,7 @@ DEF_HELPER_1(wfe, void, env)
 DEF_HELPER_1(yield, void, env)
 DEF_HELPER_1(sev, void, env) // SNPS added
 DEF_HELPER_1(sevl, void, env) // SNPS addeded
+DEF_HELPER_1(tlb_sync, void, env) // SNPS added
 DEF_HELPER_1(pre_hvc, void, env)
 DEF_HELPER_2(pre_smc, void, env, i32)
 
@@ -63,6 +62,7 @@ DEF_HELPER_1(call_breakpoints, void, env) // SNPS added
 
 DEF_HELPER_3(cpsr_write, void, env, i32, i32)
 DEF_HELPER_2(cpsr_write_eret, void, env, i32)
+DEF_HELPER_FLAGS_1(rebuild_hflags, TCG_CALL_NO_RWG, void, env) // SNPS added
 DEF_HELPER_1(cpsr_read, i32, env)
 
 DEF_HELPER_3(v7m_msr, void, env, i32, i32)
@@ -814,6 +814,14 @@ ARMMMUIdx arm_v7m_mmu_idx_for_secstate(CPUARMState *env, bool secstate);
  * tables */
 bool arm_s1_regime_using_lpae_format(CPUARMState *env, ARMMMUIdx mmu_idx);
 
+/* SNPS added: Return the softmmu TLB tag of the address space of a
+ * translation regime (VMID in the upper, ASID in the lower 16 bits) */
+uint32_t arm_mmu_idx_asid(CPUARMState *env, ARMMMUIdx mmu_idx);
+
+/* SNPS added: Switch the TLBs of all translation regimes to their current
+ * address space after a change of an ASID or VMID */
+void arm_tlb_update_asid(CPUARMState *env);
+
 /* Raise a data fault alignment exception for the specified virtual address */
 void arm_cpu_do_unaligned_access(CPUState *cs, vaddr vaddr,
                                  MMUAccessType access_type,
@@ -223,6 +223,7 @@ uint32_t HELPER(usat16)(CPUARMState *env, uint32_t x, uint32_t shift)
 void HELPER(setend)(CPUARMState *env)
 {
     env->uncached_cpsr ^= CPSR_E;
+    arm_rebuild_hflags(env); // SNPS added
 }
 
 /*
@@ -315,7 +316,9 @@ void HELPER(wfi)(CPUARMState *env, uint32_t insn_len)
 
     if (fn != NULL) {
         env->uc->is_memcb = true; // force adjustment during PC register read
+        cs->callout_pc = GETPC();
         fn(opaque, UC_HINT_WFI);
+        cs->callout_pc = 0;
         env->uc->is_memcb = false;
     } else {
         cs->exception_index = EXCP_HLT;
@@ -332,12 +335,15 @@ void HELPER(wfe)(CPUARMState *env)
     uc_hintfunc_t fn = env->uc->uc_hint_func;
     void* opaque = env->uc->uc_hint_opaque;
 
+    CPUState *cs = env_cpu(env);
+
     if (fn != NULL) {
+        cs->callout_pc = GETPC();
         fn(opaque, UC_HINT_WFE);
+        cs->callout_pc = 0;
         return;
     }
 
-    CPUState *cs = env_cpu(env);
     cs->exception_index = EXCP_YIELD;
     cs->halted = 1;
     cs->is_idle = true;
@@ -351,13 +357,15 @@ void HELPER(yield)(CPUARMState *env)
     uc_hintfunc_t fn = env->uc->uc_hint_func;
     void* opaque = env->uc->uc_hint_opaque;
 
+    CPUState *cs = env_cpu(env);
+
     if (fn != NULL) {
+        cs->callout_pc = GETPC();
         fn(opaque, UC_HINT_YIELD);
+        cs->callout_pc = 0;
         return;
     }
 
-    CPUState *cs = env_cpu(env);
-
     cs->exception_index = EXCP_YIELD;
     cs->halted = 1;
     cs->is_idle = true;
@@ -367,20 +375,41 @@ void HELPER(yield)(CPUARMState *env)
 
 void HELPER(sev)(CPUARMState *env) // SNPS added
 {
+    CPUState *cs = env_cpu(env);
     uc_hintfunc_t fn = env->uc->uc_hint_func;
     void* opaque = env->uc->uc_hint_opaque;
 
-    if (fn != NULL)
+    if (fn != NULL) {
+        cs->callout_pc = GETPC();
         fn(opaque, UC_HINT_SEV);
+        cs->callout_pc = 0;
+    }
 }
 
 void HELPER(sevl)(CPUARMState *env) // SNPS added
 {
+    CPUState *cs = env_cpu(env);
     uc_hintfunc_t fn = env->uc->uc_hint_func;
     void* opaque = env->uc->uc_hint_opaque;
 
-    if (fn != NULL)
+    if (fn != NULL) {
+        cs->callout_pc = GETPC();
         fn(opaque, UC_HINT_SEVL);
+        cs->callout_pc = 0;
+    }
+}
+
+void HELPER(tlb_sync)(CPUARMState *env) // SNPS added
+{
+    CPUState *cs = env_cpu(env);
+    struct uc_struct *uc = env->uc;
+
+    if (uc->tlb_broadcast_pending ||
+        (uc->tlb_batch && atomic_read(&uc->tlb_batch->pending))) {
+        cs->callout_pc = GETPC();
+        uc->tlb_cluster_sync(cs);
+        cs->callout_pc = 0;
+    }
 }
 
 /*
@@ -452,6 +481,7 @@ uint32_t HELPER(cpsr_read)(CPUARMState *env)
 void HELPER(cpsr_write)(CPUARMState *env, uint32_t val, uint32_t mask)
 {
     cpsr_write(env, val, mask, CPSRWriteByInstr);
+    arm_rebuild_hflags(env); // SNPS added
 }
 
 /* Write the CPSR for a 32-bit exception return */
@@ -471,6 +501,7 @@ void HELPER(cpsr_write_eret)(CPUARMState *env, uint32_t val)
      * state. Do the masking now.
      */
     env->regs[15] &= (env->thumb ? ~1 : ~3);
+    arm_rebuild_hflags(env); // SNPS added
 
     arm_call_el_change_hook(env_archcpu(env));
 }
@@ -753,29 +784,53 @@ exept:
 void HELPER(set_cp_reg)(CPUARMState *env, void *rip, uint32_t value)
 {
     const ARMCPRegInfo *ri = rip;
+    CPUState *cs = env_cpu(env); // SNPS added
 
+    cs->callout_pc = GETPC(); // SNPS added: for the PC of IO registers
+    cs->callout_lazy_pc = true; // SNPS added
     ri->writefn(env, ri, value);
+    cs->callout_lazy_pc = false; // SNPS added
+    cs->callout_pc = 0; // SNPS added
 }
 
 uint32_t HELPER(get_cp_reg)(CPUARMState *env, void *rip)
 {
     const ARMCPRegInfo *ri = rip;
+    CPUState *cs = env_cpu(env); // SNPS added
+    uint32_t val;
 
-    return ri->readfn(env, ri);
+    cs->callout_pc = GETPC(); // SNPS added: for the PC of IO registers
+    cs->callout_lazy_pc = true; // SNPS added
+    val = ri->readfn(env, ri);
+    cs->callout_lazy_pc = false; // SNPS added
+    cs->callout_pc = 0; // SNPS added
+    return val;
 }
 
 void HELPER(set_cp_reg64)(CPUARMState *env, void *rip, uint64_t value)
 {
     const ARMCPRegInfo *ri = rip;
+    CPUState *cs = env_cpu(env); // SNPS added
 
+    cs->callout_pc = GETPC(); // SNPS added: for the PC of IO registers
+    cs->callout_lazy_pc = true; // SNPS added
     ri->writefn(env, ri, value);
+    cs->callout_lazy_pc = false; // SNPS added
+    cs->callout_pc = 0; // SNPS added
 }
 
 uint64_t HELPER(get_cp_reg64)(CPUARMState *env, void *rip)
 {
     const ARMCPRegInfo *ri = rip;
-
-    return ri->readfn(env, ri);
+    CPUState *cs = env_cpu(env); // SNPS added
+    uint64_t val;
+
+    cs->callout_pc = GETPC(); // SNPS added: for the PC of IO registers
+    cs->callout_lazy_pc = true; // SNPS added
+    val = ri->readfn(env, ri);
+    cs->callout_lazy_pc = false; // SNPS added
+    cs->callout_pc = 0; // SNPS added
+    return val;
 }
 
 void HELPER(pre_hvc)(CPUARMState *env)
@@ -186,6 +186,10 @@ bool arm_cpu_tlb_fill(CPUState *cs, vaddr address, int size,
             phys_addr &= TARGET_PAGE_MASK;
             address &= TARGET_PAGE_MASK;
         }
+        // SNPS added: pick up ASID changes that bypassed the register hooks
+        tlb_set_asid_by_mmuidx(cs, arm_mmu_idx_asid(&cpu->env,
+                               core_to_arm_mmu_idx(&cpu->env, mmu_idx)),
+                               1 << mmu_idx);
         tlb_set_page_with_attrs(cs, address, phys_addr, attrs,
                                 prot, mmu_idx, page_size);
         return true;
@@ -1649,6 +1649,10 @@ static void handle_sync(DisasContext *s, uint32_t insn,
             break;
         }
         tcg_gen_mb(tcg_ctx, bar);
+        // SNPS added: TLB maintenance completes at a DSB, not at a DMB
+        if (op2 == 4) {
+            gen_helper_tlb_sync(tcg_ctx, tcg_ctx->cpu_env);
+        }
         return;
     case 6: /* ISB */
         /* We need to break the TB after this insn to execute
@@ -1768,6 +1772,7 @@ static void handle_msr_i(DisasContext *s, uint32_t insn,
         } else {
             clear_pstate_bits(s, PSTATE_UAO);
         }
+        gen_helper_rebuild_hflags(tcg_ctx, tcg_ctx->cpu_env); // SNPS added
         break;
 
     case 0x04: /* PAN */
@@ -1779,6 +1784,7 @@ static void handle_msr_i(DisasContext *s, uint32_t insn,
         } else {
             clear_pstate_bits(s, PSTATE_PAN);
         }
+        gen_helper_rebuild_hflags(tcg_ctx, tcg_ctx->cpu_env); // SNPS added
         break;
 
     case 0x05: /* SPSel */
@@ -1893,10 +1899,6 @@ static void handle_sys(DisasContext *s, uint32_t insn, bool isread,
         return;
     }
 
-    // SNPS added: always set PC to current address to allow IO register
-    // callbacks to read it correctly (moved from below)
-    gen_a64_set_pc_im(s, s->pc_curr);
-
     if (ri->accessfn) {
         /* Emit code to perform further access permissions checks at
          * runtime; this may result in an exception.
@@ -1905,7 +1907,7 @@ static void handle_sys(DisasContext *s, uint32_t insn, bool isread,
         TCGv_i32 tcg_syn, tcg_isread;
         uint32_t syndrome;
 
-        //gen_a64_set_pc_im(s, s->pc_curr); // SNPS removed
+        gen_a64_set_pc_im(s, s->pc_curr);
         tmpptr = tcg_const_ptr(tcg_ctx, ri);
         syndrome = syn_aa64_sysregtrap(op0, op1, op2, crn, crm, rt, isread);
         tcg_syn = tcg_const_i32(tcg_ctx, syndrome);
@@ -1919,7 +1921,7 @@ static void handle_sys(DisasContext *s, uint32_t insn, bool isread,
          * The readfn or writefn might raise an exception;
          * synchronize the CPU state in case it does.
          */
-        //gen_a64_set_pc_im(s, s->pc_curr); // SNPS removed
+        gen_a64_set_pc_im(s, s->pc_curr);
     }
 
     /* Handle special cases first */
@@ -1994,7 +1996,10 @@ static void handle_sys(DisasContext *s, uint32_t insn, bool isread,
         // Unicorn: commented out
         //gen_io_end();
         s->base.is_jmp = DISAS_UPDATE;
-    } else if (!isread && !(ri->type & ARM_CP_SUPPRESS_TB_END)) {
+    }
+    if (!isread && !(ri->type & ARM_CP_SUPPRESS_TB_END)) {
+        /* SNPS added: any write that ends the TB may change the hflags  */
+        gen_helper_rebuild_hflags(tcg_ctx, tcg_ctx->cpu_env);
         /* We default to ending the TB on a coprocessor register write,
          * but allow this to be suppressed by the register definition
          * (usually only necessary to work around guest bugs).
@@ -3862,13 +3867,6 @@ static void disas_ldst_single_struct(DisasContext *s, uint32_t insn)
 /* Loads and stores */
 static void disas_ldst(DisasContext *s, uint32_t insn)
 {
-    /* 
-     * SNPS added: loads and stores might trigger watchpoints in QEMU or in
-     * SystemC, so we need to sync our pc here to provide a consistent model
-     * state to the debugger
-     */
-    gen_a64_set_pc_im(s, s->pc_curr);
-
     switch (extract32(insn, 24, 6)) {
     case 0x08: /* Load/store exclusive */
         disas_ldst_excl(s, insn);
@@ -14378,12 +14376,11 @@ static void disas_a64_insn(CPUARMState *env, DisasContext *s)
     s->insn = insn;
     s->base.pc_next += 4;
 
-    // SNPS removed
-    //if (HOOK_EXISTS_BOUNDED(env->uc, UC_HOOK_CODE, s->pc_curr)) {
-    //    gen_uc_tracecode(tcg_ctx, 4, UC_HOOK_CODE_IDX, env->uc, s->pc_curr);
-    //    // the callback might want to stop emulation immediately
-    //    check_exit_request(tcg_ctx);
-    //}
+    // Unicorn: trace this instruction on request
+    // SNPS changed: the helper leaves the TB itself on uc_emu_stop()
+    if (HOOK_EXISTS_BOUNDED(env->uc, UC_HOOK_CODE, s->pc_curr)) {
+        gen_uc_tracecode(tcg_ctx, 4, UC_HOOK_CODE_IDX, env->uc, s->pc_curr);
+    }
 
     s->fp_access_checked = false;
 
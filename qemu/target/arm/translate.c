@@ -5837,7 +5837,6 @@ static int disas_coproc_insn(DisasContext *s, uint32_t insn)
             gen_io_start();
         }
 #endif
-        gen_set_pc_im(s, s->pc_curr); // SNPS added
 
         if (isread) {
             /* Read */
@@ -5925,6 +5924,10 @@ static int disas_coproc_insn(DisasContext *s, uint32_t insn)
             }
         }
 
+        if (!isread && !(ri->type & ARM_CP_SUPPRESS_TB_END)) {
+            /* SNPS added: any write that ends the TB may change the hflags  */
+            gen_helper_rebuild_hflags(tcg_ctx, tcg_ctx->cpu_env);
+        }
         if ((tb_cflags(s->base.tb) & CF_USE_ICOUNT) && (ri->type & ARM_CP_IO)) {
             /* I/O operations must end the TB here (whether read or write) */
             // Unicorn: commented out
@@ -9428,7 +9431,8 @@ static bool trans_CLREX(DisasContext *s, arg_CLREX *a)
     return true;
 }
 
-static bool trans_DSB(DisasContext *s, arg_DSB *a)
+// SNPS added: the memory barrier shared by DMB and DSB
+static bool gen_barrier(DisasContext *s)
 {
     TCGContext *tcg_ctx = s->uc->tcg_ctx;
     if (!ENABLE_ARCH_7 && !arm_dc_feature(s, ARM_FEATURE_M)) {
@@ -9438,9 +9442,22 @@ static bool trans_DSB(DisasContext *s, arg_DSB *a)
     return true;
 }
 
+static bool trans_DSB(DisasContext *s, arg_DSB *a)
+{
+    TCGContext *tcg_ctx = s->uc->tcg_ctx;
+    if (!gen_barrier(s)) {
+        return false;
+    }
+    // SNPS added: TLB maintenance is only guaranteed to be complete after
+    // a DSB (a DMB merely orders it), so the queued shootdowns are applied
+    // here rather than at every barrier
+    gen_helper_tlb_sync(tcg_ctx, tcg_ctx->cpu_env);
+    return true;
+}
+
 static bool trans_DMB(DisasContext *s, arg_DMB *a)
 {
-    return trans_DSB(s, NULL);
+    return gen_barrier(s); // SNPS changed
 }
 
 static bool trans_ISB(DisasContext *s, arg_ISB *a)
@@ -9545,10 +9562,9 @@ static void disas_arm_insn(DisasContext *s, unsigned int insn)
     }
 
     // Unicorn: trace this instruction on request
+    // SNPS changed: the helper leaves the TB itself on uc_emu_stop()
     if (HOOK_EXISTS_BOUNDED(s->uc, UC_HOOK_CODE, s->pc_curr)) {
         gen_uc_tracecode(tcg_ctx, 4, UC_HOOK_CODE_IDX, s->uc, s->pc_curr);
-        // the callback might want to stop emulation immediately
-        check_exit_request(tcg_ctx);
     }
 
     if (cond == 0xf) {
@@ -10156,11 +10172,10 @@ static void thumb_tr_translate_insn(DisasContextBase *dcbase, CPUState *cpu)
     }
 
     // Unicorn: trace this instruction on request
+    // SNPS changed: the helper leaves the TB itself on uc_emu_stop()
     const uint32_t insn_size = is_16bit ? 2 : 4;
     if (HOOK_EXISTS_BOUNDED(dc->uc, UC_HOOK_CODE, dc->base.pc_next - insn_size)) {
         gen_uc_tracecode(tcg_ctx, insn_size, UC_HOOK_CODE_IDX, dc->uc, dc->base.pc_next - insn_size);
-        // the callback might want to stop emulation immediately
-        check_exit_request(tcg_ctx);
     }
 
     if (is_16bit) {
@@ -30,13 +30,18 @@ void arm64_release(void* ctx)
 {
     TCGContext *s = (TCGContext *) ctx;
     struct uc_struct* uc = s->uc;
-    ARMCPU* cpu = ARM_CPU(uc, uc->cpu);
+    int i;
+
+    if (!uc_tcg_shared(uc)) // SNPS added
+        g_free(s->tb_ctx.tbs);
+    for (i = 0; i < uc->num_cpus; i++) { // SNPS changed
+        ARMCPU* cpu = ARM_CPU(uc, uc->cpus[i]);
 
-    g_free(s->tb_ctx.tbs);
-    g_free(cpu->cpreg_indexes);
-    g_free(cpu->cpreg_values);
-    g_free(cpu->cpreg_vmstate_indexes);
-    g_free(cpu->cpreg_vmstate_values);
+        g_free(cpu->cpreg_indexes);
+        g_free(cpu->cpreg_values);
+        g_free(cpu->cpreg_vmstate_indexes);
+        g_free(cpu->cpreg_vmstate_values);
+    }
 
     release_common(ctx);
 }
@@ -57,7 +62,8 @@ int arm_reg_write_arm(struct uc_struct *uc, unsigned int *regs, void* const* val
 #endif
 
 static uint64_t calc_pc_offset(struct uc_struct *uc, CPUARMState *state) {
-    if (!uc->is_memcb)
+    // SNPS changed: a recovered PC is the one of the current instruction
+    if (!uc->is_memcb || uc->cpu->callout_lazy_pc)
         return 0;
 
     if (!state->aarch64 && state->thumb)
@@ -502,12 +508,16 @@ int arm64_reg_write(struct uc_struct *uc, unsigned int *regs, void* const* vals,
 
             case UC_ARM64_REG_NOIMP:
             default:
+                arm_rebuild_hflags(state); // SNPS added
                 return -1;
 
             }
         }
     }
 
+    // SNPS added: any register may change the cached TB flags
+    arm_rebuild_hflags(state);
+
     return 0;
 }
 
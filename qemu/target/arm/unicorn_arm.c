@@ -26,17 +26,22 @@ void arm_release(void* ctx)
 {
     TCGContext *s = (TCGContext *) ctx;
     struct uc_struct* uc = s->uc;
-    ARMCPU* cpu = ARM_CPU(uc, uc->cpu);
-    CPUArchState *env = &cpu->env;
-
-    g_free(s->tb_ctx.tbs);
-    g_free(cpu->cpreg_indexes);
-    g_free(cpu->cpreg_values);
-    g_free(cpu->cpreg_vmstate_indexes);
-    g_free(cpu->cpreg_vmstate_values);
-    g_free(env->pmsav7.drbar);
-    g_free(env->pmsav7.drsr);
-    g_free(env->pmsav7.dracr);
+    int i;
+
+    if (!uc_tcg_shared(uc)) // SNPS added
+        g_free(s->tb_ctx.tbs);
+    for (i = 0; i < uc->num_cpus; i++) { // SNPS changed
+        ARMCPU* cpu = ARM_CPU(uc, uc->cpus[i]);
+        CPUArchState *env = &cpu->env;
+
+        g_free(cpu->cpreg_indexes);
+        g_free(cpu->cpreg_values);
+        g_free(cpu->cpreg_vmstate_indexes);
+        g_free(cpu->cpreg_vmstate_values);
+        g_free(env->pmsav7.drbar);
+        g_free(env->pmsav7.drsr);
+        g_free(env->pmsav7.dracr);
+    }
 
     release_common(ctx);
 }
@@ -66,7 +71,8 @@ uint32_t helper_v7m_mrs(CPUARMState *env, uint32_t reg);
 void helper_v7m_msr(CPUARMState *env, uint32_t maskreg, uint32_t val);
 
 static uint32_t calc_pc_offset(struct uc_struct *uc, CPUARMState *state) {
-    if (!uc->is_memcb)
+    // SNPS changed: a recovered PC is the one of the current instruction
+    if (!uc->is_memcb || uc->cpu->callout_lazy_pc)
         return 0;
 
     return state->thumb ? 2 : 4;
@@ -717,11 +723,15 @@ int arm_reg_write(struct uc_struct *uc, unsigned int *regs, void* const* vals, i
 
             case UC_ARM_REG_NOIMP:
             default:
+                arm_rebuild_hflags(state); // SNPS added
                 return -1;
             }
         }
     }
 
+    // SNPS added: any register may change the cached TB flags
+    arm_rebuild_hflags(state);
+
     return 0;
 }
 
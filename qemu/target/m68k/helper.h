@@ -1,5 +1,3 @@
-DEF_HELPER_4(uc_tracecode, void, i32, i32, ptr, i64)
-
 DEF_HELPER_1(bitrev, i32, i32)
 DEF_HELPER_1(ff1, i32, i32)
 DEF_HELPER_FLAGS_2(sats, TCG_CALL_NO_RWG_SE, i32, i32, i32)
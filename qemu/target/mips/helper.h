@@ -1,5 +1,3 @@
-DEF_HELPER_4(uc_tracecode, void, i32, i32, ptr, i64)
-
 DEF_HELPER_3(raise_exception_err, noreturn, env, i32, int)
 DEF_HELPER_2(raise_exception, noreturn, env, i32)
 DEF_HELPER_1(raise_exception_debug, noreturn, env)
@@ -335,6 +335,8 @@ static void riscv_cpu_init(struct uc_struct *uc, Object *obj, void *opaque)
 
     cpu_set_cpustate_pointers(cpu);
     cpu_exec_init(cs, &error_abort, opaque);
+
+    cpu->env.mhartid = cs->cpu_index; // SNPS added
 }
 
 static void riscv_cpu_class_init(struct uc_struct *uc, ObjectClass *oc, void *data)
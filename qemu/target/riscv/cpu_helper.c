@@ -296,11 +296,13 @@ void riscv_cpu_set_mode(CPURISCVState *env, target_ulong newpriv)
  * @first_stage: Are we in first stage translation?
  *               Second stage is used for hypervisor guest translation
  * @two_stage: Are we going to perform two stage translation
+ * @nonglobal: If not NULL, set to whether the mapping is tied to the ASID
  */
 static int get_physical_address(CPURISCVState *env, hwaddr *physical,
                                 int *prot, target_ulong addr,
                                 int access_type, int mmu_idx,
-                                bool first_stage, bool two_stage)
+                                bool first_stage, bool two_stage,
+                                bool *nonglobal) // SNPS changed
 {
     /* NOTE: the env->pc value visible here will not be
      * correct, but the value visible to the exception handler
@@ -407,12 +409,39 @@ static int get_physical_address(CPURISCVState *env, hwaddr *physical,
     }
 
     int ptshift = (levels - 1) * ptidxbits;
-    int i;
+    int i, start = 0;
+    target_ulong global = 0; // SNPS added
+
+    // SNPS added: continue at the last level if its table is cached
+    CPUWalkCacheEntry walk;
+    const CPUWalkCacheEntry *cached;
+
+    if (first_stage) {
+        walk.regime = use_background;
+        walk.base = use_background ? env->vsatp : env->satp;
+        walk.asid = get_field(walk.base, SATP_ASID);
+    } else {
+        walk.regime = 2;
+        walk.base = env->hgatp;
+        walk.asid = 0;
+    }
+    walk.ctx = 0;
+    walk.shift = PGSHIFT + ptidxbits;
+    walk.prefix_mask = (1ULL << (va_bits - walk.shift)) - 1;
+    walk.prefix = (addr >> walk.shift) & walk.prefix_mask;
+    walk.idxmap = (1 << NB_MMU_MODES) - 1;
+    cached = tlb_walk_cache_lookup(cs, &walk);
+    if (cached) {
+        start = levels - 1;
+        ptshift = 0;
+        base = cached->table;
+        global = cached->attrs;
+    }
 
 #if !TCG_OVERSIZED_GUEST
 restart:
 #endif
-    for (i = 0; i < levels; i++, ptshift -= ptidxbits) {
+    for (i = start; i < levels; i++, ptshift -= ptidxbits) {
         target_ulong idx;
         if (i == 0) {
             idx = (addr >> (PGSHIFT + ptshift)) &
@@ -431,7 +460,7 @@ restart:
 
             /* Do the second stage translation on the base PTE address. */
             get_physical_address(env, &vbase, &vbase_prot, base, access_type,
-                                 mmu_idx, false, true);
+                                 mmu_idx, false, true, NULL);
 
             pte_addr = vbase + idx * ptesize;
         } else {
@@ -444,16 +473,28 @@ restart:
             return TRANSLATE_PMP_FAIL;
         }
 
+        // SNPS changed: RAM and DMI pages without the memory API
+        target_ulong pte;
+        void *pte_host = tlb_walk_host(cs, cs->as, pte_addr, false);
+        if (pte_host) {
 #if defined(TARGET_RISCV32)
-        target_ulong pte = address_space_ldl(cs->as, pte_addr, attrs, &res);
+            pte = ldl_le_p(pte_host);
 #elif defined(TARGET_RISCV64)
-        target_ulong pte = address_space_ldq(cs->as, pte_addr, attrs, &res);
+            pte = ldq_le_p(pte_host);
 #endif
-        if (res != MEMTX_OK) {
-            return TRANSLATE_FAIL;
+        } else {
+#if defined(TARGET_RISCV32)
+            pte = address_space_ldl(cs->as, pte_addr, attrs, &res);
+#elif defined(TARGET_RISCV64)
+            pte = address_space_ldq(cs->as, pte_addr, attrs, &res);
+#endif
+            if (res != MEMTX_OK) {
+                return TRANSLATE_FAIL;
+            }
         }
 
         hwaddr ppn = pte >> PTE_PPN_SHIFT;
+        global |= pte & PTE_G; // SNPS added: G applies to all lower levels
 
         if (!(pte & PTE_V)) {
             /* Invalid PTE */
@@ -461,6 +502,11 @@ restart:
         } else if (!(pte & (PTE_R | PTE_W | PTE_X))) {
             /* Inner PTE, continue walking */
             base = ppn << PGSHIFT;
+            if (i == levels - 2) { // SNPS added
+                walk.table = base;
+                walk.attrs = global;
+                tlb_walk_cache_insert(cs, &walk);
+            }
         } else if ((pte & (PTE_R | PTE_W | PTE_X)) == PTE_W) {
             /* Reserved leaf PTE flags: PTE_W */
             return TRANSLATE_FAIL;
@@ -497,19 +543,16 @@ restart:
             if (updated_pte != pte) {
                 /*
                  * - if accessed or dirty bits need updating, and the PTE is
-                 *   in RAM, then we do so atomically with a compare and swap.
+                 *   in RAM or writable DMI memory (SNPS changed), then we do
+                 *   so atomically with a compare and swap.
                  * - if the PTE is in IO space or ROM, then it can't be updated
                  *   and we return TRANSLATE_FAIL.
                  * - if the PTE changed by the time we went to update it, then
                  *   it is no longer valid and we must re-walk the page table.
                  */
-                MemoryRegion *mr;
-                hwaddr l = sizeof(target_ulong), addr1;
-                mr = address_space_translate(cs->as, pte_addr,
-                    &addr1, &l, false);
-                if (memory_region_is_ram(mr)) {
-                    target_ulong *pte_pa =
-                        qemu_map_ram_ptr(env->uc, mr->ram_block, addr1);
+                target_ulong *pte_pa = tlb_walk_host(cs, cs->as, pte_addr,
+                                                     true);
+                if (pte_pa) {
 #if TCG_OVERSIZED_GUEST
                     /* MTTCG is not enabled on oversized TCG guests so
                      * page table updates do not need to be atomic */
@@ -548,6 +591,9 @@ restart:
                     (access_type == MMU_DATA_STORE || (pte & PTE_D))) {
                 *prot |= PAGE_WRITE;
             }
+            if (nonglobal) { // SNPS added
+                *nonglobal = !global;
+            }
             return TRANSLATE_SUCCESS;
         }
     }
@@ -609,13 +655,13 @@ hwaddr riscv_cpu_get_phys_page_debug(CPUState *cs, vaddr addr)
     int mmu_idx = cpu_mmu_index(&cpu->env, false);
 
     if (get_physical_address(env, &phys_addr, &prot, addr, 0, mmu_idx,
-                             true, riscv_cpu_virt_enabled(env))) {
+                             true, riscv_cpu_virt_enabled(env), NULL)) {
         return -1;
     }
 
     if (riscv_cpu_virt_enabled(env)) {
         if (get_physical_address(env, &phys_addr, &prot, phys_addr,
-                                 0, mmu_idx, false, true)) {
+                                 0, mmu_idx, false, true, NULL)) {
             return -1;
         }
     }
@@ -677,6 +723,8 @@ bool riscv_cpu_tlb_fill(CPUState *cs, vaddr address, int size,
     bool m_mode_two_stage = false;
     bool hs_mode_two_stage = false;
     bool first_stage_error = true;
+    MemTxAttrs attrs = MEMTXATTRS_UNSPECIFIED; // SNPS added
+    bool nonglobal = false; // SNPS added
     int ret = TRANSLATE_FAIL;
     int mode = mmu_idx;
 
@@ -711,7 +759,7 @@ bool riscv_cpu_tlb_fill(CPUState *cs, vaddr address, int size,
     if (riscv_cpu_virt_enabled(env) || m_mode_two_stage || hs_mode_two_stage) {
         /* Two stage lookup */
         ret = get_physical_address(env, &pa, &prot, address, access_type,
-                                   mmu_idx, true, true);
+                                   mmu_idx, true, true, NULL);
 
         qemu_log_mask(CPU_LOG_MMU,
                       "%s 1st-stage address=%" VADDR_PRIx " ret %d physical "
@@ -723,7 +771,7 @@ bool riscv_cpu_tlb_fill(CPUState *cs, vaddr address, int size,
             im_address = pa;
 
             ret = get_physical_address(env, &pa, &prot2, im_address,
-                                       access_type, mmu_idx, false, true);
+                                       access_type, mmu_idx, false, true, NULL);
 
             qemu_log_mask(CPU_LOG_MMU,
                     "%s 2nd-stage address=%" VADDR_PRIx " ret %d physical "
@@ -752,7 +800,7 @@ bool riscv_cpu_tlb_fill(CPUState *cs, vaddr address, int size,
     } else {
         /* Single stage lookup */
         ret = get_physical_address(env, &pa, &prot, address, access_type,
-                                   mmu_idx, true, false);
+                                   mmu_idx, true, false, &nonglobal);
 
         qemu_log_mask(CPU_LOG_MMU,
                       "%s address=%" VADDR_PRIx " ret %d physical "
@@ -770,8 +818,12 @@ bool riscv_cpu_tlb_fill(CPUState *cs, vaddr address, int size,
     }
 
     if (ret == TRANSLATE_SUCCESS) {
-        tlb_set_page(cs, address & TARGET_PAGE_MASK, pa & TARGET_PAGE_MASK,
-                     prot, mmu_idx, TARGET_PAGE_SIZE);
+        attrs.tlb_nonglobal = nonglobal; // SNPS changed: tag with the ASID
+        tlb_set_asid_by_mmuidx(cs, get_field(env->satp, SATP_ASID),
+                               1 << mmu_idx);
+        tlb_set_page_with_attrs(cs, address & TARGET_PAGE_MASK,
+                                pa & TARGET_PAGE_MASK, attrs,
+                                prot, mmu_idx, TARGET_PAGE_SIZE);
         return true;
     } else if (probe) {
         return false;
@@ -758,10 +758,10 @@ static int write_satp(CPURISCVState *env, int csrno, target_ulong val)
         if (env->priv == PRV_S && get_field(env->mstatus, MSTATUS_TVM)) {
             return -1;
         } else {
-            if((val ^ env->satp) & SATP_ASID) {
-                tlb_flush(env_cpu(env));
-            }
             env->satp = val;
+            // SNPS changed: switch the TLB to the ASID rather than flushing it
+            tlb_set_asid_by_mmuidx(env_cpu(env), get_field(val, SATP_ASID),
+                                   (1 << NB_MMU_MODES) - 1);
         }
     }
     return 0;
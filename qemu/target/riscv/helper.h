@@ -1,6 +1,3 @@
-// Unicorn
-DEF_HELPER_4(uc_tracecode, void, i32, i32, ptr, i64)
-
 /* Exceptions */
 DEF_HELPER_2(raise_exception, noreturn, env, i32)
 
@@ -81,4 +78,5 @@ DEF_HELPER_2(sret, tl, env, tl)
 DEF_HELPER_2(mret, tl, env, tl)
 DEF_HELPER_1(wfi, void, env)
 DEF_HELPER_1(tlb_flush, void, env)
+DEF_HELPER_2(tlb_flush_asid, void, env, tl) // SNPS added
 #endif
@@ -113,6 +113,13 @@ static bool trans_sfence_vma(DisasContext *ctx, arg_sfence_vma *a)
 {
 #ifndef CONFIG_USER_ONLY
     TCGContext *tcg_ctx = ctx->uc->tcg_ctx;
+    if (a->rs2 != 0) { // SNPS added: fence one ASID only
+        TCGv asid = tcg_temp_new(tcg_ctx);
+        gen_get_gpr(ctx, asid, a->rs2);
+        gen_helper_tlb_flush_asid(tcg_ctx, tcg_ctx->cpu_env, asid);
+        tcg_temp_free(tcg_ctx, asid);
+        return true;
+    }
     gen_helper_tlb_flush(tcg_ctx, tcg_ctx->cpu_env);
     return true;
 #endif
@@ -181,7 +181,9 @@ void helper_wfi(CPURISCVState *env)
 
         if (fn != NULL) {
             env->uc->is_memcb = true; // force adjustment during PC register read
+            cs->callout_pc = GETPC();
             fn(opaque, UC_HINT_WFI);
+            cs->callout_pc = 0;
             env->uc->is_memcb = false;
         } else {
             cs->halted = 1;
@@ -204,6 +206,21 @@ void helper_tlb_flush(CPURISCVState *env)
     }
 }
 
+// SNPS added: sfence.vma with rs2 != x0 leaves global mappings and those of
+// other ASIDs alone
+void helper_tlb_flush_asid(CPURISCVState *env, target_ulong asid)
+{
+    CPUState *cs = env_cpu(env);
+    if (!(env->priv >= PRV_S) ||
+        (env->priv == PRV_S &&
+         get_field(env->mstatus, MSTATUS_TVM))) {
+        riscv_raise_exception(env, RISCV_EXCP_ILLEGAL_INST, GETPC());
+    } else {
+        asid &= get_field(SATP_ASID, SATP_ASID);
+        tlb_flush_asid_by_mmuidx(cs, asid, (1 << NB_MMU_MODES) - 1);
+    }
+}
+
 // SNPS added
 void helper_call_breakpoints(CPURISCVState *env) {
     if (env->uc->uc_breakpoint_func) {
@@ -81,12 +81,6 @@ static const int tcg_memop_lookup[8] = {
 #define CASE_OP_32_64(X) case X
 #endif
 
-// SNPS added
-static inline void gen_sync_pc(const DisasContext *ctx) {
-    TCGContext *tcg_ctx = ctx->uc->tcg_ctx;
-    tcg_gen_movi_tl(tcg_ctx, tcg_ctx->cpu_pc_risc, ctx->base.pc_next);
-}
-
 static inline bool has_ext(DisasContext *ctx, uint32_t ext)
 {
     return ctx->misa & ext;
@@ -364,7 +358,6 @@ static void gen_jal(DisasContext *ctx, int rd, target_ulong imm)
 static void gen_load_c(DisasContext *ctx, uint32_t opc, int rd, int rs1,
         target_long imm)
 {
-    gen_sync_pc(ctx); // SNPS added
     TCGContext *tcg_ctx = ctx->uc->tcg_ctx;
     TCGv t0 = tcg_temp_new(tcg_ctx);
     TCGv t1 = tcg_temp_new(tcg_ctx);
@@ -386,7 +379,6 @@ static void gen_load_c(DisasContext *ctx, uint32_t opc, int rd, int rs1,
 static void gen_store_c(DisasContext *ctx, uint32_t opc, int rs1, int rs2,
         target_long imm)
 {
-    gen_sync_pc(ctx); // SNPS added
     TCGContext *tcg_ctx = ctx->uc->tcg_ctx;
     TCGv t0 = tcg_temp_new(tcg_ctx);
     TCGv dat = tcg_temp_new(tcg_ctx);
@@ -450,8 +442,6 @@ static void gen_fp_load(DisasContext *ctx, uint32_t opc, int rd,
         return;
     }
 
-    gen_sync_pc(ctx); // SNPS added
-
     t0 = tcg_temp_new(tcg_ctx);
     gen_get_gpr(ctx, t0, rs1);
     tcg_gen_addi_tl(tcg_ctx, t0, t0, imm);
@@ -492,8 +482,6 @@ static void gen_fp_store(DisasContext *ctx, uint32_t opc, int rs1,
         return;
     }
 
-    gen_sync_pc(ctx); // SNPS added
-
     t0 = tcg_temp_new(tcg_ctx);
     gen_get_gpr(ctx, t0, rs1);
     tcg_gen_addi_tl(tcg_ctx, t0, t0, imm);
@@ -863,8 +851,16 @@ static void riscv_tr_translate_insn(DisasContextBase *dcbase, CPUState *cpu)
 {
     DisasContext *ctx = container_of(dcbase, DisasContext, base);
     CPURISCVState *env = cpu->env_ptr;
+    TCGContext *tcg_ctx = cpu->uc->tcg_ctx; // SNPS added
 
     ctx->opcode = cpu_ldl_code(env, ctx->base.pc_next);
+
+    // SNPS added: trace this instruction on request
+    if (HOOK_EXISTS_BOUNDED(ctx->uc, UC_HOOK_CODE, ctx->base.pc_next)) {
+        gen_uc_tracecode(tcg_ctx, (ctx->opcode & 3) == 3 ? 4 : 2,
+                         UC_HOOK_CODE_IDX, ctx->uc, ctx->base.pc_next);
+    }
+
     decode_opc(ctx);
     ctx->base.pc_next = ctx->pc_succ_insn;
 
@@ -21,9 +21,11 @@ const int RISCV64_REGS_STORAGE_SIZE = offsetof(CPURISCVState, tlb_table);
 
 static void riscv_release(void *ctx) {
     TCGContext *tcg_ctx = (TCGContext *) ctx;
+    bool shared = uc_tcg_shared(tcg_ctx->uc); // SNPS added
 
     release_common(ctx);
-    g_free(tcg_ctx->tb_ctx.tbs);
+    if (!shared) // SNPS added
+        g_free(tcg_ctx->tb_ctx.tbs);
 }
 
 static void riscv_reg_reset(struct uc_struct *uc) {
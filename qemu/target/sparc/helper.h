@@ -1,4 +1,3 @@
-DEF_HELPER_4(uc_tracecode, void, i32, i32, ptr, i64)
 DEF_HELPER_1(power_down, void, env)
 
 #ifndef TARGET_SPARC64
@@ -2814,6 +2814,115 @@ void check_exit_request(TCGContext *tcg_ctx)
 }
 
 
+// SNPS added: append an entry to the memory trace, see uc_setup_mem_trace().
+// Room for it was reserved on entry to the TB (see gen_tb_start).
+static void gen_mem_trace(TCGContext *s, TCGv addr, TCGv_i64 val,
+                          MemOp memop, TCGArg idx, bool write)
+{
+    uc_mem_trace_t *trace = s->uc->mem_trace;
+    unsigned size = 1 << (memop & MO_SIZE);
+    TCGv_ptr pos;
+    TCGv_i64 t;
+    int ofs = 0;
+
+    // an instruction with more than UC_MEM_TRACE_INSN_MAX accesses
+    if (s->mem_trace_count == trace->entries) {
+        return;
+    }
+
+    pos = tcg_temp_new_ptr(s);
+    t = tcg_temp_new_i64(s);
+    tcg_gen_ld_ptr(s, pos, s->cpu_env,
+                   offsetof(CPUState, mem_trace_pos) - offsetof(ArchCPU, env));
+    tcg_gen_extu_tl_i64(s, t, addr);
+    tcg_gen_st_i64(s, t, pos, ofs);
+    ofs += 8;
+    tcg_gen_movi_i64(s, t, size | (write ? UC_MEM_TRACE_WRITE : 0) |
+                           idx << 16);
+    tcg_gen_st_i64(s, t, pos, ofs);
+    ofs += 8;
+
+    if (trace->flags & UC_MEM_TRACE_PADDR) {
+        // the access went through the main TLB slot of its page, whose
+        // iotlb entry holds the physical page
+        TCGv_ptr p = tcg_temp_new_ptr(s);
+        TCGv_i64 phys = tcg_temp_new_i64(s);
+        tcg_gen_extu_tl_i64(s, t, addr);
+        tcg_gen_shri_i64(s, t, t, TARGET_PAGE_BITS);
+#if TCG_TARGET_IMPLEMENTS_DYN_TLB
+        tcg_gen_ld_ptr(s, p, s->cpu_env, offsetof(CPUArchState, tlb_mask[idx]));
+        tcg_gen_extu_ptr_i64(s, phys, p);
+        tcg_gen_shri_i64(s, phys, phys, CPU_TLB_ENTRY_BITS);
+        tcg_gen_and_i64(s, t, t, phys);
+        tcg_gen_muli_i64(s, t, t, sizeof(CPUIOTLBEntry));
+        tcg_gen_trunc_i64_ptr(s, p, t);
+        {
+            TCGv_ptr iotlb = tcg_temp_new_ptr(s);
+            tcg_gen_ld_ptr(s, iotlb, s->cpu_env,
+                           offsetof(CPUArchState, iotlb[idx]));
+            tcg_gen_add_ptr(s, p, p, iotlb);
+            tcg_temp_free_ptr(s, iotlb);
+        }
+        tcg_gen_ld_i64(s, phys, p, offsetof(CPUIOTLBEntry, phys));
+#else
+        tcg_gen_andi_i64(s, t, t, CPU_TLB_SIZE - 1);
+        tcg_gen_muli_i64(s, t, t, sizeof(CPUIOTLBEntry));
+        tcg_gen_trunc_i64_ptr(s, p, t);
+        tcg_gen_add_ptr(s, p, p, s->cpu_env);
+        tcg_gen_ld_i64(s, phys, p, offsetof(CPUArchState, iotlb[idx][0].phys));
+#endif
+        tcg_gen_extu_tl_i64(s, t, addr);
+        tcg_gen_andi_i64(s, t, t, TARGET_PAGE_SIZE - 1);
+        tcg_gen_or_i64(s, phys, phys, t);
+        tcg_gen_st_i64(s, phys, pos, ofs);
+        ofs += 8;
+        tcg_temp_free_i64(s, phys);
+        tcg_temp_free_ptr(s, p);
+    }
+
+    if (trace->flags & UC_MEM_TRACE_VALUE) {
+        if (size < 8) {
+            tcg_gen_andi_i64(s, t, val, (1ull << (size * 8)) - 1);
+            tcg_gen_st_i64(s, t, pos, ofs);
+        } else {
+            tcg_gen_st_i64(s, val, pos, ofs);
+        }
+        ofs += 8;
+    }
+
+    tcg_gen_addi_ptr(s, pos, pos, ofs);
+    tcg_gen_st_ptr(s, pos, s->cpu_env,
+                   offsetof(CPUState, mem_trace_pos) - offsetof(ArchCPU, env));
+    tcg_temp_free_i64(s, t);
+    tcg_temp_free_ptr(s, pos);
+    s->mem_trace_count++;
+}
+
+// SNPS added
+static void gen_mem_trace_i32(TCGContext *s, TCGv addr, TCGv_i32 val,
+                              MemOp memop, TCGArg idx, bool write)
+{
+    TCGv_i64 val64 = NULL;
+
+    if (s->uc->mem_trace->flags & UC_MEM_TRACE_VALUE) {
+        val64 = tcg_temp_new_i64(s);
+        tcg_gen_extu_i32_i64(s, val64, val);
+    }
+    gen_mem_trace(s, addr, val64, memop, idx, write);
+    if (val64) {
+        tcg_temp_free_i64(s, val64);
+    }
+}
+
+// SNPS added: the address register may be the destination of a load
+static TCGv mem_trace_addr(TCGContext *s, TCGv addr)
+{
+    TCGv copy = tcg_temp_new(s);
+
+    tcg_gen_mov_tl(s, copy, addr);
+    return copy;
+}
+
 static void tcg_gen_req_mo(TCGContext *s, TCGBar type)
 {
 #ifdef TCG_GUEST_DEFAULT_MO
@@ -2829,6 +2938,7 @@ void tcg_gen_qemu_ld_i32(struct uc_struct *uc, TCGv_i32 val, TCGv addr, TCGArg i
 {
     MemOp orig_memop;
     TCGContext *tcg_ctx = uc->tcg_ctx;
+    TCGv trace_addr = NULL; // SNPS added
 
     tcg_gen_req_mo(tcg_ctx, TCG_MO_LD_LD | TCG_MO_ST_LD);
     memop = tcg_canonicalize_memop(memop, 0, 0);
@@ -2842,6 +2952,11 @@ void tcg_gen_qemu_ld_i32(struct uc_struct *uc, TCGv_i32 val, TCGv addr, TCGArg i
         }
     }
 
+    // SNPS added
+    if (tcg_ctx->mem_trace) {
+        trace_addr = mem_trace_addr(tcg_ctx, addr);
+    }
+
     gen_ldst_i32(tcg_ctx, INDEX_op_qemu_ld_i32, val, addr, memop, idx);
 
     if ((orig_memop ^ memop) & MO_BSWAP) {
@@ -2860,6 +2975,12 @@ void tcg_gen_qemu_ld_i32(struct uc_struct *uc, TCGv_i32 val, TCGv addr, TCGArg i
         }
     }
 
+    // SNPS added
+    if (trace_addr) {
+        gen_mem_trace_i32(tcg_ctx, trace_addr, val, memop, idx, false);
+        tcg_temp_free(tcg_ctx, trace_addr);
+    }
+
     // SNPS removed: check_exit_request(tcg_ctx);
 }
 
@@ -2867,6 +2988,7 @@ void tcg_gen_qemu_st_i32(struct uc_struct *uc, TCGv_i32 val, TCGv addr, TCGArg i
 {
     TCGv_i32 swap = NULL;
     TCGContext *tcg_ctx = uc->tcg_ctx;
+    TCGv_i32 orig_val = val; // SNPS added
 
     tcg_gen_req_mo(tcg_ctx, TCG_MO_LD_ST | TCG_MO_ST_ST);
     memop = tcg_canonicalize_memop(memop, 0, 1);
@@ -2891,6 +3013,11 @@ void tcg_gen_qemu_st_i32(struct uc_struct *uc, TCGv_i32 val, TCGv addr, TCGArg i
 
     gen_ldst_i32(tcg_ctx, INDEX_op_qemu_st_i32, val, addr, memop, idx);
 
+    // SNPS added
+    if (tcg_ctx->mem_trace) {
+        gen_mem_trace_i32(tcg_ctx, addr, orig_val, memop, idx, true);
+    }
+
     if (swap) {
         tcg_temp_free_i32(tcg_ctx, swap);
     }
@@ -2902,6 +3029,7 @@ void tcg_gen_qemu_ld_i64(struct uc_struct *uc, TCGv_i64 val, TCGv addr, TCGArg i
 {
     TCGContext *tcg_ctx = uc->tcg_ctx;
     MemOp orig_memop;
+    TCGv trace_addr = NULL; // SNPS added
 
     if (TCG_TARGET_REG_BITS == 32 && (memop & MO_SIZE) < MO_64) {
         tcg_gen_qemu_ld_i32(uc, TCGV_LOW(tcg_ctx, val), addr, idx, memop);
@@ -2927,6 +3055,11 @@ void tcg_gen_qemu_ld_i64(struct uc_struct *uc, TCGv_i64 val, TCGv addr, TCGArg i
         }
     }
 
+    // SNPS added
+    if (tcg_ctx->mem_trace) {
+        trace_addr = mem_trace_addr(tcg_ctx, addr);
+    }
+
     gen_ldst_i64(tcg_ctx, INDEX_op_qemu_ld_i64, val, addr, memop, idx);
 
     if ((orig_memop ^ memop) & MO_BSWAP) {
@@ -2951,6 +3084,12 @@ void tcg_gen_qemu_ld_i64(struct uc_struct *uc, TCGv_i64 val, TCGv addr, TCGArg i
         }
     }
 
+    // SNPS added
+    if (trace_addr) {
+        gen_mem_trace(tcg_ctx, trace_addr, val, memop, idx, false);
+        tcg_temp_free(tcg_ctx, trace_addr);
+    }
+
     // SNPS removed: check_exit_request(tcg_ctx);
 }
 
@@ -2958,6 +3097,7 @@ void tcg_gen_qemu_st_i64(struct uc_struct *uc, TCGv_i64 val, TCGv addr, TCGArg i
 {
     TCGContext *tcg_ctx = uc->tcg_ctx;
     TCGv_i64 swap = NULL;
+    TCGv_i64 orig_val = val; // SNPS added
 
     if (TCG_TARGET_REG_BITS == 32 && (memop & MO_SIZE) < MO_64) {
         tcg_gen_qemu_st_i32(uc, TCGV_LOW(tcg_ctx, val), addr, idx, memop);
@@ -2991,6 +3131,11 @@ void tcg_gen_qemu_st_i64(struct uc_struct *uc, TCGv_i64 val, TCGv addr, TCGArg i
 
     gen_ldst_i64(tcg_ctx, INDEX_op_qemu_st_i64, val, addr, memop, idx);
 
+    // SNPS added
+    if (tcg_ctx->mem_trace) {
+        gen_mem_trace(tcg_ctx, addr, orig_val, memop, idx, true);
+    }
+
     if (swap) {
         tcg_temp_free_i64(tcg_ctx, swap);
     }
@@ -43,17 +43,28 @@ void vec_gen_2(TCGContext *, TCGOpcode, TCGType, unsigned, TCGArg, TCGArg);
 void vec_gen_3(TCGContext *, TCGOpcode, TCGType, unsigned, TCGArg, TCGArg, TCGArg);
 void vec_gen_4(TCGContext *, TCGOpcode, TCGType, unsigned, TCGArg, TCGArg, TCGArg, TCGArg);
 
+// SNPS changed: call the code or block hooks (@type is UC_HOOK_*_IDX) of
+// @pc, resolved now. Nothing is generated without hooks. The movi of the
+// size is kept in uc_size_op, to patch in the size of a block later.
 static inline void gen_uc_tracecode(TCGContext *tcg_ctx, int32_t size, int32_t type, void *uc, uint64_t pc)
 {
-    TCGv_i32 tsize = tcg_const_i32(tcg_ctx, size);
-    TCGv_i32 ttype = tcg_const_i32(tcg_ctx, type);
-    TCGv_ptr tuc = tcg_const_ptr(tcg_ctx, uc);
-    TCGv_i64 tpc = tcg_const_i64(tcg_ctx, pc);
-    gen_helper_uc_tracecode(tcg_ctx, tsize, ttype, tuc, tpc);
-    tcg_temp_free_i64(tcg_ctx, tpc);
-    tcg_temp_free_ptr(tcg_ctx, tuc);
-    tcg_temp_free_i32(tcg_ctx, ttype);
+    uc_hook_list_t *hooks = uc_hook_list_get(uc, 1 << type, pc, pc);
+    TCGv_ptr thooks;
+    TCGv_i64 tpc;
+    TCGv_i32 tsize;
+
+    tcg_ctx->uc_size_op = NULL;
+    if (hooks == NULL) {
+        return;
+    }
+    thooks = tcg_const_ptr(tcg_ctx, hooks);
+    tpc = tcg_const_i64(tcg_ctx, pc);
+    tsize = tcg_const_i32(tcg_ctx, size);
+    tcg_ctx->uc_size_op = tcg_last_op(tcg_ctx);
+    gen_helper_uc_hook_code(tcg_ctx, tcg_ctx->cpu_env, thooks, tpc, tsize);
     tcg_temp_free_i32(tcg_ctx, tsize);
+    tcg_temp_free_i64(tcg_ctx, tpc);
+    tcg_temp_free_ptr(tcg_ctx, thooks);
 }
 
 static inline void tcg_gen_op1_i32(TCGContext *s, TCGOpcode opc, TCGv_i32 a1)
@@ -1267,6 +1278,12 @@ static inline void tcg_gen_ld_ptr(TCGContext *s, TCGv_ptr r, TCGv_ptr a, intptr_
     glue(tcg_gen_ld_,PTR)(s, (NAT)r, a, o);
 }
 
+// SNPS added
+static inline void tcg_gen_st_ptr(TCGContext *s, TCGv_ptr r, TCGv_ptr a, intptr_t o)
+{
+    glue(tcg_gen_st_,PTR)(s, (NAT)r, a, o);
+}
+
 static inline void tcg_gen_discard_ptr(TCGContext *s, TCGv_ptr a)
 {
     glue(tcg_gen_discard_,PTR)(s, (NAT)a);
@@ -1288,6 +1305,13 @@ static inline void tcg_gen_brcondi_ptr(TCGContext *s, TCGCond cond, TCGv_ptr a,
     glue(tcg_gen_brcondi_,PTR)(s, cond, (NAT)a, b, label);
 }
 
+// SNPS added
+static inline void tcg_gen_brcond_ptr(TCGContext *s, TCGCond cond, TCGv_ptr a,
+                                      TCGv_ptr b, TCGLabel *label)
+{
+    glue(tcg_gen_brcond_,PTR)(s, cond, (NAT)a, (NAT)b, label);
+}
+
 static inline void tcg_gen_ext_i32_ptr(TCGContext *s, TCGv_ptr r, TCGv_i32 a)
 {
 #if UINTPTR_MAX == UINT32_MAX
@@ -1946,17 +1946,24 @@ static void la_global_kill(TCGContext *s, int ng)
     }
 }
 
-/* Unicorn: for brcond, we should refresh liveness states for TCG globals */
-static inline void tcg_la_br_end(TCGContext *s)
+/* SNPS added: liveness analysis: conditional branch: all temps are dead,
+   globals and local temps should be synced, but stay live. */
+static void la_bb_sync(TCGContext *s, int ng, int nt)
 {
-    int ng = s->nb_globals;
-    int nt = s->nb_temps;
     int i;
 
     la_global_sync(s, ng);
-    for (i = ng; i < nt; i++) {
-        s->temps[i].state = s->temps[i].temp_local ? TS_DEAD | TS_MEM
-                                                   : TS_MEM;
+
+    for (i = ng; i < nt; ++i) {
+        if (s->temps[i].temp_local) {
+            int state = s->temps[i].state;
+            s->temps[i].state = state | TS_MEM;
+            if (state != TS_DEAD) {
+                continue;
+            }
+        } else {
+            s->temps[i].state = TS_DEAD;
+        }
         la_reset_pref(s, &s->temps[i]);
     }
 }
@@ -2226,21 +2233,14 @@ static void liveness_pass_1(TCGContext *s)
             /* If end of basic block, update.  */
             if (def->flags & TCG_OPF_BB_EXIT) {
                 la_func_end(s, nb_globals, nb_temps);
+            } else if (def->flags & TCG_OPF_COND_BRANCH) {
+                // SNPS changed: globals such as the condition flags are
+                // synced for the branch target (which may exit the TB, e.g.
+                // check_exit_request()), but stay live in registers on the
+                // fall-through path. Temps die as at the end of a block.
+                la_bb_sync(s, nb_globals, nb_temps);
             } else if (def->flags & TCG_OPF_BB_END) {
-                // Unicorn: do not optimize dead temps on brcond,
-                // this causes problem because check_exit_request() inserts
-                // brcond instruction in the middle of the TB,
-                // which incorrectly flags end-of-block
-                if (1) { // SNPS changed
-                    la_bb_end(s, nb_globals, nb_temps);
-                } else {
-                    // Unicorn: we do not touch dead temps for brcond,
-                    // but we should refresh TCG globals In-Memory states,
-                    // otherwise, important CPU states(especially conditional flags) might be forgotten,
-                    // result in wrongly generated host code that run into wrong branch.
-                    // Refer to https://github.com/unicorn-engine/unicorn/issues/287 for further information
-                    tcg_la_br_end(s);
-                }
+                la_bb_end(s, nb_globals, nb_temps);
             } else if (def->flags & TCG_OPF_SIDE_EFFECTS) {
                 la_global_sync(s, nb_globals);
                 if (def->flags & TCG_OPF_CALL_CLOBBER) {
@@ -2351,7 +2351,10 @@ static bool liveness_pass_2(TCGContext *s)
             nb_oargs = def->nb_oargs;
 
             /* Set flags similar to how calls require.  */
-            if (def->flags & TCG_OPF_BB_END) {
+            if (def->flags & TCG_OPF_COND_BRANCH) { // SNPS added
+                /* Like reading globals: sync_globals */
+                call_flags = TCG_CALL_NO_WRITE_GLOBALS;
+            } else if (def->flags & TCG_OPF_BB_END) {
                 /* Like writing globals: save_globals */
                 call_flags = 0;
             } else if (def->flags & TCG_OPF_SIDE_EFFECTS) {
@@ -2823,6 +2826,26 @@ static void tcg_reg_alloc_bb_end(TCGContext *s, TCGRegSet allocated_regs)
     save_globals(s, allocated_regs);
 }
 
+/* SNPS added: at a conditional branch, we assume all temporaries are dead
+   and all globals and local temps are synced to their location. */
+static void tcg_reg_alloc_cbranch(TCGContext *s, TCGRegSet allocated_regs)
+{
+    int i;
+
+    sync_globals(s, allocated_regs);
+
+    for (i = s->nb_globals; i < s->nb_temps; i++) {
+        TCGTemp *ts = &s->temps[i];
+        /* The liveness analysis already ensures that temps are dead and
+           local temps are synced. Keep tcg_debug_asserts for safety. */
+        if (ts->temp_local) {
+            tcg_debug_assert(ts->val_type != TEMP_VAL_REG || ts->mem_coherent);
+        } else {
+            tcg_debug_assert(ts->val_type == TEMP_VAL_DEAD);
+        }
+    }
+}
+
 /*
  * Specialized code generation for INDEX_op_movi_*.
  */
@@ -3175,7 +3198,9 @@ static void tcg_reg_alloc_op(TCGContext *s, const TCGOp *op)
         }
     }
 
-    if (def->flags & TCG_OPF_BB_END) {
+    if (def->flags & TCG_OPF_COND_BRANCH) { // SNPS added
+        tcg_reg_alloc_cbranch(s, i_allocated_regs);
+    } else if (def->flags & TCG_OPF_BB_END) {
         tcg_reg_alloc_bb_end(s, i_allocated_regs);
     } else {
         if (def->flags & TCG_OPF_CALL_CLOBBER) {
@@ -658,6 +658,8 @@ enum {
     TCG_OPF_NOT_PRESENT  = 0x20,
     /* Instruction operands are vectors.  */
     TCG_OPF_VECTOR       = 0x40,
+    /* SNPS added: Instruction is a conditional branch.  */
+    TCG_OPF_COND_BRANCH  = 0x80,
 };
 
 typedef struct TCGOpDef {
@@ -883,6 +885,13 @@ struct TCGContext {
     TCGLabel *exitreq_label;  // gen_tb_start()
     TCGLabel *icount_label; // SNPS added
     TCGOp* icount_op; // SNPS added
+
+    // SNPS added: memory trace of the TB being translated
+    bool mem_trace;
+    size_t mem_trace_count;     // accesses traced so far
+    TCGOp *mem_trace_op[2];     // reservation, patched by gen_tb_end()
+
+    TCGOp *uc_size_op; // SNPS added: size argument of the last gen_uc_tracecode()
 };
 
 static inline size_t temp_idx(TCGContext *tcg_ctx, TCGTemp *ts)
@@ -24,13 +24,16 @@ void free_code_gen_buffer(struct uc_struct *uc);
 
 static inline void free_address_spaces(struct uc_struct *uc)
 {
-    int i;
+    int i, n;
 
     address_space_destroy(&uc->as);
-    for (i = 0; i < uc->cpu->num_ases; i++) {
-        AddressSpace *as = uc->cpu->cpu_ases[i].as;
-        address_space_destroy(as);
-        g_free(as);
+    for (n = 0; n < uc->num_cpus; n++) { // SNPS changed
+        CPUState *cpu = uc->cpus[n];
+        for (i = 0; i < cpu->num_ases; i++) {
+            AddressSpace *as = cpu->cpu_ases[i].as;
+            address_space_destroy(as);
+            g_free(as);
+        }
     }
 }
 
@@ -70,14 +73,42 @@ static inline void tb_flush_page(CPUState* cpu,  uint64_t start,
     tb_invalidate_phys_page_range(uc, start, end, 0);
 }
 
+// SNPS added: the TBs in a virtual range that carry the hooks of the engine
+static inline void tb_flush_hooked(CPUState *cpu, uint64_t start,
+                                   uint64_t end)
+{
+    tb_invalidate_virt_range(cpu->uc, start, end, true);
+}
+
 /** Freeing common resources */
 static void release_common(void *t)
 {
     TCGPool *po, *to;
     TCGContext *s = (TCGContext *)t;
+    TCGOpDef* def;
+    int i; // SNPS added
+
+    // Destory flat view hash table
+    g_hash_table_destroy(s->uc->flat_views);
+    unicorn_free_empty_flat_view(s->uc);
+
+    // TODO(danghvu): these function is not available outside qemu
+    // so we keep them here instead of outside uc_close.
+    free_address_spaces(s->uc);
+    memory_free(s->uc);
+    free_machine_class_name(s->uc);
+
+    // SNPS added
+    for (i = 0; i < s->uc->num_cpus; i++)
+        tlb_destroy(s->uc->cpus[i]);
+
+    // SNPS added: other engines of the sharing group keep using the
+    // translation context
+    if (uc_tcg_shared(s->uc))
+        return;
 
     // Clean TCG.
-    TCGOpDef* def = &s->tcg_op_defs[0];
+    def = &s->tcg_op_defs[0];
     g_free(def->args_ct);
     g_free(def->sorted_args);
     g_free(s->tcg_op_defs);
@@ -89,17 +120,8 @@ static void release_common(void *t)
     tcg_pool_reset(s);
     g_hash_table_destroy(s->helpers);
 
-    // Destory flat view hash table
-    g_hash_table_destroy(s->uc->flat_views);
-    unicorn_free_empty_flat_view(s->uc);
-
-    // TODO(danghvu): these function is not available outside qemu
-    // so we keep them here instead of outside uc_close.
-    free_address_spaces(s->uc);
-    memory_free(s->uc);
     tb_cleanup(s->uc);
     free_code_gen_buffer(s->uc);
-    free_machine_class_name(s->uc);
     free_tcg_temp_names(s);
 }
 
@@ -110,19 +132,27 @@ static inline void uc_common_init(struct uc_struct* uc)
     uc->read_mem = cpu_physical_mem_read;
     uc->tcg_enabled = tcg_enabled;
     uc->tcg_exec_init = tcg_exec_init;
+    uc->tcg_exec_attach = tcg_exec_attach; // SNPS added
     uc->cpu_exec_init_all = cpu_exec_init_all;
     uc->cpu_exec_exit = cpu_exec_exit;
     uc->vm_start = vm_start;
 
     uc->tb_flush = tb_flush; // SNPS added
     uc->tb_flush_page = tb_flush_page; // SNPS added
+    uc->tb_flush_hooked = tb_flush_hooked; // SNPS added
+    uc->tb_warm = tb_warm; // SNPS added
+    uc->insn_count = cpu_insn_count; // SNPS added
+    uc->restore_callout_pc = cpu_restore_callout_pc; // SNPS added
 
     uc->inv_dmi_ptr = dmi_invalidate; // SNPS added
+    uc->inv_dmi_ranges_ptr = dmi_invalidate_ranges; // SNPS added
 
     uc->tlb_flush = tlb_flush; // SNPS added
     uc->tlb_flush_page = tlb_flush_page; // SNPS added
     uc->tlb_flush_mmuidx = tlb_flush_by_mmuidx; // SNPS added
     uc->tlb_flush_page_mmuidx = tlb_flush_page_by_mmuidx; // SNPS added
+    uc->tlb_flush_asid_mmuidx = tlb_flush_asid_by_mmuidx; // SNPS added
+    uc->tlb_stats = tlb_stats; // SNPS added
 
     uc->breakpoint_insert = cpu_breakpoint_insert; // SNPS added
     uc->breakpoint_remove = cpu_breakpoint_remove; // SNPS added
@@ -133,6 +163,8 @@ static inline void uc_common_init(struct uc_struct* uc)
     uc->memory_map_ptr = memory_map_ptr;
     uc->memory_map_mmio = memory_map_io; // SNPS added
     uc->memory_unmap = memory_unmap;
+    uc->memory_begin = memory_region_transaction_begin; // SNPS added
+    uc->memory_commit = memory_region_transaction_commit; // SNPS added
     uc->readonly_mem = memory_region_set_readonly;
 
     uc->target_page_size = TARGET_PAGE_SIZE;
@@ -29,6 +29,49 @@ static void error_exit(int err, const char *msg)
     //abort();
 }
 
+void qemu_mutex_init(QemuMutex *mutex)
+{
+    InitializeSRWLock(&mutex->lock);
+}
+
+void qemu_mutex_destroy(QemuMutex *mutex)
+{
+}
+
+void qemu_mutex_lock(QemuMutex *mutex)
+{
+    AcquireSRWLockExclusive(&mutex->lock);
+}
+
+void qemu_mutex_unlock(QemuMutex *mutex)
+{
+    ReleaseSRWLockExclusive(&mutex->lock);
+}
+
+void qemu_cond_signal(QemuCond *cond)
+{
+    WakeConditionVariable(&cond->var);
+}
+
+void qemu_cond_wait(QemuCond *cond, QemuMutex *mutex)
+{
+    SleepConditionVariableSRW(&cond->var, &mutex->lock, INFINITE, 0);
+}
+
+bool qemu_cond_timedwait(QemuCond *cond, QemuMutex *mutex, int64_t ns)
+{
+    /* round up, a wait must not return before the timeout has passed */
+    DWORD ms = (DWORD)((ns + 999999) / 1000000);
+
+    if (!SleepConditionVariableSRW(&cond->var, &mutex->lock, ms, 0)) {
+        if (GetLastError() != ERROR_TIMEOUT) {
+            error_exit(GetLastError(), __func__);
+        }
+        return false;
+    }
+    return true;
+}
+
 struct QemuThreadData {
     /* Passed to win32_start_routine.  */
     void             *(*start_routine)(void *);
@@ -136,6 +179,17 @@ int qemu_thread_create(struct uc_struct *uc, QemuThread *thread, const char *nam
     return 0;
 }
 
+void qemu_thread_get_self(QemuThread *thread)
+{
+    thread->data = NULL;
+    thread->tid = GetCurrentThreadId();
+}
+
+bool qemu_thread_is_self(QemuThread *thread)
+{
+    return GetCurrentThreadId() == thread->tid;
+}
+
 HANDLE qemu_thread_get_handle(QemuThread *thread)
 {
     QemuThreadData *data;
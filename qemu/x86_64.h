@@ -2715,6 +2715,9 @@
 #define tb_reset_jump tb_reset_jump_x86_64
 #define tb_set_jmp_target tb_set_jmp_target_x86_64
 #define tb_target_set_jmp_target tb_target_set_jmp_target_x86_64
+#define tb_warm tb_warm_x86_64
+#define tb_invalidate_virt_pc tb_invalidate_virt_pc_x86_64
+#define tb_invalidate_virt_range tb_invalidate_virt_range_x86_64
 #define tcg_accel_class_init tcg_accel_class_init_x86_64
 #define tcg_accel_type tcg_accel_type_x86_64
 #define tcg_add_param_i32 tcg_add_param_i32_x86_64
@@ -2746,6 +2749,7 @@
 #define tcg_emit_op tcg_emit_op_x86_64
 #define tcg_enabled tcg_enabled_x86_64
 #define tcg_exec_all tcg_exec_all_x86_64
+#define tcg_exec_attach tcg_exec_attach_x86_64
 #define tcg_exec_init tcg_exec_init_x86_64
 #define tcg_expand_vec_op tcg_expand_vec_op_x86_64
 #define tcg_find_helper tcg_find_helper_x86_64
@@ -3265,8 +3269,10 @@
 #define thumb2_logic_op thumb2_logic_op_x86_64
 #define ti925t_initfn ti925t_initfn_x86_64
 #define tlb_add_large_page tlb_add_large_page_x86_64
+#define tlb_destroy tlb_destroy_x86_64
 #define tlb_init tlb_init_x86_64
 #define tlb_flush tlb_flush_x86_64
+#define tlb_flush_asid_by_mmuidx tlb_flush_asid_by_mmuidx_x86_64
 #define tlb_flush_by_mmuidx tlb_flush_by_mmuidx_x86_64
 #define tlb_flush_entry tlb_flush_entry_x86_64
 #define tlb_flush_page tlb_flush_page_x86_64
@@ -3274,9 +3280,14 @@
 #define tlb_is_dirty_ram tlb_is_dirty_ram_x86_64
 #define tlb_reset_dirty tlb_reset_dirty_x86_64
 #define tlb_reset_dirty_range tlb_reset_dirty_range_x86_64
+#define tlb_set_asid_by_mmuidx tlb_set_asid_by_mmuidx_x86_64
 #define tlb_set_dirty tlb_set_dirty_x86_64
 #define tlb_set_page tlb_set_page_x86_64
 #define tlb_set_page_with_attrs tlb_set_page_with_attrs_x86_64
+#define tlb_stats tlb_stats_x86_64
+#define tlb_walk_host tlb_walk_host_x86_64
+#define tlb_walk_cache_lookup tlb_walk_cache_lookup_x86_64
+#define tlb_walk_cache_insert tlb_walk_cache_insert_x86_64
 #define tlb_vaddr_to_host tlb_vaddr_to_host_x86_64
 #define tlbi_aa64_asid_is_write tlbi_aa64_asid_is_write_x86_64
 #define tlbi_aa64_asid_write tlbi_aa64_asid_write_x86_64
@@ -3413,8 +3424,16 @@
 #define tlb_flush_page_all_cpus_synced tlb_flush_page_all_cpus_synced_x86_64
 #define tlb_flush_by_mmuidx_all_cpus_synced tlb_flush_by_mmuidx_all_cpus_synced_x86_64
 #define tlb_flush_page_by_mmuidx_all_cpus_synced tlb_flush_page_by_mmuidx_all_cpus_synced_x86_64
+#define tlb_flush_asid_by_mmuidx_all_cpus_synced tlb_flush_asid_by_mmuidx_all_cpus_synced_x86_64
 #define dmi_invalidate dmi_invalidate_x86_64
+#define dmi_invalidate_ranges dmi_invalidate_ranges_x86_64
 #define helper_trace_tb_entry helper_trace_tb_entry_x86_64
+#define helper_trace_bb_flush helper_trace_bb_flush_x86_64
+#define helper_trace_bb_time helper_trace_bb_time_x86_64
+#define helper_mem_trace_flush helper_mem_trace_flush_x86_64
+#define helper_uc_hook_code helper_uc_hook_code_x86_64
+#define cpu_insn_count cpu_insn_count_x86_64
+#define cpu_restore_callout_pc cpu_restore_callout_pc_x86_64
 #define cpu_mmu_index cpu_mmu_index_x86_64
 #define gen_helper_raise_exception gen_helper_raise_exception_x86_64
 #define raise_exception raise_exception_x86_64
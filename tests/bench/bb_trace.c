@@ -0,0 +1,106 @@
+/*
+Benchmark for basic block tracing. Runs two-instruction blocks with the
+callback per block of uc_setup_basic_block_trace() and with the buffered
+trace, with and without instruction counts and timestamps. Prints millions
+of blocks per second.
+*/
+
+#include <unicorn/unicorn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define CODE_ADDR 0x10000
+#define NUM_BLOCKS 64
+#define BUFFER_WORDS (3 * 4096)
+
+static uint32_t code[NUM_BLOCKS * 2];
+static uint64_t buffer[BUFFER_WORDS];
+static uint64_t sum;
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void trace_block(void *opaque, uint64_t addr)
+{
+    sum += addr;
+}
+
+static void trace_buffer(void *opaque, const uint64_t *entries, size_t count)
+{
+    sum += entries[0] + count;
+}
+
+static int run(uc_engine *uc, const char *name, size_t insns)
+{
+    double start;
+    uc_err err;
+
+    // warm up the translation cache
+    uc_emu_start(uc, CODE_ADDR, 0, 0, 1000);
+
+    start = now();
+    err = uc_emu_start(uc, CODE_ADDR, 0, 0, insns);
+    if (err) {
+        printf("emulation failed with error returned: %u\n", err);
+        return 1;
+    }
+
+    printf("%-16s %.1f M blocks/s\n", name, insns / 2 / (now() - start) / 1e6);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    size_t insns = argc > 1 ? strtoul(argv[1], NULL, 0) : 50000000;
+    uc_engine *uc;
+    uc_err err;
+    int i;
+
+    // add x0, x0, #1; b <next block>, the last one branches to the first
+    for (i = 0; i < NUM_BLOCKS; i++) {
+        code[i * 2] = 0x91000400;
+        code[i * 2 + 1] = 0x14000001;
+    }
+    code[NUM_BLOCKS * 2 - 1] = 0x14000000 | ((-(NUM_BLOCKS * 2 - 1)) & 0x3ffffff);
+
+    err = uc_open("Cortex-A53", NULL, NULL, &uc);
+    if (err) {
+        printf("Failed on uc_open() with error returned: %u\n", err);
+        return 1;
+    }
+
+    uc_mem_map(uc, CODE_ADDR, 0x1000, UC_PROT_ALL);
+    uc_mem_write(uc, CODE_ADDR, code, sizeof(code));
+
+    if (run(uc, "none", insns))
+        return 1;
+
+    uc_setup_basic_block_trace(uc, NULL, trace_block);
+    if (run(uc, "callback", insns))
+        return 1;
+    uc_setup_basic_block_trace(uc, NULL, NULL);
+
+    uc_setup_basic_block_trace_buffer(uc, NULL, buffer, BUFFER_WORDS, 0,
+                                      trace_buffer);
+    if (run(uc, "buffer", insns))
+        return 1;
+
+    uc_setup_basic_block_trace_buffer(uc, NULL, buffer, BUFFER_WORDS,
+                                      UC_BB_TRACE_ICOUNT, trace_buffer);
+    if (run(uc, "buffer+icount", insns))
+        return 1;
+
+    uc_setup_basic_block_trace_buffer(uc, NULL, buffer, BUFFER_WORDS,
+                                      UC_BB_TRACE_ICOUNT | UC_BB_TRACE_TIME,
+                                      trace_buffer);
+    if (run(uc, "buffer+time", insns))
+        return 1;
+
+    uc_close(uc);
+    return sum == 0;
+}
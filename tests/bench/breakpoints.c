@@ -0,0 +1,94 @@
+/*
+Benchmark for callback breakpoints. Inserts 1000 breakpoints into code that is
+not executed, runs two-instruction blocks with one breakpoint hit per loop,
+and then moves one of the breakpoints between short runs, as OS awareness
+does. Prints the time for the inserts, millions of instructions per second
+and short runs per second.
+*/
+
+#include <unicorn/unicorn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define CODE_ADDR  0x10000
+#define OTHER_ADDR 0x20000
+#define NUM_BLOCKS 256
+#define NUM_BPS    1000
+#define SHORT_RUN  10000
+
+static uint32_t code[NUM_BLOCKS * 2];
+static uint64_t sum;
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void hit(void *opaque, uint64_t addr)
+{
+    sum += addr;
+}
+
+int main(int argc, char **argv)
+{
+    size_t insns = argc > 1 ? strtoul(argv[1], NULL, 0) : 50000000;
+    size_t runs = insns / SHORT_RUN / 10;
+    double start;
+    uc_engine *uc;
+    uc_err err;
+    size_t i;
+
+    // add x0, x0, #1; b <next block>, the last one branches to the first
+    for (i = 0; i < NUM_BLOCKS; i++) {
+        code[i * 2] = 0x91000400;
+        code[i * 2 + 1] = 0x14000001;
+    }
+    code[NUM_BLOCKS * 2 - 1] = 0x14000000 | ((-(NUM_BLOCKS * 2 - 1)) & 0x3ffffff);
+
+    err = uc_open("Cortex-A53", NULL, NULL, &uc);
+    if (err) {
+        printf("Failed on uc_open() with error returned: %u\n", err);
+        return 1;
+    }
+
+    uc_mem_map(uc, CODE_ADDR, 0x1000, UC_PROT_ALL);
+    uc_mem_map(uc, OTHER_ADDR, 0x1000, UC_PROT_ALL);
+    uc_mem_write(uc, CODE_ADDR, code, sizeof(code));
+    uc_cbbreakpoint_setup(uc, NULL, hit);
+
+    // warm up the translation cache
+    uc_emu_start(uc, CODE_ADDR, 0, 0, NUM_BLOCKS * 4);
+
+    start = now();
+    for (i = 0; i < NUM_BPS; i++)
+        uc_cbbreakpoint_insert(uc, OTHER_ADDR + i * 4);
+    uc_cbbreakpoint_insert(uc, CODE_ADDR);
+    printf("%-8s %.3f ms\n", "insert", (now() - start) * 1e3);
+
+    uc_emu_start(uc, CODE_ADDR, 0, 0, NUM_BLOCKS * 4);
+    start = now();
+    err = uc_emu_start(uc, CODE_ADDR, 0, 0, insns);
+    if (err) {
+        printf("emulation failed with error returned: %u\n", err);
+        return 1;
+    }
+    printf("%-8s %.1f MIPS\n", "run", insns / (now() - start) / 1e6);
+
+    start = now();
+    for (i = 0; i < runs; i++) {
+        uc_cbbreakpoint_remove(uc, OTHER_ADDR + i % NUM_BPS * 4);
+        uc_cbbreakpoint_insert(uc, OTHER_ADDR + i % NUM_BPS * 4);
+        err = uc_emu_start(uc, CODE_ADDR, 0, 0, SHORT_RUN);
+        if (err) {
+            printf("emulation failed with error returned: %u\n", err);
+            return 1;
+        }
+    }
+    printf("%-8s %.0f runs/s\n", "toggle", runs / (now() - start));
+
+    uc_close(uc);
+    return sum == 0;
+}
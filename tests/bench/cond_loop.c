@@ -0,0 +1,66 @@
+/*
+Benchmark for a compare-and-branch heavy A32 loop. Most instructions are
+conditionally executed and branch within their block, prints millions of
+instructions per second.
+*/
+
+#include <unicorn/unicorn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define CODE_ADDR 0x10000
+
+static const uint32_t loop_code[] = {
+    0xe2800001, // 10000: add    r0, r0, #1
+    0xe3100001, // 10004: tst    r0, #1
+    0x10811000, // 10008: addne  r1, r1, r0
+    0x00822000, // 1000c: addeq  r2, r2, r0
+    0xe3500007, // 10010: cmp    r0, #7
+    0xc2503009, // 10014: subsgt r3, r0, #9
+    0x41a04000, // 10018: movmi  r4, r0
+    0x52944001, // 1001c: addspl r4, r4, #1
+    0xe1510002, // 10020: cmp    r1, r2
+    0x80411002, // 10024: subhi  r1, r1, r2
+    0x90422001, // 10028: subls  r2, r2, r1
+    0xeafffff3, // 1002c: b      10000
+};
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv)
+{
+    size_t insns = argc > 1 ? strtoul(argv[1], NULL, 0) : 200000000;
+    double start;
+    uc_engine *uc;
+    uc_err err;
+
+    err = uc_open("Cortex-A15", NULL, NULL, &uc);
+    if (err) {
+        printf("Failed on uc_open() with error returned: %u\n", err);
+        return 1;
+    }
+
+    uc_mem_map(uc, CODE_ADDR, 0x1000, UC_PROT_ALL);
+    uc_mem_write(uc, CODE_ADDR, loop_code, sizeof(loop_code));
+
+    // warm up the translation cache
+    uc_emu_start(uc, CODE_ADDR, 0, 0, 1000);
+
+    start = now();
+    err = uc_emu_start(uc, CODE_ADDR, 0, 0, insns);
+    if (err) {
+        printf("emulation failed with error returned: %u\n", err);
+        return 1;
+    }
+
+    printf("%.1f MIPS\n", insns / (now() - start) / 1e6);
+
+    uc_close(uc);
+    return 0;
+}
@@ -0,0 +1,83 @@
+/*
+Benchmark for running many short quanta back to back.
+Compares uc_emu_start() from the current PC against uc_emu_resume() and
+prints calls per second for a few small instruction budgets.
+*/
+
+#include <unicorn/unicorn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define CODE_ADDR 0x10000
+
+static const uint32_t loop_code[] = {
+    0x91000400, // 10000: add  x0, x0, #1
+    0x8b000021, // 10004: add  x1, x1, x0
+    0xca010042, // 10008: eor  x2, x2, x1
+    0x17fffffd, // 1000c: b    10000
+};
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static double run(uc_engine *uc, size_t budget, size_t calls, int resume)
+{
+    uint64_t pc;
+    double start;
+    size_t i;
+    uc_err err;
+
+    start = now();
+    for (i = 0; i < calls; i++) {
+        if (resume) {
+            err = uc_emu_resume(uc, budget);
+        } else {
+            uc_reg_read(uc, UC_ARM64_REG_PC, &pc);
+            err = uc_emu_start(uc, pc, 0, 0, budget);
+        }
+
+        if (err) {
+            printf("emulation failed with error returned: %u\n", err);
+            exit(1);
+        }
+    }
+
+    return calls / (now() - start);
+}
+
+int main(int argc, char **argv)
+{
+    static const size_t budgets[] = { 1, 16, 256, 4096 };
+    size_t calls = argc > 1 ? strtoul(argv[1], NULL, 0) : 200000;
+    uc_engine *uc;
+    uc_err err;
+    size_t i;
+
+    err = uc_open("Cortex-A53", NULL, NULL, &uc);
+    if (err) {
+        printf("Failed on uc_open() with error returned: %u\n", err);
+        return 1;
+    }
+
+    uc_mem_map(uc, CODE_ADDR, 0x1000, UC_PROT_ALL);
+    uc_mem_write(uc, CODE_ADDR, loop_code, sizeof(loop_code));
+
+    // warm up the translation cache
+    uc_emu_start(uc, CODE_ADDR, 0, 0, 1000);
+
+    printf("%8s %16s %16s\n", "budget", "start calls/s", "resume calls/s");
+    for (i = 0; i < sizeof(budgets) / sizeof(budgets[0]); i++) {
+        size_t n = budgets[i] > 256 ? calls / 16 : calls;
+        double start = run(uc, budgets[i], n, 0);
+        double resume = run(uc, budgets[i], n, 1);
+        printf("%8zu %16.0f %16.0f\n", budgets[i], start, resume);
+    }
+
+    uc_close(uc);
+    return 0;
+}
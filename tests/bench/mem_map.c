@@ -0,0 +1,73 @@
+/*
+Benchmark for mapping many regions. Maps MMIO pages with RAM pages in
+between, one by one and in a batch, then reads from all RAM pages. Prints the
+time to map and millions of uc_mem_read() calls per second.
+*/
+
+#include <unicorn/unicorn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define IO_BASE 0x10000000
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uc_tx_result_t mmio(uc_engine *uc, void *opaque, uc_mmio_tx_t *tx)
+{
+    return UC_TX_OK;
+}
+
+static uc_engine *map(const char *name, size_t regions, bool batch)
+{
+    double start;
+    uc_engine *uc;
+    uc_err err;
+    size_t i;
+
+    err = uc_open("Cortex-A53", NULL, NULL, &uc);
+    if (err) {
+        printf("Failed on uc_open() with error returned: %u\n", err);
+        exit(1);
+    }
+
+    start = now();
+    if (batch)
+        uc_mem_map_begin(uc);
+    for (i = 0; i < regions; i++) {
+        uc_mem_map_io(uc, IO_BASE + i * 0x2000, 0x1000, mmio, NULL);
+        uc_mem_map(uc, IO_BASE + i * 0x2000 + 0x1000, 0x1000, UC_PROT_ALL);
+    }
+    if (batch)
+        uc_mem_map_commit(uc);
+    printf("%-8s %.3f ms\n", name, (now() - start) * 1e3);
+    return uc;
+}
+
+int main(int argc, char **argv)
+{
+    size_t regions = argc > 1 ? strtoul(argv[1], NULL, 0) : 500;
+    size_t reads = regions * 1000;
+    uint32_t v, sum = 0;
+    double start;
+    uc_engine *uc;
+    size_t i;
+
+    uc_close(map("map", regions, false));
+    uc = map("batch", regions, true);
+
+    start = now();
+    for (i = 0; i < reads; i++) {
+        uc_mem_read(uc, IO_BASE + (i * 7 % regions) * 0x2000 + 0x1000, &v, 4);
+        sum += v;
+    }
+    printf("%-8s %.1f M/s\n", "read", reads / (now() - start) / 1e6);
+
+    uc_close(uc);
+    return sum != 0;
+}
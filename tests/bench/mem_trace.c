@@ -0,0 +1,94 @@
+/*
+Benchmark for the memory access trace. Runs the loop of ldst_loop without
+trace, with addresses only, and with physical addresses and values. Prints
+millions of instructions per second.
+*/
+
+#include <unicorn/unicorn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define CODE_ADDR 0x10000
+#define DATA_ADDR 0x80000
+#define BUFFER_WORDS (4 * 4096)
+
+static const uint32_t loop_code[] = {
+    0xf9400002, // 10000: ldr  x2, [x0]
+    0x91000442, // 10004: add  x2, x2, #1
+    0xf9000402, // 10008: str  x2, [x0, #8]
+    0x8b020021, // 1000c: add  x1, x1, x2
+    0xa9410c02, // 10010: ldp  x2, x3, [x0, #16]
+    0x8b030021, // 10014: add  x1, x1, x3
+    0xf9000c01, // 10018: str  x1, [x0, #24]
+    0x17fffff9, // 1001c: b    10000
+};
+
+static uint64_t buffer[BUFFER_WORDS];
+static uint64_t sum;
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void trace(void *opaque, const uint64_t *entries, size_t count)
+{
+    sum += entries[0] + count;
+}
+
+static int run(uc_engine *uc, const char *name, size_t insns)
+{
+    uint64_t x0 = DATA_ADDR;
+    double start;
+    uc_err err;
+
+    uc_reg_write(uc, UC_ARM64_REG_X0, &x0);
+
+    // warm up the translation cache
+    uc_emu_start(uc, CODE_ADDR, 0, 0, 1000);
+
+    start = now();
+    err = uc_emu_start(uc, CODE_ADDR, 0, 0, insns);
+    if (err) {
+        printf("emulation failed with error returned: %u\n", err);
+        return 1;
+    }
+
+    printf("%-12s %.1f MIPS\n", name, insns / (now() - start) / 1e6);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    size_t insns = argc > 1 ? strtoul(argv[1], NULL, 0) : 100000000;
+    uc_engine *uc;
+    uc_err err;
+
+    err = uc_open("Cortex-A53", NULL, NULL, &uc);
+    if (err) {
+        printf("Failed on uc_open() with error returned: %u\n", err);
+        return 1;
+    }
+
+    uc_mem_map(uc, CODE_ADDR, 0x1000, UC_PROT_ALL);
+    uc_mem_map(uc, DATA_ADDR, 0x1000, UC_PROT_ALL);
+    uc_mem_write(uc, CODE_ADDR, loop_code, sizeof(loop_code));
+
+    if (run(uc, "none", insns))
+        return 1;
+
+    uc_setup_mem_trace(uc, NULL, buffer, BUFFER_WORDS, 0, trace);
+    if (run(uc, "address", insns))
+        return 1;
+
+    uc_setup_mem_trace(uc, NULL, buffer, BUFFER_WORDS,
+                       UC_MEM_TRACE_PADDR | UC_MEM_TRACE_VALUE, trace);
+    if (run(uc, "paddr+value", insns))
+        return 1;
+
+    uc_close(uc);
+    return sum == 0;
+}
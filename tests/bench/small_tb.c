@@ -0,0 +1,62 @@
+/*
+Benchmark for control heavy code. Every block is two instructions long and
+chained to the next one, so the per-block overhead dominates. Prints
+millions of instructions per second.
+*/
+
+#include <unicorn/unicorn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define CODE_ADDR 0x10000
+#define NUM_BLOCKS 64
+
+static uint32_t code[NUM_BLOCKS * 2];
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv)
+{
+    size_t insns = argc > 1 ? strtoul(argv[1], NULL, 0) : 100000000;
+    double start;
+    uc_engine *uc;
+    uc_err err;
+    int i;
+
+    // add x0, x0, #1; b <next block>, the last one branches to the first
+    for (i = 0; i < NUM_BLOCKS; i++) {
+        code[i * 2] = 0x91000400;
+        code[i * 2 + 1] = 0x14000001;
+    }
+    code[NUM_BLOCKS * 2 - 1] = 0x14000000 | ((-(NUM_BLOCKS * 2 - 1)) & 0x3ffffff);
+
+    err = uc_open("Cortex-A53", NULL, NULL, &uc);
+    if (err) {
+        printf("Failed on uc_open() with error returned: %u\n", err);
+        return 1;
+    }
+
+    uc_mem_map(uc, CODE_ADDR, 0x1000, UC_PROT_ALL);
+    uc_mem_write(uc, CODE_ADDR, code, sizeof(code));
+
+    // warm up the translation cache
+    uc_emu_start(uc, CODE_ADDR, 0, 0, 1000);
+
+    start = now();
+    err = uc_emu_start(uc, CODE_ADDR, 0, 0, insns);
+    if (err) {
+        printf("emulation failed with error returned: %u\n", err);
+        return 1;
+    }
+
+    printf("%.1f MIPS\n", insns / (now() - start) / 1e6);
+
+    uc_close(uc);
+    return 0;
+}
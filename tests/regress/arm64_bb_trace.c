@@ -0,0 +1,186 @@
+/*
+Test for the buffered basic block trace. Entries are written by generated
+code, handed over when the buffer is full or the run ends, and continue the
+instruction count across runs. The same trace streamed to a file must decode
+to the same entries.
+*/
+
+#include <unicorn/unicorn.h>
+#include <stdio.h>
+#include <string.h>
+
+#define CODE_ADDR 0x10000
+#define TRACE_FILE "arm64_bb_trace.trace"
+
+static const uint32_t code[] = {
+    0xd2800000, // 10000: mov  x0, #0
+    0x91000400, // 10004: add  x0, x0, #1
+    0xf100281f, // 10008: cmp  x0, #10
+    0x54ffffc1, // 1000c: b.ne 10004
+    0x14000000, // 10010: b    10010
+};
+
+// up to the branch to itself, which must not be traced
+#define NUM_INSNS 31
+#define NUM_BLOCKS 10
+#define RUNS 2
+
+#define WORDS 3
+#define BUFFER_ENTRIES 3
+
+static uint64_t buffer[BUFFER_ENTRIES * WORDS + 1];
+static uint64_t entries[RUNS * NUM_BLOCKS + 1][WORDS];
+static size_t num_entries, calls;
+
+static void trace(void *opaque, const uint64_t *e, size_t count)
+{
+    calls++;
+    if (e != buffer || count > BUFFER_ENTRIES) {
+        printf("%zu entries at %p\n", count, (void *)e);
+        return;
+    }
+    for (; count && num_entries < RUNS * NUM_BLOCKS + 1; count--, e += WORDS)
+        memcpy(entries[num_entries++], e, sizeof(entries[0]));
+}
+
+static int run(uc_engine *uc)
+{
+    int i;
+
+    for (i = 0; i < RUNS; i++) {
+        uc_err err = uc_emu_start(uc, CODE_ADDR, 0, 0, NUM_INSNS);
+        if (err) {
+            printf("Failed on uc_emu_start() with error returned: %u\n", err);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int check(void)
+{
+    uint64_t time = 0;
+    int failed = 0;
+    size_t i;
+
+    if (num_entries != RUNS * NUM_BLOCKS) {
+        printf("%zu entries, expected %d\n", num_entries, RUNS * NUM_BLOCKS);
+        return 1;
+    }
+    for (i = 0; i < num_entries; i++) {
+        size_t n = i % NUM_BLOCKS;
+        uint64_t pc = CODE_ADDR + (n ? 4 : 0);
+        uint64_t icount = i / NUM_BLOCKS * NUM_INSNS + (n ? 1 + 3 * n : 0);
+        if (entries[i][0] != pc || entries[i][1] != icount ||
+            entries[i][2] < time) {
+            printf("entry %zu: pc 0x%llx icount %llu, expected 0x%llx %llu\n",
+                   i, (unsigned long long)entries[i][0],
+                   (unsigned long long)entries[i][1],
+                   (unsigned long long)pc, (unsigned long long)icount);
+            failed = 1;
+        }
+        time = entries[i][2];
+    }
+    return failed;
+}
+
+static int get_uleb(FILE *f, uint64_t *v)
+{
+    int b, shift = 0;
+
+    *v = 0;
+    do {
+        b = fgetc(f);
+        if (b == EOF)
+            return 0;
+        *v |= (uint64_t)(b & 0x7f) << shift;
+        shift += 7;
+    } while (b & 0x80);
+    return 1;
+}
+
+static int read_file(void)
+{
+    uint64_t prev[WORDS] = { 0 }, v;
+    char magic[7];
+    FILE *f;
+    int i;
+
+    f = fopen(TRACE_FILE, "rb");
+    if (f == NULL) {
+        printf("can't open %s\n", TRACE_FILE);
+        return 1;
+    }
+    if (fread(magic, 1, sizeof(magic), f) != sizeof(magic) ||
+        memcmp(magic, "UCBBT1", sizeof(magic)) != 0 || !get_uleb(f, &v) ||
+        v != (UC_BB_TRACE_ICOUNT | UC_BB_TRACE_TIME)) {
+        printf("bad header\n");
+        fclose(f);
+        return 1;
+    }
+    num_entries = 0;
+    while (num_entries < RUNS * NUM_BLOCKS + 1 && get_uleb(f, &v)) {
+        prev[0] += (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+        for (i = 1; i < WORDS; i++) {
+            if (!get_uleb(f, &v))
+                break;
+            prev[i] += v;
+        }
+        memcpy(entries[num_entries++], prev, sizeof(prev));
+    }
+    fclose(f);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    uc_engine *uc;
+    uc_err err;
+    int failed = 0;
+
+    err = uc_open("Cortex-A53", NULL, NULL, &uc);
+    if (err) {
+        printf("Failed on uc_open() with error returned: %u\n", err);
+        return 1;
+    }
+
+    uc_mem_map(uc, CODE_ADDR, 0x1000, UC_PROT_ALL);
+    uc_mem_write(uc, CODE_ADDR, code, sizeof(code));
+
+    // the last word of the buffer can't hold an entry
+    err = uc_setup_basic_block_trace_buffer(uc, NULL, buffer,
+            sizeof(buffer) / sizeof(buffer[0]),
+            UC_BB_TRACE_ICOUNT | UC_BB_TRACE_TIME, trace);
+    if (err) {
+        printf("Failed on uc_setup_basic_block_trace_buffer() with error "
+               "returned: %u\n", err);
+        return 1;
+    }
+    if (run(uc))
+        return 1;
+    failed |= check();
+    // 3 full buffers and the rest at the end of each run
+    if (calls != RUNS * 4) {
+        printf("%zu calls, expected %d\n", calls, RUNS * 4);
+        failed = 1;
+    }
+
+    err = uc_basic_block_trace_file(uc, TRACE_FILE,
+                                    UC_BB_TRACE_ICOUNT | UC_BB_TRACE_TIME);
+    if (err) {
+        printf("Failed on uc_basic_block_trace_file() with error returned: "
+               "%u\n", err);
+        return 1;
+    }
+    if (run(uc))
+        return 1;
+    uc_basic_block_trace_file(uc, NULL, 0);
+    if (read_file())
+        return 1;
+    failed |= check();
+
+    uc_close(uc);
+
+    printf("%s\n", failed ? "FAILED" : "OK");
+    return failed;
+}
@@ -0,0 +1,140 @@
+/*
+Test for breakpoints. Callback breakpoints inserted or removed after the code
+was translated take effect, a thousand breakpoints elsewhere don't change
+which ones are hit, and a GDB breakpoint stops before its instruction.
+*/
+
+#include <unicorn/unicorn.h>
+#include <stdio.h>
+
+#define CODE_ADDR  0x10000
+#define OTHER_ADDR 0x20000
+#define NUM_OTHER  1000
+
+static const uint32_t code[] = {
+    0x91000400, // 10000: add  x0, x0, #1
+    0x91000400, // 10004: add  x0, x0, #1
+    0x91000400, // 10008: add  x0, x0, #1
+    0x91000400, // 1000c: add  x0, x0, #1
+    0x91000400, // 10010: add  x0, x0, #1
+    0x91000400, // 10014: add  x0, x0, #1
+    0x91000400, // 10018: add  x0, x0, #1
+    0x91000400, // 1001c: add  x0, x0, #1
+    0x14000000, // 10020: b    10020
+};
+
+#define NUM_INSNS 8
+
+static uint64_t hits[8];
+static size_t num_hits;
+
+static void hit(void *opaque, uint64_t addr)
+{
+    if (num_hits < 8)
+        hits[num_hits] = addr;
+    num_hits++;
+}
+
+static int run(uc_engine *uc, uint64_t *x0)
+{
+    uc_err err;
+
+    num_hits = 0;
+    *x0 = 0;
+    uc_reg_write(uc, UC_ARM64_REG_X0, x0);
+    err = uc_emu_start(uc, CODE_ADDR, 0, 0, NUM_INSNS);
+    if (err) {
+        printf("Failed on uc_emu_start() with error returned: %u\n", err);
+        return 1;
+    }
+    uc_reg_read(uc, UC_ARM64_REG_X0, x0);
+    return 0;
+}
+
+static int check(const char *name, uint64_t x0, size_t count,
+                 uint64_t first, uint64_t second)
+{
+    if (x0 != NUM_INSNS || num_hits != count ||
+        (count > 0 && hits[0] != first) || (count > 1 && hits[1] != second)) {
+        printf("%s: x0 %llu, %zu hits, first 0x%llx\n", name,
+               (unsigned long long)x0, num_hits,
+               (unsigned long long)hits[0]);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    uc_engine *uc;
+    uc_err err;
+    uint64_t x0, pc;
+    int failed = 0;
+    int i;
+
+    err = uc_open("Cortex-A53", NULL, NULL, &uc);
+    if (err) {
+        printf("Failed on uc_open() with error returned: %u\n", err);
+        return 1;
+    }
+
+    uc_mem_map(uc, CODE_ADDR, 0x1000, UC_PROT_ALL);
+    uc_mem_write(uc, CODE_ADDR, code, sizeof(code));
+    uc_cbbreakpoint_setup(uc, NULL, hit);
+
+    // translate the code before any breakpoint is inserted
+    if (run(uc, &x0))
+        return 1;
+    failed |= check("none", x0, 0, 0, 0);
+
+    uc_cbbreakpoint_insert(uc, CODE_ADDR + 0x8);
+    uc_cbbreakpoint_insert(uc, CODE_ADDR + 0x10);
+    if (run(uc, &x0))
+        return 1;
+    failed |= check("inserted", x0, 2, CODE_ADDR + 0x8, CODE_ADDR + 0x10);
+
+    // breakpoints elsewhere, some in the same hash buckets
+    for (i = 0; i < NUM_OTHER; i++)
+        uc_cbbreakpoint_insert(uc, OTHER_ADDR + i * 4);
+    if (run(uc, &x0))
+        return 1;
+    failed |= check("others", x0, 2, CODE_ADDR + 0x8, CODE_ADDR + 0x10);
+
+    uc_cbbreakpoint_remove(uc, CODE_ADDR + 0x8);
+    if (run(uc, &x0))
+        return 1;
+    failed |= check("removed", x0, 1, CODE_ADDR + 0x10, 0);
+
+    if (uc_cbbreakpoint_remove(uc, CODE_ADDR + 0x8) != UC_ERR_ARG) {
+        printf("removed twice\n");
+        failed = 1;
+    }
+    for (i = 0; i < NUM_OTHER; i++)
+        uc_cbbreakpoint_remove(uc, OTHER_ADDR + i * 4);
+    uc_cbbreakpoint_remove(uc, CODE_ADDR + 0x10);
+    if (run(uc, &x0))
+        return 1;
+    failed |= check("all removed", x0, 0, 0, 0);
+
+    // a GDB breakpoint stops before its instruction
+    uc_breakpoint_insert(uc, CODE_ADDR + 0xc);
+    x0 = 0;
+    uc_reg_write(uc, UC_ARM64_REG_X0, &x0);
+    uc_emu_start(uc, CODE_ADDR, 0, 0, NUM_INSNS);
+    uc_reg_read(uc, UC_ARM64_REG_X0, &x0);
+    uc_reg_read(uc, UC_ARM64_REG_PC, &pc);
+    if (x0 != 3 || pc != CODE_ADDR + 0xc) {
+        printf("gdb: x0 %llu, pc 0x%llx\n", (unsigned long long)x0,
+               (unsigned long long)pc);
+        failed = 1;
+    }
+    uc_breakpoint_remove(uc, CODE_ADDR + 0xc);
+    if (run(uc, &x0))
+        return 1;
+    failed |= check("gdb removed", x0, 0, 0, 0);
+
+    uc_close(uc);
+
+    printf("%s\n", failed ? "FAILED" : "OK");
+    return failed;
+}
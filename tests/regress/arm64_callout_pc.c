@@ -0,0 +1,107 @@
+/*
+Test for the PC seen by MMIO callbacks. Loads and stores don't store the PC
+before accessing memory, it is recovered when a callback reads it, also for
+accesses in the middle of a translation block.
+*/
+
+#include <unicorn/unicorn.h>
+#include <stdio.h>
+#include <string.h>
+
+#define CODE_ADDR 0x10000
+#define MMIO_ADDR 0x100000
+
+static const uint32_t code[] = {
+    0xf9400002, // 10000: ldr  x2, [x0]
+    0x91000421, // 10004: add  x1, x1, #1
+    0xf9000401, // 10008: str  x1, [x0, #8]
+    0x91000421, // 1000c: add  x1, x1, #1
+    0x91000421, // 10010: add  x1, x1, #1
+    0xa9410c02, // 10014: ldp  x2, x3, [x0, #16]
+    0x91000421, // 10018: add  x1, x1, #1
+    0x14000000, // 1001c: b    1001c
+};
+
+static const uint64_t expected[] = {
+    0x10000, 0x10008, 0x10014, 0x10014,
+};
+
+#define NUM_ACCESSES (sizeof(expected) / sizeof(expected[0]))
+
+static uint64_t pcs[NUM_ACCESSES * 2];
+static size_t accesses;
+
+static uc_tx_result_t mmio(uc_engine *uc, void *opaque, uc_mmio_tx_t *tx)
+{
+    uint64_t pc;
+
+    uc_reg_read(uc, UC_ARM64_REG_PC, &pc);
+    if (accesses < NUM_ACCESSES * 2)
+        pcs[accesses] = pc;
+    accesses++;
+    if (tx->is_read)
+        memset(tx->data, 0, tx->size);
+    return UC_TX_OK;
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t x0 = MMIO_ADDR, x1, pc;
+    uc_engine *uc;
+    uc_err err;
+    int failed = 0, i;
+    size_t j;
+
+    err = uc_open("Cortex-A53", NULL, NULL, &uc);
+    if (err) {
+        printf("Failed on uc_open() with error returned: %u\n", err);
+        return 1;
+    }
+
+    uc_mem_map(uc, CODE_ADDR, 0x1000, UC_PROT_ALL);
+    uc_mem_write(uc, CODE_ADDR, code, sizeof(code));
+    uc_mem_map_io(uc, MMIO_ADDR, 0x1000, mmio, NULL);
+
+    // the second run executes the cached block
+    for (i = 0; i < 2; i++) {
+        accesses = 0;
+        x1 = 0;
+        uc_reg_write(uc, UC_ARM64_REG_X0, &x0);
+        uc_reg_write(uc, UC_ARM64_REG_X1, &x1);
+        err = uc_emu_start(uc, CODE_ADDR, 0, 0,
+                           sizeof(code) / sizeof(code[0]) - 1);
+        if (err) {
+            printf("Failed on uc_emu_start() with error returned: %u\n", err);
+            return 1;
+        }
+
+        if (accesses != NUM_ACCESSES) {
+            printf("%zu accesses, expected %zu\n", accesses,
+                   (size_t)NUM_ACCESSES);
+            failed = 1;
+            continue;
+        }
+        for (j = 0; j < NUM_ACCESSES; j++) {
+            if (pcs[j] != expected[j]) {
+                printf("access %zu at pc 0x%llx, expected 0x%llx\n", j,
+                       (unsigned long long)pcs[j],
+                       (unsigned long long)expected[j]);
+                failed = 1;
+            }
+        }
+
+        // the instructions after the accesses are unaffected
+        uc_reg_read(uc, UC_ARM64_REG_X1, &x1);
+        uc_reg_read(uc, UC_ARM64_REG_PC, &pc);
+        if (x1 != 4 || pc != CODE_ADDR + 0x1c) {
+            printf("x1 = %llu, pc = 0x%llx\n", (unsigned long long)x1,
+                   (unsigned long long)pc);
+            failed = 1;
+        }
+    }
+
+    uc_close(uc);
+
+    printf("%s\n", failed ? "FAILED" : "OK");
+    return failed;
+}
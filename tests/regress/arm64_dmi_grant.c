@@ -0,0 +1,160 @@
+/*
+Test for DMI grants. Pages in granted ranges are filled without calling the
+DMI callback, the others fall back to it, and revoking or replacing part of
+a grant only affects the pages involved.
+*/
+
+#include <unicorn/unicorn.h>
+#include <stdio.h>
+#include <string.h>
+
+#define CODE_ADDR 0x10000
+#define DMI_ADDR  0x100000
+#define DMI_PAGES 16
+#define GRANTED   12
+
+static const uint32_t code[] = {
+    // 10000: sum up the first words of x1 pages from x0 in x7
+    0xf9400002, // ldr  x2, [x0]
+    0x8b0200e7, // add  x7, x7, x2
+    0x91400400, // add  x0, x0, #0x1000
+    0xf1000421, // subs x1, x1, #1
+    0x54ffff81, // b.ne 10000
+};
+
+static uint64_t mem[2][DMI_PAGES][0x1000 / 8];
+static size_t mmio_count;
+
+// only the pages after the granted ones
+static bool dmi(void *opaque, uint64_t page_addr, unsigned char **dmiptr,
+                int *prot)
+{
+    if (page_addr < DMI_ADDR + GRANTED * 0x1000 ||
+        page_addr >= DMI_ADDR + DMI_PAGES * 0x1000)
+        return false;
+
+    *dmiptr = (unsigned char *)mem[0][(page_addr - DMI_ADDR) >> 12];
+    *prot = UC_DMI_PROT_READ | UC_DMI_PROT_WRITE;
+    return true;
+}
+
+static uc_tx_result_t mmio(uc_engine *uc, void *opaque, uc_mmio_tx_t *tx)
+{
+    mmio_count++;
+    memset(tx->data, 0, 8);
+    return UC_TX_OK;
+}
+
+// sum up all pages, @expected is the sum and the others are the expected
+// numbers of fills from grants and callbacks, and of MMIO accesses
+static int run(uc_engine *uc, const char *name, uint64_t expected,
+               uint64_t grants, uint64_t callbacks, size_t mmios)
+{
+    uint64_t x0 = DMI_ADDR, x1 = DMI_PAGES, x7 = 0;
+    uc_tlb_stats_t before, after;
+    uc_err err;
+
+    mmio_count = 0;
+    uc_reg_write(uc, UC_ARM64_REG_X0, &x0);
+    uc_reg_write(uc, UC_ARM64_REG_X1, &x1);
+    uc_reg_write(uc, UC_ARM64_REG_X7, &x7);
+    uc_tlb_stats(uc, &before);
+    err = uc_emu_start(uc, CODE_ADDR, 0, 0, 5 * DMI_PAGES);
+    if (err) {
+        printf("Failed on uc_emu_start() with error returned: %u\n", err);
+        return 1;
+    }
+    uc_tlb_stats(uc, &after);
+    uc_reg_read(uc, UC_ARM64_REG_X7, &x7);
+
+    if (x7 != expected || after.dmi_grants - before.dmi_grants != grants ||
+        after.dmi_callbacks - before.dmi_callbacks != callbacks ||
+        mmio_count != mmios) {
+        printf("%s: sum %llu, expected %llu, %llu grants, %llu callbacks, "
+               "%zu mmio\n", name, (unsigned long long)x7,
+               (unsigned long long)expected,
+               (unsigned long long)(after.dmi_grants - before.dmi_grants),
+               (unsigned long long)(after.dmi_callbacks - before.dmi_callbacks),
+               mmio_count);
+        return 1;
+    }
+    return 0;
+}
+
+static uint64_t sum(int first, int last, int m)
+{
+    uint64_t s = 0;
+
+    for (; first < last; first++)
+        s += mem[m][first][0];
+    return s;
+}
+
+int main(int argc, char **argv)
+{
+    uc_engine *uc;
+    uc_err err;
+    uint64_t all;
+    int failed = 0, i;
+
+    for (i = 0; i < DMI_PAGES; i++) {
+        mem[0][i][0] = i + 1;
+        mem[1][i][0] = (i + 1) * 100;
+    }
+    all = sum(0, DMI_PAGES, 0);
+
+    err = uc_open("Cortex-A53", NULL, NULL, &uc);
+    if (err) {
+        printf("Failed on uc_open() with error returned: %u\n", err);
+        return 1;
+    }
+
+    uc_mem_map(uc, CODE_ADDR, 0x1000, UC_PROT_ALL);
+    uc_mem_write(uc, CODE_ADDR, code, sizeof(code));
+    uc_mem_map_io(uc, DMI_ADDR, DMI_PAGES * 0x1000, mmio, NULL);
+    uc_setup_dmi(uc, NULL, dmi, NULL);
+
+    if (uc_dmi_grant(uc, DMI_ADDR + 8, DMI_ADDR + 0x1000,
+                     (unsigned char *)mem[0], UC_DMI_PROT_READ) != UC_ERR_ARG ||
+        uc_dmi_grant(uc, DMI_ADDR, DMI_ADDR + 0x1000, NULL,
+                     UC_DMI_PROT_READ) != UC_ERR_ARG) {
+        printf("invalid grants accepted\n");
+        failed = 1;
+    }
+
+    // two grants, the callback serves the last pages
+    uc_dmi_grant(uc, DMI_ADDR, DMI_ADDR + 8 * 0x1000, (unsigned char *)mem[0],
+                 UC_DMI_PROT_READ | UC_DMI_PROT_WRITE);
+    uc_dmi_grant(uc, DMI_ADDR + 8 * 0x1000, DMI_ADDR + GRANTED * 0x1000,
+                 (unsigned char *)mem[0][8],
+                 UC_DMI_PROT_READ | UC_DMI_PROT_WRITE);
+    failed |= run(uc, "granted", all, GRANTED, DMI_PAGES - GRANTED, 0);
+    failed |= run(uc, "again", all, 0, 0, 0);
+
+    // revoke a page in the middle of a grant, it becomes I/O
+    uc_dmi_invalidate(uc, DMI_ADDR + 2 * 0x1000, DMI_ADDR + 3 * 0x1000);
+    failed |= run(uc, "revoked", all - mem[0][2][0], 0, 1, 1);
+    failed |= run(uc, "revoked again", all - mem[0][2][0], 0, 0, 1);
+
+    // grant it again from other memory
+    uc_dmi_grant(uc, DMI_ADDR + 2 * 0x1000, DMI_ADDR + 3 * 0x1000,
+                 (unsigned char *)mem[1][2], UC_DMI_PROT_READ);
+    failed |= run(uc, "regranted", all - mem[0][2][0] + mem[1][2][0], 1, 0, 0);
+
+    // replace pages across both grants
+    uc_dmi_grant(uc, DMI_ADDR + 6 * 0x1000, DMI_ADDR + 10 * 0x1000,
+                 (unsigned char *)mem[1][6], UC_DMI_PROT_READ);
+    failed |= run(uc, "replaced",
+                  sum(0, 2, 0) + mem[1][2][0] + sum(3, 6, 0) + sum(6, 10, 1) +
+                  sum(10, DMI_PAGES, 0), 4, 0, 0);
+
+    // revoke all grants, the granted pages become I/O
+    uc_dmi_invalidate(uc, 0, DMI_ADDR + DMI_PAGES * 0x1000);
+    failed |= run(uc, "all revoked", sum(GRANTED, DMI_PAGES, 0), 0,
+                  DMI_PAGES, GRANTED);
+
+    uc_close(uc);
+
+    printf("%s\n", failed ? "FAILED" : "OK");
+    return failed;
+}
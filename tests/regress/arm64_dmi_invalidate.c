@@ -0,0 +1,143 @@
+/*
+Test for the invalidation of DMI pointers by physical range. Only the TLB
+entries of the invalidated pages may be dropped, whether the ranges are
+small enough to be looked up page by page or not.
+*/
+
+#include <unicorn/unicorn.h>
+#include <stdio.h>
+#include <string.h>
+
+#define CODE_ADDR 0x10000
+#define DMI_ADDR  0x100000
+#define DMI_PAGES 8
+
+static const uint32_t code[] = {
+    // 10000: sum up the first words of x1 pages from x0 in x7
+    0xf9400002, // ldr  x2, [x0]
+    0x8b0200e7, // add  x7, x7, x2
+    0x91400400, // add  x0, x0, #0x1000
+    0xf1000421, // subs x1, x1, #1
+    0x54ffff81, // b.ne 10000
+};
+
+static uint64_t mem[2][DMI_PAGES][0x1000 / 8];
+static int current;
+static size_t mmio_count;
+
+static bool dmi(void *opaque, uint64_t page_addr, unsigned char **dmiptr,
+                int *prot)
+{
+    if (page_addr < DMI_ADDR || page_addr >= DMI_ADDR + DMI_PAGES * 0x1000)
+        return false;
+
+    *dmiptr = (unsigned char *)mem[current][(page_addr - DMI_ADDR) >> 12];
+    *prot = UC_PROT_READ | UC_PROT_WRITE;
+    return true;
+}
+
+static uc_tx_result_t mmio(uc_engine *uc, void *opaque, uc_mmio_tx_t *tx)
+{
+    mmio_count++;
+    memset(tx->data, 0, 8);
+    return UC_TX_OK;
+}
+
+// sum up all pages, @mask selects the ones expected to have been remapped,
+// @misses is the number of expected TLB misses
+static int run(uc_engine *uc, unsigned mask, uint64_t misses)
+{
+    uint64_t x0 = DMI_ADDR, x1 = DMI_PAGES, x7 = 0, expected = 0;
+    uc_tlb_stats_t before, after;
+    uc_err err;
+    int i;
+
+    for (i = 0; i < DMI_PAGES; i++)
+        expected += mem[(mask >> i) & 1][i][0];
+
+    uc_reg_write(uc, UC_ARM64_REG_X0, &x0);
+    uc_reg_write(uc, UC_ARM64_REG_X1, &x1);
+    uc_reg_write(uc, UC_ARM64_REG_X7, &x7);
+    uc_tlb_stats(uc, &before);
+    err = uc_emu_start(uc, CODE_ADDR, 0, 0, 5 * DMI_PAGES);
+    if (err) {
+        printf("Failed on uc_emu_start() with error returned: %u\n", err);
+        return 1;
+    }
+    uc_tlb_stats(uc, &after);
+
+    uc_reg_read(uc, UC_ARM64_REG_X7, &x7);
+    if (x7 != expected) {
+        printf("sum %llu, expected %llu\n", (unsigned long long)x7,
+               (unsigned long long)expected);
+        return 1;
+    }
+    if (misses != (uint64_t)-1 && after.misses - before.misses != misses) {
+        printf("%llu TLB misses, expected %llu\n",
+               (unsigned long long)(after.misses - before.misses),
+               (unsigned long long)misses);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    static const uc_dmi_range_t small[] = {
+        { DMI_ADDR + 0x3000, DMI_ADDR + 0x3008 },
+        { DMI_ADDR + 0x1ff8, DMI_ADDR + 0x2000 },
+        { DMI_ADDR + 0x5000, DMI_ADDR + 0x5000 }, // empty
+    };
+    static const uc_dmi_range_t large[] = {
+        { DMI_ADDR + 0x6000, DMI_ADDR + 0x100000000ULL },
+        { 0, DMI_ADDR + 0x1000 },
+        { DMI_ADDR + 0x7000, DMI_ADDR + 0x8000 },
+    };
+    uc_engine *uc;
+    uc_err err;
+    int failed = 0, i;
+
+    for (i = 0; i < DMI_PAGES; i++) {
+        mem[0][i][0] = i + 1;
+        mem[1][i][0] = (i + 1) * 100;
+    }
+
+    err = uc_open("Cortex-A53", NULL, NULL, &uc);
+    if (err) {
+        printf("Failed on uc_open() with error returned: %u\n", err);
+        return 1;
+    }
+
+    uc_mem_map(uc, CODE_ADDR, 0x1000, UC_PROT_ALL);
+    uc_mem_write(uc, CODE_ADDR, code, sizeof(code));
+    uc_mem_map_io(uc, DMI_ADDR, DMI_PAGES * 0x1000, mmio, NULL);
+    uc_setup_dmi(uc, NULL, dmi, NULL);
+
+    failed |= run(uc, 0x00, -1);
+    failed |= run(uc, 0x00, 0);
+
+    // the device remaps its memory, invalidate the pages one by one
+    current = 1;
+    if (uc_dmi_invalidate_ranges(uc, small, 3) != UC_ERR_OK)
+        failed = 1;
+    failed |= run(uc, 0x0a, 2);
+
+    // the first range exceeds the hash table, check every entry
+    if (uc_dmi_invalidate_ranges(uc, large, 3) != UC_ERR_OK)
+        failed = 1;
+    failed |= run(uc, 0xcb, 4);
+
+    if (uc_dmi_invalidate(uc, DMI_ADDR, DMI_ADDR + DMI_PAGES * 0x1000))
+        failed = 1;
+    failed |= run(uc, 0xff, DMI_PAGES);
+
+    if (mmio_count != 0) {
+        printf("%zu MMIO accesses bypassed DMI\n", mmio_count);
+        failed = 1;
+    }
+
+    uc_close(uc);
+
+    printf("%s\n", failed ? "FAILED" : "OK");
+    return failed;
+}
@@ -0,0 +1,141 @@
+/*
+Test for page table walks through DMI. The page tables live in an MMIO
+region: without DMI the walker reads them through the MMIO callback, with a
+DMI grant it reads the host memory directly and sees changes to it, and once
+the grant is revoked it goes back to the callback.
+*/
+
+#include <unicorn/unicorn.h>
+#include <stdio.h>
+#include <string.h>
+
+#define CODE_ADDR 0x10000
+#define DATA_ADDR 0x80000
+#define DATA_PAGES 16
+#define PT_ADDR   0x100000
+
+#define PTE_PAGE  0x703ULL // page, AF, inner shareable, attr 0, EL1 RW
+#define PTE_TABLE 0x3ULL
+
+static const uint32_t code[] = {
+    // 10000: sum up the first words of x1 pages from x0 in x7
+    0xf9400002, // ldr  x2, [x0]
+    0x8b0200e7, // add  x7, x7, x2
+    0x91400400, // add  x0, x0, #0x1000
+    0xf1000421, // subs x1, x1, #1
+    0x54ffff81, // b.ne 10000
+};
+
+// level 1, 2 and 3 tables
+static uint64_t pt[3][512];
+static size_t mmio_count;
+
+static uc_tx_result_t mmio(uc_engine *uc, void *opaque, uc_mmio_tx_t *tx)
+{
+    uint64_t offset = tx->addr & 0xffff;
+
+    mmio_count++;
+    if (!tx->is_read || tx->size != 8)
+        return UC_TX_ERROR;
+    *(uint64_t *)tx->data = pt[offset >> 12][(offset & 0xfff) >> 3];
+    return UC_TX_OK;
+}
+
+// sum up all data pages after a TLB flush, @walk_host and @walk_io are the
+// expected numbers of page table accesses
+static int run(uc_engine *uc, const char *name, uint64_t expected,
+               uint64_t walk_host, uint64_t walk_io)
+{
+    uint64_t x0 = DATA_ADDR, x1 = DATA_PAGES, x7 = 0;
+    uc_tlb_stats_t before, after;
+    uc_err err;
+
+    mmio_count = 0;
+    uc_tlb_flush(uc);
+    uc_reg_write(uc, UC_ARM64_REG_X0, &x0);
+    uc_reg_write(uc, UC_ARM64_REG_X1, &x1);
+    uc_reg_write(uc, UC_ARM64_REG_X7, &x7);
+    uc_tlb_stats(uc, &before);
+    err = uc_emu_start(uc, CODE_ADDR, 0, 0, 5 * DATA_PAGES);
+    if (err) {
+        printf("Failed on uc_emu_start() with error returned: %u\n", err);
+        return 1;
+    }
+    uc_tlb_stats(uc, &after);
+    uc_reg_read(uc, UC_ARM64_REG_X7, &x7);
+
+    if (x7 != expected || after.walk_host - before.walk_host != walk_host ||
+        after.walk_io - before.walk_io != walk_io || mmio_count != walk_io) {
+        printf("%s: sum %llu, expected %llu, %llu host and %llu I/O walk "
+               "accesses, %zu mmio\n", name, (unsigned long long)x7,
+               (unsigned long long)expected,
+               (unsigned long long)(after.walk_host - before.walk_host),
+               (unsigned long long)(after.walk_io - before.walk_io),
+               mmio_count);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t scr = 0x401, hcr = 1ULL << 31, mair = 0xff;
+    uint64_t tcr = (1 << 23) | (3 << 12) | (1 << 10) | (1 << 8) | 25;
+    uint64_t ttbr0 = PT_ADDR, sctlr = 1, pstate = 0x3c5; // EL1h
+    uint64_t value, sum = 0, accesses;
+    uc_engine *uc;
+    uc_err err;
+    int failed = 0, i;
+
+    err = uc_open("Cortex-A53", NULL, NULL, &uc);
+    if (err) {
+        printf("Failed on uc_open() with error returned: %u\n", err);
+        return 1;
+    }
+
+    // identity mapped code and data pages, the last data page is also
+    // mapped to the page after the data
+    uc_mem_map(uc, 0, PT_ADDR, UC_PROT_ALL);
+    uc_mem_write(uc, CODE_ADDR, code, sizeof(code));
+    for (i = 0; i <= DATA_PAGES; i++) {
+        value = i + 1;
+        uc_mem_write(uc, DATA_ADDR + i * 0x1000, &value, 8);
+        if (i < DATA_PAGES)
+            sum += value;
+    }
+    uc_mem_map_io(uc, PT_ADDR, sizeof(pt), mmio, NULL);
+    pt[0][0] = (PT_ADDR + 0x1000) | PTE_TABLE;
+    pt[1][0] = (PT_ADDR + 0x2000) | PTE_TABLE;
+    pt[2][CODE_ADDR >> 12] = CODE_ADDR | PTE_PAGE;
+    for (i = 0; i < DATA_PAGES; i++)
+        pt[2][(DATA_ADDR >> 12) + i] = (DATA_ADDR + i * 0x1000) | PTE_PAGE;
+
+    uc_reg_write(uc, UC_ARM64_REG_SCR_EL3, &scr);
+    uc_reg_write(uc, UC_ARM64_REG_HCR_EL2, &hcr);
+    uc_reg_write(uc, UC_ARM64_REG_MAIR_EL1, &mair);
+    uc_reg_write(uc, UC_ARM64_REG_TCR_EL1, &tcr);
+    uc_reg_write(uc, UC_ARM64_REG_TTBR0_EL1, &ttbr0);
+    uc_reg_write(uc, UC_ARM64_REG_SCTLR_EL1, &sctlr);
+    uc_reg_write(uc, UC_ARM64_REG_PSTATE, &pstate);
+
+    // three descriptors for the code page, then the last level table is
+    // cached and the data pages only need one
+    accesses = 3 + DATA_PAGES;
+    failed |= run(uc, "mmio", sum, 0, accesses);
+
+    uc_dmi_grant(uc, PT_ADDR, PT_ADDR + sizeof(pt), (unsigned char *)pt,
+                 UC_DMI_PROT_READ);
+    failed |= run(uc, "granted", sum, accesses, 0);
+
+    // changed descriptors are seen without any invalidation of the grant
+    pt[2][(DATA_ADDR >> 12) + DATA_PAGES - 1] += 0x1000;
+    failed |= run(uc, "changed", sum + 1, accesses, 0);
+
+    uc_dmi_invalidate(uc, PT_ADDR, PT_ADDR + sizeof(pt));
+    failed |= run(uc, "revoked", sum + 1, 0, accesses);
+
+    uc_close(uc);
+
+    printf("%s\n", failed ? "FAILED" : "OK");
+    return failed;
+}
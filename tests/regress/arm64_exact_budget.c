@@ -0,0 +1,98 @@
+/*
+Test for the exact instruction budget mode ("exactbudget" config).
+uc_emu_start() must stop on exactly the requested instruction, and MMIO
+callbacks must see the number of instructions retired so far.
+*/
+
+#include <unicorn/unicorn.h>
+#include <stdio.h>
+#include <string.h>
+
+#define CODE_ADDR 0x10000
+#define MMIO_ADDR 0x100000
+
+static const uint32_t test_code[] = {
+    0x91000400, // 10000: add  x0, x0, #1
+    0x91000821, // 10004: add  x1, x1, #2
+    0xf9400042, // 10008: ldr  x2, [x2]
+    0xf10fa01f, // 1000c: cmp  x0, #1000
+    0x54ffff81, // 10010: b.ne 10000
+};
+
+#define LOOP_LEN (sizeof(test_code) / sizeof(test_code[0]))
+#define LDR_IDX  2
+
+static size_t mmio_count;
+static size_t mmio_errors;
+
+static const char* config(void *opaque, const char *name)
+{
+    return strcmp(name, "exactbudget") == 0 ? "1" : NULL;
+}
+
+static uc_tx_result_t mmio(uc_engine *uc, void *opaque, uc_mmio_tx_t *tx)
+{
+    size_t *total = opaque;
+
+    // the load is the third instruction of the loop and has not retired yet
+    if ((*total + uc_instruction_count(uc)) % LOOP_LEN != LDR_IDX)
+        mmio_errors++;
+
+    mmio_count++;
+    *(uint64_t *)tx->data = MMIO_ADDR;
+    return UC_TX_OK;
+}
+
+int main(int argc, char **argv)
+{
+    static const size_t budgets[] = { 1, 3, 5, 7, 2, 100, 13, 4, 6, 512, 9 };
+    uc_engine *uc;
+    uc_err err;
+    uint64_t pc = CODE_ADDR, x2 = MMIO_ADDR;
+    size_t total = 0, i;
+    int failed = 0;
+
+    err = uc_open("Cortex-A53", NULL, config, &uc);
+    if (err) {
+        printf("Failed on uc_open() with error returned: %u\n", err);
+        return 1;
+    }
+
+    uc_mem_map(uc, CODE_ADDR, 0x1000, UC_PROT_ALL);
+    uc_mem_map_io(uc, MMIO_ADDR, 0x1000, mmio, &total);
+    uc_mem_write(uc, CODE_ADDR, test_code, sizeof(test_code));
+    uc_reg_write(uc, UC_ARM64_REG_X2, &x2);
+
+    for (i = 0; i < sizeof(budgets) / sizeof(budgets[0]); i++) {
+        err = uc_emu_start(uc, pc, 0, 0, budgets[i]);
+        if (err) {
+            printf("Failed on uc_emu_start() with error returned: %u\n", err);
+            return 1;
+        }
+
+        uc_reg_read(uc, UC_ARM64_REG_PC, &pc);
+        if (uc_instruction_count(uc) != budgets[i]) {
+            printf("budget %zu: executed %zu instructions\n", budgets[i],
+                   uc_instruction_count(uc));
+            failed = 1;
+        }
+
+        total += uc_instruction_count(uc);
+        if (pc != CODE_ADDR + 4 * (total % LOOP_LEN)) {
+            printf("budget %zu: stopped at 0x%llx\n", budgets[i],
+                   (unsigned long long)pc);
+            failed = 1;
+        }
+    }
+
+    if (mmio_count == 0 || mmio_errors != 0) {
+        printf("%zu of %zu MMIO callbacks saw a wrong instruction count\n",
+               mmio_errors, mmio_count);
+        failed = 1;
+    }
+
+    uc_close(uc);
+
+    printf("%s\n", failed ? "FAILED" : "OK");
+    return failed;
+}
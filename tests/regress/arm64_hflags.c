@@ -0,0 +1,124 @@
+/*
+Test for the cached TB flags. The data endianness of an exception level is
+one of them: it must follow writes of SCTLR_EL1 by the guest and through
+uc_reg_write(), and the exception level changes of ERET and SVC.
+*/
+
+#include <unicorn/unicorn.h>
+#include <stdio.h>
+#include <string.h>
+
+#define CODE_ADDR 0x10000
+#define EL0_ADDR  0x10100
+#define VBAR_ADDR 0x10800
+#define DATA_ADDR 0x20000
+
+#define SCTLR_E0E (1ULL << 24)
+#define SCTLR_EE  (1ULL << 25)
+
+#define VALUE   0x0102030405060708ULL
+#define SWAPPED 0x0807060504030201ULL
+
+static const uint32_t code[] = {
+    // 10000: set SCTLR_EL1 to x1, then load from x0 to x2
+    0xd5181001, // msr  sctlr_el1, x1
+    0xd5033fdf, // isb
+    0xf9400002, // ldr  x2, [x0]
+    0xd503201f, // nop
+    // 10010: set SCTLR_EL1 to x1 and return to EL0 at x4
+    0xd5181001, // msr  sctlr_el1, x1
+    0xd518c005, // msr  vbar_el1, x5
+    0xd5184024, // msr  elr_el1, x4
+    0xd518401f, // msr  spsr_el1, xzr
+    0xd69f03e0, // eret
+};
+
+static const uint32_t el0_code[] = {
+    // 10100: load from x0 to x2, then call EL1
+    0xf9400002, // ldr  x2, [x0]
+    0xd4000001, // svc  #0
+};
+
+static const uint32_t el1_sync[] = {
+    // 10c00: synchronous exception from EL0, load from x0 to x3
+    0xf9400003, // ldr  x3, [x0]
+    0xd503201f, // nop
+};
+
+static int exec(uc_engine *uc, uint64_t begin, size_t count)
+{
+    uc_err err = uc_emu_start(uc, begin, 0, 0, count);
+
+    if (err) {
+        printf("Failed on uc_emu_start() with error returned: %u\n", err);
+        return 1;
+    }
+    return 0;
+}
+
+static int check(uc_engine *uc, const char *name, int reg, uint64_t expected)
+{
+    uint64_t value;
+
+    uc_reg_read(uc, reg, &value);
+    if (value != expected) {
+        printf("%s: loaded 0x%llx, expected 0x%llx\n", name,
+               (unsigned long long)value, (unsigned long long)expected);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t scr = 0x401, hcr = 1ULL << 31, pstate = 0x3c5; // EL1h
+    uint64_t value = VALUE, x0 = DATA_ADDR, x1, x4 = EL0_ADDR;
+    uint64_t x5 = VBAR_ADDR, sctlr;
+    uc_engine *uc;
+    uc_err err;
+    int failed = 0;
+
+    err = uc_open("Cortex-A53", NULL, NULL, &uc);
+    if (err) {
+        printf("Failed on uc_open() with error returned: %u\n", err);
+        return 1;
+    }
+
+    uc_mem_map(uc, 0, 0x100000, UC_PROT_ALL);
+    uc_mem_write(uc, CODE_ADDR, code, sizeof(code));
+    uc_mem_write(uc, EL0_ADDR, el0_code, sizeof(el0_code));
+    uc_mem_write(uc, VBAR_ADDR + 0x400, el1_sync, sizeof(el1_sync));
+    uc_mem_write(uc, DATA_ADDR, &value, sizeof(value));
+
+    uc_reg_write(uc, UC_ARM64_REG_SCR_EL3, &scr);
+    uc_reg_write(uc, UC_ARM64_REG_HCR_EL2, &hcr);
+    uc_reg_write(uc, UC_ARM64_REG_PSTATE, &pstate);
+    uc_reg_write(uc, UC_ARM64_REG_X0, &x0);
+    uc_reg_write(uc, UC_ARM64_REG_X4, &x4);
+    uc_reg_write(uc, UC_ARM64_REG_X5, &x5);
+
+    // big endian EL1 after the write of SCTLR_EL1
+    x1 = SCTLR_EE;
+    uc_reg_write(uc, UC_ARM64_REG_X1, &x1);
+    failed |= exec(uc, CODE_ADDR, 3);
+    failed |= check(uc, "sysreg", UC_ARM64_REG_X2, SWAPPED);
+
+    // big endian EL0 only, the exception return and the exception both
+    // switch the endianness
+    x1 = SCTLR_E0E;
+    uc_reg_write(uc, UC_ARM64_REG_X1, &x1);
+    failed |= exec(uc, CODE_ADDR + 0x10, 8);
+    failed |= check(uc, "eret", UC_ARM64_REG_X2, SWAPPED);
+    failed |= check(uc, "svc", UC_ARM64_REG_X3, VALUE);
+
+    // back at EL1, big endian again after the write through the API
+    sctlr = SCTLR_EE;
+    uc_reg_write(uc, UC_ARM64_REG_SCTLR_EL1, &sctlr);
+    failed |= exec(uc, CODE_ADDR + 0x8, 1);
+    failed |= check(uc, "uc_reg_write", UC_ARM64_REG_X2, SWAPPED);
+
+    uc_close(uc);
+
+    printf("%s\n", failed ? "FAILED" : "OK");
+    return failed;
+}
@@ -0,0 +1,261 @@
+/*
+Test for code, block and memory hooks. Hooks only fire inside their address
+range, block hooks see the size of the block, uc_emu_stop() in a code hook
+stops before the hooked instruction, code hooks are not called past the
+instruction count, accesses crossing into a hooked page are seen once, and
+hooks added or deleted after the code was translated, or during a run,
+take effect without flushing what is outside their range.
+*/
+
+#include <unicorn/unicorn.h>
+#include <stdio.h>
+#include <string.h>
+
+#define CODE_ADDR  0x10000
+#define DATA_ADDR  0x200000
+#define OTHER_ADDR 0x201000
+
+static const uint32_t code[] = {
+    0x91000400, // 10000: add  x0, x0, #1
+    0x91000821, // 10004: add  x1, x1, #2
+    0xf9400062, // 10008: ldr  x2, [x3]
+    0xf9000462, // 1000c: str  x2, [x3, #8]
+    0xf94000a4, // 10010: ldr  x4, [x5]
+    0x14000001, // 10014: b    10018
+    0x91000400, // 10018: add  x0, x0, #1
+    0x14000000, // 1001c: b    1001c
+};
+
+#define NUM_INSNS 7
+
+static uint64_t addrs[16];
+static uint32_t sizes[16];
+static int64_t values[16];
+static int types[16];
+static size_t calls;
+static uint64_t stop_at;
+
+static void hook_code(uc_engine *uc, uint64_t address, uint32_t size,
+                      void *user_data)
+{
+    if (calls < 16) {
+        addrs[calls] = address;
+        sizes[calls] = size;
+    }
+    calls++;
+    if (address == stop_at)
+        uc_emu_stop(uc);
+}
+
+static void hook_mem(uc_engine *uc, uc_mem_type type, uint64_t address,
+                     int size, int64_t value, void *user_data)
+{
+    if (calls < 16) {
+        types[calls] = type;
+        addrs[calls] = address;
+        sizes[calls] = size;
+        values[calls] = value;
+    }
+    calls++;
+}
+
+static uc_hook once;
+
+static void hook_once(uc_engine *uc, uint64_t address, uint32_t size,
+                      void *user_data)
+{
+    calls++;
+    uc_hook_del(uc, once);
+}
+
+static uint64_t x3 = DATA_ADDR, x5 = OTHER_ADDR;
+
+static int run(uc_engine *uc)
+{
+    uint64_t x0 = 0;
+    uc_err err;
+
+    calls = 0;
+    uc_reg_write(uc, UC_ARM64_REG_X0, &x0);
+    uc_reg_write(uc, UC_ARM64_REG_X3, &x3);
+    uc_reg_write(uc, UC_ARM64_REG_X5, &x5);
+    err = uc_emu_start(uc, CODE_ADDR, 0, 0, NUM_INSNS);
+    if (err) {
+        printf("Failed on uc_emu_start() with error returned: %u\n", err);
+        return 1;
+    }
+    return 0;
+}
+
+static int check_code(const char *name, size_t count, uint64_t first)
+{
+    size_t i;
+
+    if (calls != count) {
+        printf("%s: %zu calls, expected %zu\n", name, calls, count);
+        return 1;
+    }
+    for (i = 0; i < count; i++) {
+        if (addrs[i] != first + i * 4 || sizes[i] != 4) {
+            printf("%s: call %zu at 0x%llx size %u\n", name, i,
+                   (unsigned long long)addrs[i], sizes[i]);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    static const uint64_t data = 0x1122334455667788;
+    uc_engine *uc;
+    uc_hook hh;
+    uc_err err;
+    uint64_t pc, x0, stored;
+    uc_tlb_stats_t before, after;
+    int failed = 0;
+
+    err = uc_open("Cortex-A53", NULL, NULL, &uc);
+    if (err) {
+        printf("Failed on uc_open() with error returned: %u\n", err);
+        return 1;
+    }
+
+    uc_mem_map(uc, CODE_ADDR, 0x1000, UC_PROT_ALL);
+    uc_mem_write(uc, CODE_ADDR, code, sizeof(code));
+    uc_mem_map(uc, DATA_ADDR, 0x2000, UC_PROT_ALL);
+    uc_mem_write(uc, DATA_ADDR, &data, sizeof(data));
+
+    // translate the code before any hook is added
+    if (run(uc))
+        return 1;
+
+    // code hook on three instructions
+    uc_hook_add(uc, &hh, UC_HOOK_CODE, hook_code, NULL,
+                CODE_ADDR + 4, CODE_ADDR + 0xc);
+    if (run(uc))
+        return 1;
+    failed |= check_code("code", 3, CODE_ADDR + 4);
+
+    // stop before the store, with the preceding instructions retired
+    stop_at = CODE_ADDR + 0xc;
+    stored = 0;
+    uc_mem_write(uc, DATA_ADDR + 8, &stored, sizeof(stored));
+    if (run(uc))
+        return 1;
+    uc_reg_read(uc, UC_ARM64_REG_PC, &pc);
+    uc_reg_read(uc, UC_ARM64_REG_X0, &x0);
+    uc_mem_read(uc, DATA_ADDR + 8, &stored, sizeof(stored));
+    if (pc != stop_at || x0 != 1 || stored != 0 ||
+        uc_instruction_count(uc) != 3) {
+        printf("stopped at 0x%llx, x0 %llu, stored 0x%llx, %zu insns\n",
+               (unsigned long long)pc, (unsigned long long)x0,
+               (unsigned long long)stored, uc_instruction_count(uc));
+        failed = 1;
+    }
+    stop_at = 0;
+    uc_hook_del(uc, hh);
+
+    // deleted hooks are no longer called
+    if (run(uc))
+        return 1;
+    failed |= check_code("deleted", 0, 0);
+
+    // code hooks are not called past the instruction count
+    uc_hook_add(uc, &hh, UC_HOOK_CODE, hook_code, NULL, 1, 0);
+    calls = 0;
+    err = uc_emu_start(uc, CODE_ADDR, 0, 0, 4);
+    if (err) {
+        printf("Failed on uc_emu_start() with error returned: %u\n", err);
+        return 1;
+    }
+    failed |= check_code("count", 4, CODE_ADDR);
+    uc_reg_read(uc, UC_ARM64_REG_PC, &pc);
+    if (pc != CODE_ADDR + 0x10 || uc_instruction_count(uc) != 4) {
+        printf("count: stopped at 0x%llx, %zu insns\n",
+               (unsigned long long)pc, uc_instruction_count(uc));
+        failed = 1;
+    }
+    uc_hook_del(uc, hh);
+
+    // a hook deleted by itself during the run is called once
+    uc_hook_add(uc, &once, UC_HOOK_CODE, hook_once, NULL, 1, 0);
+    if (run(uc))
+        return 1;
+    if (calls != 1) {
+        printf("once: %zu calls\n", calls);
+        failed = 1;
+    }
+
+    // block hooks see the start and size of each block
+    uc_hook_add(uc, &hh, UC_HOOK_BLOCK, hook_code, NULL, 1, 0);
+    if (run(uc))
+        return 1;
+    if (calls != 2 || addrs[0] != CODE_ADDR || sizes[0] != 0x18 ||
+        addrs[1] != CODE_ADDR + 0x18 || sizes[1] != 8) {
+        printf("block: %zu calls, 0x%llx/%u 0x%llx/%u\n", calls,
+               (unsigned long long)addrs[0], sizes[0],
+               (unsigned long long)addrs[1], sizes[1]);
+        failed = 1;
+    }
+    uc_hook_del(uc, hh);
+
+    // memory hooks on one page, the load from the other page is not seen;
+    // only the pages of the hook leave the TLB
+    uc_tlb_stats(uc, &before);
+    uc_hook_add(uc, &hh, UC_HOOK_MEM_READ | UC_HOOK_MEM_WRITE |
+                UC_HOOK_MEM_READ_AFTER, hook_mem, NULL,
+                DATA_ADDR, DATA_ADDR + 0xfff);
+    uc_tlb_stats(uc, &after);
+    if (after.flushes != before.flushes ||
+        after.page_flushes == before.page_flushes) {
+        printf("mem: %llu flushes, %llu page flushes on adding a hook\n",
+               (unsigned long long)(after.flushes - before.flushes),
+               (unsigned long long)(after.page_flushes - before.page_flushes));
+        failed = 1;
+    }
+    if (run(uc))
+        return 1;
+    if (calls != 3 ||
+        types[0] != UC_MEM_READ || addrs[0] != DATA_ADDR || sizes[0] != 8 ||
+        types[1] != UC_MEM_READ_AFTER || values[1] != (int64_t)data ||
+        types[2] != UC_MEM_WRITE || addrs[2] != DATA_ADDR + 8 ||
+        values[2] != (int64_t)data) {
+        printf("mem: %zu calls, types %d %d %d\n", calls, types[0], types[1],
+               types[2]);
+        failed = 1;
+    }
+    uc_hook_del(uc, hh);
+
+    if (run(uc))
+        return 1;
+    if (calls != 0) {
+        printf("mem: %zu calls after delete\n", calls);
+        failed = 1;
+    }
+
+    // accesses that cross into the hooked page are seen once
+    uc_hook_add(uc, &hh, UC_HOOK_MEM_READ | UC_HOOK_MEM_WRITE |
+                UC_HOOK_MEM_READ_AFTER, hook_mem, NULL,
+                OTHER_ADDR, OTHER_ADDR + 0xfff);
+    x3 = OTHER_ADDR - 12;
+    x5 = OTHER_ADDR - 4;
+    if (run(uc))
+        return 1;
+    if (calls != 3 ||
+        types[0] != UC_MEM_WRITE || addrs[0] != OTHER_ADDR - 4 ||
+        sizes[0] != 8 ||
+        types[1] != UC_MEM_READ || addrs[1] != OTHER_ADDR - 4 ||
+        sizes[1] != 8 ||
+        types[2] != UC_MEM_READ_AFTER || addrs[2] != OTHER_ADDR - 4) {
+        printf("split: %zu calls, types %d %d %d\n", calls, types[0],
+               types[1], types[2]);
+        failed = 1;
+    }
+    uc_hook_del(uc, hh);
+
+    uc_close(uc);
+
+    printf("%s\n", failed ? "FAILED" : "OK");
+    return failed;
+}
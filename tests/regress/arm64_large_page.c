@@ -0,0 +1,179 @@
+/*
+Test for TLB invalidations within large pages. Guest blocks of 2 MiB are held
+in the TLB by their 4 KiB pages; invalidating a page of a block drops all its
+pages, but keeps the pages of the other blocks. Once more blocks are in use
+than the TLB tracks one by one, invalidating a page of the others flushes the
+TLB.
+*/
+
+#include <unicorn/unicorn.h>
+#include <stdio.h>
+#include <string.h>
+
+#define CODE_ADDR 0x10000
+#define PT_ADDR   0x100000
+#define BLOCK     0x200000ULL
+#define BLOCKS    24
+#define RAM_SIZE  (3 * BLOCK)
+
+#define PTE_BLOCK 0x701ULL // block, AF, inner shareable, attr 0, EL1 RW
+#define PTE_TABLE 0x3ULL
+
+static const uint32_t code[] = {
+    // 10000: sum up the first words of x1 pages from x0, x3 apart, in x7
+    0xf9400002, // ldr  x2, [x0]
+    0x8b0200e7, // add  x7, x7, x2
+    0x8b030000, // add  x0, x0, x3
+    0xf1000421, // subs x1, x1, #1
+    0x54ffff81, // b.ne 10000
+    0xd503201f, // nop
+    0xd503201f, // nop
+    0xd503201f, // nop
+    // 10020: invalidate the VA in x9
+    0xd5088729, // tlbi vae1, x9
+    0xd5033f9f, // dsb  sy
+    0xd5033fdf, // isb
+};
+
+// block 0 is identity mapped, the others map the data blocks
+static void map_block(uc_engine *uc, int block, uint64_t pa)
+{
+    uint64_t desc = pa | PTE_BLOCK;
+
+    uc_mem_write(uc, PT_ADDR + 0x1000 + block * 8, &desc, sizeof(desc));
+}
+
+static int exec(uc_engine *uc, uint64_t addr, size_t count)
+{
+    uc_err err = uc_emu_start(uc, addr, 0, 0, count);
+
+    if (err) {
+        printf("Failed on uc_emu_start() with error returned: %u\n", err);
+        return 1;
+    }
+    return 0;
+}
+
+// sum up @pages pages @stride apart from @addr, expecting @sum and @walks
+// page table walks
+static int run(uc_engine *uc, const char *name, uint64_t addr, uint64_t stride,
+               uint64_t pages, uint64_t sum, uint64_t walks)
+{
+    uint64_t x7 = 0;
+    uc_tlb_stats_t before, after;
+
+    uc_reg_write(uc, UC_ARM64_REG_X0, &addr);
+    uc_reg_write(uc, UC_ARM64_REG_X1, &pages);
+    uc_reg_write(uc, UC_ARM64_REG_X3, &stride);
+    uc_reg_write(uc, UC_ARM64_REG_X7, &x7);
+    uc_tlb_stats(uc, &before);
+    if (exec(uc, CODE_ADDR, 5 * pages))
+        return 1;
+    uc_tlb_stats(uc, &after);
+    uc_reg_read(uc, UC_ARM64_REG_X7, &x7);
+
+    if (x7 != sum ||
+        (after.misses - after.victim_hits) -
+        (before.misses - before.victim_hits) != walks) {
+        printf("%s: sum %llu, expected %llu, %llu walks\n", name,
+               (unsigned long long)x7, (unsigned long long)sum,
+               (unsigned long long)((after.misses - after.victim_hits) -
+                                    (before.misses - before.victim_hits)));
+        return 1;
+    }
+    return 0;
+}
+
+// invalidate @va, expecting @large_pages dropped large pages and @forced
+// flushes of the TLB
+static int tlbi(uc_engine *uc, const char *name, uint64_t va,
+                uint64_t large_pages, uint64_t forced)
+{
+    uint64_t x9 = va >> 12;
+    uc_tlb_stats_t before, after;
+
+    uc_reg_write(uc, UC_ARM64_REG_X9, &x9);
+    uc_tlb_stats(uc, &before);
+    if (exec(uc, CODE_ADDR + 0x20, 3))
+        return 1;
+    uc_tlb_stats(uc, &after);
+
+    if (after.large_page_flushes - before.large_page_flushes != large_pages ||
+        after.forced_flushes - before.forced_flushes != forced ||
+        after.flushes - before.flushes != forced) {
+        printf("%s: %llu large pages, %llu forced, %llu flushes\n", name,
+               (unsigned long long)(after.large_page_flushes -
+                                    before.large_page_flushes),
+               (unsigned long long)(after.forced_flushes -
+                                    before.forced_flushes),
+               (unsigned long long)(after.flushes - before.flushes));
+        return 1;
+    }
+    return 0;
+}
+
+static uint64_t sum(int set, int pages)
+{
+    return set * 1000 * pages + pages * (pages + 1) / 2;
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t scr = 0x401, hcr = 1ULL << 31, mair = 0xff;
+    uint64_t tcr = (1 << 23) | (3 << 12) | (1 << 10) | (1 << 8) | 25;
+    uint64_t ttbr0 = PT_ADDR, sctlr = 1, pstate = 0x3c5; // EL1h
+    uint64_t value, desc = (PT_ADDR + 0x1000) | PTE_TABLE;
+    uc_engine *uc;
+    uc_err err;
+    int failed = 0, set, i;
+
+    err = uc_open("Cortex-A53", NULL, NULL, &uc);
+    if (err) {
+        printf("Failed on uc_open() with error returned: %u\n", err);
+        return 1;
+    }
+
+    // two data blocks, the first words of their pages count up
+    uc_mem_map(uc, 0, RAM_SIZE, UC_PROT_ALL);
+    uc_mem_write(uc, CODE_ADDR, code, sizeof(code));
+    for (set = 0; set < 2; set++) {
+        for (i = 0; i < 16; i++) {
+            value = set * 1000 + i + 1;
+            uc_mem_write(uc, (set + 1) * BLOCK + i * 0x1000, &value, 8);
+        }
+    }
+    uc_mem_write(uc, PT_ADDR, &desc, sizeof(desc));
+    map_block(uc, 0, 0);
+    for (i = 1; i < BLOCKS; i++)
+        map_block(uc, i, BLOCK);
+
+    uc_reg_write(uc, UC_ARM64_REG_SCR_EL3, &scr);
+    uc_reg_write(uc, UC_ARM64_REG_HCR_EL2, &hcr);
+    uc_reg_write(uc, UC_ARM64_REG_MAIR_EL1, &mair);
+    uc_reg_write(uc, UC_ARM64_REG_TCR_EL1, &tcr);
+    uc_reg_write(uc, UC_ARM64_REG_TTBR0_EL1, &ttbr0);
+    uc_reg_write(uc, UC_ARM64_REG_SCTLR_EL1, &sctlr);
+    uc_reg_write(uc, UC_ARM64_REG_PSTATE, &pstate);
+
+    failed |= run(uc, "block 1", BLOCK, 0x1000, 16, sum(0, 16), 17);
+    failed |= run(uc, "block 2", 2 * BLOCK, 0x1000, 16, sum(0, 16), 16);
+    failed |= run(uc, "block 1 again", BLOCK, 0x1000, 16, sum(0, 16), 0);
+
+    // remap block 2, invalidating one of its pages drops all of them, but
+    // neither the code nor block 1
+    map_block(uc, 2, 2 * BLOCK);
+    failed |= tlbi(uc, "page", 2 * BLOCK + 5 * 0x1000, 1, 0);
+    failed |= run(uc, "other block", BLOCK, 0x1000, 16, sum(0, 16), 0);
+    failed |= run(uc, "remapped", 2 * BLOCK, 0x1000, 16, sum(1, 16), 16);
+
+    // the blocks beyond those tracked share a region
+    failed |= run(uc, "all blocks", 3 * BLOCK, BLOCK, BLOCKS - 3, BLOCKS - 3,
+                  BLOCKS - 3);
+    failed |= tlbi(uc, "tracked", 3 * BLOCK, 1, 0);
+    failed |= tlbi(uc, "untracked", (BLOCKS - 1) * BLOCK, 0, 1);
+
+    uc_close(uc);
+
+    printf("%s\n", failed ? "FAILED" : "OK");
+    return failed;
+}
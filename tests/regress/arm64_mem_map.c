@@ -0,0 +1,130 @@
+/*
+Test for the lookup of mapped regions and batched mapping. Hundreds of MMIO
+and RAM regions mapped out of order in a batch are found by address, overlaps
+are refused, and unmapped regions are gone.
+*/
+
+#include <unicorn/unicorn.h>
+#include <stdio.h>
+#include <stdint.h>
+
+#define CODE_ADDR 0x10000
+#define IO_BASE   0x10000000
+#define NUM_IO    300
+#define IO_ADDR(i)  (IO_BASE + (uint64_t)(i) * 0x2000)
+#define RAM_ADDR(i) (IO_ADDR(i) + 0x1000)
+
+static const uint32_t code[] = {
+    0xb9400001, // 10000: ldr  w1, [x0]
+    0x14000000, // 10004: b    10004
+};
+
+static uc_tx_result_t mmio(uc_engine *uc, void *opaque, uc_mmio_tx_t *tx)
+{
+    if (tx->is_read)
+        *(uint64_t *)tx->data = (uintptr_t)opaque;
+    return UC_TX_OK;
+}
+
+int main(int argc, char **argv)
+{
+    static uint8_t host[0x1000];
+    uc_engine *uc;
+    uc_err err;
+    uint64_t x0, x1;
+    uint32_t v;
+    int failed = 0;
+    int i, j;
+
+    err = uc_open("Cortex-A53", NULL, NULL, &uc);
+    if (err) {
+        printf("Failed on uc_open() with error returned: %u\n", err);
+        return 1;
+    }
+
+    uc_mem_map(uc, CODE_ADDR, 0x1000, UC_PROT_ALL);
+    uc_mem_write(uc, CODE_ADDR, code, sizeof(code));
+
+    // MMIO pages with RAM pages in between, mapped out of order
+    uc_mem_map_begin(uc);
+    for (i = 0; i < NUM_IO; i++) {
+        j = i * 7 % NUM_IO;
+        if (uc_mem_map_io(uc, IO_ADDR(j), 0x1000, mmio, (void *)(uintptr_t)j) ||
+            uc_mem_map(uc, RAM_ADDR(j), 0x1000, UC_PROT_ALL)) {
+            printf("Failed to map region %d\n", j);
+            return 1;
+        }
+    }
+    if (uc_mem_map(uc, IO_ADDR(5), 0x1000, UC_PROT_ALL) != UC_ERR_MAP ||
+        uc_mem_map(uc, RAM_ADDR(5) - 0x1000, 0x3000, UC_PROT_ALL) != UC_ERR_MAP ||
+        uc_mem_map(uc, IO_ADDR(NUM_IO), 0x1000, UC_PROT_ALL) != UC_ERR_OK) {
+        printf("overlap checks failed\n");
+        failed = 1;
+    }
+    if (uc_emu_start(uc, CODE_ADDR, 0, 0, 1) != UC_ERR_ARG ||
+        uc_emu_resume(uc, 1) != UC_ERR_ARG ||
+        uc_mem_unmap(uc, RAM_ADDR(0), 0x1000) != UC_ERR_ARG) {
+        printf("allowed in a batch\n");
+        failed = 1;
+    }
+    uc_mem_map_commit(uc);
+    if (uc_mem_map_commit(uc) != UC_ERR_ARG) {
+        printf("commit without a batch\n");
+        failed = 1;
+    }
+
+    for (i = 0; i < NUM_IO; i++) {
+        v = i + 1000;
+        if (uc_mem_read(uc, IO_ADDR(i) + 8, &v, 4) || v != i ||
+            uc_mem_write(uc, RAM_ADDR(i) + 0xffc, &i, 4)) {
+            printf("region %d: %u\n", i, v);
+            failed = 1;
+        }
+    }
+    for (i = 0; i < NUM_IO; i++) {
+        if (uc_mem_read(uc, RAM_ADDR(i) + 0xffc, &v, 4) || v != i) {
+            printf("ram %d: %u\n", i, v);
+            failed = 1;
+        }
+    }
+
+    x0 = IO_ADDR(123);
+    uc_reg_write(uc, UC_ARM64_REG_X0, &x0);
+    err = uc_emu_start(uc, CODE_ADDR, 0, 0, 1);
+    uc_reg_read(uc, UC_ARM64_REG_X1, &x1);
+    if (err || x1 != 123) {
+        printf("load: error %u, x1 %llu\n", err, (unsigned long long)x1);
+        failed = 1;
+    }
+
+    // every other RAM page unmapped
+    for (i = 0; i < NUM_IO; i += 2)
+        uc_mem_unmap(uc, RAM_ADDR(i), 0x1000);
+    for (i = 0; i < NUM_IO; i++) {
+        err = uc_mem_read(uc, RAM_ADDR(i) + 0xffc, &v, 4);
+        if ((i & 1) ? err || v != i : err != UC_ERR_READ_UNMAPPED) {
+            printf("unmapped %d: error %u\n", i, err);
+            failed = 1;
+        }
+    }
+    if (uc_mem_map(uc, RAM_ADDR(4), 0x1000, UC_PROT_ALL) ||
+        uc_mem_map(uc, RAM_ADDR(4), 0x1000, UC_PROT_ALL) != UC_ERR_MAP) {
+        printf("remap failed\n");
+        failed = 1;
+    }
+
+    // host memory over a mapped page, the other regions are still found
+    uc_mem_map_ptr(uc, RAM_ADDR(7), 0x1000, UC_PROT_ALL, host);
+    if (uc_mem_read(uc, IO_ADDR(200) + 8, &v, 4) || v != 200 ||
+        uc_mem_read(uc, RAM_ADDR(9) + 0xffc, &v, 4) || v != 9 ||
+        uc_mem_read(uc, RAM_ADDR(8), &v, 4) != UC_ERR_READ_UNMAPPED ||
+        uc_mem_map(uc, RAM_ADDR(9), 0x1000, UC_PROT_ALL) != UC_ERR_MAP) {
+        printf("overlapping regions\n");
+        failed = 1;
+    }
+
+    uc_close(uc);
+
+    printf("%s\n", failed ? "FAILED" : "OK");
+    return failed;
+}
@@ -0,0 +1,185 @@
+/*
+Test for the memory access trace. Loads and stores append their address,
+size, direction, physical address and value to the trace buffer, which is
+handed over when full and at the end of a run. Blocks outside the traced
+code ranges don't record anything.
+*/
+
+#include <unicorn/unicorn.h>
+#include <stdio.h>
+#include <string.h>
+
+#define CODE_ADDR 0x10000
+#define LOOP_ADDR 0x10100
+#define DATA_ADDR 0x200000
+
+static const uint32_t code[] = {
+    0xf9400002, // 10000: ldr  x2, [x0]
+    0xb9001002, // 10004: str  w2, [x0, #16]
+    0x39400403, // 10008: ldrb w3, [x0, #1]
+    0xa9020c02, // 1000c: stp  x2, x3, [x0, #32]
+    0xf9400400, // 10010: ldr  x0, [x0, #8]
+    0x14000000, // 10014: b    10014
+};
+
+static const uint32_t loop[] = {
+    0xf9400002, // 10100: ldr  x2, [x0]
+    0x91000421, // 10104: add  x1, x1, #1
+    0xf104b03f, // 10108: cmp  x1, #300
+    0x54ffffa1, // 1010c: b.ne 10100
+    0x14000000, // 10110: b    10110
+};
+
+#define LOOPS 300
+
+static const uint64_t data[] = {
+    0x1122334455667788, 0x0123456789abcdef,
+};
+
+#define WORDS 4
+
+static const uint64_t expected[][WORDS] = {
+    { DATA_ADDR, 8, DATA_ADDR, 0x1122334455667788 },
+    { DATA_ADDR + 0x10, 4 | UC_MEM_TRACE_WRITE, DATA_ADDR + 0x10, 0x55667788 },
+    { DATA_ADDR + 1, 1, DATA_ADDR + 1, 0x77 },
+    { DATA_ADDR + 0x20, 8 | UC_MEM_TRACE_WRITE, DATA_ADDR + 0x20,
+      0x1122334455667788 },
+    { DATA_ADDR + 0x28, 8 | UC_MEM_TRACE_WRITE, DATA_ADDR + 0x28, 0x77 },
+    { DATA_ADDR + 8, 8, DATA_ADDR + 8, 0x0123456789abcdef },
+};
+
+#define NUM_ACCESSES (sizeof(expected) / sizeof(expected[0]))
+
+static uint64_t buffer[UC_MEM_TRACE_MIN_ENTRIES * WORDS];
+static uint64_t entries[LOOPS + 1][WORDS];
+static size_t num_entries, calls;
+
+static void trace(void *opaque, const uint64_t *e, size_t count)
+{
+    calls++;
+    for (; count && num_entries < LOOPS + 1; count--, e += WORDS)
+        memcpy(entries[num_entries++], e, sizeof(entries[0]));
+}
+
+static int run(uc_engine *uc, uint64_t begin, size_t count)
+{
+    uint64_t x0 = DATA_ADDR, x1 = 0;
+    uc_err err;
+
+    num_entries = 0;
+    calls = 0;
+    uc_reg_write(uc, UC_ARM64_REG_X0, &x0);
+    uc_reg_write(uc, UC_ARM64_REG_X1, &x1);
+    err = uc_emu_start(uc, begin, 0, 0, count);
+    if (err) {
+        printf("Failed on uc_emu_start() with error returned: %u\n", err);
+        return 1;
+    }
+    return 0;
+}
+
+static int check_accesses(void)
+{
+    int failed = 0;
+    size_t i, j;
+
+    if (num_entries != NUM_ACCESSES) {
+        printf("%zu entries, expected %zu\n", num_entries,
+               (size_t)NUM_ACCESSES);
+        return 1;
+    }
+    for (i = 0; i < NUM_ACCESSES; i++) {
+        // the MMU index is not checked
+        entries[i][1] &= ~0xff0000ull;
+        for (j = 0; j < WORDS; j++) {
+            if (entries[i][j] != expected[i][j]) {
+                printf("entry %zu word %zu is 0x%llx, expected 0x%llx\n", i, j,
+                       (unsigned long long)entries[i][j],
+                       (unsigned long long)expected[i][j]);
+                failed = 1;
+            }
+        }
+    }
+    return failed;
+}
+
+int main(int argc, char **argv)
+{
+    uc_mem_trace_range_t range = { LOOP_ADDR, LOOP_ADDR + sizeof(loop) };
+    uc_engine *uc;
+    uc_err err;
+    int failed = 0;
+    size_t i;
+
+    err = uc_open("Cortex-A53", NULL, NULL, &uc);
+    if (err) {
+        printf("Failed on uc_open() with error returned: %u\n", err);
+        return 1;
+    }
+
+    uc_mem_map(uc, CODE_ADDR, 0x1000, UC_PROT_ALL);
+    uc_mem_write(uc, CODE_ADDR, code, sizeof(code));
+    uc_mem_write(uc, LOOP_ADDR, loop, sizeof(loop));
+    uc_mem_map(uc, DATA_ADDR, 0x1000, UC_PROT_ALL);
+    uc_mem_write(uc, DATA_ADDR, data, sizeof(data));
+
+    if (uc_setup_mem_trace(uc, NULL, buffer,
+                           sizeof(buffer) / sizeof(buffer[0]) - 1,
+                           UC_MEM_TRACE_PADDR | UC_MEM_TRACE_VALUE,
+                           trace) != UC_ERR_ARG) {
+        printf("too small buffer accepted\n");
+        failed = 1;
+    }
+    err = uc_setup_mem_trace(uc, NULL, buffer,
+                             sizeof(buffer) / sizeof(buffer[0]),
+                             UC_MEM_TRACE_PADDR | UC_MEM_TRACE_VALUE, trace);
+    if (err) {
+        printf("Failed on uc_setup_mem_trace() with error returned: %u\n", err);
+        return 1;
+    }
+
+    // all the accesses of one block, twice to run the cached block
+    for (i = 0; i < 2; i++) {
+        if (run(uc, CODE_ADDR, sizeof(code) / sizeof(code[0]) - 1))
+            return 1;
+        failed |= check_accesses();
+    }
+
+    // the buffer fills up several times
+    if (run(uc, LOOP_ADDR, LOOPS * 4))
+        return 1;
+    if (num_entries != LOOPS || calls < LOOPS / UC_MEM_TRACE_MIN_ENTRIES + 1) {
+        printf("%zu entries in %zu calls\n", num_entries, calls);
+        failed = 1;
+    }
+
+    // only the loop is traced
+    uc_mem_trace_ranges(uc, &range, 1);
+    if (run(uc, CODE_ADDR, sizeof(code) / sizeof(code[0]) - 1))
+        return 1;
+    if (num_entries != 0) {
+        printf("%zu entries outside of the traced range\n", num_entries);
+        failed = 1;
+    }
+    if (run(uc, LOOP_ADDR, LOOPS * 4))
+        return 1;
+    if (num_entries != LOOPS) {
+        printf("%zu entries in the traced range\n", num_entries);
+        failed = 1;
+    }
+
+    // nothing is recorded once the trace is off
+    uc_mem_trace_ranges(uc, NULL, 0);
+    uc_setup_mem_trace(uc, NULL, NULL, 0, 0, NULL);
+    if (run(uc, LOOP_ADDR, LOOPS * 4))
+        return 1;
+    if (calls != 0) {
+        printf("%zu calls without trace\n", calls);
+        failed = 1;
+    }
+
+    uc_close(uc);
+
+    printf("%s\n", failed ? "FAILED" : "OK");
+    return failed;
+}
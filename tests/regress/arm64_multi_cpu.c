@@ -0,0 +1,121 @@
+/*
+Test for several vCPUs in one engine ("cpus" config).
+Each vCPU has its own registers, MPIDR and breakpoints, memory is shared
+between them.
+*/
+
+#include <unicorn/unicorn.h>
+#include <stdio.h>
+#include <string.h>
+
+#define CODE_ADDR 0x10000
+#define DATA_ADDR 0x20000
+#define NUM_CPUS  4
+#define ROUNDS    3
+
+static const uint32_t test_code[] = {
+    0xd53800a3, // 10000: mrs  x3, mpidr_el1
+    0xf9400041, // 10004: ldr  x1, [x2]
+    0x91000421, // 10008: add  x1, x1, #1
+    0xf9000041, // 1000c: str  x1, [x2]
+    0x91000400, // 10010: add  x0, x0, #1
+    0x17fffffc, // 10014: b    10004
+};
+
+#define LOOP_LEN 5
+
+static const char* config(void *opaque, const char *name)
+{
+    return strcmp(name, "cpus") == 0 ? "4" : NULL;
+}
+
+int main(int argc, char **argv)
+{
+    uc_engine *uc;
+    uc_err err;
+    uint64_t x0, x2 = DATA_ADDR, x3, counter, pc;
+    int failed = 0, round, i;
+
+    err = uc_open("Cortex-A53", NULL, config, &uc);
+    if (err) {
+        printf("Failed on uc_open() with error returned: %u\n", err);
+        return 1;
+    }
+
+    if (uc_cpu_count(uc) != NUM_CPUS || uc_cpu_index(uc) != 0) {
+        printf("%d vCPUs, vCPU %d selected\n", uc_cpu_count(uc),
+               uc_cpu_index(uc));
+        return 1;
+    }
+
+    uc_mem_map(uc, CODE_ADDR, 0x1000, UC_PROT_ALL);
+    uc_mem_map(uc, DATA_ADDR, 0x1000, UC_PROT_ALL);
+    uc_mem_write(uc, CODE_ADDR, test_code, sizeof(test_code));
+
+    // round robin: every vCPU runs ten loop iterations per round
+    for (round = 0; round < ROUNDS; round++) {
+        for (i = 0; i < NUM_CPUS; i++) {
+            uc_cpu_select(uc, i);
+            if (round == 0) {
+                uc_reg_write(uc, UC_ARM64_REG_X2, &x2);
+                err = uc_emu_start(uc, CODE_ADDR, 0, 0, 1 + 10 * LOOP_LEN);
+            } else {
+                err = uc_emu_resume(uc, 10 * LOOP_LEN);
+            }
+
+            if (err) {
+                printf("vCPU %d: error %u\n", i, err);
+                failed = 1;
+            }
+        }
+    }
+
+    for (i = 0; i < NUM_CPUS; i++) {
+        uc_cpu_select(uc, i);
+        uc_reg_read(uc, UC_ARM64_REG_X0, &x0);
+        uc_reg_read(uc, UC_ARM64_REG_X3, &x3);
+        if (x0 != 10 * ROUNDS || (x3 & 0xff) != i) {
+            printf("vCPU %d: x0 %llu, mpidr 0x%llx\n", i,
+                   (unsigned long long)x0, (unsigned long long)x3);
+            failed = 1;
+        }
+    }
+
+    uc_mem_read(uc, DATA_ADDR, &counter, sizeof(counter));
+    if (counter != 10 * ROUNDS * NUM_CPUS) {
+        printf("shared counter %llu\n", (unsigned long long)counter);
+        failed = 1;
+    }
+
+    // a breakpoint of vCPU 1 is not seen by vCPU 0, which translates the
+    // code first, but stops vCPU 1
+    uc_cpu_select(uc, 1);
+    uc_breakpoint_insert(uc, CODE_ADDR + 8);
+    uc_cpu_select(uc, 0);
+    uc_emu_resume(uc, LOOP_LEN);
+    uc_reg_read(uc, UC_ARM64_REG_X0, &x0);
+    if (x0 != 10 * ROUNDS + 1) {
+        printf("vCPU 0 stopped at the breakpoint of vCPU 1, x0 %llu\n",
+               (unsigned long long)x0);
+        failed = 1;
+    }
+    uc_cpu_select(uc, 1);
+    uc_emu_resume(uc, LOOP_LEN);
+    uc_reg_read(uc, UC_ARM64_REG_PC, &pc);
+    if (pc != CODE_ADDR + 8) {
+        printf("vCPU 1 missed its breakpoint, pc 0x%llx\n",
+               (unsigned long long)pc);
+        failed = 1;
+    }
+    uc_breakpoint_remove(uc, CODE_ADDR + 8);
+
+    if (uc_cpu_select(uc, NUM_CPUS) != UC_ERR_ARG) {
+        printf("selecting a missing vCPU succeeded\n");
+        failed = 1;
+    }
+
+    uc_close(uc);
+
+    printf("%s\n", failed ? "FAILED" : "OK");
+    return failed;
+}
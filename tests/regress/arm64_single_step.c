@@ -0,0 +1,95 @@
+/*
+Test for single-stepping with count == 1.
+Each step must retire exactly one instruction, also across taken branches,
+and a following continue must run on normally sized TBs.
+*/
+
+#include <unicorn/unicorn.h>
+#include <stdio.h>
+
+#define CODE_ADDR 0x10000
+
+static const uint32_t test_code[] = {
+    0xd2800000, // 10000: mov  x0, #0
+    0x91000400, // 10004: add  x0, x0, #1
+    0x91000821, // 10008: add  x1, x1, #2
+    0xf100281f, // 1000c: cmp  x0, #10
+    0x54ffffa1, // 10010: b.ne 10004
+    0xd503201f, // 10014: nop
+};
+
+#define LOOP_STEPS (1 + 10 * 4)
+#define END_ADDR   (CODE_ADDR + 0x14)
+
+int main(int argc, char **argv)
+{
+    uc_engine *uc;
+    uc_err err;
+    uint64_t pc = CODE_ADDR, expected = CODE_ADDR, x0, x1;
+    int failed = 0, round, i;
+
+    err = uc_open("Cortex-A53", NULL, NULL, &uc);
+    if (err) {
+        printf("Failed on uc_open() with error returned: %u\n", err);
+        return 1;
+    }
+
+    uc_mem_map(uc, CODE_ADDR, 0x1000, UC_PROT_ALL);
+    uc_mem_write(uc, CODE_ADDR, test_code, sizeof(test_code));
+
+    // step through the loop twice, the second round runs on cached TBs
+    for (round = 0; round < 2; round++) {
+        x1 = 0;
+        uc_reg_write(uc, UC_ARM64_REG_X1, &x1);
+        pc = expected = CODE_ADDR;
+
+        for (i = 0; i < LOOP_STEPS; i++) {
+            err = uc_emu_start(uc, pc, 0, 0, 1);
+            if (err) {
+                printf("Failed on uc_emu_start() with error returned: %u\n", err);
+                return 1;
+            }
+
+            if (uc_instruction_count(uc) != 1) {
+                printf("step %d: executed %zu instructions\n", i,
+                       uc_instruction_count(uc));
+                failed = 1;
+            }
+
+            uc_reg_read(uc, UC_ARM64_REG_X0, &x0);
+            expected = (expected == CODE_ADDR + 0x10 && x0 != 10)
+                ? CODE_ADDR + 4 : expected + 4;
+            uc_reg_read(uc, UC_ARM64_REG_PC, &pc);
+            if (pc != expected) {
+                printf("step %d: stopped at 0x%llx instead of 0x%llx\n", i,
+                       (unsigned long long)pc, (unsigned long long)expected);
+                failed = 1;
+                break;
+            }
+        }
+
+        uc_reg_read(uc, UC_ARM64_REG_X1, &x1);
+        if (pc != END_ADDR || x1 != 20) {
+            printf("round %d: pc 0x%llx, x1 %llu\n", round,
+                   (unsigned long long)pc, (unsigned long long)x1);
+            failed = 1;
+        }
+    }
+
+    // continue from the start after stepping
+    x1 = 0;
+    uc_reg_write(uc, UC_ARM64_REG_X1, &x1);
+    err = uc_emu_start(uc, CODE_ADDR, 0, 0, LOOP_STEPS);
+    uc_reg_read(uc, UC_ARM64_REG_PC, &pc);
+    uc_reg_read(uc, UC_ARM64_REG_X1, &x1);
+    if (err || pc != END_ADDR || x1 != 20) {
+        printf("continue: error %u, pc 0x%llx, x1 %llu\n", err,
+               (unsigned long long)pc, (unsigned long long)x1);
+        failed = 1;
+    }
+
+    uc_close(uc);
+
+    printf("%s\n", failed ? "FAILED" : "OK");
+    return failed;
+}
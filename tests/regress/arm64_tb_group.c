@@ -0,0 +1,123 @@
+/*
+Test for engines sharing their translation cache ("tbgroup" config).
+The engines map the same host memory, code translated by one of them is
+executed by all, and invalidating it through one engine affects every
+engine of the group. Code hooks and breakpoints of one engine are not
+seen by the others.
+*/
+
+#include <unicorn/unicorn.h>
+#include <stdio.h>
+#include <string.h>
+
+#define CODE_ADDR   0x10000
+#define NUM_ENGINES 4
+
+static uint32_t code[0x1000 / 4] = {
+    0xd2800020, // 10000: mov  x0, #1
+    0x91000421, // 10004: add  x1, x1, #1
+};
+
+static int calls;
+
+static void hook_code(uc_engine *uc, uint64_t address, uint32_t size,
+                      void *user_data)
+{
+    calls++;
+}
+
+static const char* config(void *opaque, const char *name)
+{
+    return strcmp(name, "tbgroup") == 0 ? "cluster0" : NULL;
+}
+
+static int run(uc_engine *uc, uint64_t expected)
+{
+    uint64_t x0 = 0;
+    uc_err err;
+
+    uc_reg_write(uc, UC_ARM64_REG_X0, &x0);
+    err = uc_emu_start(uc, CODE_ADDR, 0, 0, 2);
+    if (err) {
+        printf("Failed on uc_emu_start() with error returned: %u\n", err);
+        return 1;
+    }
+
+    uc_reg_read(uc, UC_ARM64_REG_X0, &x0);
+    if (x0 != expected) {
+        printf("x0 = %llu, expected %llu\n", (unsigned long long)x0,
+               (unsigned long long)expected);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    uc_engine *uc[NUM_ENGINES], *other;
+    uc_hook hh;
+    uint64_t pc;
+    uc_err err;
+    int failed = 0, i;
+
+    for (i = 0; i < NUM_ENGINES; i++) {
+        err = uc_open("Cortex-A53", NULL, config, &uc[i]);
+        if (err) {
+            printf("Failed on uc_open() with error returned: %u\n", err);
+            return 1;
+        }
+        uc_mem_map_ptr(uc[i], CODE_ADDR, sizeof(code), UC_PROT_ALL, code);
+    }
+
+    // a different model must not join the group
+    if (uc_open("Cortex-A57", NULL, config, &other) != UC_ERR_ARG) {
+        printf("Cortex-A57 joined a Cortex-A53 group\n");
+        failed = 1;
+    }
+
+    for (i = 0; i < NUM_ENGINES; i++)
+        failed |= run(uc[i], 1);
+
+    // modify the code and invalidate it through the first engine only
+    code[0] = 0xd2800040; // mov x0, #2
+    uc_tb_flush_page(uc[0], CODE_ADDR, CODE_ADDR + sizeof(code));
+
+    for (i = NUM_ENGINES - 1; i >= 0; i--)
+        failed |= run(uc[i], 2);
+
+    // code hooks and breakpoints only apply to their own engine
+    uc_hook_add(uc[1], &hh, UC_HOOK_CODE, hook_code, NULL, 1, 0);
+    failed |= run(uc[2], 2);
+    failed |= run(uc[1], 2);
+    failed |= run(uc[3], 2);
+    if (calls != 2) {
+        printf("code hook of one engine called %d times\n", calls);
+        failed = 1;
+    }
+    uc_hook_del(uc[1], hh);
+
+    uc_breakpoint_insert(uc[2], CODE_ADDR + 4);
+    failed |= run(uc[3], 2);
+    uc_emu_start(uc[2], CODE_ADDR, 0, 0, 2);
+    uc_reg_read(uc[2], UC_ARM64_REG_PC, &pc);
+    if (pc != CODE_ADDR + 4) {
+        printf("breakpoint missed, pc 0x%llx\n", (unsigned long long)pc);
+        failed = 1;
+    }
+    failed |= run(uc[0], 2);
+    uc_breakpoint_remove(uc[2], CODE_ADDR + 4);
+    failed |= run(uc[2], 2);
+
+    // the translation cache outlives the engine that created it
+    uc_close(uc[0]);
+    code[0] = 0xd2800060; // mov x0, #3
+    uc_tb_flush(uc[1]);
+
+    for (i = 1; i < NUM_ENGINES; i++) {
+        failed |= run(uc[i], 3);
+        uc_close(uc[i]);
+    }
+
+    printf("%s\n", failed ? "FAILED" : "OK");
+    return failed;
+}
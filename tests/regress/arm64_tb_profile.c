@@ -0,0 +1,111 @@
+/*
+Test for warm-start profiles ("tbprofile" config). The blocks translated by
+one engine are saved on uc_close() and translated ahead of execution by the
+next one, which must still run the code correctly.
+*/
+
+#include <unicorn/unicorn.h>
+#include <stdio.h>
+#include <string.h>
+
+#define CODE_ADDR 0x10000
+#define PROFILE   "arm64_tb_profile.prof"
+
+static uint32_t code[0x1000 / 4] = {
+    0xd2800000, // 10000: mov  x0, #0
+    0x91000400, // 10004: add  x0, x0, #1
+    0xf100281f, // 10008: cmp  x0, #10
+    0x54ffffc1, // 1000c: b.ne 10004
+    0x91001401, // 10010: add  x1, x0, #5
+};
+
+static const char* config(void *opaque, const char *name)
+{
+    return strcmp(name, "tbprofile") == 0 ? PROFILE : NULL;
+}
+
+static uc_engine *open_engine(const char *model, uc_get_config_t cfg)
+{
+    uc_engine *uc;
+    uc_err err;
+
+    err = uc_open(model, NULL, cfg, &uc);
+    if (err) {
+        printf("Failed on uc_open() with error returned: %u\n", err);
+        return NULL;
+    }
+    uc_mem_map_ptr(uc, CODE_ADDR, sizeof(code), UC_PROT_ALL, code);
+    return uc;
+}
+
+static int run(uc_engine *uc, uint64_t expected)
+{
+    uint64_t x1 = 0;
+    uc_err err;
+
+    err = uc_emu_start(uc, CODE_ADDR, 0, 0, 32);
+    if (err) {
+        printf("Failed on uc_emu_start() with error returned: %u\n", err);
+        return 1;
+    }
+
+    uc_reg_read(uc, UC_ARM64_REG_X1, &x1);
+    if (x1 != expected) {
+        printf("x1 = %llu, expected %llu\n", (unsigned long long)x1,
+               (unsigned long long)expected);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    uc_engine *uc;
+    size_t count = 0;
+    int failed = 0;
+
+    remove(PROFILE);
+
+    // record
+    if ((uc = open_engine("Cortex-A53", config)) == NULL)
+        return 1;
+    failed |= run(uc, 15);
+    uc_close(uc);
+
+    // load explicitly
+    if ((uc = open_engine("Cortex-A53", NULL)) == NULL)
+        return 1;
+    if (uc_tb_profile_load(uc, PROFILE, &count) != UC_ERR_OK || count == 0) {
+        printf("no blocks loaded from the profile\n");
+        failed = 1;
+    }
+    if (uc_tb_profile_load(uc, PROFILE, &count) != UC_ERR_OK || count != 0) {
+        printf("%zu blocks translated twice\n", count);
+        failed = 1;
+    }
+    failed |= run(uc, 15);
+    uc_close(uc);
+
+    // a profile only applies to the model that recorded it
+    if ((uc = open_engine("Cortex-A57", NULL)) == NULL)
+        return 1;
+    if (uc_tb_profile_load(uc, PROFILE, &count) != UC_ERR_ARG) {
+        printf("Cortex-A57 loaded a Cortex-A53 profile\n");
+        failed = 1;
+    }
+    uc_close(uc);
+
+    // load on the first run, then modify the code
+    if ((uc = open_engine("Cortex-A53", config)) == NULL)
+        return 1;
+    failed |= run(uc, 15);
+    code[4] = 0x91002801; // add x1, x0, #10
+    uc_tb_flush_page(uc, CODE_ADDR, CODE_ADDR + sizeof(code));
+    failed |= run(uc, 20);
+    uc_close(uc);
+
+    remove(PROFILE);
+
+    printf("%s\n", failed ? "FAILED" : "OK");
+    return failed;
+}
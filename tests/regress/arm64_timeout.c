@@ -0,0 +1,71 @@
+/*
+Test for uc_emu_start() timeouts with several engines running in parallel.
+Every timed run of an endless loop must end with UC_ERR_TIMEOUT, and a
+following run without timeout must not report one.
+*/
+
+#include <unicorn/unicorn.h>
+#include <pthread.h>
+#include <stdio.h>
+
+#define CODE_ADDR 0x10000
+#define ENGINES   8
+#define ROUNDS    50
+
+static const uint32_t test_code[] = {
+    0x91000400, // 10000: add  x0, x0, #1
+    0x17ffffff, // 10004: b    10000
+};
+
+static void *run(void *arg)
+{
+    int *failed = arg;
+    uc_engine *uc;
+    uc_err err;
+    int i;
+
+    err = uc_open("Cortex-A53", NULL, NULL, &uc);
+    if (err) {
+        printf("Failed on uc_open() with error returned: %u\n", err);
+        *failed = 1;
+        return NULL;
+    }
+
+    uc_mem_map(uc, CODE_ADDR, 0x1000, UC_PROT_ALL);
+    uc_mem_write(uc, CODE_ADDR, test_code, sizeof(test_code));
+
+    for (i = 0; i < ROUNDS; i++) {
+        err = uc_emu_start(uc, CODE_ADDR, 0, 200, (size_t)-1);
+        if (err != UC_ERR_TIMEOUT) {
+            printf("round %d: timed run returned %u\n", i, err);
+            *failed = 1;
+        }
+
+        err = uc_emu_start(uc, CODE_ADDR, 0, 0, 1000);
+        if (err != UC_ERR_OK) {
+            printf("round %d: counted run returned %u\n", i, err);
+            *failed = 1;
+        }
+    }
+
+    uc_close(uc);
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    pthread_t threads[ENGINES];
+    int failed[ENGINES] = { 0 };
+    int i, result = 0;
+
+    for (i = 0; i < ENGINES; i++)
+        pthread_create(&threads[i], NULL, run, &failed[i]);
+
+    for (i = 0; i < ENGINES; i++) {
+        pthread_join(threads[i], NULL);
+        result |= failed[i];
+    }
+
+    printf("%s\n", result ? "FAILED" : "OK");
+    return result;
+}
@@ -0,0 +1,165 @@
+/*
+Test for the ASID tagged softmmu TLB. Two address spaces map the same
+virtual page to different physical pages. Switching between them must
+neither flush the TLB nor mix up their mappings, and TLBI ASIDE1 must only
+invalidate the mappings of its ASID.
+*/
+
+#include <unicorn/unicorn.h>
+#include <stdio.h>
+#include <string.h>
+
+#define CODE_ADDR 0x10000
+#define DATA_ADDR 0x80000
+#define PT_ADDR   0x100000
+#define RAM_SIZE  0x200000
+
+#define ASID1 1ULL
+#define ASID2 2ULL
+
+#define PTE_PAGE  0x703ULL // page, AF, inner shareable, attr 0, EL1 RW
+#define PTE_TABLE 0x3ULL
+#define PTE_NG    (1ULL << 11)
+
+static const uint32_t code[] = {
+    // 10000: read [x0] alternately in the address spaces of x5 and x6,
+    // summing up in x7 and x8, x1 times
+    0xd5182005, // msr  ttbr0_el1, x5
+    0xd5033fdf, // isb
+    0xf9400002, // ldr  x2, [x0]
+    0x8b0200e7, // add  x7, x7, x2
+    0xd5182006, // msr  ttbr0_el1, x6
+    0xd5033fdf, // isb
+    0xf9400003, // ldr  x3, [x0]
+    0x8b030108, // add  x8, x8, x3
+    0xf1000421, // subs x1, x1, #1
+    0x54fffee1, // b.ne 10000
+    // 10028: invalidate the ASID in x9
+    0xd5088749, // tlbi aside1, x9
+    0xd5033f9f, // dsb  sy
+    0xd5033fdf, // isb
+    0xd503201f, // nop
+};
+
+static uint64_t ttbr(uint64_t asid, int as)
+{
+    return asid << 48 | (PT_ADDR + as * 0x3000);
+}
+
+// a three level table per address space, the code page is global
+static void map(uc_engine *uc, int as, uint64_t data_pa)
+{
+    uint64_t l1 = PT_ADDR + as * 0x3000, l2 = l1 + 0x1000, l3 = l2 + 0x1000;
+    uint64_t desc;
+
+    desc = l2 | PTE_TABLE;
+    uc_mem_write(uc, l1, &desc, sizeof(desc));
+    desc = l3 | PTE_TABLE;
+    uc_mem_write(uc, l2, &desc, sizeof(desc));
+    desc = CODE_ADDR | PTE_PAGE;
+    uc_mem_write(uc, l3 + (CODE_ADDR >> 12) * 8, &desc, sizeof(desc));
+    desc = data_pa | PTE_PAGE | PTE_NG;
+    uc_mem_write(uc, l3 + (DATA_ADDR >> 12) * 8, &desc, sizeof(desc));
+}
+
+static int run(uc_engine *uc, uint64_t count, uint64_t sum1, uint64_t sum2)
+{
+    uint64_t x1 = count, x5 = ttbr(ASID1, 0), x6 = ttbr(ASID2, 1), zero = 0;
+    uint64_t x0 = DATA_ADDR, x7, x8;
+    uc_err err;
+
+    uc_reg_write(uc, UC_ARM64_REG_X0, &x0);
+    uc_reg_write(uc, UC_ARM64_REG_X1, &x1);
+    uc_reg_write(uc, UC_ARM64_REG_X5, &x5);
+    uc_reg_write(uc, UC_ARM64_REG_X6, &x6);
+    uc_reg_write(uc, UC_ARM64_REG_X7, &zero);
+    uc_reg_write(uc, UC_ARM64_REG_X8, &zero);
+    err = uc_emu_start(uc, CODE_ADDR, 0, 0, 10 * count);
+    if (err) {
+        printf("Failed on uc_emu_start() with error returned: %u\n", err);
+        return 1;
+    }
+
+    uc_reg_read(uc, UC_ARM64_REG_X7, &x7);
+    uc_reg_read(uc, UC_ARM64_REG_X8, &x8);
+    if (x7 != sum1 || x8 != sum2) {
+        printf("read %llu and %llu, expected %llu and %llu\n",
+               (unsigned long long)x7, (unsigned long long)x8,
+               (unsigned long long)sum1, (unsigned long long)sum2);
+        return 1;
+    }
+    return 0;
+}
+
+static int tlbi_aside1(uc_engine *uc, uint64_t asid)
+{
+    uint64_t x9 = asid << 48;
+    uc_err err;
+
+    uc_reg_write(uc, UC_ARM64_REG_X9, &x9);
+    err = uc_emu_start(uc, CODE_ADDR + 0x28, 0, 0, 3);
+    if (err) {
+        printf("Failed on uc_emu_start() with error returned: %u\n", err);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    static const uint64_t values[] = { 1, 2, 3 };
+    uint64_t scr = 0x401, hcr = 1ULL << 31, mair = 0xff;
+    uint64_t tcr = (1 << 23) | (3 << 12) | (1 << 10) | (1 << 8) | 25;
+    uint64_t ttbr0 = ttbr(ASID1, 0), sctlr = 1, pstate = 0x3c5; // EL1h
+    uint64_t pte = (DATA_ADDR + 0x20000) | PTE_PAGE | PTE_NG;
+    uc_tlb_stats_t before, after;
+    uc_engine *uc;
+    uc_err err;
+    int failed = 0, i;
+
+    err = uc_open("Cortex-A53", NULL, NULL, &uc);
+    if (err) {
+        printf("Failed on uc_open() with error returned: %u\n", err);
+        return 1;
+    }
+
+    uc_mem_map(uc, 0, RAM_SIZE, UC_PROT_ALL);
+    uc_mem_write(uc, CODE_ADDR, code, sizeof(code));
+    for (i = 0; i < 3; i++)
+        uc_mem_write(uc, DATA_ADDR + i * 0x10000, &values[i], 8);
+    map(uc, 0, DATA_ADDR);
+    map(uc, 1, DATA_ADDR + 0x10000);
+
+    uc_reg_write(uc, UC_ARM64_REG_SCR_EL3, &scr);
+    uc_reg_write(uc, UC_ARM64_REG_HCR_EL2, &hcr);
+    uc_reg_write(uc, UC_ARM64_REG_MAIR_EL1, &mair);
+    uc_reg_write(uc, UC_ARM64_REG_TCR_EL1, &tcr);
+    uc_reg_write(uc, UC_ARM64_REG_TTBR0_EL1, &ttbr0);
+    uc_reg_write(uc, UC_ARM64_REG_SCTLR_EL1, &sctlr);
+    uc_reg_write(uc, UC_ARM64_REG_PSTATE, &pstate);
+
+    // context switches keep the entries of both address spaces
+    failed |= run(uc, 1, 1, 2);
+    uc_tlb_stats(uc, &before);
+    failed |= run(uc, 1000, 1000, 2000);
+    uc_tlb_stats(uc, &after);
+    if (after.flushes != before.flushes ||
+        after.victim_hits - before.victim_hits < 2000) {
+        printf("%llu flushes, %llu victim TLB hits\n",
+               (unsigned long long)(after.flushes - before.flushes),
+               (unsigned long long)(after.victim_hits - before.victim_hits));
+        failed = 1;
+    }
+
+    // remap the page of the second address space, invalidating it by ASID
+    uc_mem_write(uc, PT_ADDR + 0x5000 + (DATA_ADDR >> 12) * 8, &pte, 8);
+    failed |= tlbi_aside1(uc, ASID1);
+    failed |= run(uc, 10, 10, 20);
+    failed |= tlbi_aside1(uc, ASID2);
+    failed |= run(uc, 10, 10, 30);
+
+    uc_close(uc);
+
+    printf("%s\n", failed ? "FAILED" : "OK");
+    return failed;
+}
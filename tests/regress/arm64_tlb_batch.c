@@ -0,0 +1,205 @@
+/*
+Test for batched TLB shootdowns ("tlbbatch" config). Two engines share their
+memory and page tables. Broadcast invalidations are queued by the receiving
+engines, coalesced, and applied at a DSB of the sender, at the next
+uc_emu_start() or by uc_tlb_sync().
+*/
+
+#include <unicorn/unicorn.h>
+#include <stdio.h>
+#include <string.h>
+
+#define CODE_ADDR 0x10000
+#define DATA_ADDR 0x80000
+#define PT_ADDR   0x100000
+#define RAM_SIZE  0x200000
+
+#define PTE_PAGE  0x703ULL // page, AF, inner shareable, attr 0, EL1 RW
+#define PTE_TABLE 0x3ULL
+
+static const uint32_t code[] = {
+    0xf9400002, // 10000: ldr  x2, [x0]
+    0xd5088329, // 10004: tlbi vae1is, x9
+    0xd5033b9f, // 10008: dsb  ish
+    0xd5033fdf, // 1000c: isb
+    0xf9400002, // 10010: ldr  x2, [x0]
+};
+
+static uint64_t ram[RAM_SIZE / 8];
+static uc_engine *uc[2];
+static int broadcasts, syncs;
+
+static const char* config(void *opaque, const char *name)
+{
+    return strcmp(name, "tlbbatch") == 0 ? "1" : NULL;
+}
+
+static void flush(void *opaque)
+{
+    int i;
+
+    broadcasts++;
+    for (i = 0; i < 2; i++)
+        uc_tlb_flush(uc[i]);
+}
+
+static void flush_page(void *opaque, uint64_t addr)
+{
+    int i;
+
+    broadcasts++;
+    for (i = 0; i < 2; i++)
+        uc_tlb_flush_page(uc[i], addr);
+}
+
+static void flush_mmuidx(void *opaque, uint16_t idxmap)
+{
+    int i;
+
+    broadcasts++;
+    for (i = 0; i < 2; i++)
+        uc_tlb_flush_mmuidx(uc[i], idxmap);
+}
+
+static void flush_page_mmuidx(void *opaque, uint64_t addr, uint16_t idxmap)
+{
+    int i;
+
+    broadcasts++;
+    for (i = 0; i < 2; i++)
+        uc_tlb_flush_page_mmuidx(uc[i], addr, idxmap);
+}
+
+static void cluster_sync(void *opaque)
+{
+    syncs++;
+    uc_tlb_sync(uc[1]);
+}
+
+static void map(uint64_t data_pa)
+{
+    ram[(PT_ADDR + 0x2000) / 8 + (DATA_ADDR >> 12)] = data_pa | PTE_PAGE;
+}
+
+static int run(uc_engine *uc, uint64_t begin, size_t count, uint64_t expected)
+{
+    uint64_t x0 = DATA_ADDR, x2 = 0, x9 = DATA_ADDR >> 12;
+    uc_err err;
+
+    uc_reg_write(uc, UC_ARM64_REG_X0, &x0);
+    uc_reg_write(uc, UC_ARM64_REG_X2, &x2);
+    uc_reg_write(uc, UC_ARM64_REG_X9, &x9);
+    err = uc_emu_start(uc, begin, 0, 0, count);
+    if (err) {
+        printf("Failed on uc_emu_start() with error returned: %u\n", err);
+        return 1;
+    }
+
+    uc_reg_read(uc, UC_ARM64_REG_X2, &x2);
+    if (x2 != expected) {
+        printf("read %llu, expected %llu\n", (unsigned long long)x2,
+               (unsigned long long)expected);
+        return 1;
+    }
+    return 0;
+}
+
+static uint64_t flushes(uc_engine *uc)
+{
+    uc_tlb_stats_t stats;
+
+    uc_tlb_stats(uc, &stats);
+    return stats.flushes;
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t scr = 0x401, hcr = 1ULL << 31, mair = 0xff;
+    uint64_t tcr = (1 << 23) | (3 << 12) | (1 << 10) | (1 << 8) | 25;
+    uint64_t ttbr0 = PT_ADDR, sctlr = 1, pstate = 0x3c5; // EL1h
+    uint64_t before;
+    uc_err err;
+    int failed = 0, i;
+
+    memcpy(&ram[CODE_ADDR / 8], code, sizeof(code));
+    ram[DATA_ADDR / 8] = 1;
+    ram[(DATA_ADDR + 0x10000) / 8] = 2;
+    ram[PT_ADDR / 8] = (PT_ADDR + 0x1000) | PTE_TABLE;
+    ram[(PT_ADDR + 0x1000) / 8] = (PT_ADDR + 0x2000) | PTE_TABLE;
+    ram[(PT_ADDR + 0x2000) / 8 + (CODE_ADDR >> 12)] = CODE_ADDR | PTE_PAGE;
+    map(DATA_ADDR);
+
+    for (i = 0; i < 2; i++) {
+        err = uc_open("Cortex-A53", NULL, config, &uc[i]);
+        if (err) {
+            printf("Failed on uc_open() with error returned: %u\n", err);
+            return 1;
+        }
+        uc_mem_map_ptr(uc[i], 0, RAM_SIZE, UC_PROT_ALL, ram);
+        uc_register_tlb_cluster(uc[i], NULL, flush, flush_page, flush_mmuidx,
+                                flush_page_mmuidx);
+        uc_register_tlb_cluster_sync(uc[i], cluster_sync);
+
+        uc_reg_write(uc[i], UC_ARM64_REG_SCR_EL3, &scr);
+        uc_reg_write(uc[i], UC_ARM64_REG_HCR_EL2, &hcr);
+        uc_reg_write(uc[i], UC_ARM64_REG_MAIR_EL1, &mair);
+        uc_reg_write(uc[i], UC_ARM64_REG_TCR_EL1, &tcr);
+        uc_reg_write(uc[i], UC_ARM64_REG_TTBR0_EL1, &ttbr0);
+        uc_reg_write(uc[i], UC_ARM64_REG_SCTLR_EL1, &sctlr);
+        uc_reg_write(uc[i], UC_ARM64_REG_PSTATE, &pstate);
+
+        failed |= run(uc[i], CODE_ADDR, 1, 1);
+    }
+
+    // the sender sees the new mapping after its DSB, which syncs the cluster
+    map(DATA_ADDR + 0x10000);
+    failed |= run(uc[0], CODE_ADDR + 4, 4, 2);
+    failed |= run(uc[0], CODE_ADDR + 8, 1, 0); // DSB without maintenance
+    if (broadcasts != 1 || syncs != 1) {
+        printf("%d broadcasts, %d syncs\n", broadcasts, syncs);
+        failed = 1;
+    }
+    failed |= run(uc[1], CODE_ADDR, 1, 2);
+
+    // invalidations are queued until the engine syncs
+    before = flushes(uc[1]);
+    uc_tlb_flush(uc[1]);
+    if (flushes(uc[1]) != before) {
+        printf("flush was not queued\n");
+        failed = 1;
+    }
+    uc_tlb_sync(uc[1]);
+    if (flushes(uc[1]) == before) {
+        printf("flush was not applied\n");
+        failed = 1;
+    }
+
+    // repeated pages are coalesced, too many pages widen to their MMU index
+    failed |= run(uc[1], CODE_ADDR, 1, 2);
+    map(DATA_ADDR);
+    failed |= run(uc[1], CODE_ADDR, 1, 2);
+    before = flushes(uc[1]);
+    for (i = 0; i < 1000; i++)
+        uc_tlb_flush_page(uc[1], DATA_ADDR);
+    uc_tlb_sync(uc[1]);
+    if (flushes(uc[1]) != before) {
+        printf("page flushes were widened\n");
+        failed = 1;
+    }
+    failed |= run(uc[1], CODE_ADDR, 1, 1);
+
+    for (i = 0; i < 100; i++)
+        uc_tlb_flush_page_mmuidx(uc[1], DATA_ADDR + i * 0x1000, 1);
+    uc_tlb_sync(uc[1]);
+    if (flushes(uc[1]) != before + 1) {
+        printf("%llu flushes for 100 pages\n",
+               (unsigned long long)(flushes(uc[1]) - before));
+        failed = 1;
+    }
+
+    for (i = 0; i < 2; i++)
+        uc_close(uc[i]);
+
+    printf("%s\n", failed ? "FAILED" : "OK");
+    return failed;
+}
@@ -0,0 +1,95 @@
+/*
+Test for the softmmu TLB counters (uc_tlb_stats()). Two pages that share a
+main TLB entry are served by the victim TLB, and a working set larger than
+the main TLB makes it grow on flushes until it holds the whole set.
+*/
+
+#include <unicorn/unicorn.h>
+#include <stdio.h>
+#include <string.h>
+
+#define CODE_ADDR  0x10000
+#define DATA_ADDR  0x1000000
+#define DATA_PAGES 4096
+
+static const uint32_t code[] = {
+    // 10000: walk x1 pages from x0
+    0xf9400002, // ldr  x2, [x0]
+    0x91400400, // add  x0, x0, #1, lsl #12
+    0xf1000421, // subs x1, x1, #1
+    0x54ffffa1, // b.ne 10000
+    // 10010: alternate between the pages at x0 and x4 x1 times
+    0xf9400002, // ldr  x2, [x0]
+    0xf9400083, // ldr  x3, [x4]
+    0xf1000421, // subs x1, x1, #1
+    0x54ffffa1, // b.ne 10010
+};
+
+static int run(uc_engine *uc, uint64_t pc, uint64_t x0, uint64_t x4,
+               uint64_t x1)
+{
+    uc_err err;
+
+    uc_reg_write(uc, UC_ARM64_REG_X0, &x0);
+    uc_reg_write(uc, UC_ARM64_REG_X1, &x1);
+    uc_reg_write(uc, UC_ARM64_REG_X4, &x4);
+    err = uc_emu_start(uc, pc, 0, 0, 4 * x1);
+    if (err) {
+        printf("Failed on uc_emu_start() with error returned: %u\n", err);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    uc_engine *uc;
+    uc_tlb_stats_t before, after;
+    uc_err err;
+    int failed = 0, i;
+
+    err = uc_open("Cortex-A53", NULL, NULL, &uc);
+    if (err) {
+        printf("Failed on uc_open() with error returned: %u\n", err);
+        return 1;
+    }
+
+    uc_mem_map(uc, CODE_ADDR, 0x1000, UC_PROT_ALL);
+    uc_mem_write(uc, CODE_ADDR, code, sizeof(code));
+    uc_mem_map(uc, DATA_ADDR, DATA_PAGES * 0x1000, UC_PROT_ALL);
+
+    // pages 256 pages apart conflict in the initial main TLB
+    uc_tlb_stats(uc, &before);
+    failed |= run(uc, CODE_ADDR + 0x10, DATA_ADDR, DATA_ADDR + 0x100000, 1000);
+    uc_tlb_stats(uc, &after);
+    if (after.victim_hits - before.victim_hits < 1000) {
+        printf("%llu victim TLB hits\n",
+               (unsigned long long)(after.victim_hits - before.victim_hits));
+        failed = 1;
+    }
+
+    // each flush of a fully used TLB doubles its size
+    for (i = 0; i < 8; i++) {
+        failed |= run(uc, CODE_ADDR, DATA_ADDR, 0, DATA_PAGES);
+        uc_tlb_flush(uc);
+    }
+
+    failed |= run(uc, CODE_ADDR, DATA_ADDR, 0, DATA_PAGES);
+    uc_tlb_stats(uc, &before);
+    failed |= run(uc, CODE_ADDR, DATA_ADDR, 0, DATA_PAGES);
+    uc_tlb_stats(uc, &after);
+
+    if (after.resizes == 0 || after.flushes == 0 ||
+        after.misses - before.misses > DATA_PAGES / 16) {
+        printf("%llu resizes, %llu entries, %llu misses\n",
+               (unsigned long long)after.resizes,
+               (unsigned long long)after.entries,
+               (unsigned long long)(after.misses - before.misses));
+        failed = 1;
+    }
+
+    uc_close(uc);
+
+    printf("%s\n", failed ? "FAILED" : "OK");
+    return failed;
+}
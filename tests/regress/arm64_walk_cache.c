@@ -0,0 +1,202 @@
+/*
+Test for the page table walk cache. After the first walk into a 2 MiB region
+only its last level descriptors are read. Two address spaces map the same
+region to different pages, switching between them keeps their cached tables
+apart, and TLBI by ASID or by VA drops the cached tables they cover.
+*/
+
+#include <unicorn/unicorn.h>
+#include <stdio.h>
+#include <string.h>
+
+#define CODE_ADDR 0x10000
+#define DATA_VA   0x200000
+#define PT_ADDR   0x100000
+#define RAM_SIZE  0x400000
+
+#define ASID1 1ULL
+#define ASID2 2ULL
+
+#define PTE_PAGE  0x703ULL // page, AF, inner shareable, attr 0, EL1 RW
+#define PTE_TABLE 0x3ULL
+#define PTE_NG    (1ULL << 11)
+
+static const uint32_t code[] = {
+    // 10000: switch to the address space in x5, then sum up the first words
+    // of x1 pages from x0 in x7
+    0xd5182005, // msr  ttbr0_el1, x5
+    0xd5033fdf, // isb
+    0xf9400002, // ldr  x2, [x0]
+    0x8b0200e7, // add  x7, x7, x2
+    0x91400400, // add  x0, x0, #0x1000
+    0xf1000421, // subs x1, x1, #1
+    0x54ffff81, // b.ne 10008
+    0xd503201f, // nop
+    // 10020: invalidate the ASID in x9
+    0xd5088749, // tlbi aside1, x9
+    0xd5033f9f, // dsb  sy
+    0xd5033fdf, // isb
+    0xd503201f, // nop
+    // 10030: invalidate the VA in x9
+    0xd5088729, // tlbi vae1, x9
+    0xd5033f9f, // dsb  sy
+    0xd5033fdf, // isb
+};
+
+// the tables of an address space: level 1, 2, and level 3 for the code and
+// the data region, plus another level 3 table for the data region
+static uint64_t l1(int as) { return PT_ADDR + as * 0x8000; }
+static uint64_t l2(int as) { return l1(as) + 0x1000; }
+static uint64_t l3_code(int as) { return l1(as) + 0x2000; }
+static uint64_t l3_data(int as, int alt) { return l1(as) + 0x3000 + alt * 0x1000; }
+
+static uint64_t data_pa(int set, int page)
+{
+    return 0x200000 + set * 0x80000 + page * 0x1000;
+}
+
+static void write_desc(uc_engine *uc, uint64_t addr, uint64_t desc)
+{
+    uc_mem_write(uc, addr, &desc, sizeof(desc));
+}
+
+// address space @as maps the data region to set @as, its alternative level 3
+// table to set 2
+static void map(uc_engine *uc, int as)
+{
+    int i;
+
+    write_desc(uc, l1(as), l2(as) | PTE_TABLE);
+    write_desc(uc, l2(as), l3_code(as) | PTE_TABLE);
+    write_desc(uc, l2(as) + 8, l3_data(as, 0) | PTE_TABLE);
+    write_desc(uc, l3_code(as) + (CODE_ADDR >> 12) * 8, CODE_ADDR | PTE_PAGE);
+    for (i = 0; i < 512; i++) {
+        write_desc(uc, l3_data(as, 0) + i * 8,
+                   data_pa(as, i % 128) | PTE_PAGE | PTE_NG);
+        write_desc(uc, l3_data(as, 1) + i * 8,
+                   data_pa(2, i % 128) | PTE_PAGE | PTE_NG);
+    }
+}
+
+static uint64_t ttbr(int as)
+{
+    return (as ? ASID2 : ASID1) << 48 | l1(as);
+}
+
+static int exec(uc_engine *uc, uint64_t addr, size_t count)
+{
+    uc_err err = uc_emu_start(uc, addr, 0, 0, count);
+
+    if (err) {
+        printf("Failed on uc_emu_start() with error returned: %u\n", err);
+        return 1;
+    }
+    return 0;
+}
+
+// sum up @pages data pages from @first in address space @as, expecting the
+// given numbers of walks that did and did not find their last level table
+static int run(uc_engine *uc, const char *name, int as, int set, int first,
+               int pages, uint64_t hits, uint64_t misses)
+{
+    uint64_t x0 = DATA_VA + first * 0x1000, x1 = pages, x5 = ttbr(as);
+    uint64_t x7 = 0, expected = 0;
+    uc_tlb_stats_t before, after;
+    int i;
+
+    for (i = first; i < first + pages; i++)
+        expected += set * 1000 + i + 1;
+
+    uc_reg_write(uc, UC_ARM64_REG_X0, &x0);
+    uc_reg_write(uc, UC_ARM64_REG_X1, &x1);
+    uc_reg_write(uc, UC_ARM64_REG_X5, &x5);
+    uc_reg_write(uc, UC_ARM64_REG_X7, &x7);
+    uc_tlb_stats(uc, &before);
+    if (exec(uc, CODE_ADDR, 2 + 5 * pages))
+        return 1;
+    uc_tlb_stats(uc, &after);
+    uc_reg_read(uc, UC_ARM64_REG_X7, &x7);
+
+    if (x7 != expected ||
+        after.walk_cache_hits - before.walk_cache_hits != hits ||
+        after.walk_cache_misses - before.walk_cache_misses != misses) {
+        printf("%s: sum %llu, expected %llu, %llu hits, %llu misses\n", name,
+               (unsigned long long)x7, (unsigned long long)expected,
+               (unsigned long long)(after.walk_cache_hits -
+                                    before.walk_cache_hits),
+               (unsigned long long)(after.walk_cache_misses -
+                                    before.walk_cache_misses));
+        return 1;
+    }
+    return 0;
+}
+
+static int tlbi(uc_engine *uc, uint64_t addr, uint64_t x9)
+{
+    uc_reg_write(uc, UC_ARM64_REG_X9, &x9);
+    return exec(uc, addr, 3);
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t scr = 0x401, hcr = 1ULL << 31, mair = 0xff;
+    uint64_t tcr = (1 << 23) | (3 << 12) | (1 << 10) | (1 << 8) | 25;
+    uint64_t ttbr0 = ttbr(0), sctlr = 1, pstate = 0x3c5; // EL1h
+    uint64_t value;
+    uc_engine *uc;
+    uc_err err;
+    int failed = 0, set, i;
+
+    err = uc_open("Cortex-A53", NULL, NULL, &uc);
+    if (err) {
+        printf("Failed on uc_open() with error returned: %u\n", err);
+        return 1;
+    }
+
+    uc_mem_map(uc, 0, RAM_SIZE, UC_PROT_ALL);
+    uc_mem_write(uc, CODE_ADDR, code, sizeof(code));
+    for (set = 0; set < 3; set++) {
+        for (i = 0; i < 128; i++) {
+            value = set * 1000 + i + 1;
+            uc_mem_write(uc, data_pa(set, i), &value, 8);
+        }
+    }
+    map(uc, 0);
+    map(uc, 1);
+
+    uc_reg_write(uc, UC_ARM64_REG_SCR_EL3, &scr);
+    uc_reg_write(uc, UC_ARM64_REG_HCR_EL2, &hcr);
+    uc_reg_write(uc, UC_ARM64_REG_MAIR_EL1, &mair);
+    uc_reg_write(uc, UC_ARM64_REG_TCR_EL1, &tcr);
+    uc_reg_write(uc, UC_ARM64_REG_TTBR0_EL1, &ttbr0);
+    uc_reg_write(uc, UC_ARM64_REG_SCTLR_EL1, &sctlr);
+    uc_reg_write(uc, UC_ARM64_REG_PSTATE, &pstate);
+
+    // full walks for the code page and the first data page only
+    failed |= run(uc, "first", 0, 0, 0, 16, 15, 2);
+    // the other address space has its own tables, the code page is global
+    failed |= run(uc, "second", 1, 1, 0, 16, 15, 1);
+    // switching back keeps the cached tables of both
+    failed |= run(uc, "first again", 0, 0, 16, 16, 16, 0);
+    failed |= run(uc, "second again", 1, 1, 16, 16, 16, 0);
+
+    // TLBI ASIDE1 only drops the tables of its ASID
+    failed |= tlbi(uc, CODE_ADDR + 0x20, ASID2 << 48);
+    failed |= run(uc, "other ASID", 0, 0, 32, 16, 16, 0);
+    failed |= run(uc, "ASID", 1, 1, 32, 16, 15, 1);
+
+    // switch the data region to another level 3 table, TLBI VAE1 of a page
+    // in it drops the old one
+    write_desc(uc, l2(0) + 8, l3_data(0, 1) | PTE_TABLE);
+    failed |= tlbi(uc, CODE_ADDR + 0x30, ASID1 << 48 | (DATA_VA >> 12));
+    failed |= run(uc, "VA", 0, 2, 48, 16, 15, 1);
+
+    // the TLB flush drops all
+    uc_tlb_flush(uc);
+    failed |= run(uc, "flushed", 0, 2, 64, 16, 15, 2);
+
+    uc_close(uc);
+
+    printf("%s\n", failed ? "FAILED" : "OK");
+    return failed;
+}
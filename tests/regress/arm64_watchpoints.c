@@ -0,0 +1,188 @@
+/*
+Stress test for callback watchpoints. Hundreds of small watchpoints on a few
+pages, overlapping ones and one over many pages must each be reported exactly
+for the accesses that touch them, and not at all once removed.
+*/
+
+#include <unicorn/unicorn.h>
+#include <stdio.h>
+
+#define CODE_ADDR  0x10000
+#define STORE_ADDR 0x10100
+#define DATA_ADDR  0x200000
+#define LARGE_ADDR 0x300000
+#define LARGE_SIZE 0x100000
+#define NUM_WPS    512
+#define STRIDE     0x40
+
+static const uint32_t loop[] = {
+    0xf9400002, // 10000: ldr  x2, [x0]
+    0xf9000002, // 10004: str  x2, [x0]
+    0x91010000, // 10008: add  x0, x0, #0x40
+    0xd1000421, // 1000c: sub  x1, x1, #1
+    0xb5ffff81, // 10010: cbnz x1, 10000
+    0x14000000, // 10014: b    10014
+};
+
+static const uint32_t store[] = {
+    0xf9000062, // 10100: str  x2, [x3]
+    0x14000000, // 10104: b    10104
+};
+
+static uc_engine *uc;
+static size_t calls, errors;
+static uint64_t last_addr, last_size;
+static bool last_write;
+
+static void hit(void *opaque, uint64_t addr, uint64_t size, uint64_t data,
+                bool iswr)
+{
+    calls++;
+    last_addr = addr;
+    last_size = size;
+    last_write = iswr;
+}
+
+// even slots are watched for reads, odd slots for writes
+static void check_loop_hit(void *opaque, uint64_t addr, uint64_t size,
+                           uint64_t data, bool iswr)
+{
+    if (addr != DATA_ADDR + calls * STRIDE || size != 8 ||
+        iswr != (calls & 1))
+        errors++;
+    calls++;
+}
+
+static int run_loop(void)
+{
+    uint64_t x0 = DATA_ADDR, x1 = NUM_WPS;
+    uc_err err;
+
+    calls = 0;
+    errors = 0;
+    uc_reg_write(uc, UC_ARM64_REG_X0, &x0);
+    uc_reg_write(uc, UC_ARM64_REG_X1, &x1);
+    err = uc_emu_start(uc, CODE_ADDR, 0, 0, NUM_WPS * 5);
+    if (err) {
+        printf("Failed on uc_emu_start() with error returned: %u\n", err);
+        return 1;
+    }
+    return 0;
+}
+
+static int run_store(uint64_t addr)
+{
+    uc_err err;
+
+    calls = 0;
+    uc_reg_write(uc, UC_ARM64_REG_X3, &addr);
+    err = uc_emu_start(uc, STORE_ADDR, 0, 0, 1);
+    if (err) {
+        printf("Failed on uc_emu_start() with error returned: %u\n", err);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    uc_err err;
+    int failed = 0;
+    int i;
+
+    err = uc_open("Cortex-A53", NULL, NULL, &uc);
+    if (err) {
+        printf("Failed on uc_open() with error returned: %u\n", err);
+        return 1;
+    }
+
+    uc_mem_map(uc, CODE_ADDR, 0x1000, UC_PROT_ALL);
+    uc_mem_write(uc, CODE_ADDR, loop, sizeof(loop));
+    uc_mem_write(uc, STORE_ADDR, store, sizeof(store));
+    uc_mem_map(uc, DATA_ADDR, NUM_WPS * STRIDE, UC_PROT_ALL);
+    uc_mem_map(uc, LARGE_ADDR, LARGE_SIZE, UC_PROT_ALL);
+
+    // one read or write watchpoint per slot, the accesses in between miss
+    uc_cbwatchpoint_setup(uc, NULL, check_loop_hit);
+    for (i = 0; i < NUM_WPS; i++) {
+        if (uc_cbwatchpoint_insert(uc, DATA_ADDR + i * STRIDE, 8,
+                                   i & 1 ? UC_WP_WRITE : UC_WP_READ)) {
+            printf("Failed on uc_cbwatchpoint_insert()\n");
+            return 1;
+        }
+    }
+    if (run_loop())
+        return 1;
+    if (calls != NUM_WPS || errors) {
+        printf("loop: %zu calls, %zu errors\n", calls, errors);
+        failed = 1;
+    }
+
+    uc_cbwatchpoint_setup(uc, NULL, hit);
+
+    // overlapping watchpoints are both reported
+    uc_cbwatchpoint_insert(uc, DATA_ADDR + STRIDE, 16, UC_WP_WRITE);
+    if (run_store(DATA_ADDR + STRIDE))
+        return 1;
+    if (calls != 2) {
+        printf("overlap: %zu calls\n", calls);
+        failed = 1;
+    }
+    uc_cbwatchpoint_remove(uc, DATA_ADDR + STRIDE, 16, UC_WP_WRITE);
+
+    // a watchpoint over many pages
+    uc_cbwatchpoint_insert(uc, LARGE_ADDR, LARGE_SIZE, UC_WP_WRITE);
+    if (run_store(LARGE_ADDR + LARGE_SIZE / 2 + 8))
+        return 1;
+    if (calls != 1 || last_addr != LARGE_ADDR || last_size != LARGE_SIZE ||
+        !last_write) {
+        printf("large: %zu calls, 0x%llx\n", calls,
+               (unsigned long long)last_addr);
+        failed = 1;
+    }
+    uc_cbwatchpoint_remove(uc, LARGE_ADDR, LARGE_SIZE, UC_WP_WRITE);
+    if (run_store(LARGE_ADDR + LARGE_SIZE / 2 + 8))
+        return 1;
+    if (calls != 0) {
+        printf("large removed: %zu calls\n", calls);
+        failed = 1;
+    }
+
+    // one watchpoint removed among the others
+    uc_cbwatchpoint_remove(uc, DATA_ADDR + 3 * STRIDE, 8, UC_WP_WRITE);
+    if (run_store(DATA_ADDR + 3 * STRIDE))
+        return 1;
+    if (calls != 0) {
+        printf("removed: %zu calls\n", calls);
+        failed = 1;
+    }
+    if (run_store(DATA_ADDR + 5 * STRIDE))
+        return 1;
+    if (calls != 1 || last_addr != DATA_ADDR + 5 * STRIDE) {
+        printf("neighbour: %zu calls\n", calls);
+        failed = 1;
+    }
+    if (uc_cbwatchpoint_remove(uc, DATA_ADDR + 3 * STRIDE, 8,
+                               UC_WP_WRITE) != UC_ERR_ARG) {
+        printf("removed twice\n");
+        failed = 1;
+    }
+
+    // nothing is reported once all are removed
+    for (i = 0; i < NUM_WPS; i++) {
+        if (i != 3)
+            uc_cbwatchpoint_remove(uc, DATA_ADDR + i * STRIDE, 8,
+                                   i & 1 ? UC_WP_WRITE : UC_WP_READ);
+    }
+    if (run_loop())
+        return 1;
+    if (calls != 0) {
+        printf("all removed: %zu calls\n", calls);
+        failed = 1;
+    }
+
+    uc_close(uc);
+
+    printf("%s\n", failed ? "FAILED" : "OK");
+    return failed;
+}
@@ -0,0 +1,134 @@
+/*
+Test for the condition flags across conditional branches inside a TB.
+Conditionally executed A32 instructions branch within the TB, the flags
+and registers they leave behind must be right whether the TB runs to its
+end or stops after any of its instructions.
+*/
+
+#include <unicorn/unicorn.h>
+#include <stdio.h>
+#include <string.h>
+
+#define CODE_ADDR 0x10000
+
+static const uint32_t code[] = {
+    0xe3a00000, // 10000: mov    r0, #0
+    0xe3a01000, // 10004: mov    r1, #0
+    0xe3a02000, // 10008: mov    r2, #0
+    0xe3a03000, // 1000c: mov    r3, #0
+    0xe3a04000, // 10010: mov    r4, #0
+    0xe2800001, // 10014: add    r0, r0, #1
+    0xe3100001, // 10018: tst    r0, #1
+    0x10811000, // 1001c: addne  r1, r1, r0
+    0x00822000, // 10020: addeq  r2, r2, r0
+    0xe3500007, // 10024: cmp    r0, #7
+    0xc2503009, // 10028: subsgt r3, r0, #9
+    0x41a04000, // 1002c: movmi  r4, r0
+    0x52944001, // 10030: addspl r4, r4, #1
+    0xe350000c, // 10034: cmp    r0, #12
+    0x1afffff5, // 10038: bne    10014
+};
+
+#define NUM_INSNS (5 + 12 * 10)
+
+static const int regs[] = {
+    UC_ARM_REG_R0, UC_ARM_REG_R1, UC_ARM_REG_R2, UC_ARM_REG_R3,
+    UC_ARM_REG_R4, UC_ARM_REG_PC, UC_ARM_REG_CPSR,
+};
+
+#define NUM_REGS (sizeof(regs) / sizeof(regs[0]))
+
+static uint32_t states[NUM_INSNS + 1][NUM_REGS];
+
+static const char* config(void *opaque, const char *name)
+{
+    return strcmp(name, "exactbudget") == 0 ? "1" : NULL;
+}
+
+static void read_state(uc_engine *uc, uint32_t *state)
+{
+    size_t i;
+
+    for (i = 0; i < NUM_REGS; i++)
+        uc_reg_read(uc, regs[i], &state[i]);
+    state[NUM_REGS - 1] &= 0xf0000000; // NZCV
+}
+
+static int run(uc_engine *uc, size_t count, uint32_t *state)
+{
+    uint32_t zero = 0, cpsr;
+    uc_err err;
+    size_t i;
+
+    for (i = 0; i < NUM_REGS - 2; i++)
+        uc_reg_write(uc, regs[i], &zero);
+    uc_reg_read(uc, UC_ARM_REG_CPSR, &cpsr);
+    cpsr &= 0x0fffffff;
+    uc_reg_write(uc, UC_ARM_REG_CPSR, &cpsr);
+    err = uc_emu_start(uc, CODE_ADDR, 0, 0, count);
+    if (err) {
+        printf("Failed on uc_emu_start() with error returned: %u\n", err);
+        return 1;
+    }
+    read_state(uc, state);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    static const uint32_t final[NUM_REGS] = {
+        12, 36, 42, 3, 12, CODE_ADDR + sizeof(code), 0x60000000,
+    };
+    uint32_t state[NUM_REGS], pc;
+    uc_engine *uc;
+    uc_err err;
+    int failed = 0;
+    size_t i, j;
+
+    err = uc_open("Cortex-A15", NULL, config, &uc);
+    if (err) {
+        printf("Failed on uc_open() with error returned: %u\n", err);
+        return 1;
+    }
+
+    uc_mem_map(uc, CODE_ADDR, 0x1000, UC_PROT_ALL);
+    uc_mem_write(uc, CODE_ADDR, code, sizeof(code));
+
+    // reference states, one instruction per call
+    if (run(uc, 1, states[1]))
+        return 1;
+    for (i = 2; i <= NUM_INSNS; i++) {
+        uc_reg_read(uc, UC_ARM_REG_PC, &pc);
+        err = uc_emu_start(uc, pc, 0, 0, 1);
+        if (err) {
+            printf("Failed on uc_emu_start() with error returned: %u\n", err);
+            return 1;
+        }
+        read_state(uc, states[i]);
+    }
+    if (memcmp(states[NUM_INSNS], final, sizeof(final)) != 0) {
+        printf("single stepping ended with r0-r4 %u %u %u %u %u\n",
+               states[NUM_INSNS][0], states[NUM_INSNS][1],
+               states[NUM_INSNS][2], states[NUM_INSNS][3],
+               states[NUM_INSNS][4]);
+        failed = 1;
+    }
+
+    // whole blocks stopping after every instruction
+    for (i = 1; i <= NUM_INSNS; i++) {
+        if (run(uc, i, state))
+            return 1;
+        for (j = 0; j < NUM_REGS; j++) {
+            if (state[j] != states[i][j]) {
+                printf("after %zu instructions reg %zu is 0x%x, "
+                       "expected 0x%x\n", i, j, state[j], states[i][j]);
+                failed = 1;
+            }
+        }
+    }
+
+    uc_close(uc);
+
+    printf("%s\n", failed ? "FAILED" : "OK");
+    return failed;
+}
@@ -20,3 +20,26 @@
 ./mips_kseg0_1
 ./mem_double_unmap
 
+./arm64_exact_budget
+./arm64_single_step
+./arm64_timeout
+./arm64_multi_cpu
+./arm64_tb_group
+./arm64_tb_profile
+./arm64_tlb_stats
+./arm64_tlb_asid
+./arm64_dmi_invalidate
+./arm64_tlb_batch
+./arm64_callout_pc
+./arm_cond_flags
+./arm64_bb_trace
+./arm64_mem_trace
+./arm64_hooks
+./arm64_breakpoints
+./arm64_watchpoints
+./arm64_mem_map
+./arm64_dmi_grant
+./arm64_dmi_walk
+./arm64_walk_cache
+./arm64_large_page
+./arm64_hflags
@@ -33,6 +33,7 @@ static void helper_tlb_cluster_flush(CPUState* cpu) {
         uc_tlb_flush(uc);
     } else {
         uc->uc_tlb_cluster_flush(uc->uc_tlb_cluster_opaque);
+        uc->tlb_broadcast_pending = true;
     }
 }
 
@@ -43,6 +44,7 @@ static void helper_tlb_cluster_flush_page(CPUState* cpu, uint64_t addr) {
         uc_tlb_flush_page(uc, addr);
     } else {
         uc->uc_tlb_cluster_flush_page(uc->uc_tlb_cluster_opaque, addr);
+        uc->tlb_broadcast_pending = true;
     }
 }
 
@@ -53,6 +55,7 @@ static void helper_tlb_cluster_flush_mmuidx(CPUState* cpu, uint16_t idxmap) {
         uc_tlb_flush_mmuidx(uc, idxmap);
     } else {
         uc->uc_tlb_cluster_flush_mmuidx(uc->uc_tlb_cluster_opaque, idxmap);
+        uc->tlb_broadcast_pending = true;
     }
 }
 
@@ -63,9 +66,44 @@ static void helper_tlb_cluster_flush_page_mmuidx(CPUState* cpu, uint64_t addr, u
         uc_tlb_flush_page_mmuidx(uc, addr, idxmap);
     } else {
         uc->uc_tlb_cluster_flush_page_mmuidx(uc->uc_tlb_cluster_opaque, addr, idxmap);
+        uc->tlb_broadcast_pending = true;
     }
 }
 
+// SNPS added: clusters that can't invalidate by ASID are flushed entirely
+static void helper_tlb_cluster_flush_asid_mmuidx(CPUState* cpu, uint32_t asid, uint16_t idxmap) {
+    uc_engine *uc = cpu->uc;
+    if (uc->uc_tlb_cluster_flush_asid_mmuidx) {
+        uc->uc_tlb_cluster_flush_asid_mmuidx(uc->uc_tlb_cluster_opaque, asid, idxmap);
+        uc->tlb_broadcast_pending = true;
+    } else if (uc->uc_tlb_cluster_flush_mmuidx) {
+        uc->uc_tlb_cluster_flush_mmuidx(uc->uc_tlb_cluster_opaque, idxmap);
+        uc->tlb_broadcast_pending = true;
+    } else {
+        uc_tlb_flush_asid_mmuidx(uc, asid, idxmap);
+    }
+}
+
+// SNPS added: a DSB waits for the broadcasts issued before it, then applies
+// the shootdowns queued for this engine
+static void helper_tlb_cluster_sync(CPUState* cpu) {
+    uc_engine *uc = cpu->uc;
+    if (uc->tlb_broadcast_pending) {
+        uc->tlb_broadcast_pending = false;
+        if (uc->uc_tlb_cluster_sync)
+            uc->uc_tlb_cluster_sync(uc->uc_tlb_cluster_opaque);
+    }
+    if (uc->tlb_batch && atomic_read(&uc->tlb_batch->pending))
+        uc->tlb_batch_apply(uc);
+}
+
+static void tlb_batch_apply(uc_engine *uc);
+static void bb_trace_stop(uc_engine *uc); // SNPS added
+static void bb_trace_free(uc_bb_trace_t *trace); // SNPS added
+static void bb_trace_set(uc_engine *uc, uc_bb_trace_t *trace); // SNPS added
+static void mem_trace_stop(uc_engine *uc); // SNPS added
+static void hooks_changed(uc_engine *uc, struct hook *hook); // SNPS added
+
 static void free_table(gpointer key, gpointer value, gpointer data)
 {
     TypeInfo *ti = (TypeInfo*) value;
@@ -215,11 +253,120 @@ static size_t parse_tbsz(const char* tbsz) {
     return sz;
 }
 
+// SNPS added
+static int parse_cpus(const char* str) {
+    char* postfix = NULL;
+    long n = strtol(str, &postfix, 10);
+
+    if (n < 1 || n > UC_MAX_CPUS || *postfix != '\0') {
+        if (strlen(str) > 0) {
+            fprintf(stderr, "[QEMU TCG] failed to parse '%s' using 1 cpu\n",
+                    str);
+        }
+        return 1;
+    }
+
+    return (int)n;
+}
+
+// SNPS added
+static bool parse_bool(const char* str) {
+    return !strcmp(str, "1") || !strcmp(str, "true") || !strcmp(str, "yes") ||
+           !strcmp(str, "on");
+}
+
+// SNPS added: translation sharing groups by name ("tbgroup" config)
+static QemuMutex tb_group_lock = QEMU_MUTEX_INITIALIZER;
+static QLIST_HEAD(, uc_tb_group) tb_groups = QLIST_HEAD_INITIALIZER(tb_groups);
+
+// SNPS added: engines only share TBs if they translate code the same way
+static uc_err tb_group_join(uc_engine *uc, const char *name)
+{
+    uc_tb_group *group;
+    uc_err err = UC_ERR_OK;
+
+    qemu_mutex_lock(&tb_group_lock);
+    QLIST_FOREACH(group, &tb_groups, entry) {
+        if (strcmp(group->name, name) == 0)
+            break;
+    }
+
+    if (group == NULL) {
+        group = calloc(1, sizeof(*group));
+        if (group == NULL) {
+            qemu_mutex_unlock(&tb_group_lock);
+            return UC_ERR_NOMEM;
+        }
+        snprintf(group->name, sizeof(group->name), "%s", name);
+        snprintf(group->model, sizeof(group->model), "%s", uc->model);
+        group->exact_budget = uc->exact_budget;
+        qemu_mutex_init(&group->lock);
+        QLIST_INSERT_HEAD(&tb_groups, group, entry);
+    } else if (strcmp(group->model, uc->model) != 0 ||
+               group->exact_budget != uc->exact_budget) {
+        err = UC_ERR_ARG;
+    }
+
+    if (err == UC_ERR_OK) {
+        group->refs++;
+        uc->tb_group = group;
+    }
+    qemu_mutex_unlock(&tb_group_lock);
+
+    return err;
+}
+
+// SNPS added: returns true if uc was the last engine of its group, which
+// then can no longer be joined. Called with the group lock held.
+static bool tb_group_leave(uc_engine *uc)
+{
+    uc_tb_group *group = uc->tb_group;
+    bool last;
+
+    qemu_mutex_lock(&tb_group_lock);
+    if (uc->tcg_ctx != NULL)
+        QLIST_REMOVE(uc, tb_group_entry);
+    last = --group->refs == 0;
+    if (last)
+        QLIST_REMOVE(group, entry);
+    qemu_mutex_unlock(&tb_group_lock);
+
+    return last;
+}
+
+// SNPS added: release what uc_open() set up before it failed, the way
+// uc_close() does
+static uc_err open_failed(uc_engine *uc, uc_err err)
+{
+    uc_tb_group *group = uc->tb_group;
+    bool last;
+
+    if (group) {
+        uc_tb_group_lock(uc);
+        last = tb_group_leave(uc);
+        uc_tb_group_unlock(uc);
+        if (last) {
+            qemu_mutex_destroy(&group->lock);
+            free(group);
+        }
+    }
+    if (uc->tlb_batch) {
+        qemu_mutex_destroy(&uc->tlb_batch->lock);
+        g_free(uc->tlb_batch);
+    }
+    free(uc->tb_profile_path);
+    free(uc->cpus);
+    free(uc);
+
+    return err;
+}
+
 UNICORN_EXPORT
 uc_err uc_open(const char* model, void *cfg_opaque, uc_get_config_t cfg_func,
                uc_engine **result) // SNPS changed
 {
     struct uc_struct *uc;
+    int i;
 
     // SNPS added
     uc_arch arch = UC_ARCH_MAX;
@@ -293,6 +440,21 @@ uc_err uc_open(const char* model, void *cfg_opaque, uc_get_config_t cfg_func,
         const char* tbsz = uc_get_config(uc, "tbsize");
         uc->tb_size = parse_tbsz(tbsz);
 
+        const char* exact = uc_get_config(uc, "exactbudget");
+        uc->exact_budget = parse_bool(exact);
+
+        const char* cpus = uc_get_config(uc, "cpus");
+        uc->smp_cpus = parse_cpus(cpus);
+        uc->cpus = calloc(uc->smp_cpus, sizeof(*uc->cpus));
+        if (!uc->cpus) {
+            free(uc);
+            return UC_ERR_NOMEM;
+        }
+
+        const char* profile = uc_get_config(uc, "tbprofile");
+        if (*profile)
+            uc->tb_profile_path = strdup(profile);
+
         switch (arch) {
         case UC_ARCH_ARM:
         case UC_ARCH_ARM64:
@@ -302,7 +464,7 @@ uc_err uc_open(const char* model, void *cfg_opaque, uc_get_config_t cfg_func,
             snprintf(uc->model, sizeof(uc->model), "%s-riscv-cpu", model);
             break;
         default:
-            return UC_ERR_ARCH;
+            return open_failed(uc, UC_ERR_ARCH); // SNPS changed
         }
 
         // SNPS added end
@@ -329,12 +491,17 @@ uc_err uc_open(const char* model, void *cfg_opaque, uc_get_config_t cfg_func,
         uc->uc_tlb_cluster_flush_page = NULL; // SNPS added
         uc->uc_tlb_cluster_flush_mmuidx = NULL; // SNPS added
         uc->uc_tlb_cluster_flush_page_mmuidx = NULL; // SNPS added
+        uc->uc_tlb_cluster_flush_asid_mmuidx = NULL; // SNPS added
+        uc->uc_tlb_cluster_sync = NULL; // SNPS added
         uc->uc_tlb_cluster_opaque = NULL; // SNPS added
 
         uc->tlb_cluster_flush = helper_tlb_cluster_flush; // SNPS added
         uc->tlb_cluster_flush_page = helper_tlb_cluster_flush_page; // SNPS added
         uc->tlb_cluster_flush_mmuidx = helper_tlb_cluster_flush_mmuidx; // SNPS added
         uc->tlb_cluster_flush_page_mmuidx = helper_tlb_cluster_flush_page_mmuidx; // SNPS added
+        uc->tlb_cluster_flush_asid_mmuidx = helper_tlb_cluster_flush_asid_mmuidx; // SNPS added
+        uc->tlb_cluster_sync = helper_tlb_cluster_sync; // SNPS added
+        uc->tlb_batch_apply = tlb_batch_apply; // SNPS added
 
         uc->uc_breakpoint_func = NULL; // SNPS added
         uc->uc_breakpoint_opaque = NULL; // SNPS added
@@ -363,8 +530,7 @@ uc_err uc_open(const char* model, void *cfg_opaque, uc_get_config_t cfg_func,
             case UC_ARCH_M68K:
                 if ((mode & ~UC_MODE_M68K_MASK) ||
                         !(mode & UC_MODE_BIG_ENDIAN)) {
-                    free(uc);
-                    return UC_ERR_MODE;
+                    return open_failed(uc, UC_ERR_MODE); // SNPS changed
                 }
                 uc->init_arch = m68k_uc_init;
                 break;
@@ -374,8 +540,7 @@ uc_err uc_open(const char* model, void *cfg_opaque, uc_get_config_t cfg_func,
                 if ((mode & ~UC_MODE_X86_MASK) ||
                         (mode & UC_MODE_BIG_ENDIAN) ||
                         !(mode & (UC_MODE_16|UC_MODE_32|UC_MODE_64))) {
-                    free(uc);
-                    return UC_ERR_MODE;
+                    return open_failed(uc, UC_ERR_MODE); // SNPS changed
                 }
                 uc->init_arch = x86_uc_init;
                 break;
@@ -383,8 +548,7 @@ uc_err uc_open(const char* model, void *cfg_opaque, uc_get_config_t cfg_func,
 #ifdef UNICORN_HAS_ARM
             case UC_ARCH_ARM:
                 if ((mode & ~UC_MODE_ARM_MASK)) {
-                    free(uc);
-                    return UC_ERR_MODE;
+                    return open_failed(uc, UC_ERR_MODE); // SNPS changed
                 }
                 if (mode & UC_MODE_BIG_ENDIAN) {
                     assert(0 && "UC_MODE_BIG_ENDIAN not supported"); // SNPS changed
@@ -399,8 +563,7 @@ uc_err uc_open(const char* model, void *cfg_opaque, uc_get_config_t cfg_func,
 #ifdef UNICORN_HAS_ARM64
             case UC_ARCH_ARM64:
                 if (mode & ~UC_MODE_ARM_MASK) {
-                    free(uc);
-                    return UC_ERR_MODE;
+                    return open_failed(uc, UC_ERR_MODE); // SNPS changed
                 }
                 if (mode & UC_MODE_BIG_ENDIAN) {
                     assert(0 && "UC_MODE_BIG_ENDIAN not supported"); // SNPS changed
@@ -414,8 +577,7 @@ uc_err uc_open(const char* model, void *cfg_opaque, uc_get_config_t cfg_func,
             case UC_ARCH_MIPS:
                 if ((mode & ~UC_MODE_MIPS_MASK) ||
                         !(mode & (UC_MODE_MIPS32|UC_MODE_MIPS64))) {
-                    free(uc);
-                    return UC_ERR_MODE;
+                    return open_failed(uc, UC_ERR_MODE); // SNPS changed
                 }
                 if (mode & UC_MODE_BIG_ENDIAN) {
 #ifdef UNICORN_HAS_MIPS
@@ -442,8 +604,7 @@ uc_err uc_open(const char* model, void *cfg_opaque, uc_get_config_t cfg_func,
 #ifdef UNICORN_HAS_RISCV
             case UC_ARCH_RISCV:
                 if (mode & ~UC_MODE_RISCV_MASK) {
-                    free(uc);
-                    return UC_ERR_MODE;
+                    return open_failed(uc, UC_ERR_MODE); // SNPS changed
                 }
                 if (mode & UC_MODE_RISCV64) {
 #ifdef UNICORN_HAS_RISCV64
@@ -462,8 +623,7 @@ uc_err uc_open(const char* model, void *cfg_opaque, uc_get_config_t cfg_func,
                 if ((mode & ~UC_MODE_SPARC_MASK) ||
                         !(mode & UC_MODE_BIG_ENDIAN) ||
                         !(mode & (UC_MODE_SPARC32|UC_MODE_SPARC64))) {
-                    free(uc);
-                    return UC_ERR_MODE;
+                    return open_failed(uc, UC_ERR_MODE); // SNPS changed
                 }
                 if (mode & UC_MODE_SPARC64)
                     uc->init_arch = sparc64_uc_init;
@@ -474,17 +634,36 @@ uc_err uc_open(const char* model, void *cfg_opaque, uc_get_config_t cfg_func,
         }
 
         if (uc->init_arch == NULL) {
-            return UC_ERR_ARCH;
+            return open_failed(uc, UC_ERR_ARCH); // SNPS changed
+        }
+
+        // SNPS added
+        const char* tbgroup = uc_get_config(uc, "tbgroup");
+        if (*tbgroup) {
+            uc_err err = tb_group_join(uc, tbgroup);
+            if (err)
+                return open_failed(uc, err);
+        }
+
+        // SNPS added
+        const char* tlbbatch = uc_get_config(uc, "tlbbatch");
+        if (parse_bool(tlbbatch)) {
+            uc->tlb_batch = g_new0(uc_tlb_batch_t, 1);
+            qemu_mutex_init(&uc->tlb_batch->lock);
         }
 
         if (machine_initialize(uc)) {
-            return UC_ERR_RESOURCE;
+            return open_failed(uc, UC_ERR_RESOURCE); // SNPS changed
         }
 
         *result = uc;
 
-        if (uc->reg_reset)
-            uc->reg_reset(uc);
+        // SNPS changed: reset all vCPUs, then select the first one
+        for (i = uc->num_cpus - 1; i >= 0; i--) {
+            uc->cpu = uc->cpus[i];
+            if (uc->reg_reset)
+                uc->reg_reset(uc);
+        }
 
         return UC_ERR_OK;
     } else {
@@ -512,6 +691,13 @@ static void free_hooks(uc_engine *uc)
         }
         list_clear(&uc->hook[i]);
     }
+
+    // SNPS added
+    for (cur = uc->hooks_to_del.head; cur; cur = cur->next)
+        free(cur->data);
+    list_clear(&uc->hooks_to_del);
+    if (uc->hook_lists)
+        g_hash_table_destroy(uc->hook_lists);
 }
 
 // SNPS added
@@ -529,24 +715,69 @@ static void free_mmios(uc_engine *uc)
 static void free_breakpoints(uc_engine *uc)
 {
     CPUBreakpoint *bp, *next;
+    int i;
 
-    QTAILQ_FOREACH_SAFE(bp, &uc->cpu->breakpoints, entry, next) {
-        QTAILQ_REMOVE(&uc->cpu->breakpoints, bp, entry);
-        g_free(bp);
+    for (i = 0; i < uc->num_cpus; i++) { // SNPS changed
+        CPUState *cpu = uc->cpus[i];
+        QTAILQ_FOREACH_SAFE(bp, &cpu->breakpoints, entry, next) {
+            QTAILQ_REMOVE(&cpu->breakpoints, bp, entry);
+            g_free(bp);
+        }
     }
 }
 
 UNICORN_EXPORT
 uc_err uc_close(uc_engine *uc)
 {
+    int i;
+    uc_tb_group *group = uc->tb_group; // SNPS added
+    bool last = true; // SNPS added
+
+    // SNPS added
+    if (uc->bb_trace) {
+        bb_trace_free(uc->bb_trace);
+        uc->bb_trace = NULL;
+    }
+    free(uc->mem_trace);
+    free(uc->mem_trace_ranges);
+
+    // SNPS added
+    if (uc->tb_profile_path) {
+        uc_tb_profile_save(uc, uc->tb_profile_path);
+        free(uc->tb_profile_path);
+        free(uc->tb_profile);
+    }
+
+    // SNPS changed: the last engine of a sharing group releases the shared
+    // translation context, the others only their own resources
+    uc_tb_group_lock(uc);
+    if (group) {
+        last = tb_group_leave(uc);
+        uc->tcg_exec_attach(uc);
+    }
+
     // Cleanup internally.
     if (uc->release)
         uc->release(uc->tcg_ctx);
-    g_free(uc->tcg_ctx);
+    if (last) {
+        g_free(uc->tcg_ctx);
+    } else {
+        uc->l1_map = NULL;
+    }
+
+    uc_tb_group_unlock(uc);
+    if (group && last) {
+        qemu_mutex_destroy(&group->lock);
+        free(group);
+    }
+    uc->tb_group = NULL;
 
     // Cleanup CPU.
-    g_free(uc->cpu->cpu_ases);
-    g_free(uc->cpu->thread);
+    for (i = 0; i < uc->num_cpus; i++) { // SNPS changed
+        g_free(uc->cpus[i]->cpu_ases);
+        g_free(uc->cpus[i]->thread);
+        g_free(uc->cpus[i]->mem_trace_discard); // SNPS added
+    }
 
     // Cleanup all objects.
     free_breakpoints(uc);
@@ -558,7 +789,8 @@ uc_err uc_close(uc_engine *uc)
 
     object_unref(uc, OBJECT(uc->machine_state->accelerator));
     object_unref(uc, OBJECT(uc->machine_state));
-    object_unref(uc, OBJECT(uc->cpu));
+    for (i = 0; i < uc->num_cpus; i++) // SNPS changed
+        object_unref(uc, OBJECT(uc->cpus[i]));
 
     // SNPS disabled
     //object_unref(uc, OBJECT(&uc->io_mem_notdirty));
@@ -586,6 +818,15 @@ uc_err uc_close(uc_engine *uc)
     free_hooks(uc);
     free_mmios(uc); // SNPS added
     free(uc->mapped_blocks);
+    free(uc->mapped_sorted); // SNPS added
+    g_free(uc->dmi_grants); // SNPS added
+    free(uc->cpus); // SNPS added
+
+    // SNPS added
+    if (uc->tlb_batch) {
+        qemu_mutex_destroy(&uc->tlb_batch->lock);
+        g_free(uc->tlb_batch);
+    }
 
     // finally, free uc itself.
     memset(uc, 0, sizeof(*uc));
@@ -598,6 +839,10 @@ uc_err uc_close(uc_engine *uc)
 UNICORN_EXPORT
 uc_err uc_reg_read_batch(uc_engine *uc, int *ids, void **vals, int count)
 {
+    // SNPS added: the PC is not stored before loads and stores
+    if (uc->cpu && uc->restore_callout_pc)
+        uc->restore_callout_pc(uc->cpu);
+
     if (uc->reg_read &&
         uc->reg_read(uc, (unsigned int *)ids, vals, count) == 0)
         return UC_ERR_OK;
@@ -731,24 +976,39 @@ uc_err uc_mem_write(uc_engine *uc, uint64_t address, const void *_bytes, size_t
         return UC_ERR_WRITE_UNMAPPED;
 }
 
-#define TIMEOUT_STEP 2    // microseconds
+// SNPS changed: a single timer thread serves the timeouts of all engines.
+// Armed engines are kept in timer_list, the thread sleeps until the earliest
+// deadline (timer_next) and is only woken up when an earlier one is armed.
+static QemuMutex timer_lock = QEMU_MUTEX_INITIALIZER;
+static QemuCond timer_cond = QEMU_COND_INITIALIZER;
+static QLIST_HEAD(, uc_struct) timer_list = QLIST_HEAD_INITIALIZER(timer_list);
+static int64_t timer_next = INT64_MAX;
+static bool timer_started;
+
 static void *_timeout_fn(void *arg)
 {
-    struct uc_struct *uc = arg;
-    int64_t current_time = get_clock();
-
-    do {
-        usleep(TIMEOUT_STEP);
-        // perhaps emulation is even done before timeout?
-        if (uc->emulation_done)
-            break;
-    } while((uint64_t)(get_clock() - current_time) < uc->timeout);
+    qemu_mutex_lock(&timer_lock);
+    for (;;) {
+        int64_t now = get_clock();
+        uc_engine *uc, *next;
+
+        timer_next = INT64_MAX;
+        QLIST_FOREACH_SAFE(uc, &timer_list, timer_entry, next) {
+            if (uc->deadline <= now) {
+                // timeout before emulation is done, force emulation to stop
+                QLIST_REMOVE(uc, timer_entry);
+                uc->deadline = 0;
+                uc->timed_out = true;
+                uc_emu_stop(uc);
+            } else if (uc->deadline < timer_next) {
+                timer_next = uc->deadline;
+            }
+        }
 
-    // timeout before emulation is done?
-    if (!uc->emulation_done) {
-        uc->timed_out = true;
-        // force emulation to stop
-        uc_emu_stop(uc);
+        if (timer_next == INT64_MAX)
+            qemu_cond_wait(&timer_cond, &timer_lock);
+        else
+            qemu_cond_timedwait(&timer_cond, &timer_lock, timer_next - now);
     }
 
     return NULL;
@@ -756,28 +1016,47 @@ static void *_timeout_fn(void *arg)
 
 static void enable_emu_timer(uc_engine *uc, uint64_t timeout)
 {
-    uc->timeout = timeout;
-    qemu_thread_create(uc, &uc->timer, "timeout", _timeout_fn,
-            uc, QEMU_THREAD_JOINABLE);
+    qemu_mutex_lock(&timer_lock);
+    if (!timer_started) {
+        QemuThread thread;
+        qemu_thread_create(uc, &thread, "timeout", _timeout_fn,
+                NULL, QEMU_THREAD_DETACHED);
+        timer_started = true;
+    }
+
+    uc->deadline = get_clock() + timeout;
+    QLIST_INSERT_HEAD(&timer_list, uc, timer_entry);
+    if (uc->deadline < timer_next) {
+        timer_next = uc->deadline;
+        qemu_cond_signal(&timer_cond);
+    }
+    qemu_mutex_unlock(&timer_lock);
 }
 
-static void hook_count_cb(struct uc_struct *uc, uint64_t address, uint32_t size, void *user_data)
+static void disable_emu_timer(uc_engine *uc)
 {
-    // count this instruction. ah ah ah.
-    uc->emu_counter++;
-
-    if (uc->emu_counter > uc->emu_count)
-        uc_emu_stop(uc);
+    qemu_mutex_lock(&timer_lock);
+    if (uc->deadline) {
+        // the timer thread may still wake up for this deadline, it just
+        // finds nothing to do
+        QLIST_REMOVE(uc, timer_entry);
+        uc->deadline = 0;
+    }
+    qemu_mutex_unlock(&timer_lock);
 }
 
 UNICORN_EXPORT
 uc_err uc_emu_start(uc_engine* uc, uint64_t begin, uint64_t until, uint64_t timeout, size_t count)
 {
+    if (uc->mem_map_batch) // SNPS added
+        return UC_ERR_ARG;
+
     // reset the counter
     uc->emu_counter = 0;
     uc->invalid_error = UC_ERR_OK;
     uc->block_full = false;
     uc->emulation_done = false;
+    uc->timed_out = false; // SNPS added
     uc->parallel_cpus = true; // SNPS changed
 
     switch(uc->arch) {
@@ -843,44 +1122,41 @@ uc_err uc_emu_start(uc_engine* uc, uint64_t begin, uint64_t until, uint64_t time
 
     uc->stop_request = false;
 
+    // SNPS changed: counted down by the instruction budget (see tcg_exec_all)
     uc->emu_count = count;
-    // remove count hook if counting isn't necessary
-    if (count <= 0 && uc->count_hook != 0) {
-        uc_hook_del(uc, uc->count_hook);
-        uc->count_hook = 0;
-    }
-    // set up count hook to count instructions.
-    if (count > 0 && uc->count_hook == 0) {
-        uc_err err;
-        // callback to count instructions must be run before everything else,
-        // so instead of appending, we must insert the hook at the begin
-        // of the hook list
-        uc->hook_insert = 1;
-        err = uc_hook_add(uc, &uc->count_hook, UC_HOOK_CODE, hook_count_cb, NULL, 1, 0);
-        // restore to append mode for uc_hook_add()
-        uc->hook_insert = 0;
-        if (err != UC_ERR_OK) {
-            return err;
-        }
-    }
 
     uc->addr_end = until;
 
-    // SNPS added
-    uc->cpu->singlestep_enabled = (count == 1);
-
     if (uc->setup_once) {
         uc->setup_once(uc->cpu);
         uc->setup_once = NULL;
     }
 
+    // SNPS added: translate the blocks of the last run before starting
+    if (uc->tb_profile_path && !uc->tb_profile_loaded) {
+        uc->tb_profile_loaded = true;
+        uc_tb_profile_load(uc, uc->tb_profile_path, NULL);
+    }
+
+    // SNPS added: deliver the shootdowns received while stopped
+    if (uc->tlb_batch && atomic_read(&uc->tlb_batch->pending))
+        tlb_batch_apply(uc);
+
     if (timeout)
         enable_emu_timer(uc, timeout * 1000);   // microseconds -> nanoseconds
 
     // SNPS changed
+    uc_tb_group_lock(uc);
+    if (uc->tb_group)
+        uc->tcg_exec_attach(uc);
     uc->is_running = true;
     int res = uc->vm_start(uc);
     uc->is_running = false;
+    if (uc->hooks_changed) // SNPS added
+        uc_hooks_refresh(uc);
+    uc_tb_group_unlock(uc);
+    bb_trace_stop(uc); // SNPS added
+    mem_trace_stop(uc); // SNPS added
 
     if (res != 0)
         return UC_ERR_RESOURCE;
@@ -889,8 +1165,7 @@ uc_err uc_emu_start(uc_engine* uc, uint64_t begin, uint64_t until, uint64_t time
     uc->emulation_done = true;
 
     if (timeout) {
-        // wait for the timer to finish
-        qemu_thread_join(&uc->timer);
+        disable_emu_timer(uc);
     }
 
     if (uc->timed_out) {
@@ -905,6 +1180,45 @@ uc_err uc_emu_start(uc_engine* uc, uint64_t begin, uint64_t until, uint64_t time
 }
 
 
+// SNPS added
+UNICORN_EXPORT
+uc_err uc_emu_resume(uc_engine *uc, size_t count)
+{
+    int res;
+
+    if (uc == NULL || uc->is_running || uc->mem_map_batch)
+        return UC_ERR_ARG;
+
+    // continue from the current CPU state: no PC write (which would force a
+    // TB exit), no hook or timer setup, just a new instruction budget
+    uc->invalid_error = UC_ERR_OK;
+    uc->emulation_done = false;
+    uc->stop_request = false;
+    uc->emu_count = count;
+
+    uc_tb_group_lock(uc);
+    if (uc->tb_group)
+        uc->tcg_exec_attach(uc);
+    uc->is_running = true;
+    res = uc->vm_start(uc);
+    uc->is_running = false;
+    if (uc->hooks_changed)
+        uc_hooks_refresh(uc);
+    uc_tb_group_unlock(uc);
+    bb_trace_stop(uc);
+    mem_trace_stop(uc);
+
+    if (res != 0)
+        return UC_ERR_RESOURCE;
+
+    uc->emulation_done = true;
+
+    if (uc->invalid_error == UC_ERR_OK && uc->cpu->is_idle)
+        uc->invalid_error = UC_ERR_YIELD;
+
+    return uc->invalid_error;
+}
+
 UNICORN_EXPORT
 uc_err uc_emu_stop(uc_engine *uc)
 {
@@ -921,12 +1235,33 @@ uc_err uc_emu_stop(uc_engine *uc)
     return UC_ERR_OK;
 }
 
+// SNPS added: number of blocks in mapped_sorted starting at or below address
+static uint32_t mapped_block_upper(struct uc_struct *uc, uint64_t address)
+{
+    uint32_t lo = 0, hi = uc->mapped_block_count;
+
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (uc->mapped_sorted[mid]->addr <= address)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
 // find if a memory range overlaps with existing mapped regions
 static bool memory_overlap(struct uc_struct *uc, uint64_t begin, size_t size)
 {
     unsigned int i;
     uint64_t end = begin + size - 1;
 
+    // SNPS added: disjoint blocks, only the last one starting before end
+    if (!uc->mapped_overlap) {
+        i = mapped_block_upper(uc, end);
+        return i > 0 && uc->mapped_sorted[i - 1]->end - 1 >= begin;
+    }
+
     for(i = 0; i < uc->mapped_block_count; i++) {
         // begin address falls inside this region?
         if (begin >= uc->mapped_blocks[i]->addr && begin <= uc->mapped_blocks[i]->end - 1)
@@ -949,25 +1284,80 @@ static bool memory_overlap(struct uc_struct *uc, uint64_t begin, size_t size)
 static uc_err mem_map(uc_engine *uc, uint64_t address, size_t size, uint32_t perms, MemoryRegion *block)
 {
     MemoryRegion **regions;
+    uint32_t i, count = uc->mapped_block_count;
 
     if (block == NULL)
         return UC_ERR_NOMEM;
 
-    if ((uc->mapped_block_count & (MEM_BLOCK_INCR - 1)) == 0) {  //time to grow
+    if (count == uc->mapped_block_alloc) {  //time to grow
+        // SNPS changed: double the arrays
+        uint32_t alloc = count ? count * 2 : MEM_BLOCK_INCR;
         regions = (MemoryRegion**)g_realloc(uc->mapped_blocks,
-                sizeof(MemoryRegion*) * (uc->mapped_block_count + MEM_BLOCK_INCR));
+                sizeof(MemoryRegion*) * alloc);
         if (regions == NULL) {
             return UC_ERR_NOMEM;
         }
         uc->mapped_blocks = regions;
+        regions = (MemoryRegion**)g_realloc(uc->mapped_sorted,
+                sizeof(MemoryRegion*) * alloc);
+        if (regions == NULL) {
+            return UC_ERR_NOMEM;
+        }
+        uc->mapped_sorted = regions;
+        uc->mapped_block_alloc = alloc;
+    }
+
+    uc->mapped_blocks[count] = block;
+
+    // SNPS added: keep mapped_sorted sorted, and note blocks that overlap
+    i = mapped_block_upper(uc, block->addr);
+    memmove(&uc->mapped_sorted[i + 1], &uc->mapped_sorted[i],
+            sizeof(MemoryRegion*) * (count - i));
+    uc->mapped_sorted[i] = block;
+    if ((i > 0 && uc->mapped_sorted[i - 1]->end - 1 >= block->addr) ||
+        (i < count && block->end - 1 >= uc->mapped_sorted[i + 1]->addr)) {
+        uc->mapped_overlap = true;
     }
 
-    uc->mapped_blocks[uc->mapped_block_count] = block;
     uc->mapped_block_count++;
 
     return UC_ERR_OK;
 }
 
+// SNPS added
+bool memory_mapping_remove(struct uc_struct *uc, MemoryRegion *mr)
+{
+    uint32_t i;
+
+    for (i = 0; i < uc->mapped_block_count; i++) {
+        if (uc->mapped_blocks[i] == mr)
+            break;
+    }
+    if (i == uc->mapped_block_count)
+        return false;
+
+    uc->mapped_block_count--;
+    //shift remainder of array down over deleted pointer
+    memmove(&uc->mapped_blocks[i], &uc->mapped_blocks[i + 1],
+            sizeof(MemoryRegion*) * (uc->mapped_block_count - i));
+
+    for (i = 0; uc->mapped_sorted[i] != mr; i++) {
+    }
+    memmove(&uc->mapped_sorted[i], &uc->mapped_sorted[i + 1],
+            sizeof(MemoryRegion*) * (uc->mapped_block_count - i));
+    uc->mapped_block_cache_index = 0;
+
+    // blocks overlap if and only if neighbours in address order do
+    uc->mapped_overlap = false;
+    for (i = 1; i < uc->mapped_block_count; i++) {
+        if (uc->mapped_sorted[i - 1]->end - 1 >= uc->mapped_sorted[i]->addr) {
+            uc->mapped_overlap = true;
+            break;
+        }
+    }
+    return true;
+}
+
 static uc_err mem_map_check(uc_engine *uc, uint64_t address, size_t size, uint32_t perms)
 {
     if (size == 0)
@@ -1164,6 +1554,9 @@ uc_err uc_mem_protect(struct uc_struct *uc, uint64_t address, size_t size, uint3
         // trivial case, no change
         return UC_ERR_OK;
 
+    if (uc->mem_map_batch) // SNPS added
+        return UC_ERR_ARG;
+
     // address must be aligned to uc->target_page_size
     if ((address & uc->target_page_align) != 0)
         return UC_ERR_ARG;
@@ -1225,6 +1618,9 @@ uc_err uc_mem_unmap(struct uc_struct *uc, uint64_t address, size_t size)
         // nothing to unmap
         return UC_ERR_OK;
 
+    if (uc->mem_map_batch) // SNPS added
+        return UC_ERR_ARG;
+
     // address must be aligned to uc->target_page_size
     if ((address & uc->target_page_align) != 0)
         return UC_ERR_ARG;
@@ -1275,18 +1671,27 @@ MemoryRegion *memory_mapping(struct uc_struct* uc, uint64_t address)
         address = uc->mem_redirect(address);
     }
 
+    // SNPS added: overlapping blocks are found in mapping order
+    if (uc->mapped_overlap) {
+        for(i = 0; i < uc->mapped_block_count; i++) {
+            if (address >= uc->mapped_blocks[i]->addr && address <= uc->mapped_blocks[i]->end - 1)
+                return uc->mapped_blocks[i];
+        }
+        return NULL;
+    }
+
     // try with the cache index first
     i = uc->mapped_block_cache_index;
 
-    if (i < uc->mapped_block_count && address >= uc->mapped_blocks[i]->addr && address < uc->mapped_blocks[i]->end)
-        return uc->mapped_blocks[i];
+    if (i < uc->mapped_block_count && address >= uc->mapped_sorted[i]->addr && address < uc->mapped_sorted[i]->end)
+        return uc->mapped_sorted[i];
 
-    for(i = 0; i < uc->mapped_block_count; i++) {
-        if (address >= uc->mapped_blocks[i]->addr && address <= uc->mapped_blocks[i]->end - 1) {
-            // cache this index for the next query
-            uc->mapped_block_cache_index = i;
-            return uc->mapped_blocks[i];
-        }
+    // SNPS changed: binary search of mapped_sorted
+    i = mapped_block_upper(uc, address);
+    if (i > 0 && address <= uc->mapped_sorted[i - 1]->end - 1) {
+        // cache this index for the next query
+        uc->mapped_block_cache_index = i - 1;
+        return uc->mapped_sorted[i - 1];
     }
 
     // not found
@@ -1373,6 +1778,8 @@ uc_err uc_hook_add(uc_engine *uc, uc_hook *hh, int type, void *callback,
     // TODO: return an error?
     if (hook->refs == 0) {
         free(hook);
+    } else if (type & UC_HOOK_RESOLVED) {
+        hooks_changed(uc, hook); // SNPS added
     }
 
     return ret;
@@ -1391,7 +1798,15 @@ uc_err uc_hook_del(uc_engine *uc, uc_hook hh)
     for (i = 0; i < UC_HOOK_MAX; i++) {
         if (list_remove(&uc->hook[i], (void *)hook)) {
             if (--hook->refs == 0) {
-                free(hook);
+                // SNPS changed: translated code and TLB entries may still
+                // call it, free it along with them
+                if (hook->type & UC_HOOK_RESOLVED) {
+                    hook->to_delete = true;
+                    list_append(&uc->hooks_to_del, hook);
+                    hooks_changed(uc, hook);
+                } else {
+                    free(hook);
+                }
                 break;
             }
         }
@@ -1399,26 +1814,223 @@ uc_err uc_hook_del(uc_engine *uc, uc_hook hh)
     return UC_ERR_OK;
 }
 
-// TCG helper
-void helper_uc_tracecode(int32_t size, uc_hook_type type, void *handle, int64_t address);
-void helper_uc_tracecode(int32_t size, uc_hook_type type, void *handle, int64_t address)
+// SNPS added: the hooks resolved for a block, an instruction or a page.
+// Lists with the same hooks are shared through uc->hook_lists.
+static guint hook_list_hash(gconstpointer key)
 {
-    struct uc_struct *uc = handle;
-    struct list_item *cur = uc->hook[type].head;
-    struct hook *hook;
+    const uc_hook_list_t *list = key;
+    guint h = list->count;
+    int i;
+
+    for (i = 0; i < list->count; i++)
+        h = h * 31 + (guint)((uintptr_t)list->hooks[i] >> 4);
+    return h;
+}
+
+static gboolean hook_list_equal(gconstpointer a, gconstpointer b)
+{
+    const uc_hook_list_t *x = a, *y = b;
+
+    return x->count == y->count &&
+           memcmp(x->hooks, y->hooks, x->count * sizeof(x->hooks[0])) == 0;
+}
+
+static bool hook_overlaps(struct hook *hook, uint64_t begin, uint64_t end)
+{
+    return hook->begin > hook->end ||
+           (hook->begin <= end && begin <= hook->end);
+}
+
+uc_hook_list_t *uc_hook_list_get(struct uc_struct *uc, int types,
+                                 uint64_t begin, uint64_t end)
+{
+    uc_hook_list_t *list, *found;
+    struct list_item *cur;
+    int count = 0;
+    int i, j;
+
+    for (i = 0; i < UC_HOOK_MAX; i++) {
+        if ((types >> i) & 1) {
+            for (cur = uc->hook[i].head; cur; cur = cur->next)
+                count += hook_overlaps(cur->data, begin, end);
+        }
+    }
+    if (count == 0)
+        return NULL;
+
+    // a hook of several types is listed once
+    list = g_malloc(sizeof(*list) + count * sizeof(list->hooks[0]));
+    list->uc = uc;
+    list->types = 0;
+    list->count = 0;
+    for (i = 0; i < UC_HOOK_MAX; i++) {
+        if (!((types >> i) & 1))
+            continue;
+        for (cur = uc->hook[i].head; cur; cur = cur->next) {
+            struct hook *hook = cur->data;
+            if (!hook_overlaps(hook, begin, end))
+                continue;
+            for (j = 0; j < list->count && list->hooks[j] != hook; j++)
+                ;
+            if (j == list->count)
+                list->hooks[list->count++] = hook;
+            list->types |= hook->type & types;
+        }
+    }
 
-    // sync PC in CPUArchState with address
-    if (uc->set_pc) {
-        uc->set_pc(uc, address);
+    if (uc->hook_lists == NULL)
+        uc->hook_lists = g_hash_table_new_full(hook_list_hash, hook_list_equal,
+                                               g_free, NULL);
+    found = g_hash_table_lookup(uc->hook_lists, list);
+    if (found) {
+        g_free(list);
+        return found;
     }
+    g_hash_table_insert(uc->hook_lists, list, list);
+    return list;
+}
+
+bool uc_hook_call_code(struct uc_struct *uc, uc_hook_list_t *hooks,
+                       uint64_t address, uint32_t size)
+{
+    int i;
+
+    // hooks of another engine of the group, its TBs are private (tb_owner())
+    if (hooks->uc != uc)
+        return uc->stop_request;
 
-    while (cur != NULL && !uc->stop_request) {
-        hook = (struct hook *)cur->data;
-        if (HOOK_BOUND_CHECK(hook, (uint64_t)address)) {
+    for (i = 0; i < hooks->count && !uc->stop_request; i++) {
+        struct hook *hook = hooks->hooks[i];
+        if (!hook->to_delete)
             ((uc_cb_hookcode_t)hook->callback)(uc, address, size, hook->user_data);
+    }
+    return uc->stop_request;
+}
+
+void uc_hook_call_mem(uc_hook_list_t *hooks, int type, uint64_t address,
+                      int size, int64_t value)
+{
+    struct uc_struct *uc = hooks->uc;
+    int mask, i;
+
+    switch (type) {
+    case UC_MEM_READ:
+        mask = UC_HOOK_MEM_READ;
+        break;
+    case UC_MEM_WRITE:
+        mask = UC_HOOK_MEM_WRITE;
+        break;
+    default:
+        mask = UC_HOOK_MEM_READ_AFTER;
+        break;
+    }
+    if (!(hooks->types & mask))
+        return;
+
+    for (i = 0; i < hooks->count && !uc->stop_request; i++) {
+        struct hook *hook = hooks->hooks[i];
+        if ((hook->type & mask) && !hook->to_delete &&
+            hook_overlaps(hook, address, address + size - 1))
+            ((uc_cb_hookmem_t)hook->callback)(uc, type, address, size, value,
+                                              hook->user_data);
+    }
+}
+
+// drop the lists that refer to a deleted hook
+static void hook_lists_purge(struct uc_struct *uc)
+{
+    GHashTableIter iter;
+    gpointer key;
+    int i;
+
+    if (uc->hook_lists == NULL)
+        return;
+    g_hash_table_iter_init(&iter, uc->hook_lists);
+    while (g_hash_table_iter_next(&iter, &key, NULL)) {
+        const uc_hook_list_t *list = key;
+        for (i = 0; i < list->count && !list->hooks[i]->to_delete; i++)
+            ;
+        if (i < list->count)
+            g_hash_table_iter_remove(&iter);
+    }
+}
+
+#define HOOK_TLB_PAGES 64 // flush the whole TLB for larger memory hooks
+
+// drop the TLB entries of the pages of a memory hook range
+static void hook_range_tlb_flush(struct uc_struct *uc,
+                                 const uc_hook_range_t *range)
+{
+    uint64_t page = range->begin & ~(uint64_t)uc->target_page_align;
+    uint64_t last = range->end & ~(uint64_t)uc->target_page_align;
+    int i;
+
+    for (i = 0; i < uc->num_cpus; i++) {
+        uint64_t addr = page;
+        if ((last - page) / uc->target_page_size >= HOOK_TLB_PAGES) {
+            uc->tlb_flush(uc->cpus[i]);
+            continue;
+        }
+        for (;; addr += uc->target_page_size) {
+            uc->tlb_flush_page(uc->cpus[i], addr);
+            if (addr == last)
+                break;
+        }
+    }
+}
+
+void uc_hooks_refresh(struct uc_struct *uc)
+{
+    struct list_item *cur;
+    int i;
+
+    uc->hooks_changed = false;
+    if (uc->hooks_refresh_all) {
+        uc->tb_flush(uc->cpu);
+        for (i = 0; i < uc->num_cpus; i++)
+            uc->tlb_flush(uc->cpus[i]);
+        if (uc->hook_lists)
+            g_hash_table_remove_all(uc->hook_lists);
+    } else {
+        // only the code and pages in the range of the changed hooks
+        for (i = 0; i < uc->hook_range_count; i++) {
+            const uc_hook_range_t *range = &uc->hook_ranges[i];
+            if (range->types & (UC_HOOK_CODE | UC_HOOK_BLOCK))
+                uc->tb_flush_hooked(uc->cpu, range->begin, range->end);
+            if (range->types & (UC_HOOK_MEM_READ | UC_HOOK_MEM_WRITE |
+                                UC_HOOK_MEM_READ_AFTER))
+                hook_range_tlb_flush(uc, range);
         }
-        cur = cur->next;
+        hook_lists_purge(uc);
+    }
+    uc->hooks_refresh_all = false;
+    uc->hook_range_count = 0;
+    for (cur = uc->hooks_to_del.head; cur; cur = cur->next)
+        free(cur->data);
+    list_clear(&uc->hooks_to_del);
+}
+
+// SNPS added: code and TLB entries refer to the hooks present when they were
+// made. While emulation runs, hooks may be on the stack, so the refresh waits
+// until the current TB is left (see cpu_exec).
+static void hooks_changed(uc_engine *uc, struct hook *hook)
+{
+    if (hook->begin > hook->end || uc->hook_range_count == UC_HOOK_RANGES) {
+        uc->hooks_refresh_all = true;
+    } else {
+        uc_hook_range_t *range = &uc->hook_ranges[uc->hook_range_count++];
+        range->begin = hook->begin;
+        range->end = hook->end;
+        range->types = hook->type & UC_HOOK_RESOLVED;
     }
+    uc->hooks_changed = true;
+    if (uc->is_running) {
+        cpu_exit(uc->cpu);
+        return;
+    }
+    uc_tb_group_lock(uc);
+    uc_hooks_refresh(uc);
+    uc_tb_group_unlock(uc);
 }
 
 UNICORN_EXPORT
@@ -1565,10 +2177,36 @@ uc_err uc_context_restore(uc_engine *uc, uc_context *context)
     return UC_ERR_OK;
 }
 
+// SNPS added
+UNICORN_EXPORT
+int uc_cpu_count(uc_engine *uc) {
+    return uc->num_cpus;
+}
+
+// SNPS added
+UNICORN_EXPORT
+int uc_cpu_index(uc_engine *uc) {
+    return uc->cpu->cpu_index;
+}
+
+// SNPS added
+UNICORN_EXPORT
+uc_err uc_cpu_select(uc_engine *uc, int index) {
+    if (uc == NULL || index < 0 || index >= uc->num_cpus)
+        return UC_ERR_ARG;
+
+    // the running vCPU cannot be switched from within a callback
+    if (uc->is_running)
+        return UC_ERR_ARG;
+
+    uc->cpu = uc->cpus[index];
+    return UC_ERR_OK;
+}
+
 // SNPS added
 UNICORN_EXPORT
 size_t uc_instruction_count(uc_engine *uc) {
-    return uc->cpu->insn_count;
+    return uc->insn_count(uc->cpu);
 }
 
 UNICORN_EXPORT
@@ -1604,8 +2242,30 @@ uc_err uc_mem_map_io(uc_engine *uc, uint64_t addr, size_t size,
     return mem_map(uc, addr, size, UC_PROT_ALL, ops->region);
 }
 
+// SNPS added
 UNICORN_EXPORT
-uc_err uc_mem_map_portio(uc_engine *uc, uc_cb_mmio_t callback, void *opaque)
+uc_err uc_mem_map_begin(uc_engine *uc)
+{
+    uc->mem_map_batch++;
+    uc->memory_begin(uc);
+    return UC_ERR_OK;
+}
+
+// SNPS added
+UNICORN_EXPORT
+uc_err uc_mem_map_commit(uc_engine *uc)
+{
+    if (!uc->mem_map_batch)
+        return UC_ERR_ARG;
+
+    uc->memory_commit(uc);
+    if (--uc->mem_map_batch == 0 && uc->current_cpu)
+        uc->tlb_flush(uc->current_cpu);
+    return UC_ERR_OK;
+}
+
+UNICORN_EXPORT
+uc_err uc_mem_map_portio(uc_engine *uc, uc_cb_mmio_t callback, void *opaque)
 {
     if (!uc || !callback)
         return UC_ERR_ARG;
@@ -1620,7 +2280,9 @@ UNICORN_EXPORT
 uc_err uc_tb_flush(uc_engine *uc) {
     if (!uc || !uc->tb_flush)
         return UC_ERR_ARG;
+    uc_tb_group_lock(uc); // SNPS added
     uc->tb_flush(uc->cpu);
+    uc_tb_group_unlock(uc); // SNPS added
     return UC_ERR_OK;
 }
 
@@ -1628,39 +2290,443 @@ UNICORN_EXPORT
 uc_err uc_tb_flush_page(uc_engine *uc, uint64_t start, uint64_t end) {
     if (!uc || !uc->tb_flush_page)
         return UC_ERR_ARG;
+    uc_tb_group_lock(uc); // SNPS added
     uc->tb_flush_page(uc->cpu, start, end);
+    uc_tb_group_unlock(uc); // SNPS added
+    return UC_ERR_OK;
+}
+
+// SNPS added: warm-start profiles
+#define TB_PROFILE_MAGIC "UCTBP1"
+
+static int tb_key_cmp(const void *a, const void *b)
+{
+    const uc_tb_key_t *x = a, *y = b;
+
+    if (x->phys_pc != y->phys_pc)
+        return x->phys_pc < y->phys_pc ? -1 : 1;
+    if (x->pc != y->pc)
+        return x->pc < y->pc ? -1 : 1;
+    if (x->flags != y->flags)
+        return x->flags < y->flags ? -1 : 1;
+    if (x->cflags != y->cflags)
+        return x->cflags < y->cflags ? -1 : 1;
+    if (x->cs_base != y->cs_base)
+        return x->cs_base < y->cs_base ? -1 : 1;
+    if (x->phys_page2 != y->phys_page2)
+        return x->phys_page2 < y->phys_page2 ? -1 : 1;
+    return 0;
+}
+
+// sort the recorded blocks and drop blocks translated more than once
+static void tb_profile_compact(uc_engine *uc)
+{
+    size_t i, n = 0;
+
+    qsort(uc->tb_profile, uc->tb_profile_len, sizeof(*uc->tb_profile),
+          tb_key_cmp);
+    for (i = 0; i < uc->tb_profile_len; i++) {
+        if (n == 0 || tb_key_cmp(&uc->tb_profile[n - 1], &uc->tb_profile[i]))
+            uc->tb_profile[n++] = uc->tb_profile[i];
+    }
+    uc->tb_profile_len = n;
+}
+
+void uc_tb_profile_add(struct uc_struct *uc, const uc_tb_key_t *key)
+{
+    if (uc->tb_profile_len == uc->tb_profile_size) {
+        tb_profile_compact(uc);
+        if (uc->tb_profile_len >= uc->tb_profile_size / 4 * 3) {
+            size_t size = uc->tb_profile_size ? 2 * uc->tb_profile_size : 1024;
+            uc_tb_key_t *p = realloc(uc->tb_profile, size * sizeof(*p));
+            if (p == NULL)
+                return;
+            uc->tb_profile = p;
+            uc->tb_profile_size = size;
+        }
+    }
+    uc->tb_profile[uc->tb_profile_len++] = *key;
+}
+
+static void put_uleb(FILE *f, uint64_t v)
+{
+    do {
+        int b = v & 0x7f;
+        v >>= 7;
+        fputc(v ? b | 0x80 : b, f);
+    } while (v);
+}
+
+static bool get_uleb(FILE *f, uint64_t *v)
+{
+    int b, shift = 0;
+
+    *v = 0;
+    do {
+        b = fgetc(f);
+        if (b == EOF || shift > 63)
+            return false;
+        *v |= (uint64_t)(b & 0x7f) << shift;
+        shift += 7;
+    } while (b & 0x80);
+    return true;
+}
+
+static uint64_t zigzag(int64_t v)
+{
+    return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+static int64_t unzigzag(uint64_t v)
+{
+    return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+// Records are sorted by physical address and delta encoded against the
+// previous record, so a profile costs a few bytes per block.
+UNICORN_EXPORT
+uc_err uc_tb_profile_save(uc_engine *uc, const char *path)
+{
+    uc_tb_key_t prev = { 0 };
+    char *tmp;
+    FILE *f;
+    size_t i;
+    bool ok;
+
+    if (!uc || !uc->tb_profile_path || !path)
+        return UC_ERR_ARG;
+
+    tmp = malloc(strlen(path) + 5);
+    if (tmp == NULL)
+        return UC_ERR_NOMEM;
+    sprintf(tmp, "%s.tmp", path);
+
+    f = fopen(tmp, "wb");
+    if (f == NULL) {
+        free(tmp);
+        return UC_ERR_RESOURCE;
+    }
+
+    tb_profile_compact(uc);
+    fwrite(TB_PROFILE_MAGIC, 1, sizeof(TB_PROFILE_MAGIC), f);
+    fwrite(uc->model, 1, strlen(uc->model) + 1, f);
+    put_uleb(f, uc->tb_profile_len);
+    for (i = 0; i < uc->tb_profile_len; i++) {
+        const uc_tb_key_t *k = &uc->tb_profile[i];
+        put_uleb(f, k->phys_pc - prev.phys_pc);
+        put_uleb(f, zigzag((k->pc - k->phys_pc) - (prev.pc - prev.phys_pc)));
+        put_uleb(f, k->phys_page2 == -1 ? 0 :
+                    zigzag(k->phys_page2 - k->phys_pc) + 1);
+        put_uleb(f, k->cs_base ^ prev.cs_base);
+        put_uleb(f, k->flags ^ prev.flags);
+        put_uleb(f, k->cflags ^ prev.cflags);
+        prev = *k;
+    }
+
+    ok = !ferror(f);
+    ok &= fclose(f) == 0;
+    // replace the profile atomically, engines may share one file
+#ifdef _WIN32
+    if (ok)
+        remove(path);
+#endif
+    ok = ok && rename(tmp, path) == 0;
+    if (!ok)
+        remove(tmp);
+    free(tmp);
+
+    return ok ? UC_ERR_OK : UC_ERR_RESOURCE;
+}
+
+static uc_err tb_profile_read(uc_engine *uc, FILE *f, uc_tb_key_t **keys,
+                              size_t *len)
+{
+    char magic[sizeof(TB_PROFILE_MAGIC)];
+    uc_tb_key_t prev = { 0 };
+    uint64_t n, v[6];
+    size_t i, j;
+    int c;
+
+    if (fread(magic, 1, sizeof(magic), f) != sizeof(magic) ||
+        memcmp(magic, TB_PROFILE_MAGIC, sizeof(magic)) != 0)
+        return UC_ERR_ARG;
+
+    // profiles of a different model hold keys that do not apply
+    for (i = 0; i <= strlen(uc->model); i++) {
+        c = fgetc(f);
+        if (c != (unsigned char)uc->model[i])
+            return UC_ERR_ARG;
+    }
+
+    if (!get_uleb(f, &n) || n > SIZE_MAX / sizeof(**keys))
+        return UC_ERR_ARG;
+    *keys = malloc((n ? n : 1) * sizeof(**keys));
+    if (*keys == NULL)
+        return UC_ERR_NOMEM;
+
+    for (i = 0; i < n; i++) {
+        uc_tb_key_t *k = &(*keys)[i];
+        for (j = 0; j < 6; j++) {
+            if (!get_uleb(f, &v[j])) {
+                free(*keys);
+                return UC_ERR_ARG;
+            }
+        }
+        k->phys_pc = prev.phys_pc + v[0];
+        k->pc = k->phys_pc + (prev.pc - prev.phys_pc) + unzigzag(v[1]);
+        k->phys_page2 = v[2] ? k->phys_pc + unzigzag(v[2] - 1) : -1;
+        k->cs_base = prev.cs_base ^ v[3];
+        k->flags = prev.flags ^ (uint32_t)v[4];
+        k->cflags = prev.cflags ^ (uint32_t)v[5];
+        prev = *k;
+    }
+    *len = n;
+
+    return UC_ERR_OK;
+}
+
+UNICORN_EXPORT
+uc_err uc_tb_profile_load(uc_engine *uc, const char *path, size_t *count)
+{
+    uc_tb_key_t *keys;
+    size_t len, i, n = 0;
+    uc_err err;
+    FILE *f;
+
+    if (!uc || !uc->tb_warm || !path)
+        return UC_ERR_ARG;
+
+    f = fopen(path, "rb");
+    if (f == NULL)
+        return UC_ERR_RESOURCE;
+    err = tb_profile_read(uc, f, &keys, &len);
+    fclose(f);
+    if (err)
+        return err;
+
+    uc_tb_group_lock(uc);
+    if (uc->tb_group)
+        uc->tcg_exec_attach(uc);
+    for (i = 0; i < len; i++)
+        n += uc->tb_warm(uc->cpu, &keys[i]);
+    // drop the TLB entries the translations have installed
+    uc->tlb_flush(uc->cpu);
+    uc_tb_group_unlock(uc);
+
+    free(keys);
+    if (count)
+        *count = n;
+
+    return UC_ERR_OK;
+}
+
+// SNPS added: drop the queued invalidations covered by a flush of @idxmap
+static void tlb_queue_flush(uc_tlb_queue_t *q, uint16_t idxmap)
+{
+    int i, n;
+
+    q->flush_idxmap |= idxmap;
+    for (i = n = 0; i < q->n_pages; i++) {
+        q->pages[i].idxmap &= ~q->flush_idxmap;
+        if (q->pages[i].idxmap)
+            q->pages[n++] = q->pages[i];
+    }
+    q->n_pages = n;
+    for (i = n = 0; i < q->n_asids; i++) {
+        q->asids[i].idxmap &= ~q->flush_idxmap;
+        if (q->asids[i].idxmap)
+            q->asids[n++] = q->asids[i];
+    }
+    q->n_asids = n;
+}
+
+static void tlb_queue_page(uc_tlb_queue_t *q, uint64_t addr, uint16_t idxmap)
+{
+    int i;
+
+    idxmap &= ~q->flush_idxmap;
+    if (!idxmap)
+        return;
+    for (i = 0; i < q->n_pages; i++) {
+        if (q->pages[i].addr == addr) {
+            q->pages[i].idxmap |= idxmap;
+            return;
+        }
+    }
+    if (q->n_pages == UC_TLB_BATCH_PAGES) {
+        for (i = 0; i < q->n_pages; i++)
+            idxmap |= q->pages[i].idxmap;
+        tlb_queue_flush(q, idxmap);
+        return;
+    }
+    q->pages[q->n_pages].addr = addr;
+    q->pages[q->n_pages].idxmap = idxmap;
+    q->n_pages++;
+}
+
+static void tlb_queue_asid(uc_tlb_queue_t *q, uint32_t asid, uint16_t idxmap)
+{
+    int i;
+
+    idxmap &= ~q->flush_idxmap;
+    if (!idxmap)
+        return;
+    for (i = 0; i < q->n_asids; i++) {
+        if (q->asids[i].asid == asid) {
+            q->asids[i].idxmap |= idxmap;
+            return;
+        }
+    }
+    if (q->n_asids == UC_TLB_BATCH_ASIDS) {
+        tlb_queue_flush(q, idxmap);
+        return;
+    }
+    q->asids[q->n_asids].asid = asid;
+    q->asids[q->n_asids].idxmap = idxmap;
+    q->n_asids++;
+}
+
+enum { TLB_BATCH_FLUSH, TLB_BATCH_PAGE, TLB_BATCH_ASID };
+
+// SNPS added: queue a shootdown in batching mode, returns false otherwise.
+// The running vCPU leaves its TB chain so that the queue is applied at the
+// next TB boundary.
+static bool tlb_batch_queue(uc_engine *uc, int op, uint64_t addr,
+                            uint32_t asid, uint16_t idxmap)
+{
+    uc_tlb_batch_t *b = uc->tlb_batch;
+    int i;
+
+    if (!b)
+        return false;
+
+    qemu_mutex_lock(&b->lock);
+    switch (op) {
+    case TLB_BATCH_FLUSH:
+        tlb_queue_flush(&b->queue, idxmap);
+        break;
+    case TLB_BATCH_PAGE:
+        tlb_queue_page(&b->queue, addr, idxmap);
+        break;
+    default:
+        tlb_queue_asid(&b->queue, asid, idxmap);
+        break;
+    }
+    atomic_set(&b->pending, 1);
+    qemu_mutex_unlock(&b->lock);
+
+    for (i = 0; i < uc->num_cpus; i++)
+        atomic_set(&uc->cpus[i]->tcg_exit_req, 1);
+    return true;
+}
+
+static void tlb_batch_apply(uc_engine *uc)
+{
+    uc_tlb_batch_t *b = uc->tlb_batch;
+    uc_tlb_queue_t q;
+    int i, j;
+
+    qemu_mutex_lock(&b->lock);
+    q = b->queue;
+    memset(&b->queue, 0, sizeof(b->queue));
+    atomic_set(&b->pending, 0);
+    qemu_mutex_unlock(&b->lock);
+
+    for (i = 0; i < uc->num_cpus; i++) {
+        CPUState *cpu = uc->cpus[i];
+
+        if (q.flush_idxmap == UINT16_MAX)
+            uc->tlb_flush(cpu);
+        else if (q.flush_idxmap)
+            uc->tlb_flush_mmuidx(cpu, q.flush_idxmap);
+        for (j = 0; j < q.n_asids; j++)
+            uc->tlb_flush_asid_mmuidx(cpu, q.asids[j].asid, q.asids[j].idxmap);
+        for (j = 0; j < q.n_pages; j++) {
+            if (q.pages[j].idxmap == UINT16_MAX)
+                uc->tlb_flush_page(cpu, q.pages[j].addr);
+            else
+                uc->tlb_flush_page_mmuidx(cpu, q.pages[j].addr, q.pages[j].idxmap);
+        }
+    }
+}
+
+// SNPS added
+UNICORN_EXPORT
+uc_err uc_tlb_sync(uc_engine *uc) {
+    if (!uc)
+        return UC_ERR_ARG;
+    if (uc->tlb_batch && atomic_read(&uc->tlb_batch->pending))
+        tlb_batch_apply(uc);
     return UC_ERR_OK;
 }
 
 UNICORN_EXPORT
 uc_err uc_tlb_flush(uc_engine *uc) {
+    int i;
     if (!uc || !uc->tlb_flush)
         return UC_ERR_ARG;
-    uc->tlb_flush(uc->cpu);
+    if (tlb_batch_queue(uc, TLB_BATCH_FLUSH, 0, 0, UINT16_MAX)) // SNPS added
+        return UC_ERR_OK;
+    for (i = 0; i < uc->num_cpus; i++) // SNPS changed: all vCPUs
+        uc->tlb_flush(uc->cpus[i]);
     return UC_ERR_OK;
 }
 
 UNICORN_EXPORT
 uc_err uc_tlb_flush_page(uc_engine *uc, uint64_t addr) {
+    int i;
     if (!uc || !uc->tlb_flush_page)
         return UC_ERR_ARG;
-    uc->tlb_flush_page(uc->cpu, addr);
+    if (tlb_batch_queue(uc, TLB_BATCH_PAGE, addr, 0, UINT16_MAX)) // SNPS added
+        return UC_ERR_OK;
+    for (i = 0; i < uc->num_cpus; i++) // SNPS changed: all vCPUs
+        uc->tlb_flush_page(uc->cpus[i], addr);
+    return UC_ERR_OK;
+}
+
+// SNPS added
+UNICORN_EXPORT
+uc_err uc_tlb_stats(uc_engine *uc, uc_tlb_stats_t *stats) {
+    if (!uc || !uc->tlb_stats || !stats)
+        return UC_ERR_ARG;
+    uc->tlb_stats(uc->cpu, stats);
     return UC_ERR_OK;
 }
 
 UNICORN_EXPORT
 uc_err uc_tlb_flush_mmuidx(uc_engine *uc, uint16_t idxmap) {
+    int i;
     if (!uc || !uc->tlb_flush_mmuidx)
         return UC_ERR_ARG;
-    uc->tlb_flush_mmuidx(uc->cpu, idxmap);
+    if (tlb_batch_queue(uc, TLB_BATCH_FLUSH, 0, 0, idxmap)) // SNPS added
+        return UC_ERR_OK;
+    for (i = 0; i < uc->num_cpus; i++) // SNPS changed: all vCPUs
+        uc->tlb_flush_mmuidx(uc->cpus[i], idxmap);
     return UC_ERR_OK;
 }
 
 UNICORN_EXPORT
 uc_err uc_tlb_flush_page_mmuidx(uc_engine *uc, uint64_t addr, uint16_t idxmap) {
+    int i;
     if (!uc || !uc->tlb_flush_page_mmuidx)
         return UC_ERR_ARG;
-    uc->tlb_flush_page_mmuidx(uc->cpu, addr, idxmap);
+    if (tlb_batch_queue(uc, TLB_BATCH_PAGE, addr, 0, idxmap)) // SNPS added
+        return UC_ERR_OK;
+    for (i = 0; i < uc->num_cpus; i++) // SNPS changed: all vCPUs
+        uc->tlb_flush_page_mmuidx(uc->cpus[i], addr, idxmap);
+    return UC_ERR_OK;
+}
+
+// SNPS added
+UNICORN_EXPORT
+uc_err uc_tlb_flush_asid_mmuidx(uc_engine *uc, uint32_t asid, uint16_t idxmap) {
+    int i;
+    if (!uc || !uc->tlb_flush_asid_mmuidx)
+        return UC_ERR_ARG;
+    if (tlb_batch_queue(uc, TLB_BATCH_ASID, 0, asid, idxmap))
+        return UC_ERR_OK;
+    for (i = 0; i < uc->num_cpus; i++)
+        uc->tlb_flush_asid_mmuidx(uc->cpus[i], asid, idxmap);
     return UC_ERR_OK;
 }
 
@@ -1677,14 +2743,42 @@ uc_err uc_register_tlb_cluster(uc_engine *uc, void *opaque,
     return UC_ERR_OK;
 }
 
+// SNPS added
+UNICORN_EXPORT
+uc_err uc_register_tlb_cluster_asid(uc_engine *uc,
+    uc_tlb_cluster_flush_asid_mmuidx_t tlb_cluster_flush_asid_mmuidx_fn) {
+    if (!uc)
+        return UC_ERR_ARG;
+    uc->uc_tlb_cluster_flush_asid_mmuidx = tlb_cluster_flush_asid_mmuidx_fn;
+    return UC_ERR_OK;
+}
+
+// SNPS added
+UNICORN_EXPORT
+uc_err uc_register_tlb_cluster_sync(uc_engine *uc,
+    uc_tlb_cluster_sync_t tlb_cluster_sync_fn) {
+    if (!uc)
+        return UC_ERR_ARG;
+    uc->uc_tlb_cluster_sync = tlb_cluster_sync_fn;
+    return UC_ERR_OK;
+}
+
 static uc_err __uc_breakpoint_insert(uc_engine *uc, uint64_t addr, int flags) {
-    if (!uc->breakpoint_insert(uc->cpu, addr, flags, NULL))
+    int ret;
+    uc_tb_group_lock(uc); // SNPS added: invalidates TBs
+    ret = uc->breakpoint_insert(uc->cpu, addr, flags, NULL);
+    uc_tb_group_unlock(uc);
+    if (!ret)
         return UC_ERR_OK;
     return UC_ERR_ARG;
 }
 
 static uc_err __uc_breakpoint_remove(uc_engine *uc, uint64_t addr, int flags) {
-    if (!uc->breakpoint_remove(uc->cpu, addr, flags))
+    int ret;
+    uc_tb_group_lock(uc); // SNPS added: invalidates TBs
+    ret = uc->breakpoint_remove(uc->cpu, addr, flags);
+    uc_tb_group_unlock(uc);
+    if (!ret)
         return UC_ERR_OK;
     return UC_ERR_ARG;
 }
@@ -1882,15 +2976,149 @@ uc_err uc_setup_dmi(uc_engine *uc, void *opaque, uc_cb_dmiptr_t dmifn,
     return UC_ERR_OK;
 }
 
+// SNPS added: number of grants starting at or below addr
+static size_t dmi_grant_upper(struct uc_struct *uc, uint64_t addr)
+{
+    size_t lo = 0, hi = uc->dmi_grant_count;
+
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (uc->dmi_grants[mid].start <= addr)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+// SNPS added
+bool uc_dmi_lookup(struct uc_struct *uc, uint64_t page, unsigned char **ptr,
+                   int *prot)
+{
+    size_t i = dmi_grant_upper(uc, page);
+    uc_dmi_grant_t *g;
+
+    if (i == 0)
+        return false;
+    g = &uc->dmi_grants[i - 1];
+    if (page >= g->end)
+        return false;
+    *ptr = g->ptr + (page - g->start);
+    *prot = g->prot;
+    return true;
+}
+
+// SNPS added: replace the grants [i, j) by n others
+static uc_dmi_grant_t *dmi_grant_splice(struct uc_struct *uc, size_t i,
+                                        size_t j, size_t n)
+{
+    size_t count = uc->dmi_grant_count - (j - i) + n;
+
+    if (count > uc->dmi_grant_alloc) {
+        uc->dmi_grant_alloc = MAX(count, uc->dmi_grant_alloc * 2);
+        uc->dmi_grants = g_renew(uc_dmi_grant_t, uc->dmi_grants,
+                                 uc->dmi_grant_alloc);
+    }
+    memmove(&uc->dmi_grants[i + n], &uc->dmi_grants[j],
+            sizeof(uc_dmi_grant_t) * (uc->dmi_grant_count - j));
+    uc->dmi_grant_count = count;
+    return &uc->dmi_grants[i];
+}
+
+// SNPS added: drop [start, end) from the grants, keeping the parts of the
+// grants that straddle it
+static void dmi_revoke(struct uc_struct *uc, uint64_t start, uint64_t end)
+{
+    uc_dmi_grant_t left, right, *g;
+    size_t i, j, n = 0;
+
+    i = dmi_grant_upper(uc, start);
+    if (i > 0 && uc->dmi_grants[i - 1].end > start)
+        i--;
+    for (j = i; j < uc->dmi_grant_count && uc->dmi_grants[j].start < end; j++) {
+    }
+    if (i == j)
+        return;
+
+    left = uc->dmi_grants[i];
+    right = uc->dmi_grants[j - 1];
+    g = dmi_grant_splice(uc, i, j, (left.start < start) + (right.end > end));
+    if (left.start < start) {
+        left.end = start;
+        g[n++] = left;
+    }
+    if (right.end > end) {
+        right.ptr += end - right.start;
+        right.start = end;
+        g[n++] = right;
+    }
+}
+
+// SNPS added
+UNICORN_EXPORT
+uc_err uc_dmi_grant(uc_engine *uc, uint64_t start, uint64_t end,
+                    unsigned char *ptr, int prot)
+{
+    uc_dmi_grant_t *g;
+    int i;
+
+    if (uc == NULL || ptr == NULL || start >= end ||
+        (start & uc->target_page_align) != 0 ||
+        (end & uc->target_page_align) != 0 ||
+        (prot & ~(UC_DMI_PROT_READ | UC_DMI_PROT_WRITE | UC_DMI_PROT_EXEC)))
+        return UC_ERR_ARG;
+
+    if (uc->inv_dmi_ptr == NULL)
+        return UC_ERR_INTERNAL;
+
+    dmi_revoke(uc, start, end);
+    i = dmi_grant_upper(uc, start);
+    g = dmi_grant_splice(uc, i, i, 1);
+    g->start = start;
+    g->end = end;
+    g->ptr = ptr;
+    g->prot = prot;
+
+    // entries filled before, as I/O or through the callback, refill from it
+    for (i = 0; i < uc->num_cpus; i++)
+        uc->inv_dmi_ptr(uc->cpus[i], start, end);
+    return UC_ERR_OK;
+}
+
 UNICORN_EXPORT
 uc_err uc_dmi_invalidate(uc_engine *uc, uint64_t start, uint64_t end) {
+    int i;
+
     if (uc == NULL)
         return UC_ERR_ARG;
 
     if (uc->inv_dmi_ptr == NULL)
         return UC_ERR_INTERNAL;
 
-    uc->inv_dmi_ptr(uc->cpu, start, end);
+    dmi_revoke(uc, start, end); // SNPS added
+    for (i = 0; i < uc->num_cpus; i++) // SNPS changed: all vCPUs
+        uc->inv_dmi_ptr(uc->cpus[i], start, end);
+    return UC_ERR_OK;
+}
+
+// SNPS added
+UNICORN_EXPORT
+uc_err uc_dmi_invalidate_ranges(uc_engine *uc, const uc_dmi_range_t *ranges,
+                                size_t count)
+{
+    size_t j;
+    int i;
+
+    if (uc == NULL || (ranges == NULL && count != 0))
+        return UC_ERR_ARG;
+
+    if (uc->inv_dmi_ranges_ptr == NULL)
+        return UC_ERR_INTERNAL;
+
+    for (j = 0; j < count; j++) // SNPS added
+        dmi_revoke(uc, ranges[j].start, ranges[j].end);
+    for (i = 0; i < uc->num_cpus; i++)
+        uc->inv_dmi_ranges_ptr(uc->cpus[i], ranges, count);
     return UC_ERR_OK;
 }
 
@@ -1922,12 +3150,421 @@ uc_err uc_setup_basic_block_trace(uc_engine *uc, void *opaque,
 
     if (uc->uc_trace_bb_func != fn)
         uc_tb_flush(uc);
+    if (fn != NULL && uc->bb_trace != NULL) // SNPS added
+        bb_trace_set(uc, NULL);
 
     uc->uc_trace_bb_opaque = opaque;
     uc->uc_trace_bb_func = fn;
     return UC_ERR_OK;
 }
 
+#define BB_TRACE_FLAGS (UC_BB_TRACE_ICOUNT | UC_BB_TRACE_TIME)
+#define BB_TRACE_MAGIC "UCBBT1"
+#define BB_TRACE_FILE_WORDS (3 * 16384) // per buffer, any entry size fits
+
+// The engine fills one buffer while the writer thread encodes the other.
+struct uc_bb_trace_file {
+    FILE *f;
+    int words;
+    uint64_t prev[3];           // last entry written
+    uint64_t *buffers[2];
+    const uint64_t *pending;    // entries handed to the writer, or NULL
+    size_t count;
+    bool quit;
+    QemuMutex lock;
+    QemuCond cond;
+    QemuThread thread;
+};
+
+static void *bb_trace_writer(void *arg)
+{
+    uc_bb_trace_file_t *file = arg;
+
+    qemu_mutex_lock(&file->lock);
+    for (;;) {
+        const uint64_t *p;
+        size_t i, n;
+        int j;
+
+        while (file->pending == NULL && !file->quit)
+            qemu_cond_wait(&file->cond, &file->lock);
+        if (file->pending == NULL)
+            break;
+        p = file->pending;
+        n = file->count;
+        qemu_mutex_unlock(&file->lock);
+
+        for (i = 0; i < n; i++, p += file->words) {
+            put_uleb(file->f, zigzag(p[0] - file->prev[0]));
+            for (j = 1; j < file->words; j++)
+                put_uleb(file->f, p[j] - file->prev[j]);
+            memcpy(file->prev, p, file->words * sizeof(*p));
+        }
+
+        qemu_mutex_lock(&file->lock);
+        file->pending = NULL;
+        qemu_cond_signal(&file->cond);
+    }
+    qemu_mutex_unlock(&file->lock);
+
+    return NULL;
+}
+
+// Hand @count entries to the writer, returns the buffer to fill next
+static uint64_t *bb_trace_file_put(uc_bb_trace_file_t *file,
+                                   uint64_t *entries, size_t count)
+{
+    if (count == 0)
+        return entries;
+
+    qemu_mutex_lock(&file->lock);
+    while (file->pending != NULL)
+        qemu_cond_wait(&file->cond, &file->lock);
+    file->pending = entries;
+    file->count = count;
+    qemu_cond_signal(&file->cond);
+    qemu_mutex_unlock(&file->lock);
+
+    return entries == file->buffers[0] ? file->buffers[1] : file->buffers[0];
+}
+
+static void bb_trace_free(uc_bb_trace_t *trace)
+{
+    uc_bb_trace_file_t *file = trace->file;
+
+    if (file) {
+        qemu_mutex_lock(&file->lock);
+        file->quit = true;
+        qemu_cond_signal(&file->cond);
+        qemu_mutex_unlock(&file->lock);
+        qemu_thread_join(&file->thread);
+        fclose(file->f);
+        qemu_mutex_destroy(&file->lock);
+        free(file->buffers[0]);
+        free(file);
+    }
+    free(trace);
+}
+
+static uc_bb_trace_t *bb_trace_new(int flags, uint64_t *buffer, size_t size)
+{
+    uc_bb_trace_t *trace;
+    int words = 1 + !!(flags & UC_BB_TRACE_ICOUNT) + !!(flags & UC_BB_TRACE_TIME);
+
+    if ((flags & ~BB_TRACE_FLAGS) || buffer == NULL || size < (size_t)words)
+        return NULL;
+
+    trace = calloc(1, sizeof(*trace));
+    if (trace == NULL)
+        return NULL;
+    trace->flags = flags;
+    trace->words = words;
+    trace->buffer = buffer;
+    trace->end = buffer + size / words * words;
+    return trace;
+}
+
+// Generated code depends on the trace setting, the vCPUs pick up the new
+// buffer through uc_bb_trace_flush() on their next block
+static void bb_trace_set(uc_engine *uc, uc_bb_trace_t *trace)
+{
+    int i;
+
+    uc_tb_flush(uc);
+    if (uc->bb_trace)
+        bb_trace_free(uc->bb_trace);
+    uc->bb_trace = trace;
+    if (trace) {
+        uc->uc_trace_bb_func = NULL;
+        uc->uc_trace_bb_opaque = NULL;
+    }
+    for (i = 0; i < uc->num_cpus; i++) {
+        uc->cpus[i]->bb_trace_pos = NULL;
+        uc->cpus[i]->bb_trace_end = NULL;
+    }
+}
+
+void uc_bb_trace_flush(struct uc_struct *uc, CPUState *cpu)
+{
+    uc_bb_trace_t *trace = uc->bb_trace;
+    uint64_t *pos = cpu->bb_trace_pos;
+    size_t count = 0, i;
+
+    if (trace == NULL) {
+        // TB translated by another engine of a sharing group
+        cpu->bb_trace_pos = cpu->bb_trace_discard;
+        cpu->bb_trace_end = cpu->bb_trace_discard + 1;
+        return;
+    }
+
+    if (pos >= trace->buffer && pos <= trace->end)
+        count = (pos - trace->buffer) / trace->words;
+    if (trace->flags & UC_BB_TRACE_ICOUNT) {
+        // generated code records the budget left before the block
+        uint64_t base = trace->icount_base + cpu->insn_limit;
+        for (i = 0; i < count; i++)
+            trace->buffer[i * trace->words + 1] =
+                base - trace->buffer[i * trace->words + 1];
+    }
+
+    if (trace->file) {
+        uint64_t *next = bb_trace_file_put(trace->file, trace->buffer, count);
+        trace->end = next + (trace->end - trace->buffer);
+        trace->buffer = next;
+    } else if (count) {
+        trace->fn(trace->opaque, trace->buffer, count);
+        // the callback may have changed the trace
+        trace = uc->bb_trace;
+        if (trace == NULL) {
+            cpu->bb_trace_pos = NULL;
+            cpu->bb_trace_end = NULL;
+            return;
+        }
+    }
+
+    cpu->bb_trace_pos = trace->buffer;
+    cpu->bb_trace_end = trace->end;
+}
+
+static void bb_trace_stop(uc_engine *uc)
+{
+    if (uc->bb_trace == NULL)
+        return;
+
+    uc_bb_trace_flush(uc, uc->cpu);
+    if (uc->bb_trace)
+        uc->bb_trace->icount_base += uc->insn_count(uc->cpu);
+}
+
+UNICORN_EXPORT
+uc_err uc_setup_basic_block_trace_buffer(uc_engine *uc, void *opaque,
+                                         uint64_t *buffer, size_t size,
+                                         int flags, uc_trace_buffer_t fn)
+{
+    uc_bb_trace_t *trace;
+
+    if (uc == NULL)
+        return UC_ERR_ARG;
+
+    if (fn == NULL) {
+        if (uc->bb_trace)
+            bb_trace_set(uc, NULL);
+        return UC_ERR_OK;
+    }
+
+    trace = bb_trace_new(flags, buffer, size);
+    if (trace == NULL)
+        return UC_ERR_ARG;
+    trace->fn = fn;
+    trace->opaque = opaque;
+    bb_trace_set(uc, trace);
+    return UC_ERR_OK;
+}
+
+UNICORN_EXPORT
+uc_err uc_basic_block_trace_file(uc_engine *uc, const char *path, int flags)
+{
+    uc_bb_trace_file_t *file;
+    uc_bb_trace_t *trace;
+    QemuCond cond = QEMU_COND_INITIALIZER;
+
+    if (uc == NULL || (flags & ~BB_TRACE_FLAGS))
+        return UC_ERR_ARG;
+
+    if (path == NULL) {
+        if (uc->bb_trace)
+            bb_trace_set(uc, NULL);
+        return UC_ERR_OK;
+    }
+
+    file = calloc(1, sizeof(*file));
+    if (file == NULL)
+        return UC_ERR_NOMEM;
+    file->buffers[0] = malloc(2 * BB_TRACE_FILE_WORDS * sizeof(uint64_t));
+    trace = bb_trace_new(flags, file->buffers[0], BB_TRACE_FILE_WORDS);
+    if (trace == NULL) {
+        free(file->buffers[0]);
+        free(file);
+        return UC_ERR_NOMEM;
+    }
+    file->buffers[1] = file->buffers[0] + BB_TRACE_FILE_WORDS;
+    file->words = trace->words;
+
+    file->f = fopen(path, "wb");
+    if (file->f == NULL) {
+        free(trace);
+        free(file->buffers[0]);
+        free(file);
+        return UC_ERR_RESOURCE;
+    }
+    fwrite(BB_TRACE_MAGIC, 1, sizeof(BB_TRACE_MAGIC), file->f);
+    put_uleb(file->f, flags);
+
+    qemu_mutex_init(&file->lock);
+    file->cond = cond;
+    if (qemu_thread_create(uc, &file->thread, "bbtrace", bb_trace_writer,
+                           file, QEMU_THREAD_JOINABLE) != 0) {
+        fclose(file->f);
+        qemu_mutex_destroy(&file->lock);
+        free(trace);
+        free(file->buffers[0]);
+        free(file);
+        return UC_ERR_RESOURCE;
+    }
+    trace->file = file;
+    bb_trace_set(uc, trace);
+    return UC_ERR_OK;
+}
+
+// SNPS added: memory access trace
+
+void uc_mem_trace_flush(struct uc_struct *uc, CPUState *cpu, size_t need)
+{
+    uc_mem_trace_t *trace = uc->mem_trace;
+    uint64_t *pos = cpu->mem_trace_pos;
+
+    if (trace && pos > trace->buffer && pos <= trace->end) {
+        trace->fn(trace->opaque, trace->buffer,
+                  (pos - trace->buffer) / trace->words);
+        // the callback may have changed the trace
+        trace = uc->mem_trace;
+    }
+
+    if (trace && need <= trace->entries * trace->words * sizeof(uint64_t)) {
+        cpu->mem_trace_pos = trace->buffer;
+        cpu->mem_trace_end = trace->end;
+        return;
+    }
+
+    // TB translated by another engine of a sharing group
+    if (cpu->mem_trace_discard_size < need) {
+        g_free(cpu->mem_trace_discard);
+        cpu->mem_trace_discard = g_malloc(need);
+        cpu->mem_trace_discard_size = need;
+    }
+    cpu->mem_trace_pos = cpu->mem_trace_discard;
+    cpu->mem_trace_end = cpu->mem_trace_discard + need / sizeof(uint64_t);
+}
+
+bool uc_mem_trace_covers(struct uc_struct *uc, uint64_t pc)
+{
+    const uc_mem_trace_range_t *r = uc->mem_trace_ranges;
+    size_t lo = 0, hi = uc->mem_trace_nranges;
+
+    if (hi == 0)
+        return true;
+
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (r[mid].end <= pc)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo < uc->mem_trace_nranges && r[lo].start <= pc;
+}
+
+static void mem_trace_stop(uc_engine *uc)
+{
+    if (uc->mem_trace)
+        uc_mem_trace_flush(uc, uc->cpu, 0);
+}
+
+// Generated code depends on the trace setting, the vCPUs pick up the new
+// buffer through uc_mem_trace_flush() on their next traced block
+static void mem_trace_set(uc_engine *uc, uc_mem_trace_t *trace)
+{
+    int i;
+
+    uc_tb_flush(uc);
+    free(uc->mem_trace);
+    uc->mem_trace = trace;
+    for (i = 0; i < uc->num_cpus; i++) {
+        uc->cpus[i]->mem_trace_pos = NULL;
+        uc->cpus[i]->mem_trace_end = NULL;
+    }
+}
+
+UNICORN_EXPORT
+uc_err uc_setup_mem_trace(uc_engine *uc, void *opaque, uint64_t *buffer,
+                          size_t size, int flags, uc_trace_buffer_t fn)
+{
+    uc_mem_trace_t *trace;
+    int words = 2 + !!(flags & UC_MEM_TRACE_PADDR) +
+                !!(flags & UC_MEM_TRACE_VALUE);
+
+    if (uc == NULL)
+        return UC_ERR_ARG;
+
+    if (fn == NULL) {
+        if (uc->mem_trace)
+            mem_trace_set(uc, NULL);
+        return UC_ERR_OK;
+    }
+
+    if ((flags & ~(UC_MEM_TRACE_PADDR | UC_MEM_TRACE_VALUE)) ||
+        buffer == NULL || size / words < UC_MEM_TRACE_MIN_ENTRIES)
+        return UC_ERR_ARG;
+
+    trace = calloc(1, sizeof(*trace));
+    if (trace == NULL)
+        return UC_ERR_NOMEM;
+    trace->flags = flags;
+    trace->words = words;
+    trace->entries = size / words;
+    trace->buffer = buffer;
+    trace->end = buffer + trace->entries * words;
+    trace->fn = fn;
+    trace->opaque = opaque;
+    mem_trace_set(uc, trace);
+    return UC_ERR_OK;
+}
+
+static int mem_trace_range_cmp(const void *a, const void *b)
+{
+    const uc_mem_trace_range_t *ra = a, *rb = b;
+
+    return ra->start < rb->start ? -1 : ra->start > rb->start;
+}
+
+// Ranges are sorted and merged so that uc_mem_trace_covers() can bisect them
+UNICORN_EXPORT
+uc_err uc_mem_trace_ranges(uc_engine *uc, const uc_mem_trace_range_t *ranges,
+                           size_t count)
+{
+    uc_mem_trace_range_t *r = NULL;
+    size_t i, n = 0;
+
+    if (uc == NULL || (count && ranges == NULL))
+        return UC_ERR_ARG;
+
+    for (i = 0; i < count; i++) {
+        if (ranges[i].start >= ranges[i].end)
+            return UC_ERR_ARG;
+    }
+
+    if (count) {
+        r = malloc(count * sizeof(*r));
+        if (r == NULL)
+            return UC_ERR_NOMEM;
+        memcpy(r, ranges, count * sizeof(*r));
+        qsort(r, count, sizeof(*r), mem_trace_range_cmp);
+        for (i = 0; i < count; i++) {
+            if (n && r[i].start <= r[n - 1].end)
+                r[n - 1].end = MAX(r[n - 1].end, r[i].end);
+            else
+                r[n++] = r[i];
+        }
+    }
+
+    free(uc->mem_trace_ranges);
+    uc->mem_trace_ranges = r;
+    uc->mem_trace_nranges = n;
+    if (uc->mem_trace)
+        uc_tb_flush(uc);
+    return UC_ERR_OK;
+}
+
 UNICORN_EXPORT
 uc_err uc_reset_cpu(uc_engine *uc) {
     CPUClass *cc = CPU_GET_CLASS(uc, uc->cpu);